@@ -0,0 +1,478 @@
+/**
+ * @file bench.c
+ * @brief Micro-benchmarks for the firmware hot paths
+ *
+ * Measures the keymap lookup, HID keycode array building, pressed key
+ * tracking, encoder decoding and HID report encoding, using the firmware
+ * sources unchanged. Built two ways:
+ * - natively (host/CMakeLists.txt, BENCH_HOST=1) against the stubbed SDK,
+ *   timing with the host monotonic clock and counting heap allocations
+ * - for the Pico (ORIONE_BENCH=ON in the firmware build), timing in core
+ *   clock cycles with SysTick and printing over RTT
+ *
+ * Every result is one JSON object per line, so runs can be saved and
+ * compared between commits (see tools/bench_compare.py):
+ *   {"bench":"build_keycode_array","case":"held=3","iters":1048576,"ns_per_op":12.34,...}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "tusb.h"
+
+#include "src/matrix/matrix.h"
+#include "src/matrix/keymap/keymap.h"
+#include "src/matrix/scan_rows/scan_rows.h"
+#include "src/matrix/snapshot/snapshot.h"
+#include "src/rotary_encoder/rotary_encoder.h"
+#include "src/usb/hid_report/hid_report.h"
+
+#ifndef BENCH_HOST
+#define BENCH_HOST 0
+#endif
+
+#if BENCH_HOST
+    #include <time.h>
+
+    #define BENCH_ITERS 1048576     // default iterations per case
+#else
+    #include "hardware/clocks.h"
+    #include "hardware/structs/systick.h"
+
+    #define BENCH_ITERS 16384
+    #define BENCH_REPEAT_MS 5000    // the suite is rerun for late RTT readers
+#endif
+
+// Iterations timed per clock read. Keeps the clock overhead negligible and,
+// on the Pico, every batch well inside the 24-bit SysTick range.
+#define BENCH_BATCH 256
+
+//--------------------------------------------------------------------+
+
+// Working matrix state, owned by main.c in the firmware
+keyboard_state_t kbd_state = {0};
+
+// Consumed results, so the compiler cannot drop the measured calls
+static volatile uint32_t bench_sink = 0;
+
+static uint32_t bench_iters = BENCH_ITERS;
+static const char* bench_filter = NULL;
+
+//--------------------------------------------------------------------+
+// CLOCK
+//--------------------------------------------------------------------+
+
+#if BENCH_HOST
+
+static uint64_t alloc_count = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+// Allocation counters, linked with -Wl,--wrap=malloc,... (host/CMakeLists.txt)
+void* __wrap_malloc(size_t size) {
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size) {
+    alloc_count++;
+    return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    alloc_count++;
+    return __real_realloc(ptr, size);
+}
+
+/**
+ * @brief Current time in nanoseconds
+ */
+static inline uint64_t bench_ticks(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t bench_elapsed(uint64_t start, uint64_t end) {
+    return end - start;
+}
+
+#else
+
+/**
+ * @brief Current SysTick value (counts core clock cycles down)
+ */
+static inline uint64_t bench_ticks(void) {
+    return systick_hw->cvr;
+}
+
+static inline uint64_t bench_elapsed(uint64_t start, uint64_t end) {
+    return (start - end) & 0x00FFFFFF;
+}
+
+/**
+ * @brief Run SysTick from the core clock, free running over 24 bits
+ */
+static void bench_clock_init(void) {
+    systick_hw->csr = 0;
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+}
+
+#endif
+
+//--------------------------------------------------------------------+
+// RESULTS
+//--------------------------------------------------------------------+
+
+typedef struct {
+    const char* name;
+    char param[24];
+    uint64_t ticks;         // ns on the host, cycles on the Pico
+    uint64_t allocs;
+} bench_result_t;
+
+/**
+ * @brief Check whether a benchmark is selected by the name filter
+ */
+static bool bench_selected(const char* name) {
+    return bench_filter == NULL || strstr(name, bench_filter) != NULL;
+}
+
+/**
+ * @brief Start measuring a benchmark case
+ */
+static void bench_begin(bench_result_t* result, const char* name, const char* param) {
+    result->name = name;
+    snprintf(result->param, sizeof(result->param), "%s", param);
+    result->ticks = 0;
+#if BENCH_HOST
+    result->allocs = alloc_count;
+#else
+    result->allocs = 0;
+#endif
+}
+
+/**
+ * @brief Print the result of a benchmark case as one JSON line
+ */
+static void bench_end(bench_result_t* result) {
+    double per_op = (double)result->ticks / bench_iters;
+
+#if BENCH_HOST
+    double allocs_per_op = (double)(alloc_count - result->allocs) / bench_iters;
+
+    printf("{\"bench\":\"%s\",\"case\":\"%s\",\"iters\":%lu,\"ns_per_op\":%.3f,\"allocs_per_op\":%.3f}\n",
+           result->name, result->param, (unsigned long)bench_iters, per_op, allocs_per_op);
+#else
+    double ns_per_op = per_op * 1e9 / clock_get_hz(clk_sys);
+
+    printf("{\"bench\":\"%s\",\"case\":\"%s\",\"iters\":%lu,\"cycles_per_op\":%.2f,\"ns_per_op\":%.3f}\n",
+           result->name, result->param, (unsigned long)bench_iters, per_op, ns_per_op);
+#endif
+}
+
+// Time `body` over bench_iters iterations, `i` being the iteration index
+#define BENCH_LOOP(result, body)                                            \
+    for (uint32_t done = 0; done < bench_iters; done += BENCH_BATCH) {      \
+        uint64_t batch_start = bench_ticks();                               \
+        for (uint32_t i = done; i < done + BENCH_BATCH; i++) {              \
+            body;                                                           \
+        }                                                                   \
+        (result)->ticks += bench_elapsed(batch_start, bench_ticks());       \
+    }
+
+//--------------------------------------------------------------------+
+// FIXTURES
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Position of the i-th key held by the fixtures
+ *
+ * Walks the matrix from the second row (regular keys on both layers),
+ * skipping the Fn key.
+ */
+static void bench_key_position(uint8_t i, uint8_t* row, uint8_t* col) {
+    uint16_t idx = MATRIX_COLS + 1 + i;
+
+    if (idx >= FN_KEY_ROW * MATRIX_COLS + FN_KEY_COL) idx++;
+
+    *row = (idx / MATRIX_COLS) % MATRIX_ROWS;
+    *col = idx % MATRIX_COLS;
+}
+
+/**
+ * @brief Fill a snapshot with the first `held` fixture keys pressed
+ */
+static void bench_snapshot(matrix_snapshot_t* snapshot, uint8_t held) {
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    for (uint8_t i = 0; i < held && i < MAX_KEYS; i++) {
+        uint8_t row, col;
+        bench_key_position(i, &row, &col);
+
+        snapshot->pressed_keys[i][0] = row;
+        snapshot->pressed_keys[i][1] = col;
+        snapshot->matrix[row] |= 1u << col;
+        snapshot->pressed_keys_count++;
+    }
+}
+
+/**
+ * @brief Release every key tracked in the working matrix state
+ */
+static void bench_reset_keys(void) {
+    memset((void*)&kbd_state, 0, sizeof(kbd_state));
+}
+
+//--------------------------------------------------------------------+
+// FAKE HID ENDPOINT
+//--------------------------------------------------------------------+
+
+static uint32_t endpoint_bytes = 0;
+
+// Always ready, accepts every report (replaces TinyUSB's HID device class)
+bool tud_hid_n_ready(uint8_t instance) {
+    (void) instance;
+    return true;
+}
+
+bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const* report, uint16_t len) {
+    (void) instance;
+    (void) report_id;
+    (void) report;
+    endpoint_bytes += len;
+    return true;
+}
+
+//--------------------------------------------------------------------+
+// BENCHMARKS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Keymap lookup over the whole matrix, per layer
+ */
+static void bench_map_key_to_hid(void) {
+    bench_result_t result;
+    char param[24];
+
+    for (uint8_t layer = 0; layer < KEYMAP_LAYERS; layer++) {
+        uint8_t row = 0, col = 0;
+
+        snprintf(param, sizeof(param), "layer=%u", layer);
+        bench_begin(&result, "map_key_to_hid", param);
+        BENCH_LOOP(&result, {
+            bench_sink += map_key_to_hid(row, col, layer);
+            if (++col == MATRIX_COLS) {
+                col = 0;
+                if (++row == MATRIX_ROWS) row = 0;
+            }
+        });
+        bench_end(&result);
+    }
+}
+
+/**
+ * @brief Full keycode array rebuild with 0..MAX_KEYS keys held
+ */
+static void bench_build_keycode_array(void) {
+    bench_result_t result;
+    matrix_snapshot_t snapshot;
+    char param[24];
+
+    for (uint8_t held = 0; held <= MAX_KEYS; held++) {
+        bench_snapshot(&snapshot, held);
+
+        snprintf(param, sizeof(param), "held=%u", held);
+        bench_begin(&result, "build_keycode_array", param);
+        BENCH_LOOP(&result, {
+            uint8_t keycode[6] = {0};
+            uint8_t modifier = 0;
+            uint16_t consumer_code = 0;
+
+            build_keycode_array(&snapshot, &modifier, keycode, &consumer_code);
+            bench_sink += keycode[0] + modifier + consumer_code;
+        });
+        bench_end(&result);
+    }
+}
+
+/**
+ * @brief Press and release one key while `held` others stay pressed
+ *
+ * One operation is a keyboard_add_key plus a keyboard_remove_key.
+ */
+static void bench_add_remove_key(void) {
+    bench_result_t result;
+    char param[24];
+
+    for (uint8_t held = 0; held < MAX_KEYS; held++) {
+        uint8_t churn_row, churn_col;
+
+        bench_reset_keys();
+        for (uint8_t i = 0; i < held; i++) {
+            uint8_t row, col;
+            bench_key_position(i, &row, &col);
+            keyboard_add_key(row, col);
+        }
+        bench_key_position(held, &churn_row, &churn_col);
+
+        snprintf(param, sizeof(param), "held=%u", held);
+        bench_begin(&result, "keyboard_add_remove_key", param);
+        BENCH_LOOP(&result, {
+            bench_sink += keyboard_add_key(churn_row, churn_col);
+            bench_sink += keyboard_remove_key(churn_row, churn_col);
+        });
+        bench_end(&result);
+    }
+
+    bench_reset_keys();
+}
+
+/**
+ * @brief Quadrature decoding of a continuous CW rotation
+ */
+static void bench_encoder_decode(void) {
+    // CLK/DT levels over one clockwise detent cycle
+    static const uint8_t clk_seq[4] = {1, 0, 0, 1};
+    static const uint8_t dt_seq[4] = {1, 1, 0, 0};
+
+    bench_result_t result;
+    uint8_t last_clk = 1;
+
+    bench_begin(&result, "rotary_encoder_decode", "cw");
+    BENCH_LOOP(&result, {
+        uint8_t clk = clk_seq[i & 3];
+        bench_sink += rotary_encoder_decode(last_clk, clk, dt_seq[i & 3]);
+        last_clk = clk;
+    });
+    bench_end(&result);
+}
+
+/**
+ * @brief HID report encoding and transmission
+ *
+ * "delta": every operation presses or releases one key on top of `held`
+ * others and sends the resulting keyboard report.
+ * "duplicate": every operation publishes an unchanged matrix, which the
+ * report layer suppresses.
+ */
+static void bench_report_encode(void) {
+    bench_result_t result;
+    matrix_snapshot_t base, extra;
+    char param[24];
+
+    for (uint8_t held = 0; held < MAX_KEYS; held++) {
+        bench_snapshot(&base, held);
+        bench_snapshot(&extra, held + 1);
+
+        snprintf(param, sizeof(param), "delta,held=%u", held);
+        bench_begin(&result, "hid_report_keyboard", param);
+        BENCH_LOOP(&result, {
+            hid_report_keyboard_update((i & 1) ? &base : &extra);
+            hid_report_flush();
+        });
+        bench_end(&result);
+    }
+
+    bench_snapshot(&base, MAX_KEYS / 2);
+    hid_report_keyboard_update(&base);
+    hid_report_flush();
+
+    bench_begin(&result, "hid_report_keyboard", "duplicate");
+    BENCH_LOOP(&result, {
+        base.seq = i;
+        hid_report_keyboard_update(&base);
+        hid_report_flush();
+    });
+    bench_end(&result);
+
+    // back to no keys for the next run
+    bench_snapshot(&base, 0);
+    hid_report_keyboard_update(&base);
+    hid_report_flush();
+    bench_sink += endpoint_bytes;
+}
+
+//--------------------------------------------------------------------+
+
+typedef struct {
+    const char* name;
+    void (*fn)(void);
+} bench_entry_t;
+
+static const bench_entry_t benches[] = {
+    {"map_key_to_hid", bench_map_key_to_hid},
+    {"build_keycode_array", bench_build_keycode_array},
+    {"keyboard_add_remove_key", bench_add_remove_key},
+    {"rotary_encoder_decode", bench_encoder_decode},
+    {"hid_report_keyboard", bench_report_encode},
+};
+
+/**
+ * @brief Run every selected benchmark once
+ */
+static void bench_run_all(void) {
+    for (size_t b = 0; b < count_of(benches); b++) {
+        if (bench_selected(benches[b].name)) {
+            benches[b].fn();
+        }
+    }
+}
+
+#if BENCH_HOST
+
+/**
+ * @brief Host entry point
+ *
+ * Usage: bench [-n iterations] [name filter]; iterations below 1 are a
+ * usage error
+ */
+int main(int argc, char** argv) {
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-n") == 0 && a + 1 < argc) {
+            char* end;
+            long iters = strtol(argv[++a], &end, 0);
+
+            // no per-op figures from zero iterations
+            if (*end != '\0' || iters < 1 || iters > (long)(UINT32_MAX - BENCH_BATCH)) {
+                fprintf(stderr, "usage: bench [-n iterations >= 1] [name filter]\n");
+                return 2;
+            }
+            bench_iters = (uint32_t)iters;
+        } else {
+            bench_filter = argv[a];
+        }
+    }
+
+    // whole batches only
+    bench_iters = ((bench_iters + BENCH_BATCH - 1) / BENCH_BATCH) * BENCH_BATCH;
+
+    keymap_init();
+    bench_run_all();
+    return 0;
+}
+
+#else
+
+/**
+ * @brief Pico entry point: run the suite over RTT, forever
+ */
+int main(void) {
+    stdio_init_all();
+    bench_clock_init();
+    keymap_init();
+
+    while (1) {
+        printf("{\"platform\":\"rp2040\",\"clk_sys_hz\":%lu}\n", (unsigned long)clock_get_hz(clk_sys));
+        bench_run_all();
+        sleep_ms(BENCH_REPEAT_MS);
+    }
+}
+
+#endif
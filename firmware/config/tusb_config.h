@@ -90,15 +90,30 @@
 #define CFG_TUD_ENDPOINT0_SIZE    64
 #endif
 
+// Configuration drive, off with ORIONE_CONFIG_DRIVE=OFF (CONFIG_DRIVE_ENABLED=0)
+#ifndef CONFIG_DRIVE_ENABLED
+#define CONFIG_DRIVE_ENABLED      1
+#endif
+
+// picotool reset interface, off with ORIONE_RESET_INTERFACE=OFF (RESET_INTERFACE_ENABLED=0)
+#ifndef RESET_INTERFACE_ENABLED
+#define RESET_INTERFACE_ENABLED   1
+#endif
+
 //------------- CLASS -------------//
-#define CFG_TUD_HID               1
+#define CFG_TUD_HID               2   // keyboard + vendor (trace/diagnostics)
 #define CFG_TUD_CDC               0
-#define CFG_TUD_MSC               0
+#define CFG_TUD_MSC               CONFIG_DRIVE_ENABLED   // configuration drive (src/usb/config_drive)
 #define CFG_TUD_MIDI              0
 #define CFG_TUD_VENDOR            0
 
 // HID buffer size Should be sufficient to hold ID (if any) + Data
-#define CFG_TUD_HID_EP_BUFSIZE    16
+// Shared by all instances: sized for the 64 byte vendor reports, the
+// keyboard endpoint itself stays at HID_KEYBOARD_EP_SIZE
+#define CFG_TUD_HID_EP_BUFSIZE    64
+
+// MSC buffer size, one sector of the configuration drive
+#define CFG_TUD_MSC_EP_BUFSIZE    512
 
 #ifdef __cplusplus
  }
@@ -0,0 +1,408 @@
+/**
+ * @file debounce_harness.c
+ * @brief Debounce algorithm evaluation harness
+ *
+ * Feeds switch waveforms (synthetic profiles or recorded traces) into the
+ * firmware debounce algorithms (src/debounce) on a simulated microsecond
+ * clock, and compares the debounced output with the intended transitions.
+ * For every profile, algorithm and debounce time it reports:
+ * - latency added to detected transitions (p50, p90, p99, max)
+ * - missed presses: intended presses never reported
+ * - phantom presses: reported presses the user did not make
+ *
+ * The simulation delivers every edge to `debounce_edge` and serves the
+ * requested timer at its exact deadline with `debounce_timer`, as the GPIO
+ * interrupt and the debounce alarm do on the keyboard (interrupt latency
+ * and the row scan are not modelled). The current firmware setting is
+ * marked with '*'.
+ *
+ * usage: debounce_harness [options], see `usage()`
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/debounce/debounce.h"
+#include "src/interrupts/interrupts.h"
+
+#include "waveform.h"
+
+//--------------------------------------------------------------------+
+
+#define MAX_TIMES 32
+
+static const uint32_t default_times_us[] = {1000, 2000, 3000, 5000, 8000, 10000};
+
+typedef struct {
+    uint32_t transitions;       // intended transitions
+    uint32_t detected;          // intended transitions reported
+    uint32_t presses;           // intended presses
+    uint32_t missed_presses;
+    uint32_t phantom_presses;
+    uint32_t latency_p50_us;
+    uint32_t latency_p90_us;
+    uint32_t latency_p99_us;
+    uint32_t latency_max_us;
+} evaluation_t;
+
+typedef struct {
+    bool csv;
+    int profile;                // -1 = all
+    int algorithm;              // -1 = all
+    uint32_t times_us[MAX_TIMES];
+    size_t time_count;
+    const char* trace_path;
+    uint32_t settle_us;
+    waveform_params_t params;
+} options_t;
+
+//--------------------------------------------------------------------+
+// SIMULATION
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Run a debounce algorithm over a waveform
+ *
+ * @param edges Raw input edges
+ * @param config Algorithm and debounce time
+ * @param output Debounced transitions
+ */
+static void simulate(const transition_list_t* edges, const debounce_config_t* config, transition_list_t* output) {
+    debounce_t debounce;
+    bool level = false;
+
+    debounce_init(&debounce, false);
+
+    for (size_t i = 0; i <= edges->count; i++) {
+        bool last = (i == edges->count);
+        uint32_t edge_us = last ? 0 : edges->items[i].time_us;
+
+        // timers due before the next edge (all of them after the last edge)
+        while (debounce.timer_armed && (last || (int32_t)(debounce.deadline_us - edge_us) <= 0)) {
+            uint32_t now_us = debounce.deadline_us;
+            uint8_t action = debounce_timer(&debounce, config, now_us, level);
+
+            if (action & DEBOUNCE_CHANGED) {
+                transition_list_push(output, now_us, debounce.stable);
+            }
+        }
+
+        if (last) break;
+
+        level = edges->items[i].pressed;
+        uint8_t action = debounce_edge(&debounce, config, edge_us, level);
+
+        if (action & DEBOUNCE_CHANGED) {
+            transition_list_push(output, edge_us, debounce.stable);
+        }
+    }
+}
+
+//--------------------------------------------------------------------+
+// EVALUATION
+//--------------------------------------------------------------------+
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile of a sorted array
+ */
+static uint32_t percentile(const uint32_t* sorted, size_t count, uint32_t pct) {
+    if (count == 0) return 0;
+
+    size_t rank = (count * pct + 99) / 100;
+    if (rank == 0) rank = 1;
+    return sorted[rank - 1];
+}
+
+/**
+ * @brief Match the debounced output against the intended transitions
+ *
+ * Each intended transition owns the output produced until the next one:
+ * the first output transition to the intended level is a detection (its
+ * delay is the added latency), every other output transition in that
+ * window is spurious. An intended transition with no detection is missed.
+ */
+static void evaluate(const transition_list_t* truth, const transition_list_t* output, evaluation_t* eval) {
+    uint32_t* latencies = malloc((truth->count + 1) * sizeof(uint32_t));
+    size_t latency_count = 0;
+    size_t j = 0;
+
+    memset(eval, 0, sizeof(*eval));
+
+    // output before the first intended transition
+    while (j < output->count && (truth->count == 0 || output->items[j].time_us < truth->items[0].time_us)) {
+        if (output->items[j].pressed) eval->phantom_presses++;
+        j++;
+    }
+
+    for (size_t k = 0; k < truth->count; k++) {
+        const transition_t* intended = &truth->items[k];
+        bool last = (k + 1 == truth->count);
+        uint32_t window_end = last ? 0 : truth->items[k + 1].time_us;
+        bool detected = false;
+
+        eval->transitions++;
+        if (intended->pressed) eval->presses++;
+
+        while (j < output->count && (last || output->items[j].time_us < window_end)) {
+            const transition_t* out = &output->items[j++];
+
+            if (!detected && out->pressed == intended->pressed) {
+                detected = true;
+                latencies[latency_count++] = out->time_us - intended->time_us;
+            } else if (out->pressed) {
+                eval->phantom_presses++;
+            }
+        }
+
+        if (detected) {
+            eval->detected++;
+        } else if (intended->pressed) {
+            eval->missed_presses++;
+        }
+    }
+
+    qsort(latencies, latency_count, sizeof(uint32_t), compare_u32);
+    eval->latency_p50_us = percentile(latencies, latency_count, 50);
+    eval->latency_p90_us = percentile(latencies, latency_count, 90);
+    eval->latency_p99_us = percentile(latencies, latency_count, 99);
+    eval->latency_max_us = latency_count ? latencies[latency_count - 1] : 0;
+
+    free(latencies);
+}
+
+//--------------------------------------------------------------------+
+// OUTPUT
+//--------------------------------------------------------------------+
+
+static bool is_firmware_setting(const debounce_config_t* config) {
+    return config->algorithm == MATRIX_DEBOUNCE_ALGORITHM && config->time_us == MATRIX_DEBOUNCE_TIME;
+}
+
+static void print_header(const options_t* options) {
+    if (options->csv) {
+        printf("profile,algorithm,time_us,transitions,detected,presses,"
+               "latency_p50_us,latency_p90_us,latency_p99_us,latency_max_us,"
+               "missed_presses,phantom_presses\n");
+        return;
+    }
+
+    printf("%-10s %-12s %8s %7s %8s %8s %8s %8s %7s %8s\n",
+           "profile", "algorithm", "time_us", "presses",
+           "p50_us", "p90_us", "p99_us", "max_us", "missed", "phantom");
+}
+
+static void print_result(const options_t* options, const char* profile,
+                         const debounce_config_t* config, const evaluation_t* eval) {
+    const char* algorithm = debounce_algorithm_name(config->algorithm);
+
+    if (options->csv) {
+        printf("%s,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+               profile, algorithm, (unsigned long)config->time_us,
+               (unsigned long)eval->transitions, (unsigned long)eval->detected, (unsigned long)eval->presses,
+               (unsigned long)eval->latency_p50_us, (unsigned long)eval->latency_p90_us,
+               (unsigned long)eval->latency_p99_us, (unsigned long)eval->latency_max_us,
+               (unsigned long)eval->missed_presses, (unsigned long)eval->phantom_presses);
+        return;
+    }
+
+    printf("%-10s %-12s %7lu%c %7lu %8lu %8lu %8lu %8lu %7lu %8lu\n",
+           profile, algorithm, (unsigned long)config->time_us, is_firmware_setting(config) ? '*' : ' ',
+           (unsigned long)eval->presses,
+           (unsigned long)eval->latency_p50_us, (unsigned long)eval->latency_p90_us,
+           (unsigned long)eval->latency_p99_us, (unsigned long)eval->latency_max_us,
+           (unsigned long)eval->missed_presses, (unsigned long)eval->phantom_presses);
+}
+
+/**
+ * @brief Evaluate every selected algorithm and time on one waveform
+ */
+static void run_waveform(const options_t* options, const char* profile, const waveform_t* wave) {
+    for (int a = 0; a < DEBOUNCE_ALGORITHM_COUNT; a++) {
+        if (options->algorithm >= 0 && options->algorithm != a) continue;
+
+        for (size_t t = 0; t < options->time_count; t++) {
+            debounce_config_t config = {
+                .algorithm = (debounce_algorithm_t)a,
+                .time_us = options->times_us[t],
+            };
+            transition_list_t output = {0};
+            evaluation_t eval;
+
+            simulate(&wave->edges, &config, &output);
+            evaluate(&wave->truth, &output, &eval);
+            print_result(options, profile, &config, &eval);
+
+            transition_list_free(&output);
+        }
+    }
+}
+
+//--------------------------------------------------------------------+
+// COMMAND LINE
+//--------------------------------------------------------------------+
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -p, --profile NAME        clean, bounce, chatter, emi or all (default)\n"
+            "  -a, --algorithm NAME      defer, eager, eager_press or all (default)\n"
+            "  -t, --times LIST          debounce times in us, comma separated\n"
+            "  -s, --seed N              random seed of the synthetic waveforms\n"
+            "  -k, --keystrokes N        keystrokes per synthetic waveform\n"
+            "      --press-bounce US     max bounce duration after a press\n"
+            "      --release-bounce US   max bounce duration after a release\n"
+            "      --max-bounces N       max extra edge pairs per bounce\n"
+            "      --fast-tap PCT        share of very short taps\n"
+            "      --chatter PCT         share of holds with a dropout (chatter)\n"
+            "      --emi-interval US     mean time between spikes (emi)\n"
+            "      --trace FILE          evaluate a recorded trace (\"<time_us> <0|1>\" lines)\n"
+            "      --settle US           quiet time ending a burst in a trace (default 20000)\n"
+            "      --csv                 machine-readable output\n",
+            argv0);
+}
+
+static int parse_name(const char* name, const char* (*name_of)(int), int count) {
+    if (strcmp(name, "all") == 0) return -1;
+
+    for (int i = 0; i < count; i++) {
+        if (strcmp(name, name_of(i)) == 0) return i;
+    }
+    return -2;
+}
+
+static const char* profile_name_of(int i) {
+    return waveform_profile_name((waveform_profile_t)i);
+}
+
+static const char* algorithm_name_of(int i) {
+    return debounce_algorithm_name((debounce_algorithm_t)i);
+}
+
+static bool parse_times(const char* list, options_t* options) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", list);
+
+    options->time_count = 0;
+    for (char* tok = strtok(buffer, ","); tok; tok = strtok(NULL, ",")) {
+        if (options->time_count == MAX_TIMES) return false;
+        options->times_us[options->time_count++] = (uint32_t)strtoul(tok, NULL, 0);
+    }
+    return options->time_count > 0;
+}
+
+static bool parse_options(int argc, char** argv, options_t* options) {
+    enum {
+        OPT_PRESS_BOUNCE = 256,
+        OPT_RELEASE_BOUNCE,
+        OPT_MAX_BOUNCES,
+        OPT_FAST_TAP,
+        OPT_CHATTER,
+        OPT_EMI_INTERVAL,
+        OPT_TRACE,
+        OPT_SETTLE,
+        OPT_CSV,
+    };
+
+    static const struct option long_options[] = {
+        {"profile", required_argument, NULL, 'p'},
+        {"algorithm", required_argument, NULL, 'a'},
+        {"times", required_argument, NULL, 't'},
+        {"seed", required_argument, NULL, 's'},
+        {"keystrokes", required_argument, NULL, 'k'},
+        {"press-bounce", required_argument, NULL, OPT_PRESS_BOUNCE},
+        {"release-bounce", required_argument, NULL, OPT_RELEASE_BOUNCE},
+        {"max-bounces", required_argument, NULL, OPT_MAX_BOUNCES},
+        {"fast-tap", required_argument, NULL, OPT_FAST_TAP},
+        {"chatter", required_argument, NULL, OPT_CHATTER},
+        {"emi-interval", required_argument, NULL, OPT_EMI_INTERVAL},
+        {"trace", required_argument, NULL, OPT_TRACE},
+        {"settle", required_argument, NULL, OPT_SETTLE},
+        {"csv", no_argument, NULL, OPT_CSV},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    memset(options, 0, sizeof(*options));
+    options->profile = -1;
+    options->algorithm = -1;
+    options->settle_us = 20000;
+    options->time_count = count_of(default_times_us);
+    memcpy(options->times_us, default_times_us, sizeof(default_times_us));
+    waveform_params_default(&options->params);
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:a:t:s:k:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p':
+                options->profile = parse_name(optarg, profile_name_of, PROFILE_COUNT);
+                if (options->profile == -2) return false;
+                break;
+            case 'a':
+                options->algorithm = parse_name(optarg, algorithm_name_of, DEBOUNCE_ALGORITHM_COUNT);
+                if (options->algorithm == -2) return false;
+                break;
+            case 't':
+                if (!parse_times(optarg, options)) return false;
+                break;
+            case 's': options->params.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'k': options->params.keystrokes = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case OPT_PRESS_BOUNCE: options->params.press_bounce_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case OPT_RELEASE_BOUNCE: options->params.release_bounce_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case OPT_MAX_BOUNCES: options->params.max_bounces = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case OPT_FAST_TAP: options->params.fast_tap_percent = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case OPT_CHATTER: options->params.chatter_percent = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case OPT_EMI_INTERVAL: options->params.emi_interval_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case OPT_TRACE: options->trace_path = optarg; break;
+            case OPT_SETTLE: options->settle_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case OPT_CSV: options->csv = true; break;
+            default: return false;
+        }
+    }
+
+    return optind == argc;
+}
+
+int main(int argc, char** argv) {
+    options_t options;
+
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!options.csv) {
+        printf("firmware: matrix %s %u us, encoder button %s %u us, encoder CLK lockout %u us\n\n",
+               debounce_algorithm_name(MATRIX_DEBOUNCE_ALGORITHM), MATRIX_DEBOUNCE_TIME,
+               debounce_algorithm_name(ENCODER_BTN_DEBOUNCE_ALGORITHM), ENCODER_BTN_DEBOUNCE_TIME,
+               ENCODER_CLK_DEBOUNCE_TIME);
+    }
+    print_header(&options);
+
+    if (options.trace_path) {
+        waveform_t wave;
+
+        if (!waveform_load_trace(&wave, options.trace_path, options.settle_us)) return 1;
+        run_waveform(&options, "trace", &wave);
+        waveform_free(&wave);
+        return 0;
+    }
+
+    for (int p = 0; p < PROFILE_COUNT; p++) {
+        if (options.profile >= 0 && options.profile != p) continue;
+
+        waveform_t wave;
+        waveform_generate(&wave, (waveform_profile_t)p, &options.params);
+        run_waveform(&options, waveform_profile_name((waveform_profile_t)p), &wave);
+        waveform_free(&wave);
+    }
+
+    return 0;
+}
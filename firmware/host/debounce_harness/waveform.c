@@ -0,0 +1,320 @@
+/**
+ * @file waveform.c
+ * @brief Switch waveform generation and loading for the debounce harness
+ *
+ * Synthetic waveforms follow a random typing pattern (mostly normal
+ * keystrokes, some very short taps) on a microsecond timeline:
+ * - contact bounce: after each intended edge, a random number of extra
+ *   edge pairs within a random fraction of the maximum bounce duration,
+ *   the usual shape of a metal leaf contact such as Gateron switches
+ * - chatter: some holds get a brief dropout, as with a worn or dirty
+ *   contact; the truth keeps the key pressed
+ * - EMI: short spikes of the opposite level at random times, away from
+ *   real edges; the truth ignores them
+ *
+ * Recorded traces are text files with one edge per line, "<time_us> <0|1>"
+ * (1 = pressed, '#' starts a comment), e.g. exported from a logic analyzer.
+ * Their truth is taken from a reference filter: edges closer than the
+ * settle time form one burst, and a burst whose final level differs from
+ * the previous one is an intended transition at the time of its first edge.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "waveform.h"
+
+//--------------------------------------------------------------------+
+
+#define WAVE_START_US 10000u
+
+// Normal keystroke and fast tap hold times, gap between keystrokes
+#define HOLD_MIN_US 30000u
+#define HOLD_MAX_US 150000u
+#define FAST_TAP_MIN_US 4000u
+#define FAST_TAP_MAX_US 12000u
+#define GAP_MIN_US 15000u
+#define GAP_MAX_US 250000u
+
+// Chatter dropout and EMI spike widths
+#define DROPOUT_MIN_US 50u
+#define DROPOUT_MAX_US 600u
+#define SPIKE_MIN_US 1u
+#define SPIKE_MAX_US 30u
+#define SPIKE_CLEARANCE_US 200u   // minimum distance between a spike and a real edge
+
+static uint32_t rng_state = 1;
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+static uint32_t rng_next(void) {
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/**
+ * @brief Uniform random value in [min, max]
+ */
+static uint32_t rng_range(uint32_t min, uint32_t max) {
+    if (max <= min) return min;
+    return min + rng_next() % (max - min + 1);
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_transition(const void* a, const void* b) {
+    const transition_t* x = a;
+    const transition_t* y = b;
+    return (x->time_us > y->time_us) - (x->time_us < y->time_us);
+}
+
+/**
+ * @brief Add an intended edge followed by its contact bounce
+ */
+static void push_bounced_edge(transition_list_t* edges, uint32_t time_us, bool pressed,
+                              uint32_t max_bounce_us, uint32_t max_bounces) {
+    transition_list_push(edges, time_us, pressed);
+
+    uint32_t pairs = (max_bounce_us > 0) ? rng_range(0, max_bounces) : 0;
+    if (pairs == 0) return;
+
+    // bounce lasts between a quarter of and the full maximum duration
+    uint32_t duration_us = rng_range(max_bounce_us / 4, max_bounce_us);
+    uint32_t offsets[2 * 32];
+    if (pairs > 32) pairs = 32;
+
+    for (uint32_t i = 0; i < 2 * pairs; i++) {
+        offsets[i] = rng_range(1, duration_us);
+    }
+    qsort(offsets, 2 * pairs, sizeof(offsets[0]), compare_u32);
+
+    for (uint32_t i = 0; i < 2 * pairs; i++) {
+        // away from the intended level first, back to it last
+        bool level = (i % 2 == 0) ? !pressed : pressed;
+        transition_list_push(edges, time_us + offsets[i] + i, level);
+    }
+}
+
+/**
+ * @brief Level of the waveform just after `time_us`
+ *
+ * @param index Set to the index of the first edge after `time_us`
+ */
+static bool level_at(const transition_list_t* edges, uint32_t time_us, size_t* index) {
+    bool level = false;
+    size_t i = 0;
+
+    while (i < edges->count && edges->items[i].time_us <= time_us) {
+        level = edges->items[i].pressed;
+        i++;
+    }
+    *index = i;
+    return level;
+}
+
+/**
+ * @brief Overlay short opposite-level spikes away from real edges
+ */
+static void add_emi_spikes(transition_list_t* edges, uint32_t end_us, uint32_t interval_us) {
+    transition_list_t spikes = {0};
+    uint32_t t = WAVE_START_US;
+
+    while (interval_us > 0) {
+        t += rng_range(1, 2 * interval_us);
+        if (t >= end_us) break;
+
+        uint32_t width = rng_range(SPIKE_MIN_US, SPIKE_MAX_US);
+        size_t next;
+        bool level = level_at(edges, t, &next);
+
+        bool clear_before = next == 0 || edges->items[next - 1].time_us + SPIKE_CLEARANCE_US < t;
+        bool clear_after = next == edges->count || edges->items[next].time_us > t + width + SPIKE_CLEARANCE_US;
+        if (!clear_before || !clear_after) continue;
+
+        transition_list_push(&spikes, t, !level);
+        transition_list_push(&spikes, t + width, level);
+    }
+
+    for (size_t i = 0; i < spikes.count; i++) {
+        transition_list_push(edges, spikes.items[i].time_us, spikes.items[i].pressed);
+    }
+    transition_list_free(&spikes);
+
+    qsort(edges->items, edges->count, sizeof(edges->items[0]), compare_transition);
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+void transition_list_push(transition_list_t* list, uint32_t time_us, bool pressed) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 256;
+        list->items = realloc(list->items, list->capacity * sizeof(list->items[0]));
+        if (!list->items) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    list->items[list->count].time_us = time_us;
+    list->items[list->count].pressed = pressed;
+    list->count++;
+}
+
+void transition_list_free(transition_list_t* list) {
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+void waveform_free(waveform_t* wave) {
+    transition_list_free(&wave->edges);
+    transition_list_free(&wave->truth);
+}
+
+/**
+ * @brief Default generation parameters
+ */
+void waveform_params_default(waveform_params_t* params) {
+    params->seed = 1;
+    params->keystrokes = 2000;
+    params->press_bounce_us = 1500;
+    params->release_bounce_us = 800;
+    params->max_bounces = 6;
+    params->fast_tap_percent = 5;
+    params->chatter_percent = 20;
+    params->emi_interval_us = 20000;
+}
+
+const char* waveform_profile_name(waveform_profile_t profile) {
+    switch (profile) {
+        case PROFILE_CLEAN: return "clean";
+        case PROFILE_BOUNCE: return "bounce";
+        case PROFILE_CHATTER: return "chatter";
+        case PROFILE_EMI: return "emi";
+        default: return "?";
+    }
+}
+
+/**
+ * @brief Generate a synthetic waveform
+ *
+ * @param wave Output waveform (free with `waveform_free`)
+ * @param profile Kind of disturbance
+ * @param params Generation parameters, the seed makes runs reproducible
+ */
+void waveform_generate(waveform_t* wave, waveform_profile_t profile, const waveform_params_t* params) {
+    memset(wave, 0, sizeof(*wave));
+    rng_state = params->seed ? params->seed : 1;
+
+    bool bounce = (profile == PROFILE_BOUNCE || profile == PROFILE_CHATTER);
+    uint32_t press_bounce_us = bounce ? params->press_bounce_us : 0;
+    uint32_t release_bounce_us = bounce ? params->release_bounce_us : 0;
+    uint32_t t = WAVE_START_US;
+
+    for (uint32_t k = 0; k < params->keystrokes; k++) {
+        bool fast_tap = rng_range(0, 99) < params->fast_tap_percent;
+        uint32_t hold = fast_tap ? rng_range(FAST_TAP_MIN_US, FAST_TAP_MAX_US)
+                                 : rng_range(HOLD_MIN_US, HOLD_MAX_US);
+        uint32_t release_at = t + hold;
+
+        // press
+        transition_list_push(&wave->truth, t, true);
+        push_bounced_edge(&wave->edges, t, true, press_bounce_us, params->max_bounces);
+
+        // dropout while held, well clear of both bounces
+        if (profile == PROFILE_CHATTER && !fast_tap && rng_range(0, 99) < params->chatter_percent) {
+            uint32_t width = rng_range(DROPOUT_MIN_US, DROPOUT_MAX_US);
+            uint32_t earliest = t + press_bounce_us + 2000;
+            uint32_t latest = release_at - width - 2000;
+
+            if (latest > earliest) {
+                uint32_t at = rng_range(earliest, latest);
+                transition_list_push(&wave->edges, at, false);
+                transition_list_push(&wave->edges, at + width, true);
+            }
+        }
+
+        // release
+        transition_list_push(&wave->truth, release_at, false);
+        push_bounced_edge(&wave->edges, release_at, false, release_bounce_us, params->max_bounces);
+
+        t = release_at + release_bounce_us + rng_range(GAP_MIN_US, GAP_MAX_US);
+    }
+
+    qsort(wave->edges.items, wave->edges.count, sizeof(wave->edges.items[0]), compare_transition);
+
+    if (profile == PROFILE_EMI) {
+        add_emi_spikes(&wave->edges, t, params->emi_interval_us);
+    }
+}
+
+/**
+ * @brief Load a recorded trace and derive its truth
+ *
+ * @param wave Output waveform (free with `waveform_free`)
+ * @param path Trace file, one "<time_us> <0|1>" edge per line
+ * @param settle_us Quiet time that ends a burst of edges
+ * @return False if the file cannot be read or holds no edges
+ */
+bool waveform_load_trace(waveform_t* wave, const char* path, uint32_t settle_us) {
+    memset(wave, 0, sizeof(*wave));
+
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        // accept "time level" and "time,level"
+        for (char* c = line; *c; c++) {
+            if (*c == ',') *c = ' ';
+        }
+
+        unsigned long time_us, level;
+        if (sscanf(line, "%lu %lu", &time_us, &level) == 2) {
+            transition_list_push(&wave->edges, (uint32_t)time_us, level != 0);
+        }
+    }
+    fclose(f);
+
+    if (wave->edges.count == 0) {
+        fprintf(stderr, "%s: no edges\n", path);
+        return false;
+    }
+
+    qsort(wave->edges.items, wave->edges.count, sizeof(wave->edges.items[0]), compare_transition);
+
+    // reference filter: bursts separated by settle_us of quiet
+    bool settled = false;
+    size_t burst_start = 0;
+
+    for (size_t i = 0; i < wave->edges.count; i++) {
+        bool last_in_burst = (i + 1 == wave->edges.count) ||
+                             (wave->edges.items[i + 1].time_us - wave->edges.items[i].time_us >= settle_us);
+        if (!last_in_burst) continue;
+
+        bool level = wave->edges.items[i].pressed;
+        if (level != settled) {
+            transition_list_push(&wave->truth, wave->edges.items[burst_start].time_us, level);
+            settled = level;
+        }
+        burst_start = i + 1;
+    }
+
+    return true;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file waveform.h
+ * @brief Switch waveform generation and loading for the debounce harness
+ *
+ * A waveform is the list of raw edges seen on one input, plus the "truth":
+ * the transitions the user actually intended. Synthetic waveforms are
+ * generated from a typing pattern with parameterised contact bounce,
+ * chatter and EMI spikes; recorded traces get their truth from a long
+ * settle-time reference.
+ */
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    // One level change, true = pressed
+    typedef struct {
+        uint32_t time_us;
+        bool pressed;
+    } transition_t;
+
+    typedef struct {
+        transition_t* items;
+        size_t count;
+        size_t capacity;
+    } transition_list_t;
+
+    typedef struct {
+        transition_list_t edges;    // raw input edges
+        transition_list_t truth;    // intended presses/releases
+    } waveform_t;
+
+    typedef enum {
+        PROFILE_CLEAN = 0,          // ideal switch, no bounce
+        PROFILE_BOUNCE,             // contact bounce on press and release
+        PROFILE_CHATTER,            // bounce plus dropouts while held (worn switch)
+        PROFILE_EMI,                // clean edges plus short spikes
+        PROFILE_COUNT
+    } waveform_profile_t;
+
+    typedef struct {
+        uint32_t seed;
+        uint32_t keystrokes;            // number of presses generated
+        uint32_t press_bounce_us;       // max bounce duration after a press
+        uint32_t release_bounce_us;     // max bounce duration after a release
+        uint32_t max_bounces;           // max extra edge pairs per bounce
+        uint32_t fast_tap_percent;      // share of very short taps
+        uint32_t chatter_percent;       // share of holds with a dropout
+        uint32_t emi_interval_us;       // mean time between spikes
+    } waveform_params_t;
+
+    void waveform_params_default(waveform_params_t* params);
+    const char* waveform_profile_name(waveform_profile_t profile);
+
+    void waveform_generate(waveform_t* wave, waveform_profile_t profile, const waveform_params_t* params);
+    bool waveform_load_trace(waveform_t* wave, const char* path, uint32_t settle_us);
+    void waveform_free(waveform_t* wave);
+
+    void transition_list_push(transition_list_t* list, uint32_t time_us, bool pressed);
+    void transition_list_free(transition_list_t* list);
+
+#endif /* WAVEFORM_H */
@@ -0,0 +1,467 @@
+/**
+ * @file orione_ctl.c
+ * @brief Live settings tool (Linux)
+ *
+ * Dumps and uploads the live settings of the keyboard (src/settings) over
+ * the vendor interface: the layers and encoder bindings of every profile,
+ * the profile report mode and debounce settings, and the tap dances. An
+ * upload takes effect at once, without rebuilding or flashing; `save`
+ * keeps it over power cycles and `defaults` goes back to the compiled
+ * keymap. `bootloader` resets the keyboard into BOOTSEL mode for
+ * reflashing and `reboot` restarts the firmware, both once no key is held.
+ * Works on the keyboard (hidraw) and on the stand-in device of
+ * host/sim_device (-d sim:<socket>).
+ *
+ * Settings file (text, '#' comments), as written by `dump`:
+ *   layout <profiles> <layers> <rows> <cols> <tap dances>
+ *   region <name>
+ *   <16-bit hex words, little endian, any line breaks>
+ * Regions: keymap (keycodes [profile][layer][row][col], one matrix row
+ * per line), encoders (cw ccw press), profiles (report mode | algorithm
+ * << 8, adaptive, debounce time low, high) and tap dances (key, modifier
+ * of single, double, triple, hold, then tap ms, hold ms). A file may omit
+ * regions, they keep their live values; its layout must match the
+ * firmware's.
+ *
+ * usage:
+ *   orione_ctl [-d /dev/hidrawN|sim:path] info
+ *   orione_ctl [-d ...] dump [out.txt]
+ *   orione_ctl [-d ...] upload [-s] in.txt      (-s: then save)
+ *   orione_ctl [-d ...] save | defaults
+ *   orione_ctl [-d ...] profile [index]
+ *   orione_ctl [-d ...] bootloader | reboot
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/settings/settings.h"
+#include "orione_hid/orione_hid.h"
+
+//--------------------------------------------------------------------+
+
+#define LINE_LEN 512
+
+static const char* const region_names[SETTINGS_REGION_COUNT] = {
+    [SETTINGS_REGION_KEYMAP] = "keymap",
+    [SETTINGS_REGION_ENCODERS] = "encoders",
+    [SETTINGS_REGION_PROFILES] = "profiles",
+    [SETTINGS_REGION_TAP_DANCES] = "tap_dances",
+};
+
+// Words per line of each region in a dump
+static const uint8_t region_line_words[SETTINGS_REGION_COUNT] = {
+    [SETTINGS_REGION_KEYMAP] = MATRIX_COLS,
+    [SETTINGS_REGION_ENCODERS] = sizeof(keymap_encoder_t) / 2,
+    [SETTINGS_REGION_PROFILES] = sizeof(settings_profile_t) / 2,
+    [SETTINGS_REGION_TAP_DANCES] = sizeof(tap_dance_t) / 2,
+};
+
+_Static_assert(sizeof(settings_record_t) % 2 == 0, "settings not made of 16-bit words");
+
+static const char* status_names[] = {
+    [SETTINGS_OK] = "ok",
+    [SETTINGS_ERR_REGION] = "write outside a region",
+    [SETTINGS_ERR_VALUE] = "invalid value",
+    [SETTINGS_ERR_FLASH] = "flash write failed",
+};
+
+// Settings of a device, or of a file
+typedef struct {
+    vendor_settings_info_t info;
+    uint8_t region[SETTINGS_REGION_COUNT][sizeof(settings_record_t)];
+    bool present[SETTINGS_REGION_COUNT];    // region read from the file
+} settings_image_t;
+
+static const char* device = NULL;
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+static double elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static bool open_device(orione_hid_t* dev) {
+    if (orione_hid_open(dev, device)) return true;
+
+    if (!device) {
+        fprintf(stderr, "keyboard vendor interface not found, use -d\n");
+    } else {
+        perror(device);
+    }
+    return false;
+}
+
+/**
+ * @brief Read the layout and check this tool was built for it
+ */
+static bool read_info(orione_hid_t* dev, vendor_settings_info_t* info) {
+    if (!orione_hid_settings_info(dev, info)) {
+        fprintf(stderr, "no answer from the keyboard\n");
+        return false;
+    }
+    if (info->version != SETTINGS_VERSION || info->region_count != SETTINGS_REGION_COUNT) {
+        fprintf(stderr, "settings version %u, this tool speaks %u\n", info->version, SETTINGS_VERSION);
+        return false;
+    }
+    for (uint8_t i = 0; i < SETTINGS_REGION_COUNT; i++) {
+        if (info->region_size[i] > sizeof(settings_record_t)) {
+            fprintf(stderr, "region %s too large (%u bytes)\n", region_names[i], info->region_size[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool print_status(const char* what, const vendor_settings_status_t* status) {
+    if (status->status == SETTINGS_OK) return true;
+
+    const char* reason = (status->status < sizeof(status_names) / sizeof(status_names[0]))
+        ? status_names[status->status] : "?";
+    fprintf(stderr, "%s failed: %s", what, reason);
+    if (status->region < SETTINGS_REGION_COUNT) {
+        fprintf(stderr, " in %s at byte %u", region_names[status->region], status->offset);
+    }
+    fprintf(stderr, "\n");
+    return false;
+}
+
+/**
+ * @brief Write the settings in the text format
+ */
+static void write_settings(FILE* out, const settings_image_t* image) {
+    const vendor_settings_info_t* info = &image->info;
+
+    fprintf(out, "# orione settings, keymap source %08x\n", (unsigned)info->keymap_hash);
+    fprintf(out, "layout %u %u %u %u %u\n", info->profiles, info->layers, info->rows, info->cols, info->tap_dances);
+
+    for (uint8_t r = 0; r < SETTINGS_REGION_COUNT; r++) {
+        uint16_t words = info->region_size[r] / 2;
+        uint8_t per_line = region_line_words[r];
+
+        fprintf(out, "\nregion %s\n", region_names[r]);
+        for (uint16_t i = 0; i < words; i++) {
+            if (r == SETTINGS_REGION_KEYMAP && i % (info->rows * info->cols) == 0) {
+                unsigned layer = i / (info->rows * info->cols);
+                fprintf(out, "# profile %u layer %u\n", layer / info->layers, layer % info->layers);
+            }
+
+            uint16_t word = image->region[r][2 * i] | (image->region[r][2 * i + 1] << 8);
+            fprintf(out, "%04x%s", word, ((i + 1) % per_line == 0 || i + 1 == words) ? "\n" : " ");
+        }
+    }
+}
+
+/**
+ * @brief Read a settings file
+ *
+ * @param image Layout to match in `info`, regions filled
+ * @return False with a message on a syntax or layout error
+ */
+static bool read_settings(FILE* in, const char* path, settings_image_t* image) {
+    const vendor_settings_info_t* info = &image->info;
+    char line[LINE_LEN];
+    unsigned line_no = 0;
+    int region = -1;
+    uint16_t filled[SETTINGS_REGION_COUNT] = {0};
+    bool have_layout = false;
+
+    while (fgets(line, sizeof(line), in)) {
+        line_no++;
+
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char* token = strtok(line, " \t\r\n");
+        if (!token) continue;
+
+        if (strcmp(token, "layout") == 0) {
+            unsigned v[5] = {0};
+            for (int i = 0; i < 5; i++) {
+                char* field = strtok(NULL, " \t\r\n");
+                if (!field) break;
+                v[i] = (unsigned)strtoul(field, NULL, 10);
+            }
+            if (v[0] != info->profiles || v[1] != info->layers || v[2] != info->rows
+                    || v[3] != info->cols || v[4] != info->tap_dances) {
+                fprintf(stderr, "%s:%u: layout %u %u %u %u %u, the keyboard has %u %u %u %u %u\n", path, line_no,
+                        v[0], v[1], v[2], v[3], v[4],
+                        info->profiles, info->layers, info->rows, info->cols, info->tap_dances);
+                return false;
+            }
+            have_layout = true;
+            continue;
+        }
+
+        if (strcmp(token, "region") == 0) {
+            char* name = strtok(NULL, " \t\r\n");
+            region = -1;
+            for (int r = 0; name && r < SETTINGS_REGION_COUNT; r++) {
+                if (strcmp(name, region_names[r]) == 0) region = r;
+            }
+            if (region < 0) {
+                fprintf(stderr, "%s:%u: unknown region %s\n", path, line_no, name ? name : "");
+                return false;
+            }
+            image->present[region] = true;
+            continue;
+        }
+
+        if (!have_layout || region < 0) {
+            fprintf(stderr, "%s:%u: data before the layout and region lines\n", path, line_no);
+            return false;
+        }
+
+        for (; token; token = strtok(NULL, " \t\r\n")) {
+            char* end;
+            unsigned long word = strtoul(token, &end, 16);
+            if (*end != '\0' || word > 0xFFFF) {
+                fprintf(stderr, "%s:%u: bad word %s\n", path, line_no, token);
+                return false;
+            }
+            if (filled[region] + 2 > info->region_size[region]) {
+                fprintf(stderr, "%s:%u: region %s longer than %u bytes\n", path, line_no,
+                        region_names[region], info->region_size[region]);
+                return false;
+            }
+            image->region[region][filled[region]++] = word & 0xFF;
+            image->region[region][filled[region]++] = word >> 8;
+        }
+    }
+
+    for (uint8_t r = 0; r < SETTINGS_REGION_COUNT; r++) {
+        if (image->present[r] && filled[r] != info->region_size[r]) {
+            fprintf(stderr, "%s: region %s has %u bytes, expected %u\n", path, region_names[r],
+                    filled[r], info->region_size[r]);
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------+
+// COMMANDS
+//--------------------------------------------------------------------+
+
+static int info(orione_hid_t* dev, int argc, char** argv) {
+    vendor_settings_info_t info;
+    (void) argv;
+
+    if (argc != 1) {
+        fprintf(stderr, "usage: orione_ctl info\n");
+        return 2;
+    }
+    if (!read_info(dev, &info)) return 1;
+
+    printf("settings version %u, keymap source %08x, %s\n", info.version, (unsigned)info.keymap_hash,
+           info.loaded ? "saved settings loaded" : "compiled settings");
+    printf("%u profiles, %u layers of %ux%u keys, Fn at %u,%u, %u tap dances\n", info.profiles, info.layers,
+           info.rows, info.cols, info.fn_row, info.fn_col, info.tap_dances);
+    for (uint8_t r = 0; r < SETTINGS_REGION_COUNT; r++) {
+        printf("region %-10s %5u bytes\n", region_names[r], info.region_size[r]);
+    }
+    return 0;
+}
+
+static int dump(orione_hid_t* dev, int argc, char** argv) {
+    static settings_image_t image;
+    struct timespec start;
+
+    if (argc > 2) {
+        fprintf(stderr, "usage: orione_ctl dump [out.txt]\n");
+        return 2;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!read_info(dev, &image.info)) return 1;
+
+    for (uint8_t r = 0; r < SETTINGS_REGION_COUNT; r++) {
+        if (!orione_hid_settings_read(dev, r, image.region[r], image.info.region_size[r])) {
+            fprintf(stderr, "reading region %s failed\n", region_names[r]);
+            return 1;
+        }
+    }
+    double ms = elapsed_ms(&start);
+
+    FILE* out = (argc == 2) ? fopen(argv[1], "w") : stdout;
+    if (!out) {
+        perror(argv[1]);
+        return 1;
+    }
+    write_settings(out, &image);
+    if (out != stdout) fclose(out);
+
+    fprintf(stderr, "read in %.1f ms\n", ms);
+    return 0;
+}
+
+static int upload(orione_hid_t* dev, int argc, char** argv) {
+    static settings_image_t image;
+    vendor_settings_status_t status;
+    struct timespec start;
+    bool save = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s")) != -1) {
+        switch (opt) {
+            case 's': save = true; break;
+            default: return 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, "usage: orione_ctl upload [-s] in.txt\n");
+        return 2;
+    }
+
+    const char* path = argv[optind];
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool parsed = read_info(dev, &image.info) && read_settings(in, path, &image);
+    fclose(in);
+    if (!parsed) return 1;
+
+    // staged back to back, applied together by the commit
+    for (uint8_t r = 0; r < SETTINGS_REGION_COUNT; r++) {
+        if (image.present[r] && !orione_hid_settings_write(dev, r, image.region[r], image.info.region_size[r])) {
+            perror("write");
+            return 1;
+        }
+    }
+    if (!orione_hid_settings_command(dev, VENDOR_CMD_SETTINGS_COMMIT, &status)) {
+        fprintf(stderr, "no answer from the keyboard\n");
+        return 1;
+    }
+    if (!print_status("commit", &status)) return 1;
+
+    if (save) {
+        if (!orione_hid_settings_command(dev, VENDOR_CMD_SETTINGS_SAVE, &status)) {
+            fprintf(stderr, "no answer from the keyboard\n");
+            return 1;
+        }
+        if (!print_status("save", &status)) return 1;
+    }
+
+    fprintf(stderr, "applied%s in %.1f ms\n", save ? " and saved" : "", elapsed_ms(&start));
+    return 0;
+}
+
+static int settings_command(orione_hid_t* dev, int argc, char** argv) {
+    vendor_settings_status_t status;
+    bool save = strcmp(argv[0], "save") == 0;
+
+    if (argc != 1) {
+        fprintf(stderr, "usage: orione_ctl %s\n", argv[0]);
+        return 2;
+    }
+
+    uint8_t cmd = save ? VENDOR_CMD_SETTINGS_SAVE : VENDOR_CMD_SETTINGS_DEFAULTS;
+    if (!orione_hid_settings_command(dev, cmd, &status)) {
+        fprintf(stderr, "no answer from the keyboard\n");
+        return 1;
+    }
+    return print_status(argv[0], &status) ? 0 : 1;
+}
+
+static int profile(orione_hid_t* dev, int argc, char** argv) {
+    uint8_t index, count;
+    char name[VENDOR_REPORT_SIZE];
+
+    if (argc > 2) {
+        fprintf(stderr, "usage: orione_ctl profile [index]\n");
+        return 2;
+    }
+
+    int select = (argc == 2) ? atoi(argv[1]) : -1;
+    if (!orione_hid_profile(dev, select, &index, &count, name, sizeof(name))) {
+        fprintf(stderr, "no answer from the keyboard\n");
+        return 1;
+    }
+
+    printf("profile %u of %u: %s\n", index, count, name);
+    return (select < 0 || select == index) ? 0 : 1;
+}
+
+static int reboot(orione_hid_t* dev, int argc, char** argv) {
+    bool bootloader = strcmp(argv[0], "bootloader") == 0;
+
+    if (argc != 1) {
+        fprintf(stderr, "usage: orione_ctl %s\n", argv[0]);
+        return 2;
+    }
+
+    // no answer: the keyboard drops off the bus
+    if (!orione_hid_command(dev, VENDOR_CMD_REBOOT, bootloader ? REBOOT_BOOTLOADER : REBOOT_FIRMWARE)) {
+        fprintf(stderr, "cannot send to the keyboard\n");
+        return 1;
+    }
+
+    fprintf(stderr, "%s requested, the keyboard resets once no key is held\n", argv[0]);
+    return 0;
+}
+
+//--------------------------------------------------------------------+
+
+int main(int argc, char** argv) {
+    static const struct {
+        const char* name;
+        int (*run)(orione_hid_t* dev, int argc, char** argv);
+    } commands[] = {
+        {"info", info},
+        {"dump", dump},
+        {"upload", upload},
+        {"save", settings_command},
+        {"defaults", settings_command},
+        {"profile", profile},
+        {"bootloader", reboot},
+        {"reboot", reboot},
+    };
+    int opt;
+
+    // options up to the command, the command parses its own
+    while ((opt = getopt(argc, argv, "+d:")) != -1) {
+        switch (opt) {
+            case 'd': device = optarg; break;
+            default: return 2;
+        }
+    }
+
+    for (size_t i = 0; optind < argc && i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (strcmp(argv[optind], commands[i].name) != 0) continue;
+
+        orione_hid_t dev;
+        if (!open_device(&dev)) return 1;
+
+        int cmd_argc = argc - optind;
+        char** cmd_argv = argv + optind;
+        optind = 1;
+
+        int rc = commands[i].run(&dev, cmd_argc, cmd_argv);
+        orione_hid_close(&dev);
+        return rc;
+    }
+
+    fprintf(stderr,
+            "usage: %s [-d /dev/hidrawN|sim:path] <command>\n"
+            "  info                  settings layout of the firmware\n"
+            "  dump [out.txt]        write the live settings\n"
+            "  upload [-s] in.txt    apply a settings file at once (-s: then save to flash)\n"
+            "  save                  keep the live settings over power cycles\n"
+            "  defaults              go back to the compiled keymap (until the next boot unless saved)\n"
+            "  profile [index]       print, or select, the active profile\n"
+            "  bootloader            reset into BOOTSEL mode (USB drive and picotool)\n"
+            "  reboot                restart the firmware\n",
+            argv[0]);
+    return 2;
+}
@@ -0,0 +1,412 @@
+/**
+ * @file orione_hid.c
+ * @brief Host access to the keyboard vendor interface (Linux)
+ *
+ * hidraw carries the reports as they are, with a report ID byte in front
+ * of the writes (0: the vendor interface has no report IDs) and feature
+ * reports through ioctls. The stand-in device socket carries the same
+ * reports behind a message kind byte; IN packets arriving while a
+ * feature report is awaited on it are dropped.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <linux/hidraw.h>
+
+#include "orione_hid.h"
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Send one message to the stand-in device
+ */
+static bool sim_send(orione_hid_t* dev, uint8_t kind, const uint8_t* report, size_t len) {
+    uint8_t msg[ORIONE_SIM_MSG_SIZE] = {0};
+
+    msg[0] = kind;
+    memcpy(&msg[1], report, (len < VENDOR_REPORT_SIZE) ? len : VENDOR_REPORT_SIZE);
+    return send(dev->fd, msg, sizeof(msg), 0) == (ssize_t)sizeof(msg);
+}
+
+/**
+ * @brief Receive one message of a kind from the stand-in device
+ *
+ * @return 1 with the report, 0 on timeout, -1 on error
+ */
+static int sim_receive(orione_hid_t* dev, uint8_t kind, uint8_t* report, int timeout_ms) {
+    struct pollfd pfd = {.fd = dev->fd, .events = POLLIN};
+    uint8_t msg[ORIONE_SIM_MSG_SIZE];
+
+    for (;;) {
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return ready;
+
+        ssize_t n = recv(dev->fd, msg, sizeof(msg), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        if (n != (ssize_t)sizeof(msg) || msg[0] != kind) continue;
+
+        memcpy(report, &msg[1], VENDOR_REPORT_SIZE);
+        return 1;
+    }
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Find the keyboard's vendor hidraw node
+ *
+ * Matches the USB vendor ID and a report descriptor starting with the
+ * vendor usage page (06 00 FF), which only the vendor interface has.
+ */
+bool orione_hid_find(char* path, size_t size) {
+    DIR* dir = opendir("/sys/class/hidraw");
+    if (!dir) return false;
+
+    struct dirent* entry;
+    bool found = false;
+
+    while (!found && (entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "hidraw", 6) != 0) continue;
+
+        char sys_path[512];
+        char line[256];
+        unsigned bus = 0, vid = 0, pid = 0;
+
+        snprintf(sys_path, sizeof(sys_path), "/sys/class/hidraw/%s/device/uevent", entry->d_name);
+        FILE* f = fopen(sys_path, "r");
+        if (!f) continue;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "HID_ID=%x:%x:%x", &bus, &vid, &pid) == 3) break;
+        }
+        fclose(f);
+        if (vid != ORIONE_HID_VID) continue;
+
+        uint8_t desc[3] = {0};
+        snprintf(sys_path, sizeof(sys_path), "/sys/class/hidraw/%s/device/report_descriptor", entry->d_name);
+        f = fopen(sys_path, "rb");
+        if (!f) continue;
+        size_t n = fread(desc, 1, sizeof(desc), f);
+        fclose(f);
+
+        if (n == 3 && desc[0] == 0x06 && desc[1] == 0x00 && desc[2] == 0xFF) {
+            snprintf(path, size, "/dev/%s", entry->d_name);
+            found = true;
+        }
+    }
+
+    closedir(dir);
+    return found;
+}
+
+/**
+ * @brief Open the vendor interface
+ *
+ * @param path hidraw node, "sim:<socket>" for the stand-in device, or
+ *             NULL to find the keyboard
+ * @return False with errno set (ENODEV: no keyboard found)
+ */
+bool orione_hid_open(orione_hid_t* dev, const char* path) {
+    char found[64];
+
+    dev->fd = -1;
+    dev->sim = false;
+
+    if (!path) {
+        if (!orione_hid_find(found, sizeof(found))) {
+            errno = ENODEV;
+            return false;
+        }
+        path = found;
+    }
+
+    size_t prefix = strlen(ORIONE_HID_SIM_PREFIX);
+    if (strncmp(path, ORIONE_HID_SIM_PREFIX, prefix) == 0) {
+        struct sockaddr_un addr = {.sun_family = AF_UNIX};
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path + prefix);
+
+        dev->fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        if (dev->fd < 0) return false;
+        if (connect(dev->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            int err = errno;
+            close(dev->fd);
+            dev->fd = -1;
+            errno = err;
+            return false;
+        }
+        dev->sim = true;
+        return true;
+    }
+
+    dev->fd = open(path, O_RDWR);
+    return dev->fd >= 0;
+}
+
+void orione_hid_close(orione_hid_t* dev) {
+    if (dev->fd >= 0) close(dev->fd);
+    dev->fd = -1;
+}
+
+/**
+ * @brief Send an OUT report, zero padded to the report size
+ */
+bool orione_hid_send(orione_hid_t* dev, const uint8_t* report, size_t len) {
+    if (len > VENDOR_REPORT_SIZE) len = VENDOR_REPORT_SIZE;
+    if (dev->sim) return sim_send(dev, ORIONE_SIM_OUT, report, len);
+
+    // hidraw: byte 0 is the report ID, 0 for a device without report IDs
+    uint8_t buf[1 + VENDOR_REPORT_SIZE] = {0};
+    memcpy(&buf[1], report, len);
+    return write(dev->fd, buf, sizeof(buf)) == (ssize_t)sizeof(buf);
+}
+
+/**
+ * @brief Send a command with one argument byte
+ */
+bool orione_hid_command(orione_hid_t* dev, uint8_t cmd, uint8_t arg) {
+    uint8_t report[2] = {cmd, arg};
+    return orione_hid_send(dev, report, sizeof(report));
+}
+
+/**
+ * @brief Read the next IN packet
+ *
+ * @param packet VENDOR_REPORT_SIZE bytes
+ * @param timeout_ms -1 to wait forever
+ * @return 1 with a packet, 0 on timeout, -1 on error
+ */
+int orione_hid_read(orione_hid_t* dev, uint8_t* packet, int timeout_ms) {
+    if (dev->sim) return sim_receive(dev, ORIONE_SIM_IN, packet, timeout_ms);
+
+    struct pollfd pfd = {.fd = dev->fd, .events = POLLIN};
+
+    for (;;) {
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return ready;
+
+        ssize_t n = read(dev->fd, packet, VENDOR_REPORT_SIZE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == VENDOR_REPORT_SIZE) return 1;
+    }
+}
+
+/**
+ * @brief Wait for the answer of a command, skipping trace packets in flight
+ *
+ * @param type vendor_in_t of the answer
+ * @param packet VENDOR_REPORT_SIZE bytes
+ * @return False after ORIONE_HID_TIMEOUT_MS without it
+ */
+bool orione_hid_wait(orione_hid_t* dev, uint8_t type, uint8_t* packet) {
+    while (orione_hid_read(dev, packet, ORIONE_HID_TIMEOUT_MS) > 0) {
+        if (packet[0] == type) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Send a SET_REPORT(Feature)
+ */
+bool orione_hid_set_feature(orione_hid_t* dev, const uint8_t* report, size_t len) {
+    if (len > VENDOR_REPORT_SIZE) len = VENDOR_REPORT_SIZE;
+    if (dev->sim) return sim_send(dev, ORIONE_SIM_SET_FEATURE, report, len);
+
+    uint8_t buf[1 + VENDOR_REPORT_SIZE] = {0};
+    memcpy(&buf[1], report, len);
+    return ioctl(dev->fd, HIDIOCSFEATURE(sizeof(buf)), buf) >= 0;
+}
+
+/**
+ * @brief Read a GET_REPORT(Feature)
+ *
+ * @param report VENDOR_REPORT_SIZE bytes
+ */
+bool orione_hid_get_feature(orione_hid_t* dev, uint8_t* report) {
+    if (dev->sim) {
+        return sim_send(dev, ORIONE_SIM_GET_FEATURE, report, 0)
+            && sim_receive(dev, ORIONE_SIM_FEATURE, report, ORIONE_HID_TIMEOUT_MS) > 0;
+    }
+
+    uint8_t buf[1 + VENDOR_REPORT_SIZE] = {0};
+    if (ioctl(dev->fd, HIDIOCGFEATURE(sizeof(buf)), buf) < 0) return false;
+
+    memcpy(report, &buf[1], VENDOR_REPORT_SIZE);
+    return true;
+}
+
+/**
+ * @brief Read one profiler entry
+ */
+bool orione_hid_profiler_entry(orione_hid_t* dev, uint8_t index, vendor_profiler_packet_t* entry) {
+    uint8_t packet[VENDOR_REPORT_SIZE];
+
+    if (!orione_hid_command(dev, VENDOR_CMD_PROFILER_READ, index)) return false;
+
+    // an answer to an earlier read may still be in flight
+    do {
+        if (!orione_hid_wait(dev, VENDOR_IN_PROFILER, packet)) return false;
+    } while (packet[1] != index);
+
+    memcpy(entry, packet, sizeof(*entry));
+    return true;
+}
+
+/**
+ * @brief Read one key statistics page (feature report)
+ */
+bool orione_hid_keystats_page(orione_hid_t* dev, uint8_t page, vendor_keystats_page_t* out) {
+    uint8_t report[VENDOR_REPORT_SIZE] = {VENDOR_FEATURE_KEYSTATS, page};
+
+    if (!orione_hid_set_feature(dev, report, 2)) return false;
+    if (!orione_hid_get_feature(dev, report)) return false;
+    if (report[0] != VENDOR_FEATURE_KEYSTATS || report[1] != page) return false;
+
+    memcpy(out, report, sizeof(*out));
+    return true;
+}
+
+/**
+ * @brief Read, or select then read, the active profile
+ *
+ * @param select Profile index to select, -1 to only read
+ * @param index Active profile
+ * @param count Profile count
+ * @param name Active profile name, NUL terminated
+ */
+bool orione_hid_profile(orione_hid_t* dev, int select, uint8_t* index, uint8_t* count, char* name, size_t name_size) {
+    uint8_t packet[VENDOR_REPORT_SIZE];
+    bool sent = (select < 0) ? orione_hid_command(dev, VENDOR_CMD_PROFILE_GET, 0)
+                             : orione_hid_command(dev, VENDOR_CMD_PROFILE_SELECT, (uint8_t)select);
+
+    if (!sent || !orione_hid_wait(dev, VENDOR_IN_PROFILE, packet)) return false;
+
+    *index = packet[1];
+    *count = packet[2];
+    snprintf(name, name_size, "%.*s", VENDOR_REPORT_SIZE - 3, (const char*)&packet[3]);
+    return true;
+}
+
+/**
+ * @brief Read the settings layout
+ */
+bool orione_hid_settings_info(orione_hid_t* dev, vendor_settings_info_t* info) {
+    uint8_t packet[VENDOR_REPORT_SIZE];
+
+    if (!orione_hid_command(dev, VENDOR_CMD_SETTINGS_INFO, 0)) return false;
+    if (!orione_hid_wait(dev, VENDOR_IN_SETTINGS_INFO, packet)) return false;
+
+    memcpy(info, packet, sizeof(*info));
+    return true;
+}
+
+/**
+ * @brief Read a whole settings region
+ *
+ * @param size Region size, from orione_hid_settings_info
+ */
+bool orione_hid_settings_read(orione_hid_t* dev, uint8_t region, uint8_t* data, uint16_t size) {
+    uint8_t packet[VENDOR_REPORT_SIZE];
+    vendor_settings_data_t chunk;
+    uint16_t received = 0;
+
+    if (size == 0) return true;
+    if (!orione_hid_command(dev, VENDOR_CMD_SETTINGS_READ, region)) return false;
+
+    while (received < size) {
+        if (!orione_hid_wait(dev, VENDOR_IN_SETTINGS_DATA, packet)) return false;
+
+        memcpy(&chunk, packet, sizeof(chunk));
+        if (chunk.region != region || chunk.offset != received || chunk.len == 0
+                || chunk.len > VENDOR_SETTINGS_CHUNK || received + chunk.len > size) return false;
+
+        memcpy(&data[received], chunk.data, chunk.len);
+        received += chunk.len;
+    }
+    return true;
+}
+
+/**
+ * @brief Stage a whole settings region
+ *
+ * Nothing is answered; `orione_hid_settings_command` with
+ * VENDOR_CMD_SETTINGS_COMMIT applies the staged regions.
+ */
+bool orione_hid_settings_write(orione_hid_t* dev, uint8_t region, const uint8_t* data, uint16_t size) {
+    for (uint16_t offset = 0; offset < size; offset += VENDOR_SETTINGS_CHUNK) {
+        vendor_settings_data_t chunk = {
+            .type = VENDOR_CMD_SETTINGS_WRITE,
+            .region = region,
+            .offset = offset,
+            .len = (size - offset < VENDOR_SETTINGS_CHUNK) ? size - offset : VENDOR_SETTINGS_CHUNK,
+        };
+        memcpy(chunk.data, &data[offset], chunk.len);
+
+        if (!orione_hid_send(dev, (const uint8_t*)&chunk, sizeof(chunk))) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Commit, save or restore the defaults
+ *
+ * A save is answered once the keyboard has written it, after every key
+ * has been released, so it is given a longer timeout.
+ *
+ * @param cmd VENDOR_CMD_SETTINGS_COMMIT, _SAVE or _DEFAULTS
+ * @param status Answer, with the region and offset of an error
+ */
+bool orione_hid_settings_command(orione_hid_t* dev, uint8_t cmd, vendor_settings_status_t* status) {
+    uint8_t packet[VENDOR_REPORT_SIZE];
+    int timeout_ms = (cmd == VENDOR_CMD_SETTINGS_SAVE) ? ORIONE_HID_SAVE_TIMEOUT_MS : ORIONE_HID_TIMEOUT_MS;
+
+    if (!orione_hid_command(dev, cmd, 0)) return false;
+
+    do {
+        if (orione_hid_read(dev, packet, timeout_ms) <= 0) return false;
+    } while (packet[0] != VENDOR_IN_SETTINGS_STATUS || packet[1] != cmd);
+
+    memcpy(status, packet, sizeof(*status));
+    return true;
+}
+
+/**
+ * @brief Read the boot stage times
+ */
+bool orione_hid_boot_times(orione_hid_t* dev, vendor_boot_packet_t* boot) {
+    uint8_t packet[VENDOR_REPORT_SIZE];
+
+    if (!orione_hid_command(dev, VENDOR_CMD_BOOT_TIMES, 0)) return false;
+    if (!orione_hid_wait(dev, VENDOR_IN_BOOT_TIMES, packet)) return false;
+
+    memcpy(boot, packet, sizeof(*boot));
+    return true;
+}
+
+/**
+ * @brief Read the clock governor transitions
+ */
+bool orione_hid_governor_stats(orione_hid_t* dev, vendor_governor_packet_t* governor) {
+    uint8_t packet[VENDOR_REPORT_SIZE];
+
+    if (!orione_hid_command(dev, VENDOR_CMD_GOVERNOR_STATS, 0)) return false;
+    if (!orione_hid_wait(dev, VENDOR_IN_GOVERNOR_STATS, packet)) return false;
+
+    memcpy(governor, packet, sizeof(*governor));
+    return true;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file orione_hid.h
+ * @brief Host access to the keyboard vendor interface (Linux)
+ *
+ * Opens the vendor HID interface through hidraw, or the stand-in device
+ * of host/sim_device through a unix socket ("sim:<path>"), and wraps the
+ * command protocol of src/usb/vendor/vendor.h: profiler entries, key
+ * statistics pages, profile selection, the event trace and the live
+ * settings.
+ *
+ * Settings writes are sent back to back without waiting for an answer
+ * (the OUT endpoint holds each report until the firmware took it), so a
+ * full upload costs one packet per 59 bytes plus a single commit round
+ * trip.
+ */
+
+#ifndef ORIONE_HID_H
+#define ORIONE_HID_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    #include "src/usb/vendor/vendor.h"
+
+    #define ORIONE_HID_VID 0xCAFE
+
+    // Time allowed for the answer to a command
+    #define ORIONE_HID_TIMEOUT_MS 1000
+
+    // Time allowed for a settings save: the keyboard writes once no key is held
+    #define ORIONE_HID_SAVE_TIMEOUT_MS 10000
+
+    // Prefix of a stand-in device path
+    #define ORIONE_HID_SIM_PREFIX "sim:"
+
+    // Stand-in device messages (SOCK_SEQPACKET): kind byte + one report
+    typedef enum {
+        ORIONE_SIM_OUT = 'O',           // host -> device, OUT report
+        ORIONE_SIM_IN = 'I',            // device -> host, IN report
+        ORIONE_SIM_SET_FEATURE = 'S',   // host -> device, SET_REPORT(Feature)
+        ORIONE_SIM_GET_FEATURE = 'G',   // host -> device, GET_REPORT(Feature)
+        ORIONE_SIM_FEATURE = 'F',       // device -> host, feature report
+    } orione_sim_msg_t;
+
+    #define ORIONE_SIM_MSG_SIZE (1 + VENDOR_REPORT_SIZE)
+
+    typedef struct {
+        int fd;
+        bool sim;                       // stand-in device socket, not hidraw
+    } orione_hid_t;
+
+    bool orione_hid_find(char* path, size_t size);
+    bool orione_hid_open(orione_hid_t* dev, const char* path);
+    void orione_hid_close(orione_hid_t* dev);
+
+    bool orione_hid_send(orione_hid_t* dev, const uint8_t* report, size_t len);
+    bool orione_hid_command(orione_hid_t* dev, uint8_t cmd, uint8_t arg);
+    int orione_hid_read(orione_hid_t* dev, uint8_t* packet, int timeout_ms);
+    bool orione_hid_wait(orione_hid_t* dev, uint8_t type, uint8_t* packet);
+    bool orione_hid_set_feature(orione_hid_t* dev, const uint8_t* report, size_t len);
+    bool orione_hid_get_feature(orione_hid_t* dev, uint8_t* report);
+
+    bool orione_hid_profiler_entry(orione_hid_t* dev, uint8_t index, vendor_profiler_packet_t* entry);
+    bool orione_hid_keystats_page(orione_hid_t* dev, uint8_t page, vendor_keystats_page_t* out);
+    bool orione_hid_profile(orione_hid_t* dev, int select, uint8_t* index, uint8_t* count, char* name, size_t name_size);
+
+    bool orione_hid_settings_info(orione_hid_t* dev, vendor_settings_info_t* info);
+    bool orione_hid_settings_read(orione_hid_t* dev, uint8_t region, uint8_t* data, uint16_t size);
+    bool orione_hid_settings_write(orione_hid_t* dev, uint8_t region, const uint8_t* data, uint16_t size);
+    bool orione_hid_settings_command(orione_hid_t* dev, uint8_t cmd, vendor_settings_status_t* status);
+
+    bool orione_hid_boot_times(orione_hid_t* dev, vendor_boot_packet_t* boot);
+    bool orione_hid_governor_stats(orione_hid_t* dev, vendor_governor_packet_t* governor);
+
+#endif /* ORIONE_HID_H */
@@ -0,0 +1,872 @@
+/**
+ * @file replay.c
+ * @brief Record-and-replay simulator of the input pipeline
+ *
+ * Replays a timestamped stream of key contact edges through the unchanged
+ * firmware input path, on the simulated clock of the host SDK:
+ * column GPIO interrupt (`gpio_callback`) -> debounce -> debounce alarm ->
+ * row scan -> `keyboard_add_key`/`keyboard_remove_key` and the Fn layer ->
+ * matrix snapshot -> `hid_report_keyboard_update` -> report dedup/flush.
+ *
+ * The key matrix is simulated electrically: a column reads high when a
+ * closed key on it sits on a row driven high, so the row scans and the
+ * column edges they cause behave as on the board. Busy waits advance the
+ * clock, alarms fire at their deadline, and the endpoint optionally only
+ * accepts a report per polling interval. The run is deterministic: the same
+ * input and firmware always give the same output.
+ *
+ * Output (stdout), one line per event, diffable between firmware versions:
+ *   <time_us> report <id> <hex bytes>          report as received by the host
+ *   <time_us> key <row>,<col> press|release <latency_us>|phantom
+ *   <time_us> key <row>,<col> press|release missed
+ *   <time_us> encoder cw|ccw                   detent decoded by the CLK interrupt
+ *   <time_us> button press|release <edges>     debounced button changes since the last line
+ * Latency is measured from the intended transition ("truth") to the
+ * delivery of the first report carrying it. A summary goes to stderr.
+ *
+ * With --hybrid, the matrix is read by the polled scan of hybrid_scan.c
+ * from the first column edge until the keys have been released for the
+ * hold-off, instead of by the column interrupts.
+ *
+ * The clock governor task runs on the simulated clock as in the firmware
+ * scheduler: a pause longer than GOVERNOR_IDLE_MS lowers clk_sys and the
+ * next edge restores it. The edge-to-full-clock latency goes to the
+ * summary.
+ *
+ * With --profile, the execution times of the interrupt entry points (see
+ * profiler.h) are written as JSON lines in the bench format, e.g.
+ *   {"bench":"wcet","case":"col_alrm","count":812,"max_us":50,"mean_us":12.40}
+ * On the simulated clock only busy waits take time, so these are the
+ * worst-case waits of each handler, checked against bench/thresholds.json
+ * by tools/bench_compare.py --check. The governor restore latency follows
+ * as {"bench":"governor","case":"restore",...} once clk_sys was restored.
+ * With --hybrid the benches are "wcet_hybrid" and "governor_hybrid", so
+ * the two modes have their own limits and their results can go in one
+ * file (tools/replay_check.sh).
+ *
+ * Input (text, '#' comments):
+ *   <time_us> edge <row> <col> <0|1>    contact opens/closes, bounce included
+ *   <time_us> truth <row> <col> <0|1>   intended transition (optional)
+ *   <time_us> encoder <clk> <dt>        encoder pin levels, 1 1 at rest (pulled up)
+ *   <time_us> button <0|1>              encoder button contact opens/closes
+ * Without truth lines, the truth is derived per key with a settle filter
+ * (bursts of edges separated by --settle of quiet). Inputs come from
+ * `replay synth` (typing with bounce, chatter or EMI, with -e encoder
+ * detents and button presses over it, with -i an idle pause ended by one
+ * more keystroke) or from a device trace (`trace_decoder decode -r`).
+ *
+ * usage:
+ *   replay synth [-p profile] [-s seed] [-k keystrokes] [-e detents] [-i idle_ms] out.txt
+ *   replay run [--poll-us US] [--settle US] [--hybrid] [--profile out.jsonl] in.txt
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp/board_api.h"
+#include "tusb.h"
+
+#include "src/debounce/debounce.h"
+#include "src/init/init.h"
+#include "src/interrupts/interrupts.h"
+#include "src/gamepad/gamepad.h"
+#include "src/matrix/keymap/keymap.h"
+#include "src/matrix/snapshot/snapshot.h"
+#include "src/power/governor/governor.h"
+#include "src/profile/profile.h"
+#include "src/profiler/profiler.h"
+#include "src/rotary_encoder/rotary_encoder.h"
+#include "src/scheduler/scheduler.h"
+#include "src/usb/hid_report/hid_report.h"
+
+#include "../debounce_harness/waveform.h"
+
+//--------------------------------------------------------------------+
+
+#define KEY_COUNT (MATRIX_ROWS * MATRIX_COLS)
+#define KEY_INDEX(row, col) ((row) * MATRIX_COLS + (col))
+
+typedef enum {
+    INPUT_EDGE = 0,
+    INPUT_TRUTH,
+    INPUT_ENCODER,              // encoder pin levels: row = CLK, col = DT
+    INPUT_BUTTON,               // encoder button contact
+} input_kind_t;
+
+typedef struct {
+    uint64_t time_us;
+    uint8_t kind;               // input_kind_t
+    uint8_t row;
+    uint8_t col;
+    bool level;                 // true = closed / pressed
+    uint32_t order;             // position in the list, keeps same-time events in order
+} input_event_t;
+
+typedef struct {
+    input_event_t* items;
+    size_t count;
+    size_t capacity;
+} input_list_t;
+
+// Intended transitions of one key and the next one not yet matched
+typedef struct {
+    input_list_t truth;
+    size_t next;
+} key_truth_t;
+
+typedef struct {
+    uint32_t transitions;
+    uint32_t detected;
+    uint32_t missed;
+    uint32_t phantom;
+    uint32_t reports;
+    uint64_t* latencies;
+    size_t latency_count;
+    size_t latency_capacity;
+} replay_stats_t;
+
+typedef struct {
+    uint32_t poll_us;           // endpoint polling interval, 0 = always ready
+    uint32_t settle_us;
+    const char* profile_path;   // interrupt execution times output, NULL = none
+    bool hybrid;                // polled scan while keys are active (hybrid_scan.h)
+} replay_options_t;
+
+// Firmware globals normally defined in main.c
+keyboard_state_t kbd_state = {0};
+
+static bool contact[MATRIX_ROWS][MATRIX_COLS] = {0};    // simulated switch contacts
+
+static replay_options_t options = {0};
+static replay_stats_t stats = {0};
+static key_truth_t key_truth[KEY_COUNT] = {0};
+
+static uint64_t endpoint_free_us = 0;
+static uint16_t applied_matrix[MATRIX_ROWS] = {0};     // last snapshot given to the report builder
+static uint16_t delivered_matrix[MATRIX_ROWS] = {0};   // key state the host has seen
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+static void input_list_push(input_list_t* list, const input_event_t* event) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 256;
+        list->items = realloc(list->items, list->capacity * sizeof(list->items[0]));
+        if (!list->items) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    list->items[list->count] = *event;
+    list->items[list->count].order = (uint32_t)list->count;
+    list->count++;
+}
+
+static int compare_event(const void* a, const void* b) {
+    const input_event_t* x = a;
+    const input_event_t* y = b;
+
+    if (x->time_us != y->time_us) return (x->time_us > y->time_us) - (x->time_us < y->time_us);
+    // same time: keep the file order (qsort is not stable)
+    return (x->order > y->order) - (x->order < y->order);
+}
+
+static void latency_push(uint64_t latency_us) {
+    if (stats.latency_count == stats.latency_capacity) {
+        stats.latency_capacity = stats.latency_capacity ? stats.latency_capacity * 2 : 1024;
+        stats.latencies = realloc(stats.latencies, stats.latency_capacity * sizeof(stats.latencies[0]));
+        if (!stats.latencies) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    stats.latencies[stats.latency_count++] = latency_us;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t* sorted, size_t count, unsigned pct) {
+    if (count == 0) return 0;
+    size_t index = (count * pct + 99) / 100;
+    return sorted[index ? index - 1 : 0];
+}
+
+static uint32_t xorshift(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+//--------------------------------------------------------------------+
+// SIMULATED HARDWARE
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Column level: a closed key on a row driven high (diode matrix)
+ */
+static bool column_input(unsigned int gpio) {
+    unsigned int col = gpio - COLUMN_0;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (contact[row][col] && gpio_get(ROW_0 + row)) return true;
+    }
+    return false;
+}
+
+bool tud_mounted(void) { return true; }
+bool tud_suspended(void) { return false; }
+bool tud_remote_wakeup(void) { return false; }
+bool tud_task_event_ready(void) { return false; }
+
+bool tud_hid_n_ready(uint8_t instance) {
+    return instance == HID_INSTANCE_KEYBOARD && time_us_64() >= endpoint_free_us;
+}
+
+/**
+ * @brief Match a key state change seen by the host with the truth
+ */
+static void deliver_key(uint8_t row, uint8_t col, bool pressed, uint64_t time_us) {
+    key_truth_t* kt = &key_truth[KEY_INDEX(row, col)];
+    const char* what = pressed ? "press" : "release";
+
+    // the change answers the latest intended transition to that state
+    size_t match = kt->truth.count;
+    for (size_t i = kt->next; i < kt->truth.count && kt->truth.items[i].time_us <= time_us; i++) {
+        if (kt->truth.items[i].level == pressed) match = i;
+    }
+
+    if (match == kt->truth.count) {
+        printf("%llu key %u,%u %s phantom\n", (unsigned long long)time_us, row, col, what);
+        stats.phantom++;
+        return;
+    }
+
+    // transitions skipped over never reached the host
+    for (; kt->next < match; kt->next++) {
+        const input_event_t* truth = &kt->truth.items[kt->next];
+        printf("%llu key %u,%u %s missed\n", (unsigned long long)truth->time_us, row, col,
+               truth->level ? "press" : "release");
+        stats.missed++;
+    }
+
+    uint64_t latency = time_us - kt->truth.items[match].time_us;
+    printf("%llu key %u,%u %s %llu\n", (unsigned long long)time_us, row, col, what, (unsigned long long)latency);
+    stats.detected++;
+    latency_push(latency);
+    kt->next = match + 1;
+}
+
+/**
+ * @brief Everything applied to the report builder is now seen by the host
+ */
+static void deliver_applied(uint64_t time_us) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        uint16_t diff = applied_matrix[row] ^ delivered_matrix[row];
+
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (diff & (1u << col)) {
+                deliver_key(row, col, (applied_matrix[row] >> col) & 1u, time_us);
+            }
+        }
+        delivered_matrix[row] = applied_matrix[row];
+    }
+}
+
+/**
+ * @brief Fake keyboard endpoint: the host receives the report at its next poll
+ */
+bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const* report, uint16_t len) {
+    if (!tud_hid_n_ready(instance)) return false;
+
+    uint64_t now = time_us_64();
+    uint64_t delivered = options.poll_us ? (now / options.poll_us + 1) * options.poll_us : now;
+    endpoint_free_us = delivered;
+
+    printf("%llu report %u", (unsigned long long)delivered, report_id);
+    for (uint16_t i = 0; i < len; i++) {
+        printf(" %02x", ((const uint8_t*)report)[i]);
+    }
+    printf("\n");
+    stats.reports++;
+
+    deliver_applied(delivered);
+    return true;
+}
+
+/**
+ * @brief Keyboard part of the firmware HID task (main.c `hid_task`)
+ */
+static void report_task(void) {
+    static uint32_t reported_seq = 0;
+
+    if (matrix_snapshot_seq() != reported_seq) {
+        matrix_snapshot_t snapshot;
+        matrix_snapshot_read(&snapshot);
+
+        reported_seq = snapshot.seq;
+        hid_report_keyboard_update(&snapshot);
+        memcpy(applied_matrix, snapshot.matrix, sizeof(applied_matrix));
+    }
+
+    while (hid_report_pending() && tud_hid_n_ready(HID_INSTANCE_KEYBOARD)) {
+        hid_report_flush();
+    }
+
+    // changes that need no report (Fn, unmapped keys) are seen right away
+    if (!hid_report_pending()) {
+        deliver_applied(time_us_64());
+    }
+
+    // encoder events as decoded, the consumer and mouse reports are not simulated
+    int8_t direction;
+    bool button_pressed;
+    uint8_t button_edges;
+
+    rotary_encoder_get_state(&direction, &button_pressed, &button_edges);
+    if (direction) {
+        printf("%llu encoder %s\n", (unsigned long long)time_us_64(), direction > 0 ? "cw" : "ccw");
+    }
+    if (button_edges) {
+        printf("%llu button %s %u\n", (unsigned long long)time_us_64(), button_pressed ? "press" : "release",
+               button_edges);
+    }
+}
+
+//--------------------------------------------------------------------+
+// INPUT
+//--------------------------------------------------------------------+
+
+static bool load_input(const char* path, input_list_t* edges) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    char line[256];
+    unsigned line_no = 0;
+    bool have_truth = false;
+
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        unsigned long long time_us;
+        char kind[16];
+        unsigned row, col, level;
+        int n = sscanf(line, "%llu %15s %u %u %u", &time_us, kind, &row, &col, &level);
+        if (n <= 0) continue;
+
+        input_event_t event = {.time_us = time_us};
+        bool valid;
+
+        if (strcmp(kind, "encoder") == 0) {
+            // <clk> <dt>
+            valid = n == 4 && row <= 1 && col <= 1;
+            event.kind = INPUT_ENCODER;
+            event.row = (uint8_t)row;
+            event.col = (uint8_t)col;
+        } else if (strcmp(kind, "button") == 0) {
+            // <0|1>
+            valid = n == 3 && row <= 1;
+            event.kind = INPUT_BUTTON;
+            event.level = row != 0;
+        } else {
+            valid = n == 5 && row < MATRIX_ROWS && col < MATRIX_COLS &&
+                    (strcmp(kind, "edge") == 0 || strcmp(kind, "truth") == 0);
+            event.kind = (strcmp(kind, "truth") == 0) ? INPUT_TRUTH : INPUT_EDGE;
+            event.row = (uint8_t)row;
+            event.col = (uint8_t)col;
+            event.level = level != 0;
+        }
+
+        if (!valid) {
+            fprintf(stderr, "%s:%u: expected \"<time_us> edge|truth <row> <col> <0|1>\", "
+                    "\"<time_us> encoder <clk> <dt>\" or \"<time_us> button <0|1>\"\n", path, line_no);
+            fclose(f);
+            return false;
+        }
+
+        if (event.kind == INPUT_TRUTH) {
+            input_list_push(&key_truth[KEY_INDEX(row, col)].truth, &event);
+            have_truth = true;
+        } else {
+            input_list_push(edges, &event);
+        }
+    }
+    fclose(f);
+
+    qsort(edges->items, edges->count, sizeof(edges->items[0]), compare_event);
+
+    if (have_truth) {
+        for (size_t k = 0; k < KEY_COUNT; k++) {
+            input_list_t* truth = &key_truth[k].truth;
+            qsort(truth->items, truth->count, sizeof(truth->items[0]), compare_event);
+        }
+        return true;
+    }
+
+    // reference filter per key: bursts separated by settle_us of quiet
+    for (size_t k = 0; k < KEY_COUNT; k++) {
+        bool settled = false;
+        const input_event_t* burst_start = NULL;
+        const input_event_t* prev = NULL;
+
+        for (size_t i = 0; i <= edges->count; i++) {
+            const input_event_t* e = (i < edges->count) ? &edges->items[i] : NULL;
+            if (e && (e->kind != INPUT_EDGE || (size_t)KEY_INDEX(e->row, e->col) != k)) continue;
+
+            if (prev && (!e || e->time_us - prev->time_us >= options.settle_us)) {
+                if (prev->level != settled) {
+                    input_event_t truth = *burst_start;
+                    truth.kind = INPUT_TRUTH;
+                    truth.level = prev->level;
+                    input_list_push(&key_truth[k].truth, &truth);
+                    settled = prev->level;
+                }
+                burst_start = NULL;
+            }
+            if (!e) break;
+
+            if (!burst_start) burst_start = e;
+            prev = e;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write the interrupt entry point execution times as JSON lines
+ *
+ * @return False if the file cannot be written
+ */
+static bool write_profile(const char* path) {
+    const char* suffix = options.hybrid ? "_hybrid" : "";
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    for (prof_id_t id = 0; id < PROF_TASK_FIRST; id++) {
+        prof_entry_t entry;
+        profiler_get(id, &entry);
+        if (entry.count == 0) continue;
+
+        fprintf(f, "{\"bench\":\"wcet%s\",\"case\":\"%s\",\"count\":%lu,\"max_us\":%lu,\"mean_us\":%.2f}\n",
+                suffix, profiler_name(id), (unsigned long)entry.count, (unsigned long)entry.max,
+                (double)entry.total / entry.count);
+    }
+
+    governor_stats_t governor;
+    governor_get_stats(&governor);
+    if (governor.restore_count) {
+        fprintf(f, "{\"bench\":\"governor%s\",\"case\":\"restore\",\"count\":%lu,\"max_us\":%lu}\n",
+                suffix, (unsigned long)governor.restore_count, (unsigned long)governor.restore_max_us);
+    }
+
+    fclose(f);
+    return true;
+}
+
+//--------------------------------------------------------------------+
+// COMMANDS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Replay an input file through the firmware pipeline
+ */
+static int run(const char* path) {
+    input_list_t edges = {0};
+    if (!load_input(path, &edges)) return 1;
+
+    for (size_t k = 0; k < KEY_COUNT; k++) {
+        stats.transitions += key_truth[k].truth.count;
+    }
+
+    printf("# replay %s: debounce %s %uus, poll %uus%s\n", path,
+           debounce_algorithm_name(MATRIX_DEBOUNCE_ALGORITHM), (unsigned)MATRIX_DEBOUNCE_TIME, options.poll_us,
+           options.hybrid ? ", hybrid scan" : "");
+
+    // firmware init on the simulated board
+    host_time_set(0);
+    keymap_init();
+    gamepad_init();
+    profile_init();
+    hybrid_scan_set_enabled(options.hybrid);
+    init_keyboard_gpio();
+    init_keyboard_interrupts();
+    init_rotary_encoder_gpio();
+    init_rotary_encoder_interrupts();
+    scheduler_register(TASK_GOVERNOR, governor_task);
+    scheduler_notify(TASK_GOVERNOR);
+
+    uint32_t column_mask = 0;
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        column_mask |= 1u << (COLUMN_0 + col);
+    }
+    host_gpio_set_input_hook(column_mask, column_input);
+
+    size_t next = 0;
+    absolute_time_t task_deadline;
+
+    while (scheduler_run_pass(&task_deadline)) {
+    }
+
+    for (;;) {
+        uint64_t alarm_us = 0;
+        bool has_alarm = host_alarm_next(&alarm_us);
+        bool has_input = next < edges.count;
+        bool endpoint_wait = hid_report_pending() && !tud_hid_n_ready(HID_INSTANCE_KEYBOARD);
+
+        if (!has_alarm && !has_input && !endpoint_wait) break;
+
+        uint64_t wake = UINT64_MAX;
+        if (has_alarm && alarm_us < wake) wake = alarm_us;
+        if (has_input && edges.items[next].time_us < wake) wake = edges.items[next].time_us;
+        if (endpoint_wait && endpoint_free_us < wake) wake = endpoint_free_us;
+        // the governor re-arms for good, its deadlines only count while input remains
+        if (has_input && (uint64_t)task_deadline < wake) wake = (uint64_t)task_deadline;
+
+        // never goes back: input arriving during a busy wait is served late
+        host_time_set(wake);
+        uint64_t now = time_us_64();
+
+        if (has_input && edges.items[next].time_us <= now && !(has_alarm && alarm_us < edges.items[next].time_us)) {
+            uint64_t at = edges.items[next].time_us;
+            while (next < edges.count && edges.items[next].time_us == at) {
+                const input_event_t* e = &edges.items[next++];
+
+                if (e->kind == INPUT_ENCODER) {
+                    host_gpio_set(ROTARY_CLK, e->row);
+                    host_gpio_set(ROTARY_DT, e->col);
+                } else if (e->kind == INPUT_BUTTON) {
+                    // active LOW
+                    host_gpio_set(ROTARY_SW, !e->level);
+                } else {
+                    contact[e->row][e->col] = e->level;
+                }
+            }
+            host_gpio_refresh();
+        } else if (has_alarm && alarm_us <= now) {
+            host_alarm_run_due();
+        }
+
+        host_gpio_irq_dispatch();
+        report_task();
+
+        // the firmware tasks served after TASK_HID
+        while (scheduler_run_pass(&task_deadline)) {
+        }
+    }
+
+    // transitions that never reached the host
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            key_truth_t* kt = &key_truth[KEY_INDEX(row, col)];
+            for (; kt->next < kt->truth.count; kt->next++) {
+                const input_event_t* truth = &kt->truth.items[kt->next];
+                printf("%llu key %u,%u %s missed\n", (unsigned long long)truth->time_us, row, col,
+                       truth->level ? "press" : "release");
+                stats.missed++;
+            }
+        }
+    }
+
+    qsort(stats.latencies, stats.latency_count, sizeof(stats.latencies[0]), compare_u64);
+    fprintf(stderr,
+            "%u transitions, %u detected, %u missed, %u phantom, %u reports\n"
+            "latency us: p50 %llu p90 %llu p99 %llu max %llu\n",
+            stats.transitions, stats.detected, stats.missed, stats.phantom, stats.reports,
+            (unsigned long long)percentile(stats.latencies, stats.latency_count, 50),
+            (unsigned long long)percentile(stats.latencies, stats.latency_count, 90),
+            (unsigned long long)percentile(stats.latencies, stats.latency_count, 99),
+            (unsigned long long)(stats.latency_count ? stats.latencies[stats.latency_count - 1] : 0));
+
+    governor_stats_t governor;
+    governor_get_stats(&governor);
+    fprintf(stderr, "governor: clk_sys lowered %lu times, restored %lu, restore us: last %lu max %lu\n",
+            (unsigned long)governor.low_count, (unsigned long)governor.restore_count,
+            (unsigned long)governor.restore_last_us, (unsigned long)governor.restore_max_us);
+
+    free(edges.items);
+
+    if (options.profile_path && !write_profile(options.profile_path)) return 1;
+    return 0;
+}
+
+/**
+ * @brief Write the events of one synthetic switch, played on random keys
+ *
+ * Each keystroke of the waveform (with its bounce, chatter or spikes) is
+ * assigned to a key drawn from `keys`; stray edges before the first
+ * keystroke go to the first key.
+ */
+static void synth_finger(input_list_t* out, const waveform_t* wave, const uint8_t (*keys)[2], size_t key_count,
+                         uint32_t* rng) {
+    size_t edge = 0;
+
+    for (size_t k = 0; k + 1 < wave->truth.count; k += 2) {
+        uint32_t pick = xorshift(rng) % key_count;
+        uint8_t row = keys[pick][0];
+        uint8_t col = keys[pick][1];
+        uint64_t end = (k + 2 < wave->truth.count) ? wave->truth.items[k + 2].time_us : UINT64_MAX;
+
+        for (int t = 0; t < 2; t++) {
+            input_event_t truth = {
+                .time_us = wave->truth.items[k + t].time_us,
+                .kind = INPUT_TRUTH,
+                .row = row,
+                .col = col,
+                .level = wave->truth.items[k + t].pressed,
+            };
+            input_list_push(out, &truth);
+        }
+
+        for (; edge < wave->edges.count && wave->edges.items[edge].time_us < end; edge++) {
+            input_event_t e = {
+                .time_us = wave->edges.items[edge].time_us,
+                .kind = INPUT_EDGE,
+                .row = row,
+                .col = col,
+                .level = wave->edges.items[edge].pressed,
+            };
+            input_list_push(out, &e);
+        }
+    }
+}
+
+/**
+ * @brief Push an encoder or button input
+ */
+static void synth_push(input_list_t* out, uint64_t time_us, uint8_t kind, uint8_t a, uint8_t b) {
+    input_event_t e = {
+        .time_us = time_us,
+        .kind = kind,
+        .row = a,
+        .col = b,
+        .level = a != 0,
+    };
+    input_list_push(out, &e);
+}
+
+/**
+ * @brief Write encoder detents and button presses spread over a session
+ *
+ * Detents alternate between clockwise and counter-clockwise, each a full
+ * quadrature cycle with one bounce on the CLK falling edge; every press
+ * of the button bounces once on closing and is held for 100 ms.
+ */
+static void synth_encoder(input_list_t* out, uint64_t span_us, uint32_t count) {
+    for (uint32_t n = 0; n < count; n++) {
+        uint64_t t = span_us * (n + 1) / (count + 1);
+        bool cw = (n % 2) == 0;
+
+        // CW: CLK falls with DT high, CCW: DT falls first
+        synth_push(out, t, INPUT_ENCODER, cw ? 0 : 1, cw ? 1 : 0);
+        synth_push(out, t + 2000, INPUT_ENCODER, 0, 0);
+        synth_push(out, t + 4000, INPUT_ENCODER, cw ? 1 : 0, cw ? 0 : 1);
+        synth_push(out, t + 6000, INPUT_ENCODER, 1, 1);
+        if (cw) {
+            synth_push(out, t + 50, INPUT_ENCODER, 1, 1);
+            synth_push(out, t + 100, INPUT_ENCODER, 0, 1);
+        } else {
+            synth_push(out, t + 2050, INPUT_ENCODER, 1, 0);
+            synth_push(out, t + 2100, INPUT_ENCODER, 0, 0);
+        }
+
+        synth_push(out, t + 20000, INPUT_BUTTON, 1, 0);
+        synth_push(out, t + 20300, INPUT_BUTTON, 0, 0);
+        synth_push(out, t + 20600, INPUT_BUTTON, 1, 0);
+        synth_push(out, t + 120000, INPUT_BUTTON, 0, 0);
+    }
+}
+
+/**
+ * @brief Generate a synthetic typing session
+ *
+ * Two independent "fingers", one on the left half of the matrix and one on
+ * the right, so keystrokes overlap (rollover, Fn combinations) while each
+ * key only ever gets its own waveform.
+ */
+static int synth(int argc, char** argv) {
+    waveform_params_t params;
+    waveform_profile_t profile = PROFILE_BOUNCE;
+    int opt;
+
+    waveform_params_default(&params);
+    params.keystrokes = 1000;
+    uint32_t idle_ms = 0;
+    uint32_t encoder_count = 0;
+
+    while ((opt = getopt(argc, argv, "p:s:k:i:e:")) != -1) {
+        switch (opt) {
+            case 'p': {
+                int p;
+                for (p = 0; p < PROFILE_COUNT; p++) {
+                    if (strcmp(optarg, waveform_profile_name((waveform_profile_t)p)) == 0) break;
+                }
+                if (p == PROFILE_COUNT) {
+                    fprintf(stderr, "unknown profile: %s\n", optarg);
+                    return 2;
+                }
+                profile = (waveform_profile_t)p;
+            }
+            break;
+            case 's': params.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'k': params.keystrokes = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'i': idle_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'e': encoder_count = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default: return 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, "usage: replay synth [-p clean|bounce|chatter|emi] [-s seed] [-k keystrokes] [-e detents] "
+                "[-i idle_ms] out.txt\n");
+        return 2;
+    }
+
+    // mapped keys of each half, Fn included
+    keymap_init();
+    uint8_t left[KEY_COUNT][2], right[KEY_COUNT][2];
+    size_t left_count = 0, right_count = 0;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            bool fn = (row == FN_KEY_ROW && col == FN_KEY_COL);
+            if (!fn && map_key_to_hid(row, col, 0) == 0) continue;
+
+            uint8_t (*half)[2] = (col < MATRIX_COLS / 2) ? left : right;
+            size_t* count = (col < MATRIX_COLS / 2) ? &left_count : &right_count;
+            half[*count][0] = row;
+            half[*count][1] = col;
+            (*count)++;
+        }
+    }
+
+    input_list_t events = {0};
+    uint32_t seed = params.seed;
+    uint32_t rng = seed ? seed : 1;
+    waveform_t wave;
+
+    waveform_generate(&wave, profile, &params);
+    synth_finger(&events, &wave, (const uint8_t (*)[2])left, left_count, &rng);
+    waveform_free(&wave);
+
+    params.seed = params.seed * 2654435761u + 1;
+    waveform_generate(&wave, profile, &params);
+    synth_finger(&events, &wave, (const uint8_t (*)[2])right, right_count, &rng);
+    waveform_free(&wave);
+
+    if (encoder_count) {
+        uint64_t span_us = 0;
+        for (size_t i = 0; i < events.count; i++) {
+            if (events.items[i].time_us > span_us) span_us = events.items[i].time_us;
+        }
+        synth_encoder(&events, span_us, encoder_count);
+    }
+
+    qsort(events.items, events.count, sizeof(events.items[0]), compare_event);
+
+    // idle pause, then one clean keystroke on the first left key
+    if (idle_ms && events.count) {
+        uint64_t at = events.items[events.count - 1].time_us + (uint64_t)idle_ms * 1000;
+
+        for (int level = 1; level >= 0; level--) {
+            for (uint8_t kind = INPUT_EDGE; kind <= INPUT_TRUTH; kind++) {
+                input_event_t e = {
+                    .time_us = at,
+                    .kind = kind,
+                    .row = left[0][0],
+                    .col = left[0][1],
+                    .level = level != 0,
+                };
+                input_list_push(&events, &e);
+            }
+            at += 100000;
+        }
+    }
+
+    FILE* f = fopen(argv[optind], "w");
+    if (!f) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    fprintf(f, "# synthetic session: profile %s, seed %u, %u keystrokes per finger",
+            waveform_profile_name(profile), seed, params.keystrokes);
+    if (encoder_count) fprintf(f, ", %u detents", encoder_count);
+    if (idle_ms) fprintf(f, ", idle %u ms", idle_ms);
+    fprintf(f, "\n");
+    for (size_t i = 0; i < events.count; i++) {
+        const input_event_t* e = &events.items[i];
+
+        if (e->kind == INPUT_ENCODER) {
+            fprintf(f, "%llu encoder %u %u\n", (unsigned long long)e->time_us, e->row, e->col);
+        } else if (e->kind == INPUT_BUTTON) {
+            fprintf(f, "%llu button %u\n", (unsigned long long)e->time_us, e->level);
+        } else {
+            fprintf(f, "%llu %s %u %u %u\n", (unsigned long long)e->time_us,
+                    (e->kind == INPUT_TRUTH) ? "truth" : "edge", e->row, e->col, e->level);
+        }
+    }
+    fclose(f);
+
+    free(events.items);
+    return 0;
+}
+
+//--------------------------------------------------------------------+
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "synth") == 0) {
+        return synth(argc - 1, argv + 1);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "run") == 0) {
+        enum { OPT_POLL = 256, OPT_SETTLE, OPT_HYBRID, OPT_PROFILE };
+        static const struct option long_options[] = {
+            {"poll-us", required_argument, NULL, OPT_POLL},
+            {"settle", required_argument, NULL, OPT_SETTLE},
+            {"hybrid", no_argument, NULL, OPT_HYBRID},
+            {"profile", required_argument, NULL, OPT_PROFILE},
+            {NULL, 0, NULL, 0},
+        };
+        int opt;
+
+        options.settle_us = 20000;
+        argc--;
+        argv++;
+        while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+            switch (opt) {
+                case OPT_POLL: options.poll_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+                case OPT_SETTLE: options.settle_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+                case OPT_HYBRID: options.hybrid = true; break;
+                case OPT_PROFILE: options.profile_path = optarg; break;
+                default: return 2;
+            }
+        }
+        if (optind + 1 == argc) {
+            return run(argv[optind]);
+        }
+    }
+
+    fprintf(stderr,
+            "usage: %s synth [-p clean|bounce|chatter|emi] [-s seed] [-k keystrokes] [-e detents] [-i idle_ms] out.txt\n"
+            "       %s run [--poll-us US] [--settle US] [--hybrid] [--profile out.jsonl] in.txt\n"
+            "  --poll-us   endpoint polling interval, 0 = report seen when sent (default)\n"
+            "  --settle    quiet time ending a burst when the input has no truth (default 20000)\n"
+            "  --hybrid    poll the matrix while keys are active (ORIONE_HYBRID_SCAN)\n"
+            "  --profile   write the interrupt handler execution times (JSON lines)\n",
+            argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,613 @@
+/**
+ * @file pico_host.c
+ * @brief Host implementation of the stubbed Pico SDK
+ *
+ * Minimal native implementation of the SDK functions declared in
+ * host/stubs, enough to link the firmware modules into host programs
+ * (benchmarks, harnesses, the replay simulator). Time is the host
+ * monotonic clock until a program takes over with a simulated clock
+ * (`host_time_set`); busy waits then advance it one microsecond per loop.
+ * Alarms are a small pool served in deadline order by `host_alarm_run_due`.
+ * GPIOs are an array of levels, IRQ edges are latched per pin, the flash
+ * is a RAM array and the clock/PLL/SysTick, PWM and DMA registers are
+ * plain memory: no PWM counter or DMA transfer runs.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/pll.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "pico/bootrom.h"
+#include "hardware/watchdog.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "hardware/dma.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/systick.h"
+
+//--------------------------------------------------------------------+
+
+#define HOST_MAX_ALARMS 32
+
+typedef struct {
+    alarm_id_t id;              // 0 = free
+    uint64_t time_us;
+    alarm_callback_t callback;
+    void* user_data;
+} host_alarm_t;
+
+static bool simulated_clock = false;
+static uint64_t simulated_us = 0;
+
+static host_alarm_t alarms[HOST_MAX_ALARMS] = {0};
+static alarm_id_t next_alarm_id = 1;
+
+static bool gpio_level[NUM_BANK0_GPIOS] = {0};
+static bool gpio_input_level[NUM_BANK0_GPIOS] = {0};    // last level seen by the edge detector
+static uint32_t gpio_irq_mask[NUM_BANK0_GPIOS] = {0};   // enabled events
+static uint32_t gpio_irq_latched[NUM_BANK0_GPIOS] = {0};
+static gpio_irq_callback_t gpio_irq_callback = NULL;
+static uint32_t gpio_hook_mask = 0;
+static host_gpio_input_fn gpio_input_hook = NULL;
+
+static clocks_hw_t host_clocks_hw = {0};
+static armv6m_scb_hw_t host_scb_hw = {0};
+static systick_hw_t host_systick_hw = {0};
+static uint32_t host_clk_sys_hz = 125 * MHZ;
+static pwm_hw_t host_pwm_hw = {0};
+static dma_hw_t host_dma_hw = {0};
+static uint32_t dma_claimed = 0;
+
+clocks_hw_t* clocks_hw = &host_clocks_hw;
+armv6m_scb_hw_t* scb_hw = &host_scb_hw;
+systick_hw_t* systick_hw = &host_systick_hw;
+pwm_hw_t* pwm_hw = &host_pwm_hw;
+dma_hw_t* dma_hw = &host_dma_hw;
+pll_hw_t* pll_sys = NULL;
+pll_hw_t* pll_usb = NULL;
+
+//--------------------------------------------------------------------+
+// TIME
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Microseconds since the first call, or the simulated clock
+ */
+uint64_t time_us_64(void) {
+    static uint64_t epoch_ns = 0;
+    struct timespec ts;
+
+    if (simulated_clock) return simulated_us;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+
+    if (epoch_ns == 0) {
+        epoch_ns = now_ns;
+    }
+    return (now_ns - epoch_ns) / 1000;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return (t + us < t || t + us > at_the_end_of_time) ? at_the_end_of_time : t + us;
+}
+
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) {
+    return delayed_by_us(t, (uint64_t)ms * 1000);
+}
+
+absolute_time_t make_timeout_time_us(uint64_t us) {
+    return delayed_by_us(get_absolute_time(), us);
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return delayed_by_ms(get_absolute_time(), ms);
+}
+
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+absolute_time_t absolute_time_min(absolute_time_t a, absolute_time_t b) {
+    return (a < b) ? a : b;
+}
+
+bool is_at_the_end_of_time(absolute_time_t t) {
+    return t == at_the_end_of_time;
+}
+
+uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+bool time_reached(absolute_time_t t) {
+    return get_absolute_time() >= t;
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp) {
+    return time_reached(timeout_timestamp);
+}
+
+void busy_wait_us(uint64_t delay_us) {
+    uint64_t start = time_us_64();
+    while (time_us_64() - start < delay_us) {
+        tight_loop_contents();
+    }
+}
+
+void busy_wait_us_32(uint32_t delay_us) {
+    busy_wait_us(delay_us);
+}
+
+void sleep_us(uint64_t us) {
+    busy_wait_us(us);
+}
+
+void sleep_ms(uint32_t ms) {
+    busy_wait_us((uint64_t)ms * 1000);
+}
+
+/**
+ * @brief Switch to the simulated clock and move it forward
+ *
+ * The clock never goes back: a time in the past (e.g. overrun by a busy
+ * wait) leaves it unchanged.
+ *
+ * @param us New time in microseconds
+ */
+void host_time_set(uint64_t us) {
+    if (!simulated_clock) {
+        simulated_clock = true;
+        simulated_us = us;
+    } else if (us > simulated_us) {
+        simulated_us = us;
+    }
+}
+
+void host_tight_loop(void) {
+    if (simulated_clock) simulated_us++;
+}
+
+// A past deadline fires on the next host_alarm_run_due, as from the alarm IRQ
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void* user_data, bool fire_if_past) {
+    (void) fire_if_past;
+
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        if (alarms[i].id != 0) continue;
+
+        alarms[i].id = next_alarm_id++;
+        if (next_alarm_id <= 0) next_alarm_id = 1;
+        alarms[i].time_us = time;
+        alarms[i].callback = callback;
+        alarms[i].user_data = user_data;
+        return alarms[i].id;
+    }
+    return -1;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past) {
+    return add_alarm_at(delayed_by_us(get_absolute_time(), us), callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        if (alarm_id != 0 && alarms[i].id == alarm_id) {
+            alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Deadline of the earliest pending alarm
+ *
+ * @param time_us Set to the deadline
+ * @return False if no alarm is pending
+ */
+bool host_alarm_next(uint64_t* time_us) {
+    bool found = false;
+
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        if (alarms[i].id == 0) continue;
+        if (!found || alarms[i].time_us < *time_us) {
+            *time_us = alarms[i].time_us;
+            found = true;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Run the alarms that are due, earliest (then oldest) first
+ *
+ * A callback returning < 0 is rescheduled that many microseconds after its
+ * deadline (a fixed rate), > 0 that many after it returns, as in the SDK.
+ *
+ * @return True if at least one alarm ran
+ */
+bool host_alarm_run_due(void) {
+    bool ran = false;
+
+    for (;;) {
+        int due = -1;
+        uint64_t now = time_us_64();
+
+        for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+            if (alarms[i].id == 0 || alarms[i].time_us > now) continue;
+            if (due < 0 || alarms[i].time_us < alarms[due].time_us ||
+                (alarms[i].time_us == alarms[due].time_us && alarms[i].id < alarms[due].id)) {
+                due = i;
+            }
+        }
+        if (due < 0) return ran;
+
+        host_alarm_t alarm = alarms[due];
+        alarms[due].id = 0;
+        ran = true;
+
+        int64_t again = alarm.callback(alarm.id, alarm.user_data);
+        if (again == 0) continue;
+
+        // same id, in its slot unless the callback took it for a new alarm
+        for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+            int slot = (due + i) % HOST_MAX_ALARMS;
+            if (alarms[slot].id != 0) continue;
+
+            alarms[slot] = alarm;
+            alarms[slot].time_us = (again < 0) ? alarm.time_us + (uint64_t)(-again) : time_us_64() + (uint64_t)again;
+            break;
+        }
+    }
+}
+
+//--------------------------------------------------------------------+
+// GPIO
+//--------------------------------------------------------------------+
+
+void gpio_init(unsigned int gpio) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_level[gpio] = false;
+}
+
+void gpio_init_mask(uint32_t gpio_mask) {
+    for (unsigned int gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (gpio_mask & (1u << gpio)) gpio_init(gpio);
+    }
+}
+
+void gpio_set_dir(unsigned int gpio, bool out) { (void) gpio; (void) out; }
+void gpio_set_dir_out_masked(uint32_t mask) { (void) mask; }
+void gpio_set_dir_in_masked(uint32_t mask) { (void) mask; }
+// an input nothing drives reads its pull
+void gpio_pull_up(unsigned int gpio) { if (gpio < NUM_BANK0_GPIOS) gpio_level[gpio] = true; }
+void gpio_pull_down(unsigned int gpio) { if (gpio < NUM_BANK0_GPIOS) gpio_level[gpio] = false; }
+void gpio_disable_pulls(unsigned int gpio) { (void) gpio; }
+void gpio_set_function(unsigned int gpio, int fn) { (void) gpio; (void) fn; }
+
+void gpio_put(unsigned int gpio, bool value) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_level[gpio] = value;
+    // outputs may change hooked inputs (e.g. a row drive seen on a column)
+    if (gpio_hook_mask) host_gpio_refresh();
+}
+
+bool gpio_get(unsigned int gpio) {
+    if (gpio >= NUM_BANK0_GPIOS) return false;
+    if ((gpio_hook_mask & (1u << gpio)) && gpio_input_hook) return gpio_input_hook(gpio);
+    return gpio_level[gpio];
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value) {
+    for (unsigned int gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (mask & (1u << gpio)) gpio_level[gpio] = (value >> gpio) & 1u;
+    }
+    if (gpio_hook_mask) host_gpio_refresh();
+}
+
+void gpio_set_mask(uint32_t mask) {
+    gpio_put_masked(mask, mask);
+}
+
+void gpio_clr_mask(uint32_t mask) {
+    gpio_put_masked(mask, 0);
+}
+
+void gpio_put_all(uint32_t value) {
+    gpio_put_masked(0xFFFFFFFFu, value);
+}
+
+uint32_t gpio_get_all(void) {
+    uint32_t value = 0;
+    for (unsigned int gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (gpio_get(gpio)) value |= 1u << gpio;
+    }
+    return value;
+}
+
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t event_mask, bool enabled) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+
+    if (enabled) {
+        gpio_irq_mask[gpio] |= event_mask;
+    } else {
+        gpio_irq_mask[gpio] &= ~event_mask;
+    }
+    // stale edges are cleared, as in the SDK
+    gpio_irq_latched[gpio] &= ~event_mask;
+    gpio_input_level[gpio] = gpio_get(gpio);
+}
+
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    gpio_irq_callback = callback;
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+}
+
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t event_mask) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_irq_latched[gpio] &= ~event_mask;
+}
+
+/**
+ * @brief Drive an input level from the host program
+ *
+ * Latches an edge if the pin has the matching IRQ enabled.
+ */
+void host_gpio_set(unsigned int gpio, bool value) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+
+    gpio_level[gpio] = value;
+    host_gpio_refresh();
+}
+
+/**
+ * @brief Compute the inputs in `mask` with a hook instead of stored levels
+ */
+void host_gpio_set_input_hook(uint32_t mask, host_gpio_input_fn hook) {
+    gpio_hook_mask = mask;
+    gpio_input_hook = hook;
+    host_gpio_refresh();
+}
+
+/**
+ * @brief Re-evaluate IRQ-enabled inputs and latch their edges
+ *
+ * Call after changing what an input hook returns.
+ */
+void host_gpio_refresh(void) {
+    for (unsigned int gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (!gpio_irq_mask[gpio]) continue;
+
+        bool level = gpio_get(gpio);
+        if (level == gpio_input_level[gpio]) continue;
+
+        gpio_input_level[gpio] = level;
+        gpio_irq_latched[gpio] |= (level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL) & gpio_irq_mask[gpio];
+    }
+}
+
+/**
+ * @brief Deliver latched GPIO edges to the callback, lowest pin first
+ *
+ * Edges latched by the callbacks themselves are delivered in the same call.
+ *
+ * @return True if the callback ran
+ */
+bool host_gpio_irq_dispatch(void) {
+    bool ran = false;
+    bool again = true;
+
+    while (again) {
+        again = false;
+        for (unsigned int gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+            // edges of pins disabled by an earlier callback stay latched
+            uint32_t events = gpio_irq_latched[gpio] & gpio_irq_mask[gpio];
+            if (!events) continue;
+
+            gpio_irq_latched[gpio] &= ~events;
+            if (gpio_irq_callback) {
+                gpio_irq_callback(gpio, events);
+                ran = true;
+            }
+            again = true;
+        }
+    }
+    return ran;
+}
+
+//--------------------------------------------------------------------+
+// CLOCKS
+//--------------------------------------------------------------------+
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return (clk_index == clk_sys || clk_index == clk_peri) ? host_clk_sys_hz : 48 * MHZ;
+}
+
+void set_sys_clock_48mhz(void) {
+    host_clk_sys_hz = 48 * MHZ;
+}
+
+bool set_sys_clock_khz(uint32_t freq_khz, bool required) {
+    (void) required;
+    host_clk_sys_hz = freq_khz * KHZ;
+    return true;
+}
+
+void pll_init(pll_hw_t* pll, unsigned int ref_div, unsigned int vco_freq, unsigned int post_div1, unsigned int post_div2) {
+    (void) pll;
+    (void) ref_div;
+    (void) vco_freq;
+    (void) post_div1;
+    (void) post_div2;
+}
+
+void pll_deinit(pll_hw_t* pll) {
+    (void) pll;
+}
+
+//--------------------------------------------------------------------+
+// PWM
+//--------------------------------------------------------------------+
+
+unsigned int pwm_gpio_to_slice_num(unsigned int gpio) {
+    return (gpio >> 1) & 7u;
+}
+
+void pwm_set_clkdiv_int_frac(unsigned int slice_num, uint8_t integer, uint8_t fract) {
+    pwm_hw->slice[slice_num].div = ((uint32_t)integer << 4) | fract;
+}
+
+void pwm_set_wrap(unsigned int slice_num, uint16_t wrap) {
+    pwm_hw->slice[slice_num].top = wrap;
+}
+
+void pwm_set_both_levels(unsigned int slice_num, uint16_t level_a, uint16_t level_b) {
+    pwm_hw->slice[slice_num].cc = ((uint32_t)level_b << 16) | level_a;
+}
+
+void pwm_set_enabled(unsigned int slice_num, bool enabled) {
+    pwm_hw->slice[slice_num].csr = enabled;
+}
+
+//--------------------------------------------------------------------+
+// DMA
+//--------------------------------------------------------------------+
+
+#define HOST_DMA_CTRL_DATA_SIZE_LSB 2
+#define HOST_DMA_CTRL_INCR_READ_BITS (1u << 4)
+#define HOST_DMA_CTRL_INCR_WRITE_BITS (1u << 5)
+#define HOST_DMA_CTRL_CHAIN_TO_LSB 11
+#define HOST_DMA_CTRL_TREQ_SEL_LSB 15
+
+int dma_claim_unused_channel(bool required) {
+    for (int channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (!(dma_claimed & (1u << channel))) {
+            dma_claimed |= 1u << channel;
+            return channel;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "host: no DMA channel left\n");
+        exit(1);
+    }
+    return -1;
+}
+
+// 8-bit transfers, read increment, no write increment, no DREQ, chained to itself (none)
+dma_channel_config dma_channel_get_default_config(unsigned int channel) {
+    dma_channel_config c = {
+        .ctrl = HOST_DMA_CTRL_INCR_READ_BITS |
+                ((uint32_t)channel << HOST_DMA_CTRL_CHAIN_TO_LSB) |
+                ((uint32_t)DREQ_FORCE << HOST_DMA_CTRL_TREQ_SEL_LSB),
+    };
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size) {
+    c->ctrl = (c->ctrl & ~(3u << HOST_DMA_CTRL_DATA_SIZE_LSB)) | ((uint32_t)size << HOST_DMA_CTRL_DATA_SIZE_LSB);
+}
+
+void channel_config_set_read_increment(dma_channel_config* c, bool incr) {
+    c->ctrl = incr ? (c->ctrl | HOST_DMA_CTRL_INCR_READ_BITS) : (c->ctrl & ~HOST_DMA_CTRL_INCR_READ_BITS);
+}
+
+void channel_config_set_write_increment(dma_channel_config* c, bool incr) {
+    c->ctrl = incr ? (c->ctrl | HOST_DMA_CTRL_INCR_WRITE_BITS) : (c->ctrl & ~HOST_DMA_CTRL_INCR_WRITE_BITS);
+}
+
+void channel_config_set_dreq(dma_channel_config* c, unsigned int dreq) {
+    c->ctrl = (c->ctrl & ~(0x3Fu << HOST_DMA_CTRL_TREQ_SEL_LSB)) | ((uint32_t)dreq << HOST_DMA_CTRL_TREQ_SEL_LSB);
+}
+
+void channel_config_set_chain_to(dma_channel_config* c, unsigned int chain_to) {
+    c->ctrl = (c->ctrl & ~(0xFu << HOST_DMA_CTRL_CHAIN_TO_LSB)) | ((uint32_t)chain_to << HOST_DMA_CTRL_CHAIN_TO_LSB);
+}
+
+void dma_channel_set_config(unsigned int channel, const dma_channel_config* config, bool trigger) {
+    (void) trigger;
+    dma_hw->ch[channel].ctrl_trig = config->ctrl;
+}
+
+void dma_channel_configure(unsigned int channel, const dma_channel_config* config, volatile void* write_addr,
+                           const volatile void* read_addr, uint32_t transfer_count, bool trigger) {
+    dma_hw->ch[channel].read_addr = read_addr;
+    dma_hw->ch[channel].write_addr = write_addr;
+    dma_hw->ch[channel].transfer_count = transfer_count;
+    dma_channel_set_config(channel, config, trigger);
+}
+
+void dma_channel_abort(unsigned int channel) {
+    (void) channel;
+}
+
+//--------------------------------------------------------------------+
+// FLASH
+//--------------------------------------------------------------------+
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+__attribute__((constructor))
+static void host_flash_init(void) {
+    memset(host_flash, 0xFF, sizeof(host_flash));
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs + count > sizeof(host_flash)) return;
+    memset(&host_flash[flash_offs], 0xFF, count);
+}
+
+// NOR programming only clears bits
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count) {
+    if (flash_offs + count > sizeof(host_flash)) return;
+    for (size_t i = 0; i < count; i++) {
+        host_flash[flash_offs + i] &= data[i];
+    }
+}
+
+int flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms) {
+    (void) enter_exit_timeout_ms;
+    func(param);
+    return PICO_OK;
+}
+
+//--------------------------------------------------------------------+
+// RESET
+//--------------------------------------------------------------------+
+
+void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask, uint32_t disable_interface_mask) {
+    fprintf(stderr, "host: reset to the bootloader (activity 0x%08x, disabled 0x%x)\n",
+            (unsigned)usb_activity_gpio_pin_mask, (unsigned)disable_interface_mask);
+}
+
+void watchdog_reboot(uint32_t pc, uint32_t sp, uint32_t delay_ms) {
+    (void) pc;
+    (void) sp;
+    fprintf(stderr, "host: watchdog reboot in %u ms\n", (unsigned)delay_ms);
+}
+
+//--------------------------------------------------------------------+
+
+irq_handler_t irq_get_vtable_handler(unsigned int num) {
+    (void) num;
+    return NULL;
+}
+
+bool stdio_init_all(void) {
+    return true;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file sim_device.c
+ * @brief Stand-in keyboard for the host tools
+ *
+ * Serves the vendor interface of the unchanged firmware (vendor.c,
+ * settings.c and the modules behind them, on the host SDK) on a unix
+ * socket, so orione_ctl and trace_decoder run without a board:
+ *
+ *   ./build-host/sim_device -f flash.bin /tmp/orione.sock &
+ *   ./build-host/orione_ctl -d sim:/tmp/orione.sock dump
+ *
+ * Each message is a kind byte and one 64 byte report (orione_hid.h). One
+ * host connects at a time; the vendor state is reset when it leaves, as
+ * on a USB unmount. With -f the simulated flash (saved settings, key
+ * statistics) is loaded from the file at start and written back after
+ * every change, so saved settings come back when the stand-in restarts.
+ *
+ * usage:
+ *   sim_device [-f flash.bin] socket
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "hardware/flash.h"
+#include "tusb.h"
+
+#include "src/debounce/tuner/tuner.h"
+#include "src/gamepad/gamepad.h"
+#include "src/keystats/keystats.h"
+#include "src/matrix/keymap/keymap.h"
+#include "src/profile/profile.h"
+#include "src/settings/settings.h"
+#include "src/usb/vendor/vendor.h"
+#include "orione_hid/orione_hid.h"
+
+//--------------------------------------------------------------------+
+
+// Firmware globals normally defined in main.c
+keyboard_state_t kbd_state = {0};
+
+static int client = -1;                 // connected host, -1 = none
+static bool sent = false;               // vendor_task sent a packet
+static const char* flash_path = NULL;
+static uint8_t flash_written[PICO_FLASH_SIZE_BYTES];   // contents of the flash file
+static volatile sig_atomic_t stop = 0;
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+static void on_signal(int sig) {
+    (void) sig;
+    stop = 1;
+}
+
+bool tud_mounted(void) { return client >= 0; }
+bool tud_suspended(void) { return false; }
+bool tud_remote_wakeup(void) { return false; }
+bool tud_task_event_ready(void) { return false; }
+
+bool tud_hid_n_ready(uint8_t instance) {
+    return instance == HID_INSTANCE_VENDOR && client >= 0;
+}
+
+/**
+ * @brief Vendor endpoint: the report goes to the connected host
+ */
+bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const* report, uint16_t len) {
+    uint8_t msg[ORIONE_SIM_MSG_SIZE] = {ORIONE_SIM_IN};
+    (void) report_id;
+
+    if (!tud_hid_n_ready(instance)) return false;
+
+    memcpy(&msg[1], report, (len < VENDOR_REPORT_SIZE) ? len : VENDOR_REPORT_SIZE);
+    if (send(client, msg, sizeof(msg), MSG_NOSIGNAL) != (ssize_t)sizeof(msg)) return false;
+
+    sent = true;
+    return true;
+}
+
+static void flash_load(void) {
+    FILE* f = fopen(flash_path, "rb");
+    if (f) {
+        size_t n = fread(host_flash, 1, sizeof(host_flash), f);
+        fclose(f);
+        fprintf(stderr, "flash: %zu bytes from %s\n", n, flash_path);
+    }
+    memcpy(flash_written, host_flash, sizeof(flash_written));
+}
+
+static void flash_store(void) {
+    if (!flash_path || memcmp(flash_written, host_flash, sizeof(host_flash)) == 0) return;
+
+    FILE* f = fopen(flash_path, "wb");
+    if (!f || fwrite(host_flash, 1, sizeof(host_flash), f) != sizeof(host_flash)) {
+        perror(flash_path);
+    }
+    if (f) fclose(f);
+    memcpy(flash_written, host_flash, sizeof(flash_written));
+}
+
+/**
+ * @brief Handle one message of the host
+ *
+ * @return False when the host left
+ */
+static bool serve_message(void) {
+    uint8_t msg[ORIONE_SIM_MSG_SIZE];
+
+    ssize_t n = recv(client, msg, sizeof(msg), 0);
+    if (n < 0 && errno == EINTR) return true;
+    if (n <= 0) return false;
+    if (n != (ssize_t)sizeof(msg)) return true;
+
+    switch (msg[0]) {
+        case ORIONE_SIM_OUT: {
+            vendor_receive(&msg[1], VENDOR_REPORT_SIZE);
+        }
+        break;
+
+        case ORIONE_SIM_SET_FEATURE: {
+            vendor_set_feature(&msg[1], VENDOR_REPORT_SIZE);
+        }
+        break;
+
+        case ORIONE_SIM_GET_FEATURE: {
+            uint8_t answer[ORIONE_SIM_MSG_SIZE] = {ORIONE_SIM_FEATURE};
+            vendor_get_feature(&answer[1], VENDOR_REPORT_SIZE);
+            send(client, answer, sizeof(answer), MSG_NOSIGNAL);
+        }
+        break;
+
+        default:
+        break;
+    }
+
+    // TASK_VENDOR, woken again by every completed report
+    do {
+        sent = false;
+        vendor_task();
+    } while (sent);
+
+    flash_store();
+    return true;
+}
+
+//--------------------------------------------------------------------+
+
+int main(int argc, char** argv) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:")) != -1) {
+        switch (opt) {
+            case 'f': flash_path = optarg; break;
+            default: return 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, "usage: %s [-f flash.bin] socket\n", argv[0]);
+        return 2;
+    }
+
+    const char* socket_path = argv[optind];
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "%s: path too long\n", socket_path);
+        return 2;
+    }
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+
+    if (flash_path) flash_load();
+
+    // boot sequence of main.c init()
+    keymap_init();
+    gamepad_init();
+    profile_init();
+    keystats_init();
+    tuner_init();
+    settings_init();
+    fprintf(stderr, "%s settings\n", settings_loaded() ? "saved" : "compiled");
+
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    unlink(socket_path);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0) {
+        perror(socket_path);
+        return 1;
+    }
+
+    struct sigaction action = {.sa_handler = on_signal};
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    fprintf(stderr, "serving on %s, Ctrl-C to stop\n", socket_path);
+
+    while (!stop) {
+        client = accept(listener, NULL, NULL);
+        if (client < 0) continue;
+
+        while (!stop && serve_message()) {
+        }
+
+        close(client);
+        client = -1;
+        vendor_reset();
+    }
+
+    close(listener);
+    unlink(socket_path);
+    return 0;
+}
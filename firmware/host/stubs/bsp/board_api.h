@@ -0,0 +1,19 @@
+/**
+ * @file board_api.h
+ * @brief Host stand-in for the TinyUSB BSP `bsp/board_api.h`
+ */
+
+#ifndef HOST_BSP_BOARD_API_H
+#define HOST_BSP_BOARD_API_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    void board_init(void);
+    void board_init_after_tusb(void) __attribute__((weak));
+    void board_led_write(bool state);
+    uint32_t board_millis(void);
+    size_t board_usb_get_serial(uint16_t desc_str1[], size_t max_chars);
+
+#endif /* HOST_BSP_BOARD_API_H */
@@ -0,0 +1,63 @@
+/**
+ * @file clocks.h
+ * @brief Host stand-in for the Pico SDK `hardware/clocks.h`
+ *
+ * Clock frequencies are plain values held by the host SDK; the sleep
+ * enable registers are ordinary memory.
+ */
+
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #define KHZ 1000
+    #define MHZ 1000000
+
+    enum clock_index {
+        clk_gpout0 = 0,
+        clk_gpout1,
+        clk_gpout2,
+        clk_gpout3,
+        clk_ref,
+        clk_sys,
+        clk_peri,
+        clk_usb,
+        clk_adc,
+        clk_rtc,
+        CLK_COUNT
+    };
+
+    typedef struct {
+        volatile uint32_t sleep_en0;
+        volatile uint32_t sleep_en1;
+        volatile uint32_t wake_en0;
+        volatile uint32_t wake_en1;
+    } clocks_hw_t;
+
+    extern clocks_hw_t* clocks_hw;
+
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_CLOCKS_BITS        (1u << 0)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS     (1u << 3)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS            (1u << 10)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS          (1u << 14)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_PLL_SYS_BITS       (1u << 17)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_PLL_USB_BITS       (1u << 18)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS         (1u << 28)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS         (1u << 29)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS         (1u << 30)
+    #define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS         (1u << 31)
+    #define CLOCKS_SLEEP_EN1_CLK_SYS_SRAM4_BITS         (1u << 0)
+    #define CLOCKS_SLEEP_EN1_CLK_SYS_SRAM5_BITS         (1u << 1)
+    #define CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS         (1u << 2)
+    #define CLOCKS_SLEEP_EN1_CLK_SYS_WATCHDOG_BITS      (1u << 10)
+    #define CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS       (1u << 11)
+    #define CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS       (1u << 12)
+    #define CLOCKS_SLEEP_EN1_CLK_SYS_XOSC_BITS          (1u << 13)
+
+    uint32_t clock_get_hz(enum clock_index clk_index);
+    void set_sys_clock_48mhz(void);
+    bool set_sys_clock_khz(uint32_t freq_khz, bool required);
+
+#endif /* HOST_HARDWARE_CLOCKS_H */
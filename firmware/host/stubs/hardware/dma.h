@@ -0,0 +1,56 @@
+/**
+ * @file dma.h
+ * @brief Host stand-in for the Pico SDK `hardware/dma.h`
+ *
+ * Channels can be claimed and configured, and their registers are plain
+ * memory, but no transfer ever runs.
+ */
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #define NUM_DMA_CHANNELS 12
+
+    #define DREQ_PWM_WRAP0 24
+    #define DREQ_FORCE 63
+
+    enum dma_channel_transfer_size {
+        DMA_SIZE_8 = 0,
+        DMA_SIZE_16 = 1,
+        DMA_SIZE_32 = 2,
+    };
+
+    typedef struct {
+        uint32_t ctrl;
+    } dma_channel_config;
+
+    typedef struct {
+        volatile const void* read_addr;
+        volatile void* write_addr;
+        volatile uint32_t transfer_count;
+        volatile uint32_t ctrl_trig;
+        volatile const void* al3_read_addr_trig;
+    } dma_channel_hw_t;
+
+    typedef struct {
+        dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+    } dma_hw_t;
+
+    extern dma_hw_t* dma_hw;
+
+    int dma_claim_unused_channel(bool required);
+    dma_channel_config dma_channel_get_default_config(unsigned int channel);
+    void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size);
+    void channel_config_set_read_increment(dma_channel_config* c, bool incr);
+    void channel_config_set_write_increment(dma_channel_config* c, bool incr);
+    void channel_config_set_dreq(dma_channel_config* c, unsigned int dreq);
+    void channel_config_set_chain_to(dma_channel_config* c, unsigned int chain_to);
+    void dma_channel_set_config(unsigned int channel, const dma_channel_config* config, bool trigger);
+    void dma_channel_configure(unsigned int channel, const dma_channel_config* config, volatile void* write_addr,
+                               const volatile void* read_addr, uint32_t transfer_count, bool trigger);
+    void dma_channel_abort(unsigned int channel);
+
+#endif /* HOST_HARDWARE_DMA_H */
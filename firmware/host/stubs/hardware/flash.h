@@ -0,0 +1,28 @@
+/**
+ * @file flash.h
+ * @brief Host stand-in for the Pico SDK `hardware/flash.h`
+ *
+ * The flash is a RAM array mapped at `XIP_BASE`, erased to 0xFF at start;
+ * programming clears bits like NOR flash. Smaller than the Pico flash:
+ * only the storage logs at its end are used.
+ */
+
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+    #include <stdint.h>
+    #include <stddef.h>
+
+    #define FLASH_PAGE_SIZE (1u << 8)
+    #define FLASH_SECTOR_SIZE (1u << 12)
+
+    #define PICO_FLASH_SIZE_BYTES (64 * 1024)
+
+    extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+    #define XIP_BASE ((uintptr_t)host_flash)
+
+    void flash_range_erase(uint32_t flash_offs, size_t count);
+    void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count);
+
+#endif /* HOST_HARDWARE_FLASH_H */
@@ -0,0 +1,65 @@
+/**
+ * @file gpio.h
+ * @brief Host stand-in for the Pico SDK `hardware/gpio.h`
+ *
+ * GPIOs are plain levels held by the host SDK: outputs keep the last value
+ * written, inputs read what the host program sets (see `host_gpio_set`) or
+ * what an input hook computes from the outputs (e.g. a key matrix). Edges
+ * on IRQ-enabled pins are latched and delivered to the GPIO callback by
+ * `host_gpio_irq_dispatch`, like the IO bank interrupt.
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #define NUM_BANK0_GPIOS 30
+
+    enum gpio_irq_level {
+        GPIO_IRQ_LEVEL_LOW = 0x1u,
+        GPIO_IRQ_LEVEL_HIGH = 0x2u,
+        GPIO_IRQ_EDGE_FALL = 0x4u,
+        GPIO_IRQ_EDGE_RISE = 0x8u,
+    };
+
+    enum gpio_function {
+        GPIO_FUNC_PWM = 4,
+        GPIO_FUNC_SIO = 5,
+    };
+
+    typedef void (*gpio_irq_callback_t)(unsigned int gpio, uint32_t event_mask);
+
+    void gpio_init(unsigned int gpio);
+    void gpio_init_mask(uint32_t gpio_mask);
+    void gpio_set_dir(unsigned int gpio, bool out);
+    void gpio_set_dir_out_masked(uint32_t mask);
+    void gpio_set_dir_in_masked(uint32_t mask);
+    void gpio_pull_up(unsigned int gpio);
+    void gpio_pull_down(unsigned int gpio);
+    void gpio_disable_pulls(unsigned int gpio);
+    void gpio_set_function(unsigned int gpio, int fn);
+
+    void gpio_put(unsigned int gpio, bool value);
+    bool gpio_get(unsigned int gpio);
+    void gpio_set_mask(uint32_t mask);
+    void gpio_clr_mask(uint32_t mask);
+    void gpio_put_masked(uint32_t mask, uint32_t value);
+    void gpio_put_all(uint32_t value);
+    uint32_t gpio_get_all(void);
+
+    void gpio_set_irq_enabled(unsigned int gpio, uint32_t event_mask, bool enabled);
+    void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback);
+    void gpio_acknowledge_irq(unsigned int gpio, uint32_t event_mask);
+
+    // host only: level of an input computed from the other pins
+    typedef bool (*host_gpio_input_fn)(unsigned int gpio);
+
+    // host only: drive the level seen by gpio_get on an input
+    void host_gpio_set(unsigned int gpio, bool value);
+    void host_gpio_set_input_hook(uint32_t mask, host_gpio_input_fn hook);
+    void host_gpio_refresh(void);
+    bool host_gpio_irq_dispatch(void);
+
+#endif /* HOST_HARDWARE_GPIO_H */
@@ -0,0 +1,18 @@
+/**
+ * @file irq.h
+ * @brief Host stand-in for the Pico SDK `hardware/irq.h`
+ *
+ * The host has no vector table: no handler is ever installed.
+ */
+
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+    typedef void (*irq_handler_t)(void);
+
+    #define VTABLE_FIRST_IRQ 16
+    #define USBCTRL_IRQ 5
+
+    irq_handler_t irq_get_vtable_handler(unsigned int num);
+
+#endif /* HOST_HARDWARE_IRQ_H */
@@ -0,0 +1,17 @@
+/**
+ * @file pll.h
+ * @brief Host stand-in for the Pico SDK `hardware/pll.h`
+ */
+
+#ifndef HOST_HARDWARE_PLL_H
+#define HOST_HARDWARE_PLL_H
+
+    typedef struct pll_hw pll_hw_t;
+
+    extern pll_hw_t* pll_sys;
+    extern pll_hw_t* pll_usb;
+
+    void pll_init(pll_hw_t* pll, unsigned int ref_div, unsigned int vco_freq, unsigned int post_div1, unsigned int post_div2);
+    void pll_deinit(pll_hw_t* pll);
+
+#endif /* HOST_HARDWARE_PLL_H */
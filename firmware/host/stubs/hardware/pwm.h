@@ -0,0 +1,37 @@
+/**
+ * @file pwm.h
+ * @brief Host stand-in for the Pico SDK `hardware/pwm.h`
+ *
+ * The PWM slice registers are plain memory: levels and dividers keep the
+ * last value written, and no counter runs.
+ */
+
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #define NUM_PWM_SLICES 8
+
+    typedef struct {
+        volatile uint32_t csr;
+        volatile uint32_t div;
+        volatile uint32_t ctr;
+        volatile uint32_t cc;
+        volatile uint32_t top;
+    } pwm_slice_hw_t;
+
+    typedef struct {
+        pwm_slice_hw_t slice[NUM_PWM_SLICES];
+    } pwm_hw_t;
+
+    extern pwm_hw_t* pwm_hw;
+
+    unsigned int pwm_gpio_to_slice_num(unsigned int gpio);
+    void pwm_set_clkdiv_int_frac(unsigned int slice_num, uint8_t integer, uint8_t fract);
+    void pwm_set_wrap(unsigned int slice_num, uint16_t wrap);
+    void pwm_set_both_levels(unsigned int slice_num, uint16_t level_a, uint16_t level_b);
+    void pwm_set_enabled(unsigned int slice_num, bool enabled);
+
+#endif /* HOST_HARDWARE_PWM_H */
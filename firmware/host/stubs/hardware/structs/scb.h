@@ -0,0 +1,23 @@
+/**
+ * @file scb.h
+ * @brief Host stand-in for the Pico SDK `hardware/structs/scb.h`
+ */
+
+#ifndef HOST_HARDWARE_STRUCTS_SCB_H
+#define HOST_HARDWARE_STRUCTS_SCB_H
+
+    #include <stdint.h>
+
+    typedef struct {
+        volatile uint32_t cpuid;
+        volatile uint32_t icsr;
+        volatile uint32_t vtor;
+        volatile uint32_t aircr;
+        volatile uint32_t scr;
+    } armv6m_scb_hw_t;
+
+    extern armv6m_scb_hw_t* scb_hw;
+
+    #define M0PLUS_SCR_SLEEPDEEP_BITS (1u << 2)
+
+#endif /* HOST_HARDWARE_STRUCTS_SCB_H */
@@ -0,0 +1,23 @@
+/**
+ * @file systick.h
+ * @brief Host stand-in for the Pico SDK `hardware/structs/systick.h`
+ */
+
+#ifndef HOST_HARDWARE_STRUCTS_SYSTICK_H
+#define HOST_HARDWARE_STRUCTS_SYSTICK_H
+
+    #include <stdint.h>
+
+    typedef struct {
+        volatile uint32_t csr;
+        volatile uint32_t rvr;
+        volatile uint32_t cvr;
+        volatile uint32_t calib;
+    } systick_hw_t;
+
+    extern systick_hw_t* systick_hw;
+
+    #define M0PLUS_SYST_CSR_ENABLE_BITS (1u << 0)
+    #define M0PLUS_SYST_CSR_CLKSOURCE_BITS (1u << 2)
+
+#endif /* HOST_HARDWARE_STRUCTS_SYSTICK_H */
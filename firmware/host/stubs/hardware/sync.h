@@ -0,0 +1,36 @@
+/**
+ * @file sync.h
+ * @brief Host stand-in for the Pico SDK `hardware/sync.h`
+ *
+ * The host runs single threaded with no interrupts, so barriers and
+ * interrupt masking reduce to compiler barriers.
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+    #include <stdint.h>
+
+    static inline void __compiler_memory_barrier(void) {
+        __asm__ volatile ("" : : : "memory");
+    }
+
+    static inline void __dmb(void) { __compiler_memory_barrier(); }
+    static inline void __dsb(void) { __compiler_memory_barrier(); }
+    static inline void __isb(void) { __compiler_memory_barrier(); }
+    static inline void __sev(void) {}
+    static inline void __wfe(void) {}
+    static inline void __wfi(void) {}
+    static inline void __nop(void) {}
+
+    static inline uint32_t save_and_disable_interrupts(void) {
+        __compiler_memory_barrier();
+        return 0;
+    }
+
+    static inline void restore_interrupts(uint32_t status) {
+        (void) status;
+        __compiler_memory_barrier();
+    }
+
+#endif /* HOST_HARDWARE_SYNC_H */
@@ -0,0 +1,15 @@
+/**
+ * @file watchdog.h
+ * @brief Host stand-in for the Pico SDK `hardware/watchdog.h`
+ *
+ * There is no chip to reset: the host SDK only logs the call.
+ */
+
+#ifndef HOST_HARDWARE_WATCHDOG_H
+#define HOST_HARDWARE_WATCHDOG_H
+
+    #include <stdint.h>
+
+    void watchdog_reboot(uint32_t pc, uint32_t sp, uint32_t delay_ms);
+
+#endif /* HOST_HARDWARE_WATCHDOG_H */
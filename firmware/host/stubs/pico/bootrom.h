@@ -0,0 +1,15 @@
+/**
+ * @file bootrom.h
+ * @brief Host stand-in for the Pico SDK `pico/bootrom.h`
+ *
+ * There is no ROM bootloader to enter: the host SDK only logs the call.
+ */
+
+#ifndef HOST_PICO_BOOTROM_H
+#define HOST_PICO_BOOTROM_H
+
+    #include <stdint.h>
+
+    void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask, uint32_t disable_interface_mask);
+
+#endif /* HOST_PICO_BOOTROM_H */
@@ -0,0 +1,17 @@
+/**
+ * @file flash.h
+ * @brief Host stand-in for the Pico SDK `pico/flash.h`
+ *
+ * Nothing runs concurrently on the host: the function is called directly.
+ */
+
+#ifndef HOST_PICO_FLASH_H
+#define HOST_PICO_FLASH_H
+
+    #include <stdint.h>
+
+    #define PICO_OK 0
+
+    int flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms);
+
+#endif /* HOST_PICO_FLASH_H */
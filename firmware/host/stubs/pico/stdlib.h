@@ -0,0 +1,40 @@
+/**
+ * @file stdlib.h
+ * @brief Host stand-in for the Pico SDK `pico/stdlib.h`
+ *
+ * Declares the subset of the Pico SDK used by the firmware sources, so they
+ * can be compiled natively and linked against the host SDK (sdk/pico_host.c).
+ * Section placement macros expand to nothing on the host.
+ */
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+    #include <string.h>
+    #include <stdio.h>
+
+    typedef unsigned int uint;
+
+    #define __not_in_flash_func(func_name) func_name
+    #define __time_critical_func(func_name) func_name
+    #define __no_inline_not_in_flash_func(func_name) func_name
+    #define __not_in_flash(group)
+    #define __isr
+
+    #define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+    #include "hardware/gpio.h"
+    #include "hardware/sync.h"
+    #include "pico/time.h"
+
+    // advances the simulated clock, so busy waits end
+    static inline void tight_loop_contents(void) {
+        host_tight_loop();
+    }
+
+    bool stdio_init_all(void);
+
+#endif /* HOST_PICO_STDLIB_H */
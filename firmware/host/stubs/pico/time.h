@@ -0,0 +1,55 @@
+/**
+ * @file time.h
+ * @brief Host stand-in for the Pico SDK `pico/time.h`
+ *
+ * Timestamps come from the host monotonic clock, in microseconds since the
+ * host SDK was first used, or from a simulated clock once the host program
+ * sets it with `host_time_set`. Alarms are kept in a pool and run by the
+ * host program with `host_alarm_run_due` (see sdk/pico_host.c).
+ */
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    typedef uint64_t absolute_time_t;
+    typedef int32_t alarm_id_t;
+    typedef int64_t (*alarm_callback_t)(alarm_id_t id, void* user_data);
+
+    #define at_the_end_of_time ((absolute_time_t)INT64_MAX)
+    #define nil_time ((absolute_time_t)0)
+
+    uint32_t time_us_32(void);
+    uint64_t time_us_64(void);
+
+    absolute_time_t get_absolute_time(void);
+    absolute_time_t make_timeout_time_us(uint64_t us);
+    absolute_time_t make_timeout_time_ms(uint32_t ms);
+    absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us);
+    absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms);
+    int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+    absolute_time_t absolute_time_min(absolute_time_t a, absolute_time_t b);
+    bool is_at_the_end_of_time(absolute_time_t t);
+    uint64_t to_us_since_boot(absolute_time_t t);
+    uint32_t to_ms_since_boot(absolute_time_t t);
+    bool time_reached(absolute_time_t t);
+    bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp);
+
+    void busy_wait_us(uint64_t delay_us);
+    void busy_wait_us_32(uint32_t delay_us);
+    void sleep_us(uint64_t us);
+    void sleep_ms(uint32_t ms);
+
+    alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past);
+    alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void* user_data, bool fire_if_past);
+    bool cancel_alarm(alarm_id_t alarm_id);
+
+    // host only: simulated clock and alarm pool
+    void host_time_set(uint64_t us);
+    void host_tight_loop(void);
+    bool host_alarm_next(uint64_t* time_us);
+    bool host_alarm_run_due(void);
+
+#endif /* HOST_PICO_TIME_H */
@@ -0,0 +1,39 @@
+/**
+ * @file tusb.h
+ * @brief Host stand-in for the TinyUSB `tusb.h`
+ *
+ * Declares the device API used by the firmware. As in TinyUSB, the
+ * single-instance HID helpers are inline wrappers of the `_n_` functions,
+ * which the host program provides (e.g. a fake endpoint in the bench).
+ */
+
+#ifndef HOST_TUSB_H
+#define HOST_TUSB_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "class/hid/hid.h"
+
+    #define BOARD_TUD_RHPORT 0
+
+    bool tud_init(uint8_t rhport);
+    void tud_task(void);
+    bool tud_task_event_ready(void);
+    bool tud_mounted(void);
+    bool tud_suspended(void);
+    bool tud_connected(void);
+    bool tud_remote_wakeup(void);
+
+    bool tud_hid_n_ready(uint8_t instance);
+    bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const* report, uint16_t len);
+
+    static inline bool tud_hid_ready(void) {
+        return tud_hid_n_ready(0);
+    }
+
+    static inline bool tud_hid_report(uint8_t report_id, void const* report, uint16_t len) {
+        return tud_hid_n_report(0, report_id, report, len);
+    }
+
+#endif /* HOST_TUSB_H */
@@ -0,0 +1,802 @@
+/**
+ * @file trace_decoder.c
+ * @brief Event trace capture and decoder (Linux)
+ *
+ * Captures the event trace streamed by the keyboard on its vendor HID
+ * interface (see src/usb/vendor/vendor.c) through hidraw or the stand-in
+ * device (host/orione_hid), and decodes a capture into:
+ * - a readable timeline, one event per line
+ * - a Chrome trace JSON file (chrome://tracing, ui.perfetto.dev) with key
+ *   holds and bus suspends as duration slices, layer as a counter and the
+ *   other events as instants
+ *
+ * - a replay input for host/replay (-r): the column edges, each assigned
+ *   to the row of the nearest key press/release on that column; edges
+ *   right after a debounce decision are dropped, they come from the row
+ *   scan rather than from the switch
+ *
+ * A capture file is the sequence of raw 64 byte IN packets. The 32-bit
+ * firmware timestamps are unwrapped to 64 bits while decoding.
+ *
+ * `profile` reads the execution time profiler of a firmware built with
+ * ORIONE_PROFILER: run count, mean, max and log2 histogram of every IRQ
+ * entry point and task, converted from core cycles at the current clk_sys.
+ *
+ * `keystats` reads the per-key statistics feature report and prints the
+ * press count, chatter count, longest bounce and debounce time of every
+ * key as heatmaps laid out like the matrix.
+ *
+ * `boot` reads the boot stage times: when each stage was reached since
+ * the timer started and how long it took after the previous one, up to
+ * the first keyboard report taken by the host.
+ *
+ * `governor` reads the clock governor transitions: how often clk_sys was
+ * lowered and how long the last and the slowest return to full speed took
+ * after the input edge.
+ *
+ * usage:
+ *   trace_decoder capture [-d /dev/hidrawN|sim:path] [-n] out.bin   (Ctrl-C stops)
+ *   trace_decoder decode [-j trace.json] [-r replay.txt] in.bin
+ *   trace_decoder profile [-d /dev/hidrawN|sim:path] [-r]
+ *   trace_decoder keystats [-d /dev/hidrawN|sim:path] [-r]
+ *   trace_decoder boot [-d /dev/hidrawN|sim:path]
+ *   trace_decoder governor [-d /dev/hidrawN|sim:path]
+ */
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/matrix/matrix.h"
+#include "src/trace/trace.h"
+#include "src/usb/vendor/vendor.h"
+#include "orione_hid/orione_hid.h"
+
+//--------------------------------------------------------------------+
+
+// Chrome trace thread ids
+#define TID_GPIO 1
+#define TID_DEBOUNCE 2
+#define TID_HID 3
+#define TID_USB 4
+#define TID_KEY_BASE 100
+
+#define KEY_SLOTS 256
+
+// Column edges this soon after a debounce decision are caused by the row scan
+#define SCAN_WINDOW_US 200
+
+// Interval of the stop flag checks while capturing
+#define CAPTURE_POLL_MS 100
+
+// Record with its unwrapped timestamp, kept for the replay export
+typedef struct {
+    uint64_t time_us;
+    trace_record_t record;
+} timed_record_t;
+
+typedef struct {
+    FILE* json;
+    bool first_event;
+    bool have_time;
+    uint32_t last_time_us;
+    uint64_t time_us;               // unwrapped timestamp of the current record
+    uint64_t start_us;              // first timestamp, timeline origin
+    bool key_open[KEY_SLOTS];       // key hold slice open in the JSON output
+    bool suspend_open;
+    uint64_t records;
+    uint64_t dropped;
+    timed_record_t* kept;           // all records, when exporting a replay input
+    size_t kept_count;
+    size_t kept_capacity;
+    bool keep;
+} decoder_t;
+
+static volatile sig_atomic_t stop_capture = 0;
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+static void on_signal(int sig) {
+    (void) sig;
+    stop_capture = 1;
+}
+
+static const char* type_name(uint8_t type) {
+    switch (type) {
+        case TRACE_GPIO_EDGE: return "gpio_edge";
+        case TRACE_DEBOUNCE: return "debounce";
+        case TRACE_KEY_ADD: return "key_add";
+        case TRACE_KEY_REMOVE: return "key_remove";
+        case TRACE_LAYER: return "layer";
+        case TRACE_REPORT: return "report";
+        case TRACE_USB_MOUNT: return "usb_mount";
+        case TRACE_USB_UNMOUNT: return "usb_unmount";
+        case TRACE_USB_SUSPEND: return "usb_suspend";
+        case TRACE_USB_RESUME: return "usb_resume";
+        case TRACE_SCAN: return "scan";
+        default: return "?";
+    }
+}
+
+static const char* report_name(uint8_t report_id) {
+    switch (report_id) {
+        case REPORT_ID_KEYBOARD: return "keyboard";
+        case REPORT_ID_MOUSE: return "mouse";
+        case REPORT_ID_CONSUMER_CONTROL: return "consumer";
+        case REPORT_ID_GAMEPAD: return "gamepad";
+        default: return "?";
+    }
+}
+
+static void json_event(decoder_t* dec, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Append one event object to the Chrome trace JSON
+ */
+static void json_event(decoder_t* dec, const char* fmt, ...) {
+    if (!dec->json) return;
+
+    va_list args;
+    va_start(args, fmt);
+    fputs(dec->first_event ? "\n  " : ",\n  ", dec->json);
+    vfprintf(dec->json, fmt, args);
+    va_end(args);
+    dec->first_event = false;
+}
+
+static double rel_us(const decoder_t* dec) {
+    return (double)(dec->time_us - dec->start_us);
+}
+
+/**
+ * @brief Decode one record: timeline line and JSON event(s)
+ */
+static void decode_record(decoder_t* dec, const trace_record_t* record) {
+    // unwrap; the signed delta also tolerates a record pushed a few us out of order
+    if (!dec->have_time) {
+        dec->time_us = record->time_us;
+        dec->start_us = dec->time_us;
+        dec->have_time = true;
+    } else {
+        dec->time_us += (int64_t)(int32_t)(record->time_us - dec->last_time_us);
+    }
+    dec->last_time_us = record->time_us;
+    dec->records++;
+
+    if (dec->keep) {
+        if (dec->kept_count == dec->kept_capacity) {
+            dec->kept_capacity = dec->kept_capacity ? dec->kept_capacity * 2 : 4096;
+            dec->kept = realloc(dec->kept, dec->kept_capacity * sizeof(dec->kept[0]));
+            if (!dec->kept) {
+                perror("realloc");
+                exit(1);
+            }
+        }
+        dec->kept[dec->kept_count].time_us = dec->time_us - dec->start_us;
+        dec->kept[dec->kept_count].record = *record;
+        dec->kept_count++;
+    }
+
+    double t = rel_us(dec);
+    uint8_t a8 = record->arg8;
+    uint16_t a16 = record->arg16;
+
+    printf("%12.6f  %-12s ", t / 1e6, type_name(record->type));
+
+    switch (record->type) {
+        case TRACE_GPIO_EDGE: {
+            printf("gpio %u %s\n", a8, (a16 & GPIO_IRQ_EDGE_RISE) ? "rise" : "fall");
+            json_event(dec, "{\"name\":\"gpio %u\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.0f,\"pid\":1,\"tid\":%d,"
+                            "\"args\":{\"events\":%u}}", a8, t, TID_GPIO, a16);
+        }
+        break;
+
+        case TRACE_DEBOUNCE: {
+            if (a8 == TRACE_INPUT_ENCODER_BTN) {
+                printf("encoder button %s\n", a16 ? "pressed" : "released");
+                json_event(dec, "{\"name\":\"encoder button %s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.0f,\"pid\":1,\"tid\":%d}",
+                           a16 ? "pressed" : "released", t, TID_DEBOUNCE);
+            } else {
+                printf("col %u %s\n", a8, a16 ? "pressed" : "released");
+                json_event(dec, "{\"name\":\"col %u %s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.0f,\"pid\":1,\"tid\":%d}",
+                           a8, a16 ? "pressed" : "released", t, TID_DEBOUNCE);
+            }
+        }
+        break;
+
+        case TRACE_KEY_ADD:
+        case TRACE_KEY_REMOVE: {
+            bool add = record->type == TRACE_KEY_ADD;
+            unsigned slot = (a8 * MATRIX_COLS + a16) % KEY_SLOTS;
+
+            printf("row %u col %u\n", a8, a16);
+
+            // one thread per key keeps the slices of overlapping holds nested
+            if (add && !dec->key_open[slot]) {
+                json_event(dec, "{\"name\":\"key %u,%u\",\"ph\":\"B\",\"ts\":%.0f,\"pid\":1,\"tid\":%u}",
+                           a8, a16, t, TID_KEY_BASE + slot);
+                json_event(dec, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"key %u,%u\"}}",
+                           TID_KEY_BASE + slot, a8, a16);
+                dec->key_open[slot] = true;
+            } else if (!add && dec->key_open[slot]) {
+                json_event(dec, "{\"ph\":\"E\",\"ts\":%.0f,\"pid\":1,\"tid\":%u}", t, TID_KEY_BASE + slot);
+                dec->key_open[slot] = false;
+            }
+        }
+        break;
+
+        case TRACE_LAYER: {
+            printf("%u\n", a8);
+            json_event(dec, "{\"name\":\"layer\",\"ph\":\"C\",\"ts\":%.0f,\"pid\":1,\"args\":{\"layer\":%u}}", t, a8);
+        }
+        break;
+
+        case TRACE_REPORT: {
+            printf("%s (%u bytes)\n", report_name(a8), a16);
+            json_event(dec, "{\"name\":\"report %s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.0f,\"pid\":1,\"tid\":%d,"
+                            "\"args\":{\"len\":%u}}", report_name(a8), t, TID_HID, a16);
+        }
+        break;
+
+        case TRACE_USB_SUSPEND: {
+            printf("remote wakeup %s\n", a8 ? "enabled" : "disabled");
+            if (!dec->suspend_open) {
+                json_event(dec, "{\"name\":\"suspended\",\"ph\":\"B\",\"ts\":%.0f,\"pid\":1,\"tid\":%d}", t, TID_USB);
+                dec->suspend_open = true;
+            }
+        }
+        break;
+
+        case TRACE_USB_RESUME: {
+            printf("\n");
+            if (dec->suspend_open) {
+                json_event(dec, "{\"ph\":\"E\",\"ts\":%.0f,\"pid\":1,\"tid\":%d}", t, TID_USB);
+                dec->suspend_open = false;
+            }
+        }
+        break;
+
+        case TRACE_SCAN: {
+            printf("%s\n", a8 ? "polled" : "column interrupts");
+            json_event(dec, "{\"name\":\"polled scan\",\"ph\":\"C\",\"ts\":%.0f,\"pid\":1,\"args\":{\"polled\":%u}}", t, a8);
+        }
+        break;
+
+        case TRACE_USB_MOUNT:
+        case TRACE_USB_UNMOUNT: {
+            printf("\n");
+            json_event(dec, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%.0f,\"pid\":1,\"tid\":%d}",
+                       type_name(record->type), t, TID_USB);
+        }
+        break;
+
+        default: {
+            printf("type %u args %u %u\n", record->type, a8, a16);
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Close the slices still open at the end of the capture
+ */
+static void decoder_finish(decoder_t* dec) {
+    double t = rel_us(dec);
+
+    for (unsigned slot = 0; slot < KEY_SLOTS; slot++) {
+        if (dec->key_open[slot]) {
+            json_event(dec, "{\"ph\":\"E\",\"ts\":%.0f,\"pid\":1,\"tid\":%u}", t, TID_KEY_BASE + slot);
+        }
+    }
+    if (dec->suspend_open) {
+        json_event(dec, "{\"ph\":\"E\",\"ts\":%.0f,\"pid\":1,\"tid\":%d}", t, TID_USB);
+    }
+}
+
+/**
+ * @brief Row of the key event nearest in time on a column
+ *
+ * @return The row, or -1 if the column has no key event
+ */
+static int nearest_row(const decoder_t* dec, size_t index, uint8_t col) {
+    const timed_record_t* kept = dec->kept;
+    uint64_t t = kept[index].time_us;
+    int row = -1;
+    uint64_t best = UINT64_MAX;
+
+    for (size_t i = index; i-- > 0;) {
+        if (t - kept[i].time_us >= best) break;
+        uint8_t type = kept[i].record.type;
+        if ((type == TRACE_KEY_ADD || type == TRACE_KEY_REMOVE) && kept[i].record.arg16 == col) {
+            best = t - kept[i].time_us;
+            row = kept[i].record.arg8;
+            break;
+        }
+    }
+    for (size_t i = index + 1; i < dec->kept_count; i++) {
+        if (kept[i].time_us - t >= best) break;
+        uint8_t type = kept[i].record.type;
+        if ((type == TRACE_KEY_ADD || type == TRACE_KEY_REMOVE) && kept[i].record.arg16 == col) {
+            row = kept[i].record.arg8;
+            break;
+        }
+    }
+    return row;
+}
+
+/**
+ * @brief Write the column edges as a host/replay input file
+ */
+static bool export_replay(const decoder_t* dec, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    fprintf(f, "# replay input from an event trace: %llu records, %llu dropped\n",
+            (unsigned long long)dec->records, (unsigned long long)dec->dropped);
+
+    uint64_t last_decision = 0;
+    bool have_decision = false;
+
+    for (size_t i = 0; i < dec->kept_count; i++) {
+        const trace_record_t* record = &dec->kept[i].record;
+        uint64_t t = dec->kept[i].time_us;
+
+        if (record->type == TRACE_DEBOUNCE) {
+            last_decision = t;
+            have_decision = true;
+            continue;
+        }
+        if (record->type != TRACE_GPIO_EDGE) continue;
+        if (record->arg8 < COLUMN_0 || record->arg8 >= COLUMN_0 + MATRIX_COLS) continue;
+        if (have_decision && t - last_decision < SCAN_WINDOW_US) continue;
+
+        uint8_t col = record->arg8 - COLUMN_0;
+        int row = nearest_row(dec, i, col);
+        if (row < 0) continue;
+
+        fprintf(f, "%llu edge %d %u %u\n", (unsigned long long)t, row, col,
+                (record->arg16 & GPIO_IRQ_EDGE_RISE) ? 1u : 0u);
+    }
+
+    fclose(f);
+    return true;
+}
+
+//--------------------------------------------------------------------+
+// COMMANDS
+//--------------------------------------------------------------------+
+
+static int capture(int argc, char** argv) {
+    const char* device = NULL;
+    uint8_t flags = VENDOR_TRACE_FROM_OLDEST;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:n")) != -1) {
+        switch (opt) {
+            case 'd': device = optarg; break;
+            case 'n': flags = 0; break;
+            default: return 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, "usage: trace_decoder capture [-d /dev/hidrawN|sim:path] [-n] out.bin\n");
+        return 2;
+    }
+
+    orione_hid_t dev;
+    if (!orione_hid_open(&dev, device)) {
+        if (!device) {
+            fprintf(stderr, "keyboard vendor interface not found, use -d\n");
+        } else {
+            perror(device);
+        }
+        return 1;
+    }
+
+    FILE* out = fopen(argv[optind], "wb");
+    if (!out) {
+        perror(argv[optind]);
+        orione_hid_close(&dev);
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    if (!orione_hid_command(&dev, VENDOR_CMD_TRACE_START, flags)) {
+        perror("start");
+        fclose(out);
+        orione_hid_close(&dev);
+        return 1;
+    }
+    fprintf(stderr, "capturing from %s, Ctrl-C to stop\n", device ? device : "the keyboard");
+
+    uint8_t packet[VENDOR_REPORT_SIZE];
+    unsigned long packets = 0;
+
+    while (!stop_capture) {
+        int n = orione_hid_read(&dev, packet, CAPTURE_POLL_MS);
+        if (n < 0) {
+            perror("read");
+            break;
+        }
+        if (n == 0 || packet[0] != VENDOR_IN_TRACE) continue;
+
+        fwrite(packet, 1, sizeof(packet), out);
+        packets++;
+    }
+
+    orione_hid_command(&dev, VENDOR_CMD_TRACE_STOP, 0);
+    fprintf(stderr, "%lu packets\n", packets);
+
+    fclose(out);
+    orione_hid_close(&dev);
+    return 0;
+}
+
+static int profile(int argc, char** argv) {
+    const char* device = NULL;
+    bool reset = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:r")) != -1) {
+        switch (opt) {
+            case 'd': device = optarg; break;
+            case 'r': reset = true; break;
+            default: return 2;
+        }
+    }
+    if (optind != argc) {
+        fprintf(stderr, "usage: trace_decoder profile [-d /dev/hidrawN|sim:path] [-r]\n");
+        return 2;
+    }
+
+    orione_hid_t dev;
+    if (!orione_hid_open(&dev, device)) {
+        if (!device) {
+            fprintf(stderr, "keyboard vendor interface not found, use -d\n");
+        } else {
+            perror(device);
+        }
+        return 1;
+    }
+
+    vendor_profiler_packet_t entry;
+    if (!orione_hid_profiler_entry(&dev, 0, &entry)) {
+        fprintf(stderr, "no answer from the keyboard\n");
+        orione_hid_close(&dev);
+        return 1;
+    }
+    if (entry.entry_count == 0) {
+        fprintf(stderr, "firmware built without the profiler (ORIONE_PROFILER)\n");
+        orione_hid_close(&dev);
+        return 1;
+    }
+
+    double ticks_per_us = entry.ticks_per_us ? entry.ticks_per_us : 1;
+    printf("clk_sys %u MHz, histogram bin n: [2^(n-1), 2^n) cycles\n", (unsigned)entry.ticks_per_us);
+    printf("%-8s %10s %10s %10s  histogram\n", "entry", "count", "mean_us", "max_us");
+
+    for (uint8_t index = 0; index < entry.entry_count; index++) {
+        if (index > 0 && !orione_hid_profiler_entry(&dev, index, &entry)) {
+            fprintf(stderr, "no answer for entry %u\n", index);
+            orione_hid_close(&dev);
+            return 1;
+        }
+
+        char name[PROFILER_NAME_LEN + 1] = {0};
+        memcpy(name, entry.name, PROFILER_NAME_LEN);
+        double mean = entry.count ? (double)entry.total / entry.count / ticks_per_us : 0.0;
+
+        printf("%-8s %10u %10.2f %10.2f ", name, (unsigned)entry.count, mean, entry.max / ticks_per_us);
+        for (uint8_t bin = 0; bin < entry.hist_bins && bin < PROFILER_HIST_BINS; bin++) {
+            if (entry.hist[bin]) printf(" %u:%u", bin, entry.hist[bin]);
+        }
+        printf("\n");
+    }
+
+    if (reset) {
+        orione_hid_command(&dev, VENDOR_CMD_PROFILER_RESET, 0);
+    }
+
+    orione_hid_close(&dev);
+    return 0;
+}
+
+static int decode(int argc, char** argv) {
+    const char* json_path = NULL;
+    const char* replay_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:r:")) != -1) {
+        switch (opt) {
+            case 'j': json_path = optarg; break;
+            case 'r': replay_path = optarg; break;
+            default: return 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, "usage: trace_decoder decode [-j trace.json] [-r replay.txt] in.bin\n");
+        return 2;
+    }
+
+    FILE* in = fopen(argv[optind], "rb");
+    if (!in) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    decoder_t dec = {.first_event = true, .keep = replay_path != NULL};
+
+    if (json_path) {
+        dec.json = fopen(json_path, "w");
+        if (!dec.json) {
+            perror(json_path);
+            fclose(in);
+            return 1;
+        }
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", dec.json);
+        json_event(&dec, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"gpio\"}}", TID_GPIO);
+        json_event(&dec, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"debounce\"}}", TID_DEBOUNCE);
+        json_event(&dec, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"hid reports\"}}", TID_HID);
+        json_event(&dec, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"usb\"}}", TID_USB);
+    }
+
+    uint8_t packet[VENDOR_REPORT_SIZE];
+
+    while (fread(packet, 1, sizeof(packet), in) == sizeof(packet)) {
+        if (packet[0] != VENDOR_IN_TRACE) continue;
+
+        uint16_t dropped = packet[2] | (packet[3] << 8);
+        if (dropped) {
+            dec.dropped += dropped;
+            printf("%12s  --- %u records dropped ---\n", "", dropped);
+            if (dec.have_time) {
+                json_event(&dec, "{\"name\":\"%u records dropped\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.0f,\"pid\":1,\"tid\":%d}",
+                           dropped, rel_us(&dec), TID_USB);
+            }
+        }
+
+        uint8_t count = packet[1];
+        if (count > VENDOR_TRACE_RECORDS_PER_PACKET) count = VENDOR_TRACE_RECORDS_PER_PACKET;
+
+        for (uint8_t i = 0; i < count; i++) {
+            trace_record_t record;
+            memcpy(&record, &packet[VENDOR_TRACE_HEADER_LEN + i * sizeof(trace_record_t)], sizeof(record));
+            decode_record(&dec, &record);
+        }
+    }
+    fclose(in);
+
+    if (dec.json) {
+        decoder_finish(&dec);
+        fputs("\n]}\n", dec.json);
+        fclose(dec.json);
+    }
+
+    fprintf(stderr, "%llu records, %llu dropped\n", (unsigned long long)dec.records, (unsigned long long)dec.dropped);
+
+    bool ok = !replay_path || export_replay(&dec, replay_path);
+    free(dec.kept);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Print one field of the key statistics laid out like the matrix
+ */
+static void print_heatmap(const char* title, const vendor_keystats_entry_t* keys, int field) {
+    printf("%s\n", title);
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            const vendor_keystats_entry_t* key = &keys[row * MATRIX_COLS + col];
+            uint32_t value;
+            switch (field) {
+                case 0: value = key->stats.presses; break;
+                case 1: value = key->stats.chatter; break;
+                case 2: value = key->stats.max_bounce_us; break;
+                default: value = key->debounce_us; break;
+            }
+            printf(" %7u", (unsigned)value);
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+static int keystats(int argc, char** argv) {
+    const char* device = NULL;
+    bool reset = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:r")) != -1) {
+        switch (opt) {
+            case 'd': device = optarg; break;
+            case 'r': reset = true; break;
+            default: return 2;
+        }
+    }
+    if (optind != argc) {
+        fprintf(stderr, "usage: trace_decoder keystats [-d /dev/hidrawN|sim:path] [-r]\n");
+        return 2;
+    }
+
+    orione_hid_t dev;
+    if (!orione_hid_open(&dev, device)) {
+        if (!device) {
+            fprintf(stderr, "keyboard vendor interface not found, use -d\n");
+        } else {
+            perror(device);
+        }
+        return 1;
+    }
+
+    vendor_keystats_entry_t keys[KEYSTATS_KEY_COUNT] = {0};
+    vendor_keystats_page_t page;
+    uint8_t page_count = 1;
+
+    for (uint8_t p = 0; p < page_count; p++) {
+        if (!orione_hid_keystats_page(&dev, p, &page)) {
+            fprintf(stderr, "no answer for key statistics page %u\n", p);
+            orione_hid_close(&dev);
+            return 1;
+        }
+        if (p == 0 && page.keys_per_page) {
+            page_count = (page.key_count + page.keys_per_page - 1) / page.keys_per_page;
+        }
+        for (uint8_t i = 0; i < page.keys_per_page && i < VENDOR_KEYSTATS_PER_PAGE; i++) {
+            unsigned index = p * page.keys_per_page + i;
+            if (index < KEYSTATS_KEY_COUNT) keys[index] = page.keys[i];
+        }
+    }
+
+    print_heatmap("presses", keys, 0);
+    print_heatmap("chatter (transitions with re-triggers in the debounce window)", keys, 1);
+    print_heatmap("longest bounce (us)", keys, 2);
+    print_heatmap("debounce time (us)", keys, 3);
+
+    if (reset) {
+        orione_hid_command(&dev, VENDOR_CMD_KEYSTATS_RESET, 0);
+    }
+
+    orione_hid_close(&dev);
+    return 0;
+}
+
+static int boot(int argc, char** argv) {
+    const char* device = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:")) != -1) {
+        switch (opt) {
+            case 'd': device = optarg; break;
+            default: return 2;
+        }
+    }
+    if (optind != argc) {
+        fprintf(stderr, "usage: trace_decoder boot [-d /dev/hidrawN|sim:path]\n");
+        return 2;
+    }
+
+    orione_hid_t dev;
+    if (!orione_hid_open(&dev, device)) {
+        if (!device) {
+            fprintf(stderr, "keyboard vendor interface not found, use -d\n");
+        } else {
+            perror(device);
+        }
+        return 1;
+    }
+
+    vendor_boot_packet_t packet;
+    if (!orione_hid_boot_times(&dev, &packet)) {
+        fprintf(stderr, "no answer from the keyboard\n");
+        orione_hid_close(&dev);
+        return 1;
+    }
+    orione_hid_close(&dev);
+
+    // times since the timer started (SDK runtime init), the ROM and boot2 come before
+    printf("%-8s %10s %10s\n", "stage", "at_ms", "delta_ms");
+
+    uint32_t previous = 0;
+    for (uint8_t stage = 0; stage < packet.stage_count && stage < BOOT_STAGE_COUNT; stage++) {
+        if (!(packet.reached & (1u << stage))) {
+            printf("%-8s %10s %10s\n", boot_stage_name(stage), "-", "-");
+            continue;
+        }
+
+        uint32_t at = packet.time_us[stage];
+        printf("%-8s %10.3f %10.3f\n", boot_stage_name(stage), at / 1000.0, (int32_t)(at - previous) / 1000.0);
+        previous = at;
+    }
+    return 0;
+}
+
+static int governor(int argc, char** argv) {
+    const char* device = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:")) != -1) {
+        switch (opt) {
+            case 'd': device = optarg; break;
+            default: return 2;
+        }
+    }
+    if (optind != argc) {
+        fprintf(stderr, "usage: trace_decoder governor [-d /dev/hidrawN|sim:path]\n");
+        return 2;
+    }
+
+    orione_hid_t dev;
+    if (!orione_hid_open(&dev, device)) {
+        if (!device) {
+            fprintf(stderr, "keyboard vendor interface not found, use -d\n");
+        } else {
+            perror(device);
+        }
+        return 1;
+    }
+
+    vendor_governor_packet_t packet;
+    if (!orione_hid_governor_stats(&dev, &packet)) {
+        fprintf(stderr, "no answer from the keyboard\n");
+        orione_hid_close(&dev);
+        return 1;
+    }
+    orione_hid_close(&dev);
+
+    if (packet.idle_ms == 0) {
+        printf("clock governor disabled (GOVERNOR_IDLE_MS 0)\n");
+        return 0;
+    }
+
+    printf("idle before lowering  %10lu ms\n", (unsigned long)packet.idle_ms);
+    printf("lowered               %10lu times\n", (unsigned long)packet.low_count);
+    printf("restored              %10lu times\n", (unsigned long)packet.restore_count);
+    printf("restore, last         %10lu us\n", (unsigned long)packet.restore_last_us);
+    printf("restore, max          %10lu us\n", (unsigned long)packet.restore_max_us);
+    return 0;
+}
+
+//--------------------------------------------------------------------+
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "capture") == 0) {
+        return capture(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "decode") == 0) {
+        return decode(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "profile") == 0) {
+        return profile(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "keystats") == 0) {
+        return keystats(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "boot") == 0) {
+        return boot(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "governor") == 0) {
+        return governor(argc - 1, argv + 1);
+    }
+
+    fprintf(stderr,
+            "usage: %s capture [-d /dev/hidrawN] [-n] out.bin   stream the trace to a file (-n: new events only)\n"
+            "       %s decode [-j trace.json] [-r replay.txt] in.bin\n"
+            "                                                     print the timeline, write a Chrome trace\n"
+            "                                                     and/or a host/replay input\n"
+            "       %s profile [-d /dev/hidrawN] [-r]           print the IRQ/task execution times (-r: then reset)\n"
+            "       %s keystats [-d /dev/hidrawN] [-r]          print the per-key press/chatter/bounce/debounce heatmaps (-r: then reset)\n"
+            "       %s boot [-d /dev/hidrawN]                   print the boot stage times up to the first report\n"
+            "       %s governor [-d /dev/hidrawN]               print the clock governor transitions\n",
+            argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+    return 2;
+}
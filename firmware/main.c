@@ -2,8 +2,8 @@
  * @file main.c
  * @brief Main entry point for Orione keyboard firmware
  * 
- * Handles USB device initialization, main loop execution, LED status blinking,
- * and HID report generation for both keyboard matrix and rotary encoder inputs.
+ * Handles USB device initialization, main loop execution and HID report
+ * generation for both keyboard matrix and rotary encoder inputs.
  */
 
 #include <stdlib.h>
@@ -19,13 +19,29 @@
 #include "src/global.h"
 #include "src/init/init.h"
 #include "src/matrix/scan_rows/scan_rows.h"
+#include "src/scheduler/scheduler.h"
+#include "src/power/power.h"
+#include "src/power/governor/governor.h"
+#include "src/log/log.h"
+#include "src/usb/hid_report/hid_report.h"
+#include "src/usb/vendor/vendor.h"
+#include "src/mousekey/mousekey.h"
+#include "src/gamepad/gamepad.h"
+#include "src/profile/profile.h"
+#include "src/keystats/keystats.h"
+#include "src/leader/leader.h"
+#include "src/tap_dance/tap_dance.h"
+#include "src/settings/settings.h"
+#include "src/usb/config_drive/config_drive.h"
+#include "src/debounce/tuner/tuner.h"
+#include "src/profiler/profiler.h"
+#include "src/boot/boot.h"
+#include "src/reboot/reboot.h"
+#include "src/indicator/indicator.h"
 
 //--------------------------------------------------------------------+
 
-uint32_t blink_interval_ms = BLINK_NOT_MOUNTED;
-
 keyboard_state_t kbd_state = {
-    .has_new_key = false,
     .pressed_keys_count = 0,
     .current_layer = 0
 };
@@ -33,110 +49,172 @@ keyboard_state_t kbd_state = {
 //--------------------------------------------------------------------+
 
 /**
- * @brief Blink onboard LED based on USB connection status
- * 
- * Provides visual feedback of the device state:
- * - Fast blink (250ms): Not mounted/connected
- * - Slow blink (1000ms): Mounted and ready
- * - Very slow blink (2500ms): Suspended
- * - Solid on: Caps Lock active
- * - Off: Blink disabled
+ * @brief Run a rotary encoder binding
+ *
+ * Consumer codes are sent as a tap, wheel keys scroll by one detent.
+ *
+ * @param key Binding (see keymap_encoder_t)
  */
-void led_blinking_task(void) {
-    static uint32_t start_ms = 0;
-    static bool led_state = false;
-
-    // blink is disabled
-    if (!blink_interval_ms) return;
-
-    // Blink every interval ms
-    if (board_millis() - start_ms < blink_interval_ms) return;
-    start_ms += blink_interval_ms;
+static void encoder_action(uint16_t key) {
+    if (is_consumer_key(key)) {
+        hid_report_consumer_tap(KC_CONSUMER_USAGE(key));
+    } else if (key == KC_MS_WH_UP) {
+        mousekey_wheel(1);
+    } else if (key == KC_MS_WH_DOWN) {
+        mousekey_wheel(-1);
+    }
+}
 
-    board_led_write(led_state);
-    led_state = 1 - led_state;
+/**
+ * @brief Apply a change of the encoder button
+ *
+ * A tap dance binding sees every press and release, to tell the gestures
+ * apart; other bindings run on press.
+ *
+ * @param key Button binding (see keymap_encoder_t)
+ * @param pressed Button level after the change
+ */
+static void encoder_button(uint16_t key, bool pressed) {
+    if (is_tap_dance_key(key)) {
+        if (pressed) {
+            tap_dance_press(key);
+        } else {
+            tap_dance_release(key);
+        }
+    } else if (pressed) {
+        encoder_action(key);
+    }
 }
 
 /**
  * @brief Process and send HID reports for keyboard and rotary encoder
  * 
- * Polls keyboard state and rotary encoder at 10ms intervals (required by TinyUSB).
+ * Runs as TASK_HID, notified by the matrix and encoder interrupts and by
+ * `tud_hid_report_complete_cb`. Keyboard changes are detected by comparing
+ * the matrix snapshot version with the last one applied, and only the keys
+ * that changed are applied to the keyboard report (see hid_report.c). In
+ * gamepad mode the snapshot goes through the gamepad first, which takes
+ * the keys bound on its layer out of it (see gamepad.c).
+ * Reports identical to what the host already has are not sent. Sends at
+ * most one report per run, since only one report can be in flight on the
+ * HID endpoint; the completion callback wakes the task again for the next.
  * Handles:
- * - Remote wakeup when suspended
  * - Keyboard key press/release reports
- * - Rotary encoder volume control (rotation) and mute (button press)
+ * - Rotary encoder rotation and button, bound per profile
  */
 void hid_task(void) {
-    // Poll every 10ms -> required by TinyUSB
-    const uint32_t interval_ms = 10;
-    static uint32_t start_ms = 0;
-
-    // check interval
-    if (board_millis() - start_ms < interval_ms) return;
-    start_ms += interval_ms;
-
-    // Remote wakeup if suspended
-    if (tud_suspended()) {
-        if (kbd_state.has_new_key) {
-            tud_remote_wakeup();
-            kbd_state.has_new_key = false;
+    // Last matrix snapshot version applied to the keyboard report
+    static uint32_t reported_seq = 0;
+    // Gamepad mode/rule generation the reports reflect
+    static uint32_t gamepad_seq = 0;
+
+    bool gamepad_changed = gamepad_generation() != gamepad_seq;
+    bool has_new_key = matrix_snapshot_seq() != reported_seq || gamepad_changed;
+    bool has_work = has_new_key || rotary_state.has_event || hid_report_pending();
+    if (!has_work) return;
+
+    // suspended: the power task issues the remote wakeup on the input edge,
+    // the report follows after resume
+    if (tud_suspended()) return;
+
+    // Handle keyboard input: apply only the keys that changed
+    if (has_new_key) {
+        matrix_snapshot_t snapshot;
+        matrix_snapshot_read(&snapshot);
+
+        reported_seq = snapshot.seq;
+        gamepad_seq = gamepad_generation();
+
+        // Fn layer indicator, applied by TASK_LED
+        indicator_set(INDICATOR_LAYER, snapshot.current_layer != 0);
+
+        // gamepad mode: bound keys go to the gamepad report only
+        if (gamepad_active()) {
+            gamepad_update(&snapshot);
         }
-        return;
-    } else {
-        if (tud_hid_ready()) {
-            // Handle keyboard input
-            if (kbd_state.has_new_key) {
-                // Clear flag
-                kbd_state.has_new_key = false;
-                // send report
-                send_hid_report(REPORT_ID_KEYBOARD, 0);
-            }
-
-            // Handle rotary encoder input
-            int8_t direction;
-            bool button_pressed;
-            
-            rotary_encoder_get_state(&direction, &button_pressed);
-            
-            if (button_pressed) {
-                // mute/unmute
-                send_hid_report(REPORT_ID_CONSUMER_CONTROL, HID_USAGE_CONSUMER_MUTE);
-                sleep_ms(10);
-                send_hid_report(REPORT_ID_CONSUMER_CONTROL, 0);
-            } else if (direction > 0) {
-                // volume up
-                send_hid_report(REPORT_ID_CONSUMER_CONTROL, HID_USAGE_CONSUMER_VOLUME_INCREMENT);
-                sleep_ms(10);
-                send_hid_report(REPORT_ID_CONSUMER_CONTROL, 0);
-            } else if (direction < 0) {
-                // volume down
-                send_hid_report(REPORT_ID_CONSUMER_CONTROL, HID_USAGE_CONSUMER_VOLUME_DECREMENT);
-                sleep_ms(10);
-                send_hid_report(REPORT_ID_CONSUMER_CONTROL, 0);
-            }
+        hid_report_keyboard_update(&snapshot);
+    }
+
+    // Handle rotary encoder input, once the previous tap has been released
+    if (rotary_state.has_event && hid_report_tap_idle()) {
+        int8_t direction;
+        bool button_pressed;
+        uint8_t button_edges;
+
+        rotary_encoder_get_state(&direction, &button_pressed, &button_edges);
+
+        // bindings of the active profile (see config/orione.keymap)
+        const keymap_encoder_t* encoder = keymap_encoder();
 
+        // every button change in order, the last one to the current level
+        for (uint8_t edge = button_edges; edge > 0; edge--) {
+            encoder_button(encoder->press, (edge & 1) ? button_pressed : !button_pressed);
         }
+
+        if (direction > 0) {
+            encoder_action(encoder->cw);
+        } else if (direction < 0) {
+            encoder_action(encoder->ccw);
+        }
+    }
+
+    if (!hid_report_pending()) return;
+
+    // not mounted yet -> tud_mount_cb wakes the task for the first poll
+    if (!tud_mounted()) return;
+
+    // endpoint busy -> retry later
+    if (!tud_hid_ready()) {
+        scheduler_wake_in_ms(TASK_HID, HID_RETRY_MS);
+        return;
     }
+
+    // one report per run, the report complete callback triggers the next
+    hid_report_flush();
 }
 
 /**
  * @brief Initialize all hardware peripherals
  * 
- * Configures GPIO pins and interrupts for:
- * - Keyboard matrix (rows, columns, interrupts)
+ * Copies the keymap and profiles to RAM, loads the key statistics and
+ * the saved settings and configures GPIO pins and interrupts for:
+ * - Keyboard matrix (rows, columns, a first scan, interrupts)
  * - Rotary encoder (CLK, DT, SW pins and interrupts)
- * - Status LEDs (Caps Lock indicator)
+ * - Status and Caps Lock LEDs (PWM indicator patterns)
+ *
+ * The configuration drive is only built once the host has mounted the
+ * device, off the way to the first report (see config_drive.c).
  */
 void init(void) {
-    // keyboard
+    // keymap tables and profiles to RAM
+    keymap_init();
+    gamepad_init();
+    profile_init();
+
+    // key statistics from flash, before the matrix interrupts count,
+    // and the debounce times learned from them
+    keystats_init();
+    tuner_init();
+
+    // settings saved from the host over the compiled ones
+    settings_init();
+    boot_mark(BOOT_SETTINGS);
+
+    // keyboard, keys already held included
     init_keyboard_gpio();
     init_keyboard_interrupts();
-    
+    boot_mark(BOOT_MATRIX);
+
+#if CFG_TUD_MSC
+    // configuration drive with the settings as text, built on mount
+    config_drive_init();
+#endif
+
     // rotary encoder
     init_rotary_encoder_gpio();
     init_rotary_encoder_interrupts();
 
-    // Caps-Lock led
+    // status and Caps-Lock leds
     init_led();
 }
 
@@ -145,27 +223,64 @@ void init(void) {
 /**
  * @brief Main program entry point
  * 
- * Initializes the USB device stack and hardware peripherals, then enters
- * the main loop to continuously process USB tasks, update LED status,
- * and handle HID input/output.
+ * Initializes the USB device stack and hardware peripherals, registers the
+ * USB, HID, mouse keys, vendor (trace streaming), LED, power, clock governor,
+ * key statistics, leader, tap dance, configuration drive and reset tasks
+ * and hands control to the scheduler, which sleeps between USB, GPIO and
+ * timer events.
  * 
  * @return Never returns (infinite loop)
  */
 int main(void) {
-    // init TinyUSB
+    boot_mark(BOOT_MAIN);
+
+    // init TinyUSB first: the host waits 100 ms after attach before the
+    // reset, the rest of the boot runs meanwhile
     board_init();
+    boot_mark(BOOT_BOARD);
     tud_init(BOARD_TUD_RHPORT);
+    boot_mark(BOOT_USB);
     if (board_init_after_tusb) {
         board_init_after_tusb();
     }
 
+    // cycle counter and USB IRQ hook, once TinyUSB owns the IRQ
+    profiler_init();
+
     // init sys
     init();
 
+    // tasks
+    scheduler_register(TASK_USB, tud_task);
+    scheduler_register(TASK_HID, hid_task);
+    scheduler_register(TASK_MOUSE, mousekey_task);
+    scheduler_register(TASK_VENDOR, vendor_task);
+    scheduler_register(TASK_LED, indicator_task);
+    scheduler_register(TASK_POWER, power_task);
+    scheduler_register(TASK_GOVERNOR, governor_task);
+    scheduler_register(TASK_KEYSTATS, keystats_task);
+    scheduler_register(TASK_LEADER, leader_task);
+    scheduler_register(TASK_TAP_DANCE, tap_dance_task);
+#if CFG_TUD_MSC
+    scheduler_register(TASK_DRIVE, config_drive_task);
+#endif
+    scheduler_register(TASK_REBOOT, reboot_task);
+
+#if LOG_ENABLED || SCHED_STATS
+    stdio_init_all();
+#endif
+
+#if SCHED_STATS
+    scheduler_register(TASK_STATS, scheduler_report_stats);
+    scheduler_wake_in_ms(TASK_STATS, SCHED_STATS_REPORT_MS);
+#endif
+
+    scheduler_notify(TASK_USB);
+    scheduler_notify(TASK_LED);
+    scheduler_notify(TASK_GOVERNOR);
+    scheduler_wake_in_ms(TASK_KEYSTATS, KEYSTATS_CHECKPOINT_MS);
+
     // loop
-    while (1) {
-        tud_task();
-        led_blinking_task();
-        hid_task();
-    }
+    boot_mark(BOOT_LOOP);
+    scheduler_run();
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+/**
+ * @file boot.c
+ * @brief Boot timing implementation
+ *
+ * A timestamp and a reached bit per stage. Marks come from main(), from
+ * the USB callbacks and from TASK_HID, all on the main loop side, so no
+ * locking is needed.
+ */
+
+#include "boot.h"
+
+//--------------------------------------------------------------------+
+
+typedef struct {
+    uint32_t reached;                   // bit n set = stage n marked
+    uint32_t time_us[BOOT_STAGE_COUNT];
+} boot_state_t;
+
+static boot_state_t boot_state = {0};
+
+static const char* const stage_names[BOOT_STAGE_COUNT] = {
+    [BOOT_MAIN] = "main",
+    [BOOT_BOARD] = "board",
+    [BOOT_USB] = "usb",
+    [BOOT_SETTINGS] = "settings",
+    [BOOT_MATRIX] = "matrix",
+    [BOOT_LOOP] = "loop",
+    [BOOT_MOUNTED] = "mounted",
+    [BOOT_REPORT] = "report",
+};
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Record the time a stage is reached
+ *
+ * Only the first mark of a stage counts: a remount or a later report
+ * leaves the boot time alone.
+ *
+ * @param stage Boot stage
+ */
+void boot_mark(boot_stage_t stage) {
+    if (stage >= BOOT_STAGE_COUNT || (boot_state.reached & (1u << stage))) return;
+
+    boot_state.time_us[stage] = time_us_32();
+    boot_state.reached |= 1u << stage;
+}
+
+/**
+ * @brief Get the time a stage was reached
+ *
+ * @param stage Boot stage
+ * @param time_us Pointer to store the time_us_32() value
+ * @return False if the stage has not been reached (yet)
+ */
+bool boot_time(boot_stage_t stage, uint32_t* time_us) {
+    if (stage >= BOOT_STAGE_COUNT || !(boot_state.reached & (1u << stage))) return false;
+
+    *time_us = boot_state.time_us[stage];
+    return true;
+}
+
+/**
+ * @brief Get the short name of a stage
+ *
+ * @param stage Boot stage
+ * @return Name, at most BOOT_NAME_LEN characters
+ */
+const char* boot_stage_name(boot_stage_t stage) {
+    return (stage < BOOT_STAGE_COUNT) ? stage_names[stage] : "?";
+}
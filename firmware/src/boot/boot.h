@@ -0,0 +1,41 @@
+/**
+ * @file boot.h
+ * @brief Boot timing declarations
+ *
+ * Timestamps of the boot stages, from the entry of main() to the first
+ * keyboard report taken by the host, read over the vendor interface
+ * (`trace_decoder boot`). Times are time_us_32() values: the timer starts
+ * with the clocks in the SDK runtime init, so the BOOT_MAIN time is the
+ * runtime init itself and the ROM/boot2 time before it is not seen.
+ * Each stage keeps its first timestamp; later marks are ignored.
+ */
+
+#ifndef BOOT_H
+#define BOOT_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    // Longest stage name, without the terminator
+    #define BOOT_NAME_LEN 8
+
+    // Boot stages, in the order they are normally reached
+    typedef enum {
+        BOOT_MAIN = 0,          // main() entered
+        BOOT_BOARD,             // board_init done
+        BOOT_USB,               // tud_init done, pull-up on, the host starts counting
+        BOOT_SETTINGS,          // keymap, profiles, statistics and saved settings in RAM
+        BOOT_MATRIX,            // matrix scanned once, column interrupts armed
+        BOOT_LOOP,              // scheduler loop entered
+        BOOT_MOUNTED,           // configuration set by the host (tud_mount_cb)
+        BOOT_REPORT,            // first keyboard report taken by the host
+        BOOT_STAGE_COUNT
+    } boot_stage_t;
+
+    void boot_mark(boot_stage_t stage);
+    bool boot_time(boot_stage_t stage, uint32_t* time_us);
+    const char* boot_stage_name(boot_stage_t stage);
+
+#endif /* BOOT_H */
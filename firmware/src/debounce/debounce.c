@@ -0,0 +1,145 @@
+/**
+ * @file debounce.c
+ * @brief Switch debounce algorithms implementation
+ *
+ * Each input has a `debounce_t` holding its debounced (stable) level. The
+ * caller reports every edge with `debounce_edge` and, when the returned
+ * action contains DEBOUNCE_ARM, (re)arms a one-shot timer at `deadline_us`
+ * and calls `debounce_timer` with the sampled level when it expires.
+ * DEBOUNCE_CHANGED means the stable level has just changed.
+ *
+ * Algorithms:
+ * - DEFER: every edge restarts the debounce time; the level sampled once
+ *   the input has been quiet that long becomes the stable level. Immune to
+ *   short spikes, but adds the debounce time to every transition.
+ * - EAGER: the first edge away from the stable level is reported at once
+ *   and edges are ignored for the debounce time; the level is verified at
+ *   the end of the lockout. No added latency, but any spike is reported.
+ * - EAGER_PRESS: eager on press, defer on release.
+ *
+ * Times are 32-bit microsecond timestamps, compared with wrap-safe
+ * differences.
+ */
+
+#include "debounce.h"
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Check whether a transition to `pressed` is handled eagerly
+ */
+static inline bool debounce_is_eager(const debounce_config_t* config, bool pressed) {
+    return config->algorithm == DEBOUNCE_EAGER ||
+           (config->algorithm == DEBOUNCE_EAGER_PRESS && pressed);
+}
+
+/**
+ * @brief Request the timer at an absolute deadline
+ */
+static inline uint8_t debounce_arm(debounce_t* debounce, uint32_t deadline_us) {
+    debounce->deadline_us = deadline_us;
+    debounce->timer_armed = true;
+    return DEBOUNCE_ARM;
+}
+
+/**
+ * @brief Accept a new stable level and start the eager lockout
+ */
+static inline uint8_t debounce_accept_eager(debounce_t* debounce, const debounce_config_t* config, uint32_t now_us, bool pressed) {
+    debounce->stable = pressed;
+    debounce->locked = true;
+    return DEBOUNCE_CHANGED | debounce_arm(debounce, now_us + config->time_us);
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Initialise the state of an input
+ *
+ * In RAM: the hybrid scan resets every key from the GPIO interrupt that
+ * starts polling.
+ *
+ * @param debounce Input state
+ * @param pressed Initial stable level
+ */
+void __not_in_flash_func(debounce_init)(debounce_t* debounce, bool pressed) {
+    debounce->stable = pressed;
+    debounce->locked = false;
+    debounce->timer_armed = false;
+    debounce->deadline_us = 0;
+    debounce->last_edge_us = 0;
+}
+
+/**
+ * @brief Process an input edge
+ *
+ * @param debounce Input state
+ * @param config Algorithm and debounce time
+ * @param now_us Edge timestamp
+ * @param pressed Input level after the edge
+ * @return DEBOUNCE_CHANGED and/or DEBOUNCE_ARM
+ */
+uint8_t __not_in_flash_func(debounce_edge)(debounce_t* debounce, const debounce_config_t* config, uint32_t now_us, bool pressed) {
+    debounce->last_edge_us = now_us;
+
+    // eager lockout: the level is verified when it ends
+    if (debounce->locked) return 0;
+
+    if (debounce_is_eager(config, pressed) && pressed != debounce->stable) {
+        return debounce_accept_eager(debounce, config, now_us, pressed);
+    }
+
+    // defer: wait for the input to be quiet for the debounce time
+    return debounce_arm(debounce, now_us + config->time_us);
+}
+
+/**
+ * @brief Process the expiry of the timer requested with DEBOUNCE_ARM
+ *
+ * @param debounce Input state
+ * @param config Algorithm and debounce time
+ * @param now_us Expiry timestamp
+ * @param pressed Input level sampled at expiry
+ * @return DEBOUNCE_CHANGED and/or DEBOUNCE_ARM
+ */
+uint8_t __not_in_flash_func(debounce_timer)(debounce_t* debounce, const debounce_config_t* config, uint32_t now_us, bool pressed) {
+    debounce->timer_armed = false;
+
+    if (debounce->locked) {
+        debounce->locked = false;
+
+        // still where the eager edge left it
+        if (pressed == debounce->stable) return 0;
+
+        // moved during the lockout
+        if (debounce_is_eager(config, pressed)) {
+            return debounce_accept_eager(debounce, config, now_us, pressed);
+        }
+
+        uint32_t quiet_us = now_us - debounce->last_edge_us;
+        if (quiet_us < config->time_us) {
+            return debounce_arm(debounce, debounce->last_edge_us + config->time_us);
+        }
+    }
+
+    if (pressed == debounce->stable) return 0;
+
+    debounce->stable = pressed;
+    return DEBOUNCE_CHANGED;
+}
+
+/**
+ * @brief Printable name of an algorithm
+ */
+const char* debounce_algorithm_name(debounce_algorithm_t algorithm) {
+    switch (algorithm) {
+        case DEBOUNCE_DEFER: return "defer";
+        case DEBOUNCE_EAGER: return "eager";
+        case DEBOUNCE_EAGER_PRESS: return "eager_press";
+        default: return "?";
+    }
+}
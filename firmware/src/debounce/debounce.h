@@ -0,0 +1,49 @@
+/**
+ * @file debounce.h
+ * @brief Switch debounce algorithms declarations
+ *
+ * Per-input debounce state machines, driven by input edges and by a timer
+ * the caller arms when asked to. Independent of GPIOs and alarms, so the
+ * same code runs in the interrupt handlers and in the host evaluation
+ * harness (host/debounce_harness).
+ */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    typedef enum {
+        DEBOUNCE_DEFER = 0,     // report a level once it has been stable for the debounce time
+        DEBOUNCE_EAGER,         // report the first edge at once, then ignore edges for the debounce time
+        DEBOUNCE_EAGER_PRESS,   // eager on press, defer on release
+        DEBOUNCE_ALGORITHM_COUNT
+    } debounce_algorithm_t;
+
+    typedef struct {
+        debounce_algorithm_t algorithm;
+        uint32_t time_us;
+    } debounce_config_t;
+
+    typedef struct {
+        bool stable;            // debounced level, true = pressed
+        bool locked;            // eager lockout running until deadline_us
+        bool timer_armed;       // a timer is expected at deadline_us
+        uint32_t deadline_us;
+        uint32_t last_edge_us;
+    } debounce_t;
+
+    // Actions returned to the caller
+    #define DEBOUNCE_CHANGED (1u << 0)  // stable level changed, process it now
+    #define DEBOUNCE_ARM     (1u << 1)  // (re)arm the timer at deadline_us
+
+    void debounce_init(debounce_t* debounce, bool pressed);
+    uint8_t debounce_edge(debounce_t* debounce, const debounce_config_t* config, uint32_t now_us, bool pressed);
+    uint8_t debounce_timer(debounce_t* debounce, const debounce_config_t* config, uint32_t now_us, bool pressed);
+
+    const char* debounce_algorithm_name(debounce_algorithm_t algorithm);
+
+#endif /* DEBOUNCE_H */
@@ -0,0 +1,105 @@
+/**
+ * @file tuner.c
+ * @brief Adaptive debounce time implementation
+ *
+ * The learned times derive from the key statistics only, so they persist
+ * with them (keystats checkpoints) and restart from the configured time
+ * when the statistics are cleared.
+ *
+ * Debouncing runs per column and the key behind an edge is only known
+ * after the row scan, so a column uses the longest learned time among the
+ * keys that can cause its next transition: the keys not held for a press,
+ * the held keys for a release. A worn switch slows down the presses of
+ * its column and its own releases; the other releases keep their times.
+ */
+
+#include "tuner.h"
+
+//--------------------------------------------------------------------+
+
+#define TIME_UNLEARNED 0
+
+// Learned time of every key, TIME_UNLEARNED until it has enough samples
+static uint16_t key_time_us[MATRIX_ROWS][MATRIX_COLS] = {0};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Learned time from the statistics of a key
+ */
+static uint16_t __not_in_flash_func(learn_time)(const keystats_key_t* stats) {
+    if (stats->presses < TUNER_MIN_SAMPLES) return TIME_UNLEARNED;
+
+    uint32_t time_us = stats->max_bounce_us + TUNER_MARGIN_US;
+    if (time_us < TUNER_MIN_US) time_us = TUNER_MIN_US;
+    if (time_us > TUNER_MAX_US) time_us = TUNER_MAX_US;
+
+    return time_us;
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Derive every learned time from the key statistics
+ *
+ * Call after `keystats_init`, and after the statistics are cleared.
+ */
+void tuner_init(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            tuner_update(row, col);
+        }
+    }
+}
+
+/**
+ * @brief Derive the learned time of a key after its statistics changed
+ *
+ * Called from the matrix interrupt handlers at the end of every transition.
+ */
+void __not_in_flash_func(tuner_update)(uint8_t row, uint8_t col) {
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS) return;
+
+    keystats_key_t stats;
+    keystats_get(row * MATRIX_COLS + col, &stats);
+    key_time_us[row][col] = learn_time(&stats);
+}
+
+/**
+ * @brief Debounce time of a key
+ *
+ * @param row Key row
+ * @param col Key column
+ * @param fallback_us Time while the key has too few samples
+ */
+uint32_t __not_in_flash_func(tuner_key_time)(uint8_t row, uint8_t col, uint32_t fallback_us) {
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS) return fallback_us;
+
+    uint16_t time_us = key_time_us[row][col];
+    return (time_us == TIME_UNLEARNED) ? fallback_us : time_us;
+}
+
+/**
+ * @brief Debounce time of a column for a set of candidate keys
+ *
+ * @param col Column
+ * @param rows Bit r set = key (r, col) may cause the transition
+ * @param fallback_us Time of unlearned keys, and of an empty set
+ * @return Longest time among the candidates
+ */
+uint32_t __not_in_flash_func(tuner_column_time)(uint8_t col, uint8_t rows, uint32_t fallback_us) {
+    uint32_t longest = 0;
+
+    for (uint8_t row = 0; rows; row++, rows >>= 1) {
+        if (rows & 1) {
+            uint32_t time_us = tuner_key_time(row, col, fallback_us);
+            if (time_us > longest) longest = time_us;
+        }
+    }
+
+    return longest ? longest : fallback_us;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file tuner.h
+ * @brief Adaptive debounce time declarations
+ *
+ * Learns a debounce time for every matrix key from its observed bounce
+ * (see keystats.h): the longest bounce seen plus a margin, within bounds.
+ * Used by the profiles with `debounce_adaptive` set.
+ */
+
+#ifndef TUNER_H
+#define TUNER_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../../matrix/matrix.h"
+    #include "../../keystats/keystats.h"
+
+    // Bounds of a learned time, in microseconds
+    #ifndef TUNER_MIN_US
+    #define TUNER_MIN_US 1000
+    #endif
+    #ifndef TUNER_MAX_US
+    #define TUNER_MAX_US 10000
+    #endif
+
+    // Added to the longest bounce seen
+    #ifndef TUNER_MARGIN_US
+    #define TUNER_MARGIN_US 1000
+    #endif
+
+    // Presses observed before a key uses its learned time
+    #ifndef TUNER_MIN_SAMPLES
+    #define TUNER_MIN_SAMPLES 50
+    #endif
+
+    void tuner_init(void);
+    void tuner_update(uint8_t row, uint8_t col);
+    uint32_t tuner_key_time(uint8_t row, uint8_t col, uint32_t fallback_us);
+    uint32_t tuner_column_time(uint8_t col, uint8_t rows, uint32_t fallback_us);
+
+#endif /* TUNER_H */
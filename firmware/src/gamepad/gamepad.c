@@ -0,0 +1,259 @@
+/**
+ * @file gamepad.c
+ * @brief Gamepad mode implementation
+ *
+ * The gamepad report is evaluated straight from the matrix bitmap of each
+ * snapshot, in TASK_HID: the bound keys of a row are one AND away, and
+ * each pressed one indexes a control table built from `gamepad_keymap` at
+ * boot. The same bitmap of bound keys is cleared from the snapshot before
+ * it reaches the keyboard report, so the keyboard path does no extra work
+ * and never sees a gamepad key.
+ *
+ * SOCD resolution needs the press order of opposing directions: every
+ * direction records the update in which it became held. Directions that
+ * became held in the same update count as simultaneous and resolve to
+ * neutral under both the last-wins and the first-wins rule.
+ */
+
+#include "gamepad.h"
+#include "../usb/hid_report/hid_report.h"
+
+//--------------------------------------------------------------------+
+
+#define CONTROL_NONE 0xFF
+#define CONTROL_BIT(code) (1u << ((code) - GP_DPAD_UP))
+
+// Directions are the first controls, buttons follow
+#define DIRECTION_COUNT (GP_BTN_0 - GP_DPAD_UP)
+
+typedef struct {
+    bool active;
+    gamepad_socd_t socd;
+    uint32_t generation;                            // bumped on mode or rule changes
+    uint16_t bound[MATRIX_ROWS];                    // keys bound on the gamepad layer
+    uint8_t control[MATRIX_ROWS][MATRIX_COLS];      // control index of each key, CONTROL_NONE if unbound
+    uint32_t held;                                  // CONTROL_BIT of the controls held
+    uint32_t update;                                // update counter, orders presses
+    uint32_t held_since[DIRECTION_COUNT];           // update in which a direction became held
+} gamepad_state_t;
+
+static gamepad_state_t gamepad_state = {
+    .socd = GAMEPAD_SOCD_DEFAULT,
+};
+
+// Hat switch value, indexed [y + 1][x + 1] (y positive down)
+static const uint8_t hat_table[3][3] = {
+    {GAMEPAD_HAT_UP_LEFT, GAMEPAD_HAT_UP, GAMEPAD_HAT_UP_RIGHT},
+    {GAMEPAD_HAT_LEFT, GAMEPAD_HAT_CENTERED, GAMEPAD_HAT_RIGHT},
+    {GAMEPAD_HAT_DOWN_LEFT, GAMEPAD_HAT_DOWN, GAMEPAD_HAT_DOWN_RIGHT},
+};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Resolve a pair of opposing directions
+ *
+ * @param negative Control of the negative direction (up or left)
+ * @param positive Control of the positive direction (down or right)
+ * @return -1, 0 or 1
+ */
+static int8_t __not_in_flash_func(resolve_socd)(uint16_t negative, uint16_t positive) {
+    const gamepad_state_t* gp = &gamepad_state;
+    bool neg = gp->held & CONTROL_BIT(negative);
+    bool pos = gp->held & CONTROL_BIT(positive);
+
+    if (neg != pos) return pos ? 1 : -1;
+    if (!neg) return 0;
+
+    uint32_t neg_since = gp->held_since[negative - GP_DPAD_UP];
+    uint32_t pos_since = gp->held_since[positive - GP_DPAD_UP];
+    if (neg_since == pos_since) return 0;
+
+    switch (gp->socd) {
+        case GAMEPAD_SOCD_LAST_WINS: return (pos_since > neg_since) ? 1 : -1;
+        case GAMEPAD_SOCD_FIRST_WINS: return (pos_since < neg_since) ? 1 : -1;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Set the gamepad report to the resolved controls
+ */
+static void __not_in_flash_func(update_report)(void) {
+    hid_gamepad_report_t report = {0};
+
+    int8_t dpad_x = resolve_socd(GP_DPAD_LEFT, GP_DPAD_RIGHT);
+    int8_t dpad_y = resolve_socd(GP_DPAD_UP, GP_DPAD_DOWN);
+    report.hat = hat_table[dpad_y + 1][dpad_x + 1];
+
+    report.x = resolve_socd(GP_LS_LEFT, GP_LS_RIGHT) * GAMEPAD_AXIS_MAX;
+    report.y = resolve_socd(GP_LS_UP, GP_LS_DOWN) * GAMEPAD_AXIS_MAX;
+    report.z = resolve_socd(GP_RS_LEFT, GP_RS_RIGHT) * GAMEPAD_AXIS_MAX;
+    report.rz = resolve_socd(GP_RS_UP, GP_RS_DOWN) * GAMEPAD_AXIS_MAX;
+
+    report.buttons = gamepad_state.held >> DIRECTION_COUNT;
+
+    hid_report_set(REPORT_ID_GAMEPAD, &report, sizeof(report));
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Build the control table from the gamepad layer
+ *
+ * Called once at boot, reads `gamepad_keymap` from flash.
+ */
+void gamepad_init(void) {
+    gamepad_state_t* gp = &gamepad_state;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        gp->bound[row] = 0;
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint16_t code = gamepad_keymap[row][col];
+
+            if (code >= GP_DPAD_UP && code <= GP_LAST) {
+                gp->control[row][col] = code - GP_DPAD_UP;
+                gp->bound[row] |= 1u << col;
+            } else {
+                gp->control[row][col] = CONTROL_NONE;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Check whether gamepad mode is on
+ */
+bool gamepad_active(void) {
+    return gamepad_state.active;
+}
+
+/**
+ * @brief Check whether a keycode is a gamepad mode action
+ *
+ * @param key Keycode from the keymap
+ * @return True for KC_GP_* codes
+ */
+bool __not_in_flash_func(is_gamepad_key)(uint16_t key) {
+    return key >= KC_GP_TOGGLE && key <= KC_GP_LAST;
+}
+
+/**
+ * @brief Run a gamepad mode action
+ *
+ * Called on the press of a KC_GP_* key. Leaving gamepad mode returns the
+ * gamepad to neutral. TASK_HID is notified to apply the change.
+ *
+ * @param key Action (KC_GP_*)
+ */
+void gamepad_action(uint16_t key) {
+    gamepad_state_t* gp = &gamepad_state;
+
+    switch (key) {
+        case KC_GP_TOGGLE: {
+            gamepad_set_active(!gp->active);
+        }
+        break;
+
+        case KC_GP_SOCD: {
+            gamepad_set_socd((gp->socd + 1) % GAMEPAD_SOCD_COUNT);
+        }
+        break;
+
+        default:
+        return;
+    }
+
+    scheduler_notify(TASK_HID);
+}
+
+/**
+ * @brief Turn gamepad mode on or off
+ *
+ * Also set by the report mode of the selected profile (see profile.c).
+ * Leaving gamepad mode returns the gamepad to neutral.
+ *
+ * @param active True to turn gamepad mode on
+ */
+void gamepad_set_active(bool active) {
+    gamepad_state_t* gp = &gamepad_state;
+
+    if (gp->active == active) return;
+
+    gp->active = active;
+    gp->held = 0;
+
+    if (!active) {
+        update_report();
+    }
+    gp->generation++;
+}
+
+/**
+ * @brief Select the SOCD resolution rule
+ *
+ * @param mode Resolution rule
+ */
+void gamepad_set_socd(gamepad_socd_t mode) {
+    if (mode >= GAMEPAD_SOCD_COUNT) return;
+
+    gamepad_state.socd = mode;
+    gamepad_state.generation++;
+}
+
+/**
+ * @brief Get the SOCD resolution rule
+ */
+gamepad_socd_t gamepad_get_socd(void) {
+    return gamepad_state.socd;
+}
+
+/**
+ * @brief Counter of gamepad mode and rule changes
+ *
+ * TASK_HID re-evaluates the current snapshot when it changes.
+ */
+uint32_t gamepad_generation(void) {
+    return gamepad_state.generation;
+}
+
+/**
+ * @brief Apply a matrix snapshot to the gamepad report
+ *
+ * Evaluates the bound keys from the matrix bitmap, resolves opposing
+ * directions, updates the gamepad report, then clears the bound keys from
+ * the snapshot bitmap for the keyboard report. Call only in gamepad mode.
+ *
+ * @param snapshot Consistent matrix state, bound keys cleared on return
+ */
+void __not_in_flash_func(gamepad_update)(matrix_snapshot_t* snapshot) {
+    gamepad_state_t* gp = &gamepad_state;
+    uint32_t held = 0;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        uint16_t keys = snapshot->matrix[row] & gp->bound[row];
+        snapshot->matrix[row] &= ~gp->bound[row];
+
+        for (uint8_t col = 0; keys; col++, keys >>= 1) {
+            if (keys & 1) {
+                held |= 1u << gp->control[row][col];
+            }
+        }
+    }
+
+    // directions that became held in this update
+    gp->update++;
+    uint32_t pressed = held & ~gp->held;
+    for (uint8_t dir = 0; dir < DIRECTION_COUNT; dir++) {
+        if (pressed & (1u << dir)) {
+            gp->held_since[dir] = gp->update;
+        }
+    }
+    gp->held = held;
+
+    update_report();
+}
@@ -0,0 +1,51 @@
+/**
+ * @file gamepad.h
+ * @brief Gamepad mode declarations
+ *
+ * While gamepad mode is on, the keys bound on the gamepad layer of
+ * config/orione.keymap (`gamepad_keymap`) drive the REPORT_ID_GAMEPAD
+ * report (D-pad, 16 buttons, both sticks at full deflection) instead of
+ * the keyboard report. Opposing directions held together (SOCD) are
+ * resolved by the selected rule.
+ */
+
+#ifndef GAMEPAD_H
+#define GAMEPAD_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include <class/hid/hid.h>
+
+    #include "../matrix/matrix.h"
+    #include "../matrix/keymap/keymap.h"
+    #include "../matrix/snapshot/snapshot.h"
+    #include "../scheduler/scheduler.h"
+
+    // Simultaneous opposing cardinal direction resolution
+    typedef enum {
+        GAMEPAD_SOCD_LAST_WINS = 0,     // the direction pressed last
+        GAMEPAD_SOCD_NEUTRAL,           // neither direction
+        GAMEPAD_SOCD_FIRST_WINS,        // the direction held first
+        GAMEPAD_SOCD_COUNT
+    } gamepad_socd_t;
+
+    #ifndef GAMEPAD_SOCD_DEFAULT
+    #define GAMEPAD_SOCD_DEFAULT GAMEPAD_SOCD_LAST_WINS
+    #endif
+
+    // Stick value of a held direction key
+    #define GAMEPAD_AXIS_MAX 127
+
+    void gamepad_init(void);
+    bool gamepad_active(void);
+    void gamepad_set_active(bool active);
+    bool is_gamepad_key(uint16_t key);
+    void gamepad_action(uint16_t key);
+    void gamepad_set_socd(gamepad_socd_t mode);
+    gamepad_socd_t gamepad_get_socd(void);
+    uint32_t gamepad_generation(void);
+    void gamepad_update(matrix_snapshot_t* snapshot);
+
+#endif /* GAMEPAD_H */
@@ -0,0 +1,331 @@
+/**
+ * @file indicator.c
+ * @brief LED indicator implementation
+ *
+ * Each LED pin is the output of a PWM slice running a ~2 kHz carrier, so
+ * its brightness is the slice compare level. A pattern is a table of
+ * levels, one per INDICATOR_STEP_MS, built in RAM at boot. Two DMA
+ * channels play it:
+ * - the data channel copies one level per wrap of the pacing slice
+ *   (DREQ_PWM_WRAP) into the compare register of the LED slice, which
+ *   latches it at its own next wrap, so steps never glitch
+ * - at the end of the table it chains to the control channel, which
+ *   writes the table start to the data channel's READ_ADDR trigger alias
+ *   and so restarts it with the same transfer count
+ * The pair loops until it is stopped; steady levels (off, on) need no DMA.
+ * A level is written to both halves of the compare register: the other
+ * channel of each slice drives a matrix pin that stays on SIO.
+ *
+ * The dividers depend on clk_sys, which the clock governor and the suspend
+ * mode change: they are recomputed by `indicator_clock_changed`. While the
+ * bus is suspended the clocks of the PWM and DMA are gated, so the LED
+ * pins are handed back to SIO, driven LOW, until resume.
+ */
+
+#include "indicator.h"
+
+//--------------------------------------------------------------------+
+
+// Compare register value: the level on channels A and B
+#define INDICATOR_CC(level) ((uint32_t)(level) * 0x00010001u)
+
+typedef struct {
+    uint gpio;
+    uint slice;
+    uint data_chan;                 // plays the step table
+    uint ctrl_chan;                 // restarts the data channel
+    const uint32_t* restart;        // table start, read by the control channel
+    indicator_pattern_t pattern;
+} indicator_led_t;
+
+typedef struct {
+    const uint32_t* steps;          // NULL: steady level
+    uint16_t count;
+    uint16_t level;
+} indicator_table_t;
+
+enum {
+    LED_STATUS = 0,
+    LED_CAPS_LOCK,
+    LED_COUNT
+};
+
+typedef struct {
+    bool ready;                     // slices and channels set up
+    bool suspended;                 // pins on SIO, LOW
+    uint32_t state;                 // indicator_state_t bits
+    indicator_led_t leds[LED_COUNT];
+} indicator_t;
+
+static uint32_t blink_slow[INDICATOR_BLINK_SLOW_MS / INDICATOR_STEP_MS];
+static uint32_t blink_fast[INDICATOR_BLINK_FAST_MS / INDICATOR_STEP_MS];
+static uint32_t blink_rapid[INDICATOR_BLINK_RAPID_MS / INDICATOR_STEP_MS];
+static uint32_t breathe[INDICATOR_BREATHE_MS / INDICATOR_STEP_MS];
+
+#define TABLE(steps) { steps, sizeof(steps) / sizeof(steps[0]), 0 }
+
+static const indicator_table_t patterns[INDICATOR_PATTERN_COUNT] = {
+    [INDICATOR_PATTERN_OFF] = { NULL, 0, 0 },
+    [INDICATOR_PATTERN_ON] = { NULL, 0, INDICATOR_LEVEL_MAX },
+    [INDICATOR_PATTERN_BLINK_SLOW] = TABLE(blink_slow),
+    [INDICATOR_PATTERN_BLINK_FAST] = TABLE(blink_fast),
+    [INDICATOR_PATTERN_BLINK_RAPID] = TABLE(blink_rapid),
+    [INDICATOR_PATTERN_BREATHE] = TABLE(breathe),
+};
+
+static indicator_t indicator = {
+    .leds = {
+        [LED_STATUS] = { .gpio = STATUS_LED },
+        [LED_CAPS_LOCK] = { .gpio = CAPS_LOCK_LED },
+    },
+};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Fill a blink table: on for the first half of the period
+ */
+static void pattern_blink(uint32_t* steps, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        steps[i] = INDICATOR_CC(i < count / 2 ? INDICATOR_LEVEL_MAX : 0);
+    }
+}
+
+/**
+ * @brief Fill a breathe table: up and down, on a square law
+ *
+ * The eye is far more sensitive to changes at low brightness, so a
+ * linear ramp would look like it spends most of the period at full.
+ */
+static void pattern_breathe(uint32_t* steps, uint16_t count) {
+    uint32_t half = count / 2;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t t = (i < half) ? i : count - i;
+        steps[i] = INDICATOR_CC(INDICATOR_LEVEL_MAX * t * t / (half * half));
+    }
+}
+
+/**
+ * @brief Data channel configuration of an LED
+ *
+ * @param looping Chain to the control channel at the end of the table
+ */
+static dma_channel_config indicator_data_config(const indicator_led_t* led, bool looping) {
+    dma_channel_config c = dma_channel_get_default_config(led->data_chan);
+
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, DREQ_PWM_WRAP0 + INDICATOR_PACE_SLICE);
+    // chained to itself: no chaining
+    channel_config_set_chain_to(&c, looping ? led->ctrl_chan : led->data_chan);
+    return c;
+}
+
+/**
+ * @brief Stop the pattern of an LED
+ *
+ * The data channel is unchained first, so a table ending meanwhile no
+ * longer restarts it; then both channels are aborted, the control channel
+ * first since it could still trigger the data channel.
+ */
+static void indicator_stop(indicator_led_t* led) {
+    if (!patterns[led->pattern].steps) return;
+
+    dma_channel_config c = indicator_data_config(led, false);
+    dma_channel_set_config(led->data_chan, &c, false);
+
+    dma_channel_abort(led->ctrl_chan);
+    dma_channel_abort(led->data_chan);
+}
+
+/**
+ * @brief Start a pattern on an LED, if it is not already playing
+ */
+static void indicator_play(indicator_led_t* led, indicator_pattern_t pattern) {
+    if (pattern == led->pattern) return;
+
+    indicator_stop(led);
+    led->pattern = pattern;
+
+    const indicator_table_t* table = &patterns[pattern];
+    if (!table->steps) {
+        pwm_set_both_levels(led->slice, table->level, table->level);
+        return;
+    }
+
+    led->restart = table->steps;
+    dma_channel_config c = indicator_data_config(led, true);
+    dma_channel_configure(led->data_chan, &c, &pwm_hw->slice[led->slice].cc, table->steps, table->count, true);
+}
+
+/**
+ * @brief Set up the slice and DMA channels of an LED, off
+ */
+static void indicator_led_init(indicator_led_t* led) {
+    led->slice = pwm_gpio_to_slice_num(led->gpio);
+    pwm_set_wrap(led->slice, INDICATOR_PWM_TOP);
+    pwm_set_both_levels(led->slice, 0, 0);
+    led->pattern = INDICATOR_PATTERN_OFF;
+
+    led->data_chan = (uint)dma_claim_unused_channel(true);
+    led->ctrl_chan = (uint)dma_claim_unused_channel(true);
+
+    // one word, the table start, to the data channel's READ_ADDR trigger
+    dma_channel_config c = dma_channel_get_default_config(led->ctrl_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(led->ctrl_chan, &c, &dma_hw->ch[led->data_chan].al3_read_addr_trig, &led->restart, 1, false);
+}
+
+/**
+ * @brief Start or stop the PWM slices of the indicators
+ */
+static void indicator_slices_enable(bool enabled) {
+    pwm_set_enabled(INDICATOR_PACE_SLICE, enabled);
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        pwm_set_enabled(indicator.leds[i].slice, enabled);
+    }
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Build the pattern tables and set up the slices and DMA channels
+ *
+ * The LED pins must already be SIO outputs, LOW (see `init_led`): they are
+ * switched to PWM here and go back to SIO while the bus is suspended. The
+ * patterns start when TASK_LED first runs.
+ */
+void indicator_init(void) {
+    pattern_blink(blink_slow, sizeof(blink_slow) / sizeof(blink_slow[0]));
+    pattern_blink(blink_fast, sizeof(blink_fast) / sizeof(blink_fast[0]));
+    pattern_blink(blink_rapid, sizeof(blink_rapid) / sizeof(blink_rapid[0]));
+    pattern_breathe(breathe, sizeof(breathe) / sizeof(breathe[0]));
+
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        indicator_led_init(&indicator.leds[i]);
+    }
+
+    indicator.ready = true;
+    indicator_clock_changed();
+    indicator_slices_enable(true);
+
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        gpio_set_function(indicator.leds[i].gpio, GPIO_FUNC_PWM);
+    }
+}
+
+/**
+ * @brief Record a change of the keyboard state shown by the LEDs
+ *
+ * Called from USB callbacks and tasks. Only records the state: TASK_LED
+ * reprograms the LEDs.
+ *
+ * @param state State bit (indicator_state_t)
+ * @param on New value
+ */
+void indicator_set(indicator_state_t state, bool on) {
+    uint32_t next = on ? (indicator.state | state) : (indicator.state & ~(uint32_t)state);
+    if (next == indicator.state) return;
+
+    indicator.state = next;
+    scheduler_notify(TASK_LED);
+}
+
+/**
+ * @brief Turn the LEDs off for suspend, or back on at resume
+ *
+ * Called by the power task around deep sleep, and applied at once since
+ * the PWM and DMA clocks are about to be gated. The patterns are started
+ * again by TASK_LED.
+ *
+ * @param suspended True entering suspend
+ */
+void indicator_suspend(bool suspended) {
+    if (!indicator.ready || suspended == indicator.suspended) return;
+
+    indicator.suspended = suspended;
+
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        indicator_led_t* led = &indicator.leds[i];
+
+        if (suspended) {
+            indicator_play(led, INDICATOR_PATTERN_OFF);
+            gpio_put(led->gpio, LOW);
+            gpio_set_function(led->gpio, GPIO_FUNC_SIO);
+        } else {
+            gpio_set_function(led->gpio, GPIO_FUNC_PWM);
+        }
+    }
+    indicator_slices_enable(!suspended);
+
+    if (!suspended) {
+        scheduler_notify(TASK_LED);
+    }
+}
+
+/**
+ * @brief Recompute the slice dividers for the current clk_sys
+ *
+ * Called after every clk_sys change (see `power_clocks_low` and
+ * `power_clocks_full`). The pacing slice wraps once per step, with the
+ * smallest divider that fits the step in its 16-bit counter.
+ */
+void indicator_clock_changed(void) {
+    if (!indicator.ready) return;
+
+    uint32_t sys_hz = clock_get_hz(clk_sys);
+
+    uint32_t led_div = sys_hz / (INDICATOR_LEVEL_MAX * INDICATOR_PWM_HZ);
+    if (led_div < 1) led_div = 1;
+    if (led_div > 255) led_div = 255;
+
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        pwm_set_clkdiv_int_frac(indicator.leds[i].slice, (uint8_t)led_div, 0);
+    }
+
+    uint32_t step_cycles = sys_hz / 1000 * INDICATOR_STEP_MS;
+    uint32_t pace_div = (step_cycles + 0xFFFF) / 0x10000;
+
+    pwm_set_clkdiv_int_frac(INDICATOR_PACE_SLICE, (uint8_t)pace_div, 0);
+    pwm_set_wrap(INDICATOR_PACE_SLICE, (uint16_t)(step_cycles / pace_div - 1));
+}
+
+/**
+ * @brief LED indicator task
+ *
+ * Runs as TASK_LED, notified by `indicator_set` and on resume. Works out
+ * the pattern of each LED from the recorded state and restarts only those
+ * that changed; in between the LEDs run on their own and the task never
+ * wakes.
+ * - Status LED: rapid blink with Caps Lock on, breathing while the Fn
+ *   layer is held, slow blink when mounted, fast blink otherwise
+ * - Caps Lock LED: on with Caps Lock on
+ */
+void indicator_task(void) {
+    if (!indicator.ready || indicator.suspended) return;
+
+    uint32_t state = indicator.state;
+    indicator_pattern_t status;
+
+    if (state & INDICATOR_CAPS_LOCK) {
+        status = INDICATOR_PATTERN_BLINK_RAPID;
+    } else if (state & INDICATOR_LAYER) {
+        status = INDICATOR_PATTERN_BREATHE;
+    } else if (state & INDICATOR_MOUNTED) {
+        status = INDICATOR_PATTERN_BLINK_SLOW;
+    } else {
+        status = INDICATOR_PATTERN_BLINK_FAST;
+    }
+
+    indicator_play(&indicator.leds[LED_STATUS], status);
+    indicator_play(&indicator.leds[LED_CAPS_LOCK],
+                   (state & INDICATOR_CAPS_LOCK) ? INDICATOR_PATTERN_ON : INDICATOR_PATTERN_OFF);
+}
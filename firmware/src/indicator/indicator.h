@@ -0,0 +1,69 @@
+/**
+ * @file indicator.h
+ * @brief LED indicator declarations
+ *
+ * The onboard status LED and the Caps Lock LED are driven by PWM slices,
+ * and their patterns (blink, breathe) are played by DMA from step tables
+ * into the slice compare registers, paced by a third PWM slice. Once a
+ * pattern is started it loops with no CPU involvement.
+ *
+ * What the LEDs show follows from the keyboard state: USB callbacks and
+ * tasks only record a state change with `indicator_set`, and TASK_LED
+ * works out the patterns and reprograms the LEDs whose pattern changed.
+ */
+
+#ifndef INDICATOR_H
+#define INDICATOR_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "hardware/clocks.h"
+    #include "hardware/dma.h"
+    #include "hardware/pwm.h"
+
+    #include "../global.h"
+    #include "../scheduler/scheduler.h"
+
+    // PWM slice pacing the pattern steps, its pins are not switched to PWM
+    #define INDICATOR_PACE_SLICE 7
+
+    // Pattern step: one DMA transfer per LED
+    #define INDICATOR_STEP_MS 20
+
+    // LED brightness: levels 0..INDICATOR_LEVEL_MAX, carrier frequency
+    #define INDICATOR_PWM_TOP 255
+    #define INDICATOR_LEVEL_MAX (INDICATOR_PWM_TOP + 1)
+    #define INDICATOR_PWM_HZ 2000
+
+    // Pattern periods
+    #define INDICATOR_BLINK_SLOW_MS 2000
+    #define INDICATOR_BLINK_FAST_MS 500
+    #define INDICATOR_BLINK_RAPID_MS 200
+    #define INDICATOR_BREATHE_MS 1000
+
+    // Keyboard state shown by the LEDs
+    typedef enum {
+        INDICATOR_MOUNTED   = 1u << 0,  // configured by the host
+        INDICATOR_CAPS_LOCK = 1u << 1,  // host Caps Lock LED report
+        INDICATOR_LAYER     = 1u << 2,  // Fn layer active
+    } indicator_state_t;
+
+    typedef enum {
+        INDICATOR_PATTERN_OFF = 0,
+        INDICATOR_PATTERN_ON,
+        INDICATOR_PATTERN_BLINK_SLOW,
+        INDICATOR_PATTERN_BLINK_FAST,
+        INDICATOR_PATTERN_BLINK_RAPID,
+        INDICATOR_PATTERN_BREATHE,
+        INDICATOR_PATTERN_COUNT
+    } indicator_pattern_t;
+
+    void indicator_init(void);
+    void indicator_set(indicator_state_t state, bool on);
+    void indicator_suspend(bool suspended);
+    void indicator_clock_changed(void);
+    void indicator_task(void);
+
+#endif /* INDICATOR_H */
@@ -25,25 +25,13 @@ extern uint8_t last_clk_state;
  * 
  * Configures all row pins as outputs and sets them HIGH (inactive state).
  * Rows are driven HIGH one at a time during scanning to detect key presses.
+ * The rows are consecutive pins, set up with one register write per step;
+ * the level is set before the direction, so the pins go straight to HIGH.
  */
 void init_row(void) {
-    gpio_init(ROW_0);
-    gpio_init(ROW_1);
-    gpio_init(ROW_2);
-    gpio_init(ROW_3);
-    gpio_init(ROW_4);
-
-    gpio_set_dir(ROW_0, GPIO_OUT);
-    gpio_set_dir(ROW_1, GPIO_OUT);
-    gpio_set_dir(ROW_2, GPIO_OUT);
-    gpio_set_dir(ROW_3, GPIO_OUT);
-    gpio_set_dir(ROW_4, GPIO_OUT);
-
-    gpio_put(ROW_0, HIGH);
-    gpio_put(ROW_1, HIGH);
-    gpio_put(ROW_2, HIGH);
-    gpio_put(ROW_3, HIGH);
-    gpio_put(ROW_4, HIGH);
+    gpio_init_mask(ROW_MASK);
+    gpio_set_mask(ROW_MASK);
+    gpio_set_dir_out_masked(ROW_MASK);
 }
 
 /**
@@ -51,52 +39,16 @@ void init_row(void) {
  * 
  * Configures all column pins as inputs with pull-down resistors.
  * When a key is pressed, the column pin will read HIGH if its row is active.
+ * Function and direction are set for all columns at once; the pulls live
+ * in a pad register per pin.
  */
 void init_column(void) {
-    gpio_init(COLUMN_0);
-    gpio_init(COLUMN_1);
-    gpio_init(COLUMN_2);
-    gpio_init(COLUMN_3);
-    gpio_init(COLUMN_4);
-    gpio_init(COLUMN_5);
-    gpio_init(COLUMN_6);
-    gpio_init(COLUMN_7);
-    gpio_init(COLUMN_8);
-    gpio_init(COLUMN_9);
-    gpio_init(COLUMN_10);
-    gpio_init(COLUMN_11);
-    gpio_init(COLUMN_12);
-    gpio_init(COLUMN_13);
-    
-    gpio_set_dir(COLUMN_0, GPIO_IN);
-    gpio_set_dir(COLUMN_1, GPIO_IN);
-    gpio_set_dir(COLUMN_2, GPIO_IN);
-    gpio_set_dir(COLUMN_3, GPIO_IN);
-    gpio_set_dir(COLUMN_4, GPIO_IN);
-    gpio_set_dir(COLUMN_5, GPIO_IN);
-    gpio_set_dir(COLUMN_6, GPIO_IN);
-    gpio_set_dir(COLUMN_7, GPIO_IN);
-    gpio_set_dir(COLUMN_8, GPIO_IN);
-    gpio_set_dir(COLUMN_9, GPIO_IN);
-    gpio_set_dir(COLUMN_10, GPIO_IN);
-    gpio_set_dir(COLUMN_11, GPIO_IN);
-    gpio_set_dir(COLUMN_12, GPIO_IN);
-    gpio_set_dir(COLUMN_13, GPIO_IN);
-    
-    gpio_pull_down(COLUMN_0);
-    gpio_pull_down(COLUMN_1);
-    gpio_pull_down(COLUMN_2);
-    gpio_pull_down(COLUMN_3);
-    gpio_pull_down(COLUMN_4);
-    gpio_pull_down(COLUMN_5);
-    gpio_pull_down(COLUMN_6);
-    gpio_pull_down(COLUMN_7);
-    gpio_pull_down(COLUMN_8);
-    gpio_pull_down(COLUMN_9);
-    gpio_pull_down(COLUMN_10);
-    gpio_pull_down(COLUMN_11);
-    gpio_pull_down(COLUMN_12);
-    gpio_pull_down(COLUMN_13);
+    gpio_init_mask(COLUMN_MASK);
+    gpio_set_dir_in_masked(COLUMN_MASK);
+
+    for (uint gpio = COLUMN_0; gpio < COLUMN_0 + MATRIX_COLS; gpio++) {
+        gpio_pull_down(gpio);
+    }
 }
 
 //--------------------------------------------------------------------+
@@ -140,25 +92,25 @@ void init_rotary_encoder_gpio(void) {
 /**
  * @brief Initialize keyboard matrix interrupts
  * 
- * Enables GPIO interrupts on all column pins for both rising and falling edges.
+ * Scans the matrix once, so keys held at power-on are reported and their
+ * release is seen (see `keyboard_boot_scan`), then enables GPIO interrupts
+ * on all column pins for both rising and falling edges.
  * The first column (COLUMN_0) also registers the shared interrupt callback handler.
+ * In hybrid mode, the matrix is polled from the start, so keys held at
+ * power-on are followed until released.
  */
 void init_keyboard_interrupts(void) {
+    keyboard_boot_scan();
+
     gpio_set_irq_enabled_with_callback(COLUMN_0, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true, &gpio_callback);
-    
-    gpio_set_irq_enabled(COLUMN_1, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_2, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_3, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_4, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_5, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_6, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_7, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_8, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_9, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_10, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_11, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_12, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(COLUMN_13, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
+
+    for (uint gpio = COLUMN_1; gpio < COLUMN_0 + MATRIX_COLS; gpio++) {
+        gpio_set_irq_enabled(gpio, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
+    }
+
+    if (hybrid_scan_enabled()) {
+        hybrid_scan_start();
+    }
 }
 
 /**
@@ -175,13 +127,20 @@ void init_rotary_encoder_interrupts(void) {
 }
 
 /**
- * @brief Initialize Caps Lock LED
+ * @brief Initialize the status and Caps Lock LEDs
  * 
- * Configures the Caps Lock LED pin as an output and sets it to OFF (LOW).
- * The LED state is controlled by USB HID LED status reports from the host.
+ * Configures both LED pins as outputs and sets them to OFF (LOW), the
+ * state they return to while the bus is suspended. The indicator engine
+ * then drives them from PWM (see indicator.c).
  */
 void init_led(void) {
+    gpio_init(STATUS_LED);
+    gpio_set_dir(STATUS_LED, GPIO_OUT);
+    gpio_put(STATUS_LED, LOW);
+
     gpio_init(CAPS_LOCK_LED);
     gpio_set_dir(CAPS_LOCK_LED, GPIO_OUT);
     gpio_put(CAPS_LOCK_LED, LOW);
+
+    indicator_init();
 }
\ No newline at end of file
@@ -15,6 +15,7 @@
     #include "../global.h"
     #include "../rotary_encoder/rotary_encoder.h"
     #include "../interrupts/interrupts.h"
+    #include "../indicator/indicator.h"
 
     #define GPIO_OUT true
     #define GPIO_IN false
@@ -3,35 +3,45 @@
  * @brief GPIO interrupt handler implementation
  *
  * Implements interrupt service routines for keyboard matrix key detection,
- * rotary encoder direction sensing, and Fn layer switching. For the keyboard
- * matrix, IRQs schedule a one-shot debounce alarm per column to sample
- * the stable pin state after a short delay (see `MATRIX_DEBOUNCE_TIME`).
- * The alarm callback (`column_debounce_alarm`) performs the actual row scan
- * and press/release handling. On release events, all rows are scanned to
- * correctly identify which key was released, handling multiple simultaneous
- * key presses on the same column.
+ * rotary encoder direction sensing, and Fn layer switching. Matrix columns
+ * (with the settings of the selected profile, see profile.c) and the
+ * encoder button are debounced by the algorithms in debounce/debounce.c:
+ * every edge is passed to the column's debounce state, which may ask for
+ * a one-shot alarm (`column_debounce_alarm`) to sample the pin later. When
+ * the debounced level of a column changes, `column_process` performs the actual
+ * row scan and press/release handling. On release events, all rows are
+ * scanned to correctly identify which key was released, handling multiple
+ * simultaneous key presses on the same column.
  */
 
 #include "interrupts.h"
 
 //--------------------------------------------------------------------+
 
-// Structure to track debounce state for each column
-typedef struct {
-    alarm_id_t alarm_id;
-    bool last_stable_state;  // true = HIGH/pressed, false = LOW/released
-} column_debounce_t;
+#define BURST_NO_KEY 0xFF
+
+// Column edges this soon after a row scan come from the scan, not a switch
+#define ROW_SCAN_EDGE_WINDOW_US 200
 
+// Debounce state and pending alarm of an input
 typedef struct {
     alarm_id_t alarm_id;
-    bool last_stable_state;  // true = pressed (LOW), false = released (HIGH)
-} rotary_button_debounce_t;
-
-static column_debounce_t column_debounce[14] = {0};
-static rotary_button_debounce_t rotary_button_debounce = {0};
-
-// Alarm id for rotary button debounce timer
-static alarm_id_t rotary_button_alarm_id = 0;
+    debounce_t debounce;     // stable level: true = pressed
+    uint16_t burst_edges;    // edges since the debounce window opened (columns)
+    uint32_t burst_start_us; // first of them
+    uint32_t burst_last_us;  // last of them before a quiet gap of KEYSTATS_BURST_GAP_US
+    bool burst_settled;      // the gap has been seen
+    uint8_t burst_row;       // row of the key the burst changed, BURST_NO_KEY if none
+} input_debounce_t;
+
+static input_debounce_t column_debounce[MATRIX_COLS] = {0};
+static input_debounce_t rotary_button_debounce = {0};
+static uint32_t last_row_scan_us = 0;
+
+static const debounce_config_t rotary_button_debounce_config = {
+    .algorithm = ENCODER_BTN_DEBOUNCE_ALGORITHM,
+    .time_us = ENCODER_BTN_DEBOUNCE_TIME,
+};
 
 extern keyboard_state_t kbd_state;
 
@@ -40,8 +50,6 @@ extern uint32_t last_button_time;
 extern uint8_t last_clk_state;
 extern rotary_encoder_state_t rotary_state;
 
-extern void keyboard_add_key(uint8_t row, uint8_t col);
-extern void keyboard_remove_key(uint8_t row, uint8_t col);
 
 // forward declaration for debounce alarm callback
 static int64_t column_debounce_alarm(alarm_id_t id, void *user_data);
@@ -50,47 +58,109 @@ static int64_t rotary_button_debounce_alarm(alarm_id_t id, void *user_data);
 //--------------------------------------------------------------------+
 
 /**
- * @brief Keyboard matrix interrupt callback
+ * @brief (Re)arm the debounce alarm of an input if requested
  *
- * This callback is invoked directly from GPIO IRQs for column pins. Instead of
- * making an immediate press/release decision inside the IRQ (which is
- * vulnerable to switch bounce), the callback schedules a one-shot alarm to
- * run after `MATRIX_DEBOUNCE_TIME` microseconds. The alarm samples the
- * stabilized column level and performs the row scan and key add/remove
- * operations inside `column_debounce_alarm`.
+ * Any pending alarm for the input is cancelled first, so only the most
+ * recent request is served.
  *
- * Any pending alarm for this column is cancelled to ensure we always process
- * the most recent edge transition, preventing missed key releases when
- * multiple keys on the same column are pressed in rapid succession.
+ * @param input Input debounce state
+ * @param action Action returned by the debounce algorithm
+ * @param now_us Current time
+ * @param callback Alarm callback
+ * @param user_data Alarm callback argument
+ */
+static void __not_in_flash_func(input_debounce_arm)(input_debounce_t* input, uint8_t action, uint32_t now_us,
+                                                    alarm_callback_t callback, void* user_data) {
+    if (!(action & DEBOUNCE_ARM)) return;
+
+    if (input->alarm_id != 0) {
+        cancel_alarm(input->alarm_id);
+        input->alarm_id = 0;
+    }
+
+    uint32_t delay_us = input->debounce.deadline_us - now_us;
+    alarm_id_t aid = add_alarm_in_us(delay_us, callback, user_data, true);
+    if (aid >= 0) {
+        input->alarm_id = aid;
+    }
+}
+
+/**
+ * @brief Count an edge of a column for the key statistics
  *
- * @param gpio GPIO pin number that triggered the interrupt
- * @param events Interrupt event flags (EDGE_RISE or EDGE_FALL)
+ * The first edge after a closed debounce window opens a burst. Edges
+ * caused by a row scan are not counted. The bounce time of the burst
+ * stops at its first quiet gap of KEYSTATS_BURST_GAP_US: an isolated spike
+ * later in the window (EMI) would otherwise read as a long bounce, and with
+ * adaptive debounce lengthen the window that catches the next one.
  */
-void keyboard_callback(uint gpio, uint32_t events) {
-    uint8_t column = gpio - COLUMN_0;
+static inline void __not_in_flash_func(column_burst_edge)(input_debounce_t* input, uint32_t now_us) {
+    if (now_us - last_row_scan_us < ROW_SCAN_EDGE_WINDOW_US) return;
+
+    if (input->burst_edges == 0) {
+        input->burst_start_us = now_us;
+        input->burst_row = BURST_NO_KEY;
+        input->burst_last_us = now_us;
+        input->burst_settled = false;
+    }
+    if (input->burst_edges != UINT16_MAX) {
+        input->burst_edges++;
+    }
 
-    if (column >= 14) return;
+    if (now_us - input->burst_last_us >= KEYSTATS_BURST_GAP_US) {
+        input->burst_settled = true;
+    }
+    if (!input->burst_settled) {
+        input->burst_last_us = now_us;
+    }
+}
 
-    // Cancel any pending alarm for this column to ensure we process the latest event
-    if (column_debounce[column].alarm_id != 0) {
-        cancel_alarm(column_debounce[column].alarm_id);
-        column_debounce[column].alarm_id = 0;
+/**
+ * @brief Close the burst of a column once its debounce window has closed
+ *
+ * Bursts that changed no key (noise that the debounce rejected) are not
+ * accounted.
+ */
+static inline void __not_in_flash_func(column_burst_end)(input_debounce_t* input, uint32_t col) {
+    if (input->burst_edges && input->burst_row != BURST_NO_KEY) {
+        keystats_bounce(input->burst_row, col, input->burst_edges - 1,
+                        input->burst_last_us - input->burst_start_us);
+        tuner_update(input->burst_row, col);
     }
+    input->burst_edges = 0;
+}
 
-    // Schedule new debounce alarm
-    alarm_id_t aid = add_alarm_in_us(MATRIX_DEBOUNCE_TIME, column_debounce_alarm, (void*)(uintptr_t)column, true);
-    if (aid >= 0) {
-        column_debounce[column].alarm_id = aid;
+/**
+ * @brief Debounce settings of a column for its next transition
+ *
+ * The settings of the selected profile; with adaptive debounce, the time
+ * is the longest learned time of the keys that can cause the transition
+ * (keys not held for a press, held keys for a release).
+ *
+ * @param col Column index
+ * @param input Column debounce state
+ * @param adapted Storage for adapted settings
+ * @return Settings to pass to the debounce algorithm
+ */
+static const debounce_config_t* __not_in_flash_func(column_config)(uint32_t col, const input_debounce_t* input,
+                                                                   debounce_config_t* adapted) {
+    const profile_t* profile = profile_get_active();
+    if (!profile->debounce_adaptive) return &profile->debounce;
+
+    uint8_t held = 0;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (kbd_state.matrix[row] & (1u << col)) held |= 1u << row;
     }
+    uint8_t rows = input->debounce.stable ? held : (uint8_t)(~held & ((1u << MATRIX_ROWS) - 1));
+
+    *adapted = profile->debounce;
+    adapted->time_us = tuner_column_time(col, rows, profile->debounce.time_us);
+    return adapted;
 }
 
 /**
- * @brief Alarm callback to process stabilized column state after debounce
+ * @brief Apply a debounced column level change
  *
- * This alarm callback executes after `MATRIX_DEBOUNCE_TIME` microseconds and
- * reads the column pin once to decide whether the column is stably HIGH
- * (pressed) or LOW (released).
- * 
  * On press: Performs a row scan to identify which key was pressed and updates
  * kbd_state by calling keyboard_add_key.
  * 
@@ -98,20 +168,17 @@ void keyboard_callback(uint gpio, uint32_t events) {
  * were released. This handles the case where multiple keys on the same column
  * are pressed/released in rapid succession, ensuring no releases are missed.
  *
- * @param id Alarm identifier for this callback invocation
- * @param user_data The column index (0..13) passed when scheduling the alarm
- * @return 0 (one-shot)
+ * Once the decision is applied, the new state is published as a single
+ * matrix snapshot for the report builder.
+ *
+ * @param col Column index (0..13)
+ * @param pressed Debounced column level (true = HIGH/pressed)
  */
-static int64_t column_debounce_alarm(alarm_id_t id, void *user_data) {
-    uint32_t col = (uintptr_t)user_data;
-    if (col >= 14) return 0;
-
+static void __not_in_flash_func(column_process)(uint32_t col, bool pressed) {
     uint gpio_pin = COLUMN_0 + col;
-    bool current_state = (gpio_get(gpio_pin) == HIGH);
-    
-    column_debounce[col].alarm_id = 0;
+    bool changed = false;
 
-    if (current_state) {
+    if (pressed) {
         // Key pressed - scan to find which row
         uint8_t row = scan_rows(gpio_pin);
 
@@ -125,21 +192,16 @@ static int64_t column_debounce_alarm(alarm_id_t id, void *user_data) {
         if (row != 0xFF) {
             if (row == FN_KEY_ROW && col == FN_KEY_COL) {
                 kbd_state.current_layer = 1;
+                TRACE(TRACE_LAYER, 1, 0);
+            }
+            changed = keyboard_add_key(row, col);
+            if (changed) {
+                keystats_press(row, col);
+                column_debounce[col].burst_row = row;
             }
-            keyboard_add_key(row, col);
         }
     } else {
         // Key released - need to check which key(s) on this column are still pressed
-        // Build list of rows currently tracked for this column
-        uint8_t pressed_rows[5];
-        uint8_t pressed_count = 0;
-        
-        for (uint8_t i = 0; i < kbd_state.pressed_keys_count; i++) {
-            if (kbd_state.pressed_keys[i][1] == col) {
-                pressed_rows[pressed_count++] = kbd_state.pressed_keys[i][0];
-            }
-        }
-        
         // Scan to see which keys are actually still pressed
         for (uint8_t r = 0; r < 5; r++) {
             gpio_put(ROW_0, (r == 0) ? HIGH : LOW);
@@ -148,26 +210,21 @@ static int64_t column_debounce_alarm(alarm_id_t id, void *user_data) {
             gpio_put(ROW_3, (r == 3) ? HIGH : LOW);
             gpio_put(ROW_4, (r == 4) ? HIGH : LOW);
             
-            busy_wait_us(10);
+            settle_wait_us(ROW_SETTLE_TIME_US);
             
             bool still_pressed = (gpio_get(gpio_pin) == HIGH);
             
             // Check if this row was tracked as pressed
-            bool was_pressed = false;
-            for (uint8_t i = 0; i < pressed_count; i++) {
-                if (pressed_rows[i] == r) {
-                    was_pressed = true;
-                    break;
-                }
-            }
+            bool was_pressed = (kbd_state.matrix[r] & (1u << col)) != 0;
             
             // If it was pressed but isn't anymore, remove it
             if (was_pressed && !still_pressed) {
                 if (r == FN_KEY_ROW && col == FN_KEY_COL) {
                     kbd_state.current_layer = 0;
-                } else {
-                    keyboard_remove_key(r, col);
+                    TRACE(TRACE_LAYER, 0, 0);
                 }
+                changed |= keyboard_remove_key(r, col);
+                column_debounce[col].burst_row = r;
             }
         }
         
@@ -179,6 +236,93 @@ static int64_t column_debounce_alarm(alarm_id_t id, void *user_data) {
         gpio_put(ROW_4, HIGH);
     }
 
+    last_row_scan_us = time_us_32();
+
+    if (changed) {
+        matrix_snapshot_publish();
+    }
+}
+
+/**
+ * @brief Keyboard matrix interrupt callback
+ *
+ * This callback is invoked directly from GPIO IRQs for column pins. Instead of
+ * making a press/release decision from the raw edge (which is vulnerable to
+ * switch bounce), the edge is passed to the column's debounce algorithm,
+ * which either reports a new stable level right away (eager) or asks for
+ * an alarm to sample the column once it is quiet (defer). In hybrid mode
+ * the edge only starts the polled scan (see hybrid_scan.h).
+ *
+ * @param gpio GPIO pin number that triggered the interrupt
+ * @param events Interrupt event flags (EDGE_RISE or EDGE_FALL)
+ */
+void __not_in_flash_func(keyboard_callback)(uint gpio, uint32_t events) {
+    uint8_t column = gpio - COLUMN_0;
+
+    if (column >= MATRIX_COLS) return;
+
+    // hybrid mode: the polled scan takes over from the first edge
+    if (hybrid_scan_enabled()) {
+        hybrid_scan_start();
+        return;
+    }
+
+    input_debounce_t* input = &column_debounce[column];
+    uint32_t now_us = time_us_32();
+    bool pressed = (gpio_get(gpio) == HIGH);
+
+    debounce_config_t adapted;
+    const debounce_config_t* config = column_config(column, input, &adapted);
+
+    column_burst_edge(input, now_us);
+    uint8_t action = debounce_edge(&input->debounce, config, now_us, pressed);
+    input_debounce_arm(input, action, now_us, column_debounce_alarm, (void*)(uintptr_t)column);
+
+    if (action & DEBOUNCE_CHANGED) {
+        TRACE(TRACE_DEBOUNCE, column, input->debounce.stable);
+        column_process(column, input->debounce.stable);
+    }
+}
+
+/**
+ * @brief Alarm callback sampling a column for its debounce algorithm
+ *
+ * Reads the column pin once and hands the level to the debounce algorithm;
+ * processes the column if its debounced level changed.
+ *
+ * @param id Alarm identifier for this callback invocation
+ * @param user_data The column index (0..13) passed when scheduling the alarm
+ * @return 0 (one-shot)
+ */
+static int64_t __not_in_flash_func(column_debounce_alarm)(alarm_id_t id, void *user_data) {
+    uint32_t col = (uintptr_t)user_data;
+    if (col >= MATRIX_COLS) return 0;
+
+    PROF_BEGIN();
+
+    input_debounce_t* input = &column_debounce[col];
+    input->alarm_id = 0;
+
+    uint32_t now_us = time_us_32();
+    bool pressed = (gpio_get(COLUMN_0 + col) == HIGH);
+
+    debounce_config_t adapted;
+    const debounce_config_t* config = column_config(col, input, &adapted);
+
+    uint8_t action = debounce_timer(&input->debounce, config, now_us, pressed);
+    input_debounce_arm(input, action, now_us, column_debounce_alarm, user_data);
+
+    if (action & DEBOUNCE_CHANGED) {
+        TRACE(TRACE_DEBOUNCE, col, input->debounce.stable);
+        column_process(col, input->debounce.stable);
+    }
+
+    // window closed: the transition's bounce is complete
+    if (!(action & DEBOUNCE_ARM)) {
+        column_burst_end(input, col);
+    }
+
+    PROF_END(PROF_COLUMN_ALARM);
     return 0; // one-shot
 }
 
@@ -192,103 +336,155 @@ static int64_t column_debounce_alarm(alarm_id_t id, void *user_data) {
  * @param gpio GPIO pin number (should be ROTARY_CLK)
  * @param events Interrupt event flags
  */
-void rotary_clk_callback(uint gpio, uint32_t events) {
+void __not_in_flash_func(rotary_clk_callback)(uint gpio, uint32_t events) {
+    PROF_BEGIN();
     uint32_t current_time = time_us_32();
     
     // Debounce
     if (current_time - last_encoder_time < ENCODER_CLK_DEBOUNCE_TIME) {
+        PROF_END(PROF_ROTARY_CLK);
         return;
     }
     last_encoder_time = current_time;
 
     // Wait for signal to stabilize
-    busy_wait_us(100); 
+    settle_wait_us(100);
     
     // Read current state
     uint8_t clk_state = gpio_get(ROTARY_CLK);
     uint8_t dt_state = gpio_get(ROTARY_DT);
     
     // Detect direction on falling edge of CLK
-    if (last_clk_state == 1 && clk_state == 0) {
-        if (dt_state == 1) {
-            // DT is HIGH during CLK fall = Clockwise rotation
-            rotary_state.direction = 1;
-        } else {
-            // DT is LOW during CLK fall = Counter-clockwise rotation
-            rotary_state.direction = -1;
-        }
+    int8_t direction = rotary_encoder_decode(last_clk_state, clk_state, dt_state);
+    if (direction != 0) {
+        rotary_state.direction = direction;
         rotary_state.has_event = true;
+        scheduler_notify(TASK_HID);
     }
     
     // store current state
     last_clk_state = clk_state;
+
+    PROF_END(PROF_ROTARY_CLK);
+}
+
+/**
+ * @brief Apply a debounced button level change
+ *
+ * Registers both press and release events by setting button_pressed
+ * accordingly, counting the edge and setting has_event flag.
+ *
+ * @param pressed Debounced button level
+ */
+static void __not_in_flash_func(rotary_button_process)(bool pressed) {
+    rotary_state.button_pressed = pressed;
+    rotary_state.button_edges++;
+    rotary_state.has_event = true;
+
+    scheduler_notify(TASK_HID);
 }
 
 /**
  * @brief Rotary encoder button interrupt callback
  * 
- * Schedules a one-shot alarm to sample the button state after 
- * `ENCODER_BTN_DEBOUNCE_TIME` microseconds, avoiding false triggers
- * from mechanical bounce. Cancels any pending alarm to ensure the
- * most recent edge transition is processed. The alarm callback verifies
- * the stable button state and registers both press and release events.
+ * Passes the edge to the button's debounce algorithm (see
+ * `ENCODER_BTN_DEBOUNCE_ALGORITHM`), avoiding false triggers from
+ * mechanical bounce. The button is active LOW.
  * 
  * @param gpio GPIO pin number (should be ROTARY_SW)
  * @param events Interrupt event flags
  */
-void rotary_button_callback(uint gpio, uint32_t events) {
-    // Cancel pending alarm if state is changing
-    if (rotary_button_debounce.alarm_id != 0) {
-        cancel_alarm(rotary_button_debounce.alarm_id);
-        rotary_button_debounce.alarm_id = 0;
-    }
+void __not_in_flash_func(rotary_button_callback)(uint gpio, uint32_t events) {
+    input_debounce_t* input = &rotary_button_debounce;
+    uint32_t now_us = time_us_32();
+    bool pressed = (gpio_get(ROTARY_SW) == 0);
 
-    alarm_id_t aid = add_alarm_in_us(ENCODER_BTN_DEBOUNCE_TIME, rotary_button_debounce_alarm, NULL, true);
-    if (aid >= 0) {
-        rotary_button_debounce.alarm_id = aid;
+    uint8_t action = debounce_edge(&input->debounce, &rotary_button_debounce_config, now_us, pressed);
+    input_debounce_arm(input, action, now_us, rotary_button_debounce_alarm, NULL);
+
+    if (action & DEBOUNCE_CHANGED) {
+        TRACE(TRACE_DEBOUNCE, TRACE_INPUT_ENCODER_BTN, input->debounce.stable);
+        rotary_button_process(input->debounce.stable);
     }
 }
 
 /**
- * @brief Alarm callback to process stabilized button state after debounce
+ * @brief Alarm callback sampling the button for its debounce algorithm
  *
- * This alarm callback executes after `ENCODER_BTN_DEBOUNCE_TIME` microseconds
- * and reads the button pin to verify its stable state (LOW = pressed, HIGH = released).
- * Registers both press and release events by setting button_pressed accordingly
- * and setting has_event flag. State changes are tracked to avoid processing
- * duplicate events. The alarm is one-shot; its id is cleared before performing
- * state updates.
+ * Reads the button pin (LOW = pressed, HIGH = released) and hands the level
+ * to the debounce algorithm, which only reports actual state changes. The
+ * alarm is one-shot; its id is cleared before performing state updates.
  *
  * @param id Alarm identifier for this callback invocation
  * @param user_data Unused for button debouncing
  * @return 0 (one-shot)
  */
-static int64_t rotary_button_debounce_alarm(alarm_id_t id, void *user_data) {
-    rotary_button_debounce.alarm_id = 0;
+static int64_t __not_in_flash_func(rotary_button_debounce_alarm)(alarm_id_t id, void *user_data) {
+    PROF_BEGIN();
+    input_debounce_t* input = &rotary_button_debounce;
+    input->alarm_id = 0;
 
-    // Button is active LOW (pressed = 0, released = 1)
-    bool current_state = (gpio_get(ROTARY_SW) == 0);
-    
-    // Only process if state changed
-    if (current_state == rotary_button_debounce.last_stable_state) {
-        return 0;
-    }
-    
-    rotary_button_debounce.last_stable_state = current_state;
+    uint32_t now_us = time_us_32();
+    bool pressed = (gpio_get(ROTARY_SW) == 0);
 
-    if (current_state) {
-        // Button pressed (transition HIGH→LOW)
-        rotary_state.button_pressed = true;
-        rotary_state.has_event = true;
-    } else {
-        // Button released (transition LOW→HIGH)
-        rotary_state.button_pressed = false;
-        rotary_state.has_event = true;
+    uint8_t action = debounce_timer(&input->debounce, &rotary_button_debounce_config, now_us, pressed);
+    input_debounce_arm(input, action, now_us, rotary_button_debounce_alarm, NULL);
+
+    if (action & DEBOUNCE_CHANGED) {
+        TRACE(TRACE_DEBOUNCE, TRACE_INPUT_ENCODER_BTN, input->debounce.stable);
+        rotary_button_process(input->debounce.stable);
     }
 
+    PROF_END(PROF_BUTTON_ALARM);
     return 0;
 }
 
+/**
+ * @brief Read the whole matrix once, before the column interrupts are on
+ *
+ * Column interrupts only see edges: a key already held at power-on (or
+ * pressed while the firmware was starting) would stay unreported until
+ * released and pressed again. Each row is driven HIGH alone and all the
+ * columns are read at once; the held keys are added to the state, their
+ * columns start debounced as pressed so the release is seen, and the
+ * result is published as the first snapshot, sent on the first IN poll
+ * after the mount (see `hid_report_resync`).
+ */
+void keyboard_boot_scan(void) {
+    bool changed = false;
+    uint32_t held_columns = 0;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        gpio_put_masked(ROW_MASK, 1u << (ROW_0 + row));
+        settle_wait_us(ROW_SETTLE_TIME_US);
+
+        uint32_t columns = (gpio_get_all() & COLUMN_MASK) >> COLUMN_0;
+        held_columns |= columns;
+
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (!(columns & (1u << col))) continue;
+
+            if (row == FN_KEY_ROW && col == FN_KEY_COL) {
+                kbd_state.current_layer = 1;
+                TRACE(TRACE_LAYER, 1, 0);
+            }
+            changed |= keyboard_add_key(row, col);
+        }
+    }
+
+    // idle state of rows
+    gpio_set_mask(ROW_MASK);
+    last_row_scan_us = time_us_32();
+
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        debounce_init(&column_debounce[col].debounce, (held_columns & (1u << col)) != 0);
+    }
+
+    if (changed) {
+        matrix_snapshot_publish();
+    }
+}
+
 //--------------------------------------------------------------------+
 
 /**
@@ -296,30 +492,39 @@ static int64_t rotary_button_debounce_alarm(alarm_id_t id, void *user_data) {
  * 
  * Routes GPIO interrupts to the appropriate handler based on which pin
  * triggered the interrupt. This single callback handles all keyboard matrix
- * columns, rotary encoder CLK, and rotary encoder button.
+ * columns, rotary encoder CLK, and rotary encoder button. Every edge is
+ * profiled, recorded in the event trace and reported to the power manager as a
+ * remote wakeup source and to the clock governor as activity.
  * 
  * @param gpio GPIO pin number that triggered the interrupt
  * @param events Interrupt event flags (EDGE_RISE, EDGE_FALL, etc.)
  */
-void gpio_callback(uint gpio, uint32_t events) {
+void __not_in_flash_func(gpio_callback)(uint gpio, uint32_t events) {
+    PROF_BEGIN();
+    TRACE(TRACE_GPIO_EDGE, gpio, events);
+
+    // wake source while the USB bus is suspended
+    power_input_edge();
+    // activity for the clock governor
+    governor_input_edge();
+
     switch (gpio) {
         case ROTARY_CLK: {
             rotary_clk_callback(gpio, events);
-            return;
         }
         break;
         
         case ROTARY_SW: {
             rotary_button_callback(gpio, events);
-            return;
         }
         break;
 
         default: {
             // all other GPIOs are keyboard matrix columns
             keyboard_callback(gpio, events);
-            return;
         }
         break;
     }
+
+    PROF_END(PROF_GPIO_IRQ);
 }
\ No newline at end of file
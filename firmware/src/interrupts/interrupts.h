@@ -13,13 +13,43 @@
     
     #include "../init/init.h"
     #include "../matrix/scan_rows/scan_rows.h"
+    #include "../matrix/hybrid_scan/hybrid_scan.h"
     #include "../global.h"
     #include "../rotary_encoder/rotary_encoder.h"
+    #include "../scheduler/scheduler.h"
+    #include "../power/power.h"
+    #include "../power/governor/governor.h"
+    #include "../debounce/debounce.h"
+    #include "../trace/trace.h"
+    #include "../profiler/profiler.h"
+    #include "../profile/profile.h"
+    #include "../keystats/keystats.h"
+    #include "../debounce/tuner/tuner.h"
 
+    // Debounce settings, in microseconds (see host/debounce_harness to evaluate them);
+    // the matrix settings are the defaults of the profiles (see profile.c)
+    #ifndef MATRIX_DEBOUNCE_TIME
     #define MATRIX_DEBOUNCE_TIME 5000
-    #define ENCODER_CLK_DEBOUNCE_TIME 500
+    #endif
+    #ifndef MATRIX_DEBOUNCE_ALGORITHM
+    #define MATRIX_DEBOUNCE_ALGORITHM DEBOUNCE_DEFER
+    #endif
+    #ifndef MATRIX_DEBOUNCE_ADAPTIVE
+    #define MATRIX_DEBOUNCE_ADAPTIVE 0      // learn the time of every key (see debounce/tuner)
+    #endif
+
+    #ifndef ENCODER_CLK_DEBOUNCE_TIME
+    #define ENCODER_CLK_DEBOUNCE_TIME 500   // lockout after an accepted CLK edge
+    #endif
+
+    #ifndef ENCODER_BTN_DEBOUNCE_TIME
     #define ENCODER_BTN_DEBOUNCE_TIME 5000
+    #endif
+    #ifndef ENCODER_BTN_DEBOUNCE_ALGORITHM
+    #define ENCODER_BTN_DEBOUNCE_ALGORITHM DEBOUNCE_DEFER
+    #endif
 
+    void keyboard_boot_scan(void);
     void gpio_callback(uint gpio, uint32_t events);
 
 #endif /* INTERRUPTS_H */
\ No newline at end of file
@@ -0,0 +1,158 @@
+/**
+ * @file keystats.c
+ * @brief Per-key statistics implementation
+ *
+ * The counters are written by the matrix interrupt handlers only, which
+ * share one priority, so updates need no locking; readers copy with
+ * interrupts masked. A generation counter marks changes: TASK_KEYSTATS
+ * wakes every KEYSTATS_CHECKPOINT_MS and appends the table to its flash
+ * log only if the generation moved since the last checkpoint, and only
+ * while no key is held, since interrupts stay masked while the flash is
+ * busy (see storage.c). The table is loaded back at boot.
+ */
+
+#include <string.h>
+
+#include "keystats.h"
+
+//--------------------------------------------------------------------+
+
+typedef struct {
+    keystats_key_t keys[KEYSTATS_KEY_COUNT];
+    volatile uint32_t generation;       // bumped on every update
+    uint32_t saved_generation;          // generation of the last checkpoint
+    storage_log_t log;
+} keystats_state_t;
+
+static keystats_state_t keystats_state = {0};
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Load the last checkpoint
+ *
+ * Call once at boot, before the matrix interrupts are enabled. Starts
+ * from zero if the log holds no valid checkpoint.
+ */
+void keystats_init(void) {
+    keystats_state_t* ks = &keystats_state;
+
+    storage_log_init(&ks->log, STORAGE_LOG_KEYSTATS, sizeof(ks->keys));
+    if (!storage_load(&ks->log, ks->keys, sizeof(ks->keys))) {
+        memset(ks->keys, 0, sizeof(ks->keys));
+    }
+    ks->generation = 0;
+    ks->saved_generation = 0;
+}
+
+/**
+ * @brief Count a debounced press
+ *
+ * Called from the matrix interrupt handlers.
+ */
+void __not_in_flash_func(keystats_press)(uint8_t row, uint8_t col) {
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS) return;
+
+    keystats_state.keys[row * MATRIX_COLS + col].presses++;
+    keystats_state.generation++;
+}
+
+/**
+ * @brief Account the edges of a finished transition
+ *
+ * Called from the matrix interrupt handlers once the debounce window of a
+ * transition has closed.
+ *
+ * @param row Key row
+ * @param col Key column
+ * @param retriggers Edges after the first one
+ * @param bounce_us Time from the first to the last edge
+ */
+void __not_in_flash_func(keystats_bounce)(uint8_t row, uint8_t col, uint16_t retriggers, uint32_t bounce_us) {
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS || retriggers == 0) return;
+
+    keystats_key_t* key = &keystats_state.keys[row * MATRIX_COLS + col];
+    if (key->chatter != UINT16_MAX) key->chatter++;
+    if (bounce_us > UINT16_MAX) bounce_us = UINT16_MAX;
+    if (bounce_us > key->max_bounce_us) key->max_bounce_us = bounce_us;
+    keystats_state.generation++;
+}
+
+/**
+ * @brief Get a copy of the counters of a key
+ *
+ * In RAM: `tuner_update` reads the counters from the matrix interrupt
+ * handlers at the end of every transition.
+ *
+ * @param index row * MATRIX_COLS + col
+ * @param key Pointer to store the counters, zero past the last key
+ */
+void __not_in_flash_func(keystats_get)(uint8_t index, keystats_key_t* key) {
+    if (index >= KEYSTATS_KEY_COUNT) {
+        *key = (keystats_key_t){0};
+        return;
+    }
+
+    uint32_t status = save_and_disable_interrupts();
+    *key = keystats_state.keys[index];
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Clear every counter
+ *
+ * The cleared table is checkpointed like any other change.
+ */
+void keystats_reset(void) {
+    uint32_t status = save_and_disable_interrupts();
+    memset(keystats_state.keys, 0, sizeof(keystats_state.keys));
+    keystats_state.generation++;
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Write the counters to flash now if they changed
+ *
+ * The caller makes sure no key is held: interrupts are masked during the
+ * write. Used by TASK_KEYSTATS and before a software reset.
+ */
+void keystats_flush(void) {
+    keystats_state_t* ks = &keystats_state;
+    static keystats_key_t copy[KEYSTATS_KEY_COUNT];
+
+    if (ks->generation == ks->saved_generation) return;
+
+    uint32_t status = save_and_disable_interrupts();
+    memcpy(copy, ks->keys, sizeof(copy));
+    uint32_t generation = ks->generation;
+    restore_interrupts(status);
+
+    if (storage_save(&ks->log, copy, sizeof(copy))) {
+        ks->saved_generation = generation;
+    }
+}
+
+/**
+ * @brief Checkpoint the counters to flash if they changed
+ *
+ * Runs as TASK_KEYSTATS, re-armed every KEYSTATS_CHECKPOINT_MS.
+ */
+void keystats_task(void) {
+    keystats_state_t* ks = &keystats_state;
+
+    if (ks->generation == ks->saved_generation) {
+        scheduler_wake_in_ms(TASK_KEYSTATS, KEYSTATS_CHECKPOINT_MS);
+        return;
+    }
+
+    // a write would delay the release of held keys
+    if (!matrix_snapshot_idle()) {
+        scheduler_wake_in_ms(TASK_KEYSTATS, KEYSTATS_RETRY_MS);
+        return;
+    }
+
+    keystats_flush();
+    scheduler_wake_in_ms(TASK_KEYSTATS, KEYSTATS_CHECKPOINT_MS);
+}
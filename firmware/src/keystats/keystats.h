@@ -0,0 +1,53 @@
+/**
+ * @file keystats.h
+ * @brief Per-key statistics declarations
+ *
+ * Press count, chatter count and longest bounce of every matrix key,
+ * updated by the matrix interrupt handlers, checkpointed to flash (see
+ * storage.h) and read over the vendor interface as feature reports.
+ * A chatter event is a debounced transition during which the contact
+ * re-triggered inside the debounce window; the bounce is the time from
+ * the first to the last edge of that transition.
+ */
+
+#ifndef KEYSTATS_H
+#define KEYSTATS_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../matrix/matrix.h"
+    #include "../matrix/snapshot/snapshot.h"
+    #include "../storage/storage.h"
+    #include "../scheduler/scheduler.h"
+
+    // Checkpoint period; nothing is written when no counter changed
+    #ifndef KEYSTATS_CHECKPOINT_MS
+    #define KEYSTATS_CHECKPOINT_MS (10 * 60 * 1000)
+    #endif
+
+    // Retry period while keys are held (the flash write masks interrupts)
+    #define KEYSTATS_RETRY_MS 1000
+
+    #define KEYSTATS_KEY_COUNT (MATRIX_ROWS * MATRIX_COLS)
+
+    // Bounce ends at the first quiet gap this long, later edges of a burst are noise
+    #define KEYSTATS_BURST_GAP_US 1000
+
+    typedef struct __attribute__((packed)) {
+        uint32_t presses;
+        uint16_t chatter;
+        uint16_t max_bounce_us;         // saturates at 65535
+    } keystats_key_t;
+
+    void keystats_init(void);
+    void keystats_press(uint8_t row, uint8_t col);
+    void keystats_bounce(uint8_t row, uint8_t col, uint16_t retriggers, uint32_t bounce_us);
+    void keystats_get(uint8_t index, keystats_key_t* key);
+    void keystats_reset(void);
+    void keystats_flush(void);
+    void keystats_task(void);
+
+#endif /* KEYSTATS_H */
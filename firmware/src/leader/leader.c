@@ -0,0 +1,188 @@
+/**
+ * @file leader.c
+ * @brief Leader key implementation
+ *
+ * The sequences are compiled at build time into a double-array trie in
+ * flash (see tools/keymap_gen.py): every key usage maps to a symbol
+ * through a 256-entry table, and the position after a key is
+ * `base[node] + symbol`, valid when its check names the node. Each key of
+ * a sequence is one transition, the same for one sequence as for hundreds.
+ *
+ * Keys arrive from the keyboard report update in TASK_HID (see
+ * update_keycode_array in scan_rows.c). The timeout and the playback of
+ * actions run in TASK_LEADER on the scheduler; an action with several taps
+ * sends the next one once the previous release has gone out.
+ */
+
+#include "leader.h"
+#include "../usb/hid_report/hid_report.h"
+#include "../matrix/scan_rows/scan_rows.h"
+
+//--------------------------------------------------------------------+
+
+#define LEADER_NO_NODE 0xFFFF
+
+typedef struct {
+    bool active;                    // collecting a sequence
+    uint16_t node;                  // trie position of the keys so far
+    absolute_time_t deadline;       // end of the wait for the next key
+    const leader_step_t* step;      // next tap of the running action, NULL if none
+} leader_state_t;
+
+static leader_state_t leader_state = {0};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Trie transition
+ *
+ * @param node Current position
+ * @param key Keycode of the next key
+ * @return Next position, LEADER_NO_NODE if no sequence continues with the key
+ */
+static uint16_t leader_next(uint16_t node, uint16_t key) {
+    if (key >= LEADER_SYMBOL_RANGE) return LEADER_NO_NODE;
+
+    uint8_t symbol = leader_symbols[key];
+    uint32_t next = (uint32_t)leader_nodes[node].base + symbol;
+
+    if (!symbol || !leader_nodes[node].base || next >= LEADER_NODES) return LEADER_NO_NODE;
+    if (leader_nodes[next].check != node + 1) return LEADER_NO_NODE;
+
+    return next;
+}
+
+/**
+ * @brief End the sequence and run the action of a position, if any
+ */
+static void leader_finish(uint16_t node) {
+    leader_state_t* ld = &leader_state;
+
+    ld->active = false;
+    if (leader_nodes[node].action) {
+        ld->step = &leader_steps[leader_nodes[node].action - 1];
+        scheduler_notify(TASK_LEADER);
+    }
+}
+
+/**
+ * @brief Send the next tap of the running action
+ *
+ * @return False while the previous tap is still going out
+ */
+static bool leader_play_step(const leader_step_t* step) {
+    if (!hid_report_keyboard_tap_idle() || !hid_report_tap_idle()) return false;
+
+    if (is_consumer_key(step->key)) {
+        hid_report_consumer_tap(KC_CONSUMER_USAGE(step->key));
+    } else if (is_profile_key(step->key)) {
+        profile_action(step->key);
+    } else if (is_gamepad_key(step->key)) {
+        gamepad_action(step->key);
+    } else if (is_reboot_key(step->key)) {
+        reboot_action(step->key);
+    } else {
+        hid_report_keyboard_tap(step->modifier, (uint8_t)step->key);
+    }
+
+    scheduler_notify(TASK_HID);
+    return true;
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Check whether a keycode is the leader key
+ *
+ * @param key Keycode from the keymap
+ * @return True for KC_LEADER
+ */
+bool __not_in_flash_func(is_leader_key)(uint16_t key) {
+    return key == KC_LEADER;
+}
+
+/**
+ * @brief Start a sequence
+ *
+ * Called on the press of KC_LEADER. Pressing it again starts over.
+ */
+void leader_start(void) {
+    leader_state_t* ld = &leader_state;
+
+    ld->active = true;
+    ld->node = 0;
+    ld->deadline = make_timeout_time_ms(LEADER_TIMEOUT_MS);
+    scheduler_wake_at(TASK_LEADER, ld->deadline);
+}
+
+/**
+ * @brief Check whether a sequence is being collected
+ */
+bool __not_in_flash_func(leader_active)(void) {
+    return leader_state.active;
+}
+
+/**
+ * @brief Feed a key press to the sequence being collected
+ *
+ * Modifiers are left to the keyboard report. Every other key is consumed:
+ * it advances the sequence, completes it (the action runs), or matches
+ * nothing and ends it.
+ *
+ * @param key Keycode the key resolved to
+ * @return True if the key was consumed and must not reach the report
+ */
+bool leader_key(uint16_t key) {
+    leader_state_t* ld = &leader_state;
+
+    if (!ld->active) return false;
+    if (key >= HID_KEY_CONTROL_LEFT && key <= HID_KEY_GUI_RIGHT) return false;
+
+    uint16_t next = leader_next(ld->node, key);
+    if (next == LEADER_NO_NODE) {
+        ld->active = false;
+        return true;
+    }
+
+    ld->node = next;
+    if (!leader_nodes[next].base) {
+        // nothing longer starts with these keys
+        leader_finish(next);
+    } else {
+        ld->deadline = make_timeout_time_ms(LEADER_TIMEOUT_MS);
+        scheduler_wake_at(TASK_LEADER, ld->deadline);
+    }
+    return true;
+}
+
+/**
+ * @brief Expire the sequence and play actions
+ *
+ * Runs as TASK_LEADER: armed with the sequence deadline, notified when an
+ * action starts, and re-armed every LEADER_STEP_RETRY_MS while an action
+ * waits for its previous tap.
+ */
+void leader_task(void) {
+    leader_state_t* ld = &leader_state;
+
+    if (ld->active) {
+        if (time_reached(ld->deadline)) {
+            // the keys so far may be a complete, shorter sequence
+            leader_finish(ld->node);
+        } else {
+            scheduler_wake_at(TASK_LEADER, ld->deadline);
+        }
+    }
+
+    while (ld->step) {
+        if (!leader_play_step(ld->step)) {
+            scheduler_wake_in_ms(TASK_LEADER, LEADER_STEP_RETRY_MS);
+            return;
+        }
+        ld->step = ld->step->last ? NULL : ld->step + 1;
+    }
+}
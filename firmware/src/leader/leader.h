@@ -0,0 +1,38 @@
+/**
+ * @file leader.h
+ * @brief Leader key declarations
+ *
+ * KC_LEADER starts a sequence: the next keys are taken out of the keyboard
+ * report and matched against the sequences of config/orione.keymap, and
+ * a complete sequence runs its action (key taps with modifiers, consumer
+ * taps, profile and gamepad actions, typed text). A key that matches no
+ * sequence ends it silently.
+ */
+
+#ifndef LEADER_H
+#define LEADER_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../matrix/keymap/keymap.h"
+    #include "../scheduler/scheduler.h"
+
+    // Time allowed between two keys of a sequence; a sequence that is the
+    // start of a longer one runs once it expires
+    #ifndef LEADER_TIMEOUT_MS
+    #define LEADER_TIMEOUT_MS 1000
+    #endif
+
+    // Poll period while an action waits for the previous tap to go out
+    #define LEADER_STEP_RETRY_MS 1
+
+    bool is_leader_key(uint16_t key);
+    void leader_start(void);
+    bool leader_active(void);
+    bool leader_key(uint16_t key);
+    void leader_task(void);
+
+#endif /* LEADER_H */
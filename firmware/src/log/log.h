@@ -0,0 +1,25 @@
+/**
+ * @file log.h
+ * @brief Debug logging macro
+ *
+ * `LOG()` prints over the RTT stdio channel when the firmware is built with
+ * ORIONE_LOG (LOG_ENABLED=1) and compiles to nothing otherwise, so log
+ * statements can stay in the hot paths of release builds.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+    #include <stdio.h>
+
+    #ifndef LOG_ENABLED
+    #define LOG_ENABLED 0
+    #endif
+
+    #if LOG_ENABLED
+    #define LOG(...) printf(__VA_ARGS__)
+    #else
+    #define LOG(...) do { } while (0)
+    #endif
+
+#endif /* LOG_H */
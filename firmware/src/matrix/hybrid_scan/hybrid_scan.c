@@ -0,0 +1,297 @@
+/**
+ * @file hybrid_scan.c
+ * @brief Hybrid interrupt / polled matrix scanning implementation
+ *
+ * Each scan drives one row HIGH at a time and reads all the columns at
+ * once, then leaves every row HIGH, the idle state the column interrupts
+ * need. Every key runs the debounce algorithm of the active profile on its
+ * own samples: a sample that differs from the previous one is an edge, and
+ * the debounce timer is served by the first scan at or after its deadline,
+ * so debounce times are rounded up to the scan period. Key changes go
+ * through `keyboard_add_key`/`keyboard_remove_key` and a snapshot, as in
+ * the interrupt-driven path, and the sampled edges feed the key statistics,
+ * the clock governor and the USB remote wakeup.
+ *
+ * The edge that starts polling only switches the column interrupts off and
+ * sets the alarm due at once, so the first scan follows the edge within
+ * microseconds and the GPIO interrupt stays as short as before. The alarm
+ * is then rescheduled from its own deadline, which keeps the period exact.
+ * Handing back to the interrupts, a key pressed between the last scan and
+ * the arming raised no edge: the columns are read once more after arming,
+ * and polling goes on if one is high.
+ */
+
+#include "hybrid_scan.h"
+
+//--------------------------------------------------------------------+
+
+// Polling state of a key
+typedef struct {
+    debounce_t debounce;        // stable level: true = pressed
+    bool level;                 // last sampled level
+    bool burst_changed;         // the burst changed the key
+    bool burst_settled;         // the quiet gap ending the bounce has been seen
+    uint16_t burst_edges;       // sampled edges since the debounce window opened
+    uint32_t burst_start_us;    // first of them
+    uint32_t burst_last_us;     // last of them before a quiet gap of KEYSTATS_BURST_GAP_US
+} key_scan_t;
+
+typedef struct {
+    bool enabled;               // hybrid mode selected
+    volatile bool active;       // polling, column interrupts off
+    uint32_t quiet_since_us;    // every key released and settled since
+    key_scan_t keys[MATRIX_ROWS][MATRIX_COLS];
+} hybrid_scan_state_t;
+
+static hybrid_scan_state_t scan = {
+    .enabled = MATRIX_HYBRID_SCAN,
+};
+
+extern keyboard_state_t kbd_state;
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Switch the edge interrupts of every column on or off
+ *
+ * Enabling clears the edges latched meanwhile (by the scans), so only
+ * edges from then on are delivered.
+ */
+static void __not_in_flash_func(hybrid_scan_column_irqs)(bool enabled) {
+    for (uint gpio = COLUMN_0; gpio < COLUMN_0 + MATRIX_COLS; gpio++) {
+        gpio_set_irq_enabled(gpio, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, enabled);
+    }
+}
+
+/**
+ * @brief Count a sampled edge of a key for the key statistics
+ *
+ * As `column_burst_edge` in interrupts.c, at the resolution of the scan.
+ */
+static inline void __not_in_flash_func(key_burst_edge)(key_scan_t* key, uint32_t now_us) {
+    if (key->burst_edges == 0) {
+        key->burst_start_us = now_us;
+        key->burst_last_us = now_us;
+        key->burst_changed = false;
+        key->burst_settled = false;
+    }
+    if (key->burst_edges != UINT16_MAX) {
+        key->burst_edges++;
+    }
+
+    if (now_us - key->burst_last_us >= KEYSTATS_BURST_GAP_US) {
+        key->burst_settled = true;
+    }
+    if (!key->burst_settled) {
+        key->burst_last_us = now_us;
+    }
+}
+
+/**
+ * @brief Close the burst of a key once its debounce window has closed
+ */
+static inline void __not_in_flash_func(key_burst_end)(key_scan_t* key, uint8_t row, uint8_t col) {
+    if (key->burst_edges && key->burst_changed) {
+        keystats_bounce(row, col, key->burst_edges - 1, key->burst_last_us - key->burst_start_us);
+        tuner_update(row, col);
+    }
+    key->burst_edges = 0;
+}
+
+/**
+ * @brief Apply a debounced key level change
+ *
+ * @return True if the tracked key state changed
+ */
+static bool __not_in_flash_func(key_process)(key_scan_t* key, uint8_t row, uint8_t col, bool pressed) {
+    bool fn_key = row == FN_KEY_ROW && col == FN_KEY_COL;
+
+    TRACE(TRACE_DEBOUNCE, col, pressed);
+    key->burst_changed = true;
+
+    if (pressed) {
+        if (fn_key) {
+            kbd_state.current_layer = 1;
+            TRACE(TRACE_LAYER, 1, 0);
+        }
+        if (!keyboard_add_key(row, col)) return false;
+
+        keystats_press(row, col);
+        return true;
+    }
+
+    if (fn_key) {
+        kbd_state.current_layer = 0;
+        TRACE(TRACE_LAYER, 0, 0);
+    }
+    return keyboard_remove_key(row, col);
+}
+
+/**
+ * @brief Scan the whole matrix and debounce every key
+ *
+ * @param now_us Time of the samples
+ * @return True while a key is pressed or a debounce window is open
+ */
+static bool __not_in_flash_func(hybrid_scan_matrix)(uint32_t* now_us) {
+    uint32_t columns[MATRIX_ROWS];
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        gpio_put_masked(ROW_MASK, 1u << (ROW_0 + row));
+        settle_wait_us(ROW_SETTLE_TIME_US);
+        columns[row] = (gpio_get_all() & COLUMN_MASK) >> COLUMN_0;
+    }
+
+    // idle state of rows
+    gpio_set_mask(ROW_MASK);
+
+    uint32_t now = time_us_32();
+    const profile_t* profile = profile_get_active();
+    bool changed = false;
+    bool edges = false;
+    bool busy = false;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            key_scan_t* key = &scan.keys[row][col];
+            bool level = (columns[row] >> col) & 1u;
+            bool edge = level != key->level;
+            bool due = key->debounce.timer_armed && (int32_t)(now - key->debounce.deadline_us) >= 0;
+
+            if (edge || due) {
+                debounce_config_t config = profile->debounce;
+                if (profile->debounce_adaptive) {
+                    config.time_us = tuner_key_time(row, col, config.time_us);
+                }
+
+                uint8_t action;
+                if (edge) {
+                    key->level = level;
+                    key_burst_edge(key, now);
+                    action = debounce_edge(&key->debounce, &config, now, level);
+                    edges = true;
+                } else {
+                    action = debounce_timer(&key->debounce, &config, now, level);
+                }
+
+                if (action & DEBOUNCE_CHANGED) {
+                    changed |= key_process(key, row, col, key->debounce.stable);
+                }
+
+                // window closed: the transition's bounce is complete
+                if (!edge && !key->debounce.timer_armed) {
+                    key_burst_end(key, row, col);
+                }
+            }
+
+            busy |= level || key->debounce.stable || key->debounce.timer_armed;
+        }
+    }
+
+    if (edges) {
+        // wake source while the USB bus is suspended, activity for the clock governor
+        power_input_edge();
+        governor_input_edge();
+    }
+
+    if (changed) {
+        matrix_snapshot_publish();
+    }
+
+    *now_us = now;
+    return busy;
+}
+
+/**
+ * @brief Scan once, and hand back to the column interrupts after the hold-off
+ *
+ * @return True while polling goes on
+ */
+static bool __not_in_flash_func(hybrid_scan_run)(void) {
+    uint32_t now_us;
+
+    if (hybrid_scan_matrix(&now_us)) {
+        scan.quiet_since_us = now_us;
+        return true;
+    }
+    if (now_us - scan.quiet_since_us < MATRIX_SCAN_HOLDOFF_US) return true;
+
+    hybrid_scan_column_irqs(true);
+
+    // pressed after the last scan: no edge was latched for it
+    if (gpio_get_all() & COLUMN_MASK) {
+        hybrid_scan_column_irqs(false);
+        return true;
+    }
+
+    scan.active = false;
+    TRACE(TRACE_SCAN, 0, 0);
+    return false;
+}
+
+/**
+ * @brief Alarm callback scanning the matrix while polling
+ *
+ * @return Negative period: rescheduled from its own deadline; 0 once the
+ *         column interrupts are armed again
+ */
+static int64_t __not_in_flash_func(hybrid_scan_alarm)(alarm_id_t id, void* user_data) {
+    (void) id;
+    (void) user_data;
+
+    PROF_BEGIN();
+    bool active = hybrid_scan_run();
+    PROF_END(PROF_MATRIX_SCAN);
+
+    return active ? -(int64_t)MATRIX_SCAN_PERIOD_US : 0;
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Select the hybrid mode, before `init_keyboard_interrupts`
+ */
+void hybrid_scan_set_enabled(bool enabled) {
+    scan.enabled = enabled;
+}
+
+/**
+ * @brief Check whether the hybrid mode is selected
+ */
+bool __not_in_flash_func(hybrid_scan_enabled)(void) {
+    return scan.enabled;
+}
+
+/**
+ * @brief Switch from the column interrupts to polling
+ *
+ * Called on a column edge in hybrid mode and at boot. The keys start from
+ * the tracked state, settled; the first scan is due at once.
+ */
+void __not_in_flash_func(hybrid_scan_start)(void) {
+    if (scan.active) return;
+
+    hybrid_scan_column_irqs(false);
+    scan.active = true;
+    TRACE(TRACE_SCAN, 1, 0);
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            key_scan_t* key = &scan.keys[row][col];
+            key->level = (kbd_state.matrix[row] & (1u << col)) != 0;
+            key->burst_edges = 0;
+            debounce_init(&key->debounce, key->level);
+        }
+    }
+    scan.quiet_since_us = time_us_32();
+
+    // no alarm left: back to the interrupts rather than stop reading the keys
+    if (add_alarm_in_us(0, hybrid_scan_alarm, NULL, true) < 0) {
+        scan.active = false;
+        hybrid_scan_column_irqs(true);
+    }
+}
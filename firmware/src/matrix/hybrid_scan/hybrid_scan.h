@@ -0,0 +1,57 @@
+/**
+ * @file hybrid_scan.h
+ * @brief Hybrid interrupt / polled matrix scanning declarations
+ *
+ * While the keyboard is idle, every row is driven HIGH and a column edge
+ * wakes the firmware, as in the interrupt-driven scan (interrupts.c). In
+ * hybrid mode, that first edge switches the column interrupts off and
+ * starts a full matrix scan every MATRIX_SCAN_PERIOD_US from a repeating
+ * alarm, with the debounce state kept per key. Once every key has been
+ * released and settled for MATRIX_SCAN_HOLDOFF_US, the column interrupts
+ * are armed again. Idle costs nothing more than before; while typing, the
+ * matrix is read at a fixed rate whatever the switches do, so chattering
+ * contacts no longer raise an interrupt per edge.
+ *
+ * The mode is chosen at build time (ORIONE_HYBRID_SCAN) and can be set
+ * before `init_keyboard_interrupts` (host/replay --hybrid).
+ */
+
+#ifndef HYBRID_SCAN_H
+#define HYBRID_SCAN_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../matrix.h"
+    #include "../scan_rows/scan_rows.h"
+    #include "../snapshot/snapshot.h"
+    #include "../../debounce/debounce.h"
+    #include "../../debounce/tuner/tuner.h"
+    #include "../../keystats/keystats.h"
+    #include "../../power/power.h"
+    #include "../../power/governor/governor.h"
+    #include "../../profile/profile.h"
+    #include "../../profiler/profiler.h"
+    #include "../../trace/trace.h"
+
+    #ifndef MATRIX_HYBRID_SCAN
+    #define MATRIX_HYBRID_SCAN 0
+    #endif
+
+    // Full matrix scan period while keys are active
+    #ifndef MATRIX_SCAN_PERIOD_US
+    #define MATRIX_SCAN_PERIOD_US 1000
+    #endif
+
+    // Time with every key released and settled before the column interrupts are armed again
+    #ifndef MATRIX_SCAN_HOLDOFF_US
+    #define MATRIX_SCAN_HOLDOFF_US 50000
+    #endif
+
+    void hybrid_scan_set_enabled(bool enabled);
+    bool hybrid_scan_enabled(void);
+    void hybrid_scan_start(void);
+
+#endif /* HYBRID_SCAN_H */
@@ -4,17 +4,106 @@
  * 
  * Provides translation function from row/column matrix coordinates to
  * HID keycodes based on the currently active layer (base or Fn).
+ *
+ * The generated tables are already laid out as the lookup indexes them,
+ * [profile][layer][row][col], so the RAM copy is a single block and a
+ * lookup is a single load.
  */
 
+#include <string.h>
+
 #include "keymap.h"
 
 //--------------------------------------------------------------------+
 
+// RAM copy of the layer tables of every profile, indexed [profile][layer][row][col]
+static uint16_t keymap_ram[KEYMAP_PROFILES][KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS];
+
+// Layers of the active profile
+static uint16_t (*keymap_active)[MATRIX_ROWS][MATRIX_COLS] = keymap_ram[0];
+
+// RAM copy of the encoder bindings and tap dances
+static keymap_encoder_t keymap_encoder_ram[KEYMAP_PROFILES];
+static tap_dance_t keymap_tap_dance_ram[KEYMAP_TAP_DANCE_SLOTS];
+
+// Encoder bindings of the active profile
+static const keymap_encoder_t* keymap_active_encoder = &keymap_encoder_ram[0];
+
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Copy the keymap tables to RAM
+ *
+ * Called at boot, for every profile, and to restore the compiled tables
+ * over changed settings. The lookup in `map_key_to_hid` then reads RAM
+ * only, so the first keypress after idle does not wait on XIP cache misses
+ * and keeps working while flash is being written.
+ */
+void keymap_init(void) {
+    _Static_assert(sizeof(keymap_ram) == sizeof(keymap_tables), "keymap RAM copy and tables differ");
+    memcpy(keymap_ram, keymap_tables, sizeof(keymap_ram));
+    memcpy(keymap_encoder_ram, keymap_encoders, sizeof(keymap_encoder_ram));
+    memcpy(keymap_tap_dance_ram, keymap_tap_dances, KEYMAP_TAP_DANCES * sizeof(tap_dance_t));
+}
+
+/**
+ * @brief Switch the lookup to the layers and encoder bindings of a profile
+ *
+ * A pointer swap: the tables of every profile are already in RAM.
+ *
+ * @param profile Profile index
+ */
+void keymap_select(uint8_t profile) {
+    if (profile >= KEYMAP_PROFILES) return;
+
+    keymap_active = keymap_ram[profile];
+    keymap_active_encoder = &keymap_encoder_ram[profile];
+}
+
+/**
+ * @brief Encoder bindings of the active profile
+ */
+const keymap_encoder_t* keymap_encoder(void) {
+    return keymap_active_encoder;
+}
+
+/**
+ * @brief Gesture actions of a tap dance
+ *
+ * @param index Tap dance index (KC_TAP_DANCE_INDEX), below KEYMAP_TAP_DANCES
+ */
+const tap_dance_t* keymap_tap_dance(uint8_t index) {
+    return &keymap_tap_dance_ram[index];
+}
+
+/**
+ * @brief RAM layer tables of every profile, for the settings
+ *
+ * Written from the main loop only, like every lookup reads them.
+ */
+uint16_t (*keymap_layers_ram(void))[KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS] {
+    return keymap_ram;
+}
+
+/**
+ * @brief RAM encoder bindings of every profile, for the settings
+ */
+keymap_encoder_t* keymap_encoders_ram(void) {
+    return keymap_encoder_ram;
+}
+
+/**
+ * @brief RAM tap dances, for the settings
+ */
+tap_dance_t* keymap_tap_dances_ram(void) {
+    return keymap_tap_dance_ram;
+}
+
 /**
  * @brief Map physical key position to HID keycode
  * 
  * Translates a physical key location (row, column) to its corresponding
- * HID keycode based on the active layer. Returns 0 for invalid positions
+ * HID keycode based on the active profile and layer. Returns 0 for invalid positions
  * or unmapped keys.
  * 
  * @param row Row number (0-4)
@@ -22,19 +111,12 @@
  * @param layer Active layer (0 = base, 1 = Fn)
  * @return HID keycode value, or 0 if invalid/unmapped
  */
-uint16_t map_key_to_hid(uint8_t row, uint8_t col, uint8_t layer) {    
-    // validate row and column
-    if (row >= 5 && col >= 14) {
+uint16_t __not_in_flash_func(map_key_to_hid)(uint8_t row, uint8_t col, uint8_t layer) {
+    // validate row, column and layer
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS || layer >= KEYMAP_LAYERS) {
         return 0;
     }
 
     // return keycode from right layer
-    if (layer == 0) {
-        return base_keymap[row][col];
-    } else if (layer == 1) {
-        return fn_keymap[row][col];
-    }
-
-    // invalid layer
-    return 0;
-}
\ No newline at end of file
+    return keymap_active[layer][row][col];
+}
@@ -2,41 +2,171 @@
  * @file keymap.h
  * @brief Keyboard layout definitions
  * 
- * Defines key mappings for base and Fn layers, translating physical
- * matrix positions (row, column) to HID keycodes. Includes Fn key location.
+ * Keycodes of the base and Fn layers, translating physical matrix
+ * positions (row, column) to HID keycodes and firmware actions, the
+ * gamepad mode layer and the encoder bindings. Every profile has its own
+ * layer set. The tables are generated at build time from
+ * config/orione.keymap (see tools/keymap_gen.py) and stay in flash;
+ * `keymap_init` copies them to RAM at boot, where the settings over the
+ * vendor interface can change them (see settings/settings.c).
  */
 
 #ifndef KEYMAP_H
 #define KEYMAP_H
 
+    #include "pico/stdlib.h"
     #include <class/hid/hid.h>
 
-    static const uint16_t base_keymap[5][14] = {
-        // Row 0
-        {HID_KEY_GRAVE, HID_KEY_1, HID_KEY_2, HID_KEY_3, HID_KEY_4, HID_KEY_5, HID_KEY_6, HID_KEY_7, HID_KEY_8, HID_KEY_9, HID_KEY_0, HID_KEY_MINUS, HID_KEY_EQUAL, HID_KEY_BACKSPACE},
-        // Row 1
-        {HID_KEY_TAB, HID_KEY_Q, HID_KEY_W, HID_KEY_E, HID_KEY_R, HID_KEY_T, HID_KEY_Y, HID_KEY_U, HID_KEY_I, HID_KEY_O, HID_KEY_P, HID_KEY_BRACKET_LEFT, HID_KEY_BRACKET_RIGHT, HID_KEY_BACKSLASH},
-        // Row 2
-        {HID_KEY_CAPS_LOCK, HID_KEY_A, HID_KEY_S, HID_KEY_D, HID_KEY_F, HID_KEY_G, HID_KEY_H, HID_KEY_J, HID_KEY_K, HID_KEY_L, HID_KEY_SEMICOLON, HID_KEY_APOSTROPHE, 0, HID_KEY_ENTER},
-        // Row 3
-        {HID_KEY_SHIFT_LEFT, HID_KEY_Z, HID_KEY_X, HID_KEY_C, HID_KEY_V, HID_KEY_B, HID_KEY_N, HID_KEY_M, HID_KEY_COMMA, HID_KEY_PERIOD, HID_KEY_SLASH, 0, 0, HID_KEY_SHIFT_RIGHT},
-        // Row 4
-        {HID_KEY_CONTROL_LEFT, HID_KEY_GUI_LEFT, HID_KEY_ALT_LEFT, 0, 0, HID_KEY_SPACE, 0, 0, 0, 0, HID_KEY_ARROW_LEFT, HID_KEY_ARROW_UP, HID_KEY_ARROW_DOWN, HID_KEY_ARROW_RIGHT}
+    #include "../matrix.h"
+
+    // Consumer control usages, moved out of the keyboard usage range they
+    // overlap (Mute is Left Alt's value, the brightness keys F20 and F21)
+    #define KC_CONSUMER_0 0x4000
+    #define KC_CONSUMER_LAST 0x4FFF
+    #define KC_CONSUMER(usage) (KC_CONSUMER_0 + (usage))
+    #define KC_CONSUMER_USAGE(key) ((uint16_t)((key) - KC_CONSUMER_0))
+
+    // Mouse keys (see mousekey/mousekey.c), above every HID keyboard and
+    // consumer usage so they never collide with a real keycode
+    enum {
+        KC_MS_UP = 0x5100,
+        KC_MS_DOWN,
+        KC_MS_LEFT,
+        KC_MS_RIGHT,
+        KC_MS_BTN1,
+        KC_MS_BTN2,
+        KC_MS_BTN3,
+        KC_MS_WH_UP,
+        KC_MS_WH_DOWN,
+        KC_MS_WH_LEFT,
+        KC_MS_WH_RIGHT,
+        KC_MS_PRECISION,        // held: slow constant speed, no acceleration
+        KC_MS_LAST = KC_MS_PRECISION
+    };
+
+    // Gamepad mode actions (see gamepad/gamepad.c), on the keyboard layers
+    enum {
+        KC_GP_TOGGLE = 0x5200,  // enter/leave gamepad mode
+        KC_GP_SOCD,             // next SOCD resolution mode
+        KC_GP_LAST = KC_GP_SOCD
     };
 
-    static const uint16_t fn_keymap[5][14] = {
-        // Row 0
-        {HID_KEY_ESCAPE, HID_KEY_F1, HID_KEY_F2, HID_KEY_F3, HID_KEY_F4, HID_KEY_F5, HID_KEY_F6, HID_KEY_F7, HID_KEY_F8, HID_KEY_F9, HID_KEY_F10, HID_KEY_F11, HID_KEY_F12, 0},
-        // Row 1
-        {0, HID_KEY_Q, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-        // Row 2
-        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, HID_USAGE_CONSUMER_BRIGHTNESS_DECREMENT, HID_USAGE_CONSUMER_BRIGHTNESS_INCREMENT, 0, 0},
-        // Row 3
-        {0, HID_USAGE_CONSUMER_SCAN_PREVIOUS, HID_USAGE_CONSUMER_PLAY_PAUSE, HID_USAGE_CONSUMER_SCAN_NEXT, 0, 0, 0, 0, 0, HID_KEY_ALT_RIGHT, 0, 0, 0, 0},
-        // Row 4
-        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    // Profile actions (see profile/profile.c), on the keyboard layers
+    enum {
+        KC_PROFILE_NEXT = 0x5300,
+        KC_PROFILE_0,           // select a profile, KC_PROFILE(n)
+    };
+
+    #define KC_PROFILE(n) (KC_PROFILE_0 + (n))
+
+    // Leader key (see leader/leader.c), on the keyboard layers
+    enum {
+        KC_LEADER = 0x5400,     // start a leader sequence
     };
 
+    // Tap dances (see tap_dance/tap_dance.c), on the keyboard layers and
+    // the encoder button
+    enum {
+        KC_TAP_DANCE_0 = 0x5500, // tap dance n, KC_TAP_DANCE(n)
+    };
+
+    #define KC_TAP_DANCE(n) (KC_TAP_DANCE_0 + (n))
+    #define KC_TAP_DANCE_INDEX(key) ((uint8_t)((key) - KC_TAP_DANCE_0))
+
+    // Software resets (see reboot/reboot.c), on the keyboard layers
+    enum {
+        KC_BOOTLOADER = 0x5600, // ROM bootloader (BOOTSEL mode)
+        KC_REBOOT,              // restart the firmware
+        KC_REBOOT_LAST = KC_REBOOT
+    };
+
+    // Gamepad controls, only on the gamepad layer
+    enum {
+        GP_DPAD_UP = 0x5210,
+        GP_DPAD_DOWN,
+        GP_DPAD_LEFT,
+        GP_DPAD_RIGHT,
+        GP_LS_UP,               // left stick, full deflection
+        GP_LS_DOWN,
+        GP_LS_LEFT,
+        GP_LS_RIGHT,
+        GP_RS_UP,               // right stick, full deflection
+        GP_RS_DOWN,
+        GP_RS_LEFT,
+        GP_RS_RIGHT,
+        GP_BTN_0,               // buttons 0..15, GP_BTN(n)
+        GP_LAST = GP_BTN_0 + 15
+    };
+
+    #define GP_BTN(n) (GP_BTN_0 + (n))
+
+    // Rotary encoder bindings of a profile: consumer codes (KC_CONSUMER),
+    // KC_MS_WH_UP or KC_MS_WH_DOWN, and a tap dance on the button
+    typedef struct {
+        uint16_t cw;            // clockwise detent
+        uint16_t ccw;           // counter-clockwise detent
+        uint16_t press;         // button
+    } keymap_encoder_t;
+
+    // Leader sequences, a double-array trie over the keyboard usages they
+    // use: the children of position s are at base + symbol, with check s + 1
+    typedef struct {
+        uint16_t base;          // 0 for a leaf
+        uint16_t check;         // parent position + 1, 0 = free position
+        uint16_t action;        // first step + 1 in leader_steps, 0 = none
+    } leader_node_t;
+
+    // One tap of a leader action
+    typedef struct {
+        uint16_t key;           // keyboard usage, KC_CONSUMER or a firmware action
+        uint8_t modifier;       // KEYBOARD_MODIFIER_* held with a keyboard usage
+        uint8_t last;           // last step of the action
+    } leader_step_t;
+
+    // Gestures told apart by a tap dance
+    typedef enum {
+        TAP_DANCE_SINGLE = 0,
+        TAP_DANCE_DOUBLE,
+        TAP_DANCE_TRIPLE,
+        TAP_DANCE_HOLD,         // first press held past the hold window
+        TAP_DANCE_GESTURES
+    } tap_dance_gesture_t;
+
+    // Tap of a gesture, key 0 if the gesture is not bound
+    typedef struct {
+        uint16_t key;           // keyboard usage, KC_CONSUMER, KC_MS_WH_* or a firmware action
+        uint8_t modifier;       // KEYBOARD_MODIFIER_* held with a keyboard usage
+    } tap_dance_action_t;
+
+    // Tap dance, windows 0 for the defaults of tap_dance.h
+    typedef struct {
+        tap_dance_action_t actions[TAP_DANCE_GESTURES];
+        uint16_t tap_ms;        // from a release to the next press
+        uint16_t hold_ms;       // from the first press to a hold
+    } tap_dance_t;
+
+    // Name of a keycode in keymap files
+    typedef struct {
+        const char* name;
+        uint16_t code;
+    } keymap_name_t;
+
+    // Generated from config/orione.keymap by tools/keymap_gen.py
+    #include "keymap_tables.h"
+
+    #define KC_PROFILE_LAST (KC_PROFILE_0 + KEYMAP_PROFILES - 1)
+    #define KC_TAP_DANCE_LAST (KC_TAP_DANCE_0 + KEYMAP_TAP_DANCES - 1)
+
+    // RAM copy size of the tap dances, at least one entry
+    #define KEYMAP_TAP_DANCE_SLOTS (KEYMAP_TAP_DANCES ? KEYMAP_TAP_DANCES : 1)
+
+    void keymap_init(void);
+    void keymap_select(uint8_t profile);
+    const keymap_encoder_t* keymap_encoder(void);
+    const tap_dance_t* keymap_tap_dance(uint8_t index);
+    uint16_t (*keymap_layers_ram(void))[KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS];
+    keymap_encoder_t* keymap_encoders_ram(void);
+    tap_dance_t* keymap_tap_dances_ram(void);
     uint16_t map_key_to_hid(uint8_t row, uint8_t col, uint8_t layer);
 
 #endif /* KEYMAP_H */
\ No newline at end of file
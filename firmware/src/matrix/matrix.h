@@ -9,12 +9,20 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+    #include <stdint.h>
+    #include <stdbool.h>
+
     #define MAX_KEYS 6 // max number of key pressed at the same time
 
+    #define MATRIX_ROWS 5
+    #define MATRIX_COLS 14
+
+    // Working matrix state, owned by the debounce alarms. Other contexts
+    // read it through matrix snapshots (see snapshot/snapshot.h)
     typedef struct {
-        volatile bool has_new_key;
         volatile uint8_t pressed_keys_count;
         volatile uint8_t pressed_keys[MAX_KEYS][2]; // [row, column] pairs
+        volatile uint16_t matrix[MATRIX_ROWS];       // bit c of row r set = key (r, c) pressed
         volatile uint8_t current_layer;
     } keyboard_state_t;
 
@@ -39,6 +47,10 @@
     #define COLUMN_12 17
     #define COLUMN_13 18
 
+    // Rows and columns are consecutive pins, set up and read as masks
+    #define ROW_MASK ((((uint32_t) 1 << MATRIX_ROWS) - 1) << ROW_0)
+    #define COLUMN_MASK ((((uint32_t) 1 << MATRIX_COLS) - 1) << COLUMN_0)
+
     #define FN_KEY_ROW 4
     #define FN_KEY_COL 9
 
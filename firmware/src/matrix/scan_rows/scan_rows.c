@@ -4,7 +4,8 @@
  * 
  * Scans keyboard matrix to identify active keys, maintains a list of
  * currently pressed keys, and constructs HID keycode arrays including
- * modifier keys. Implements Fn key layer switching logic.
+ * modifier keys, either from scratch or incrementally from matrix
+ * changes. Implements Fn key layer switching logic.
  */
 
 #include "scan_rows.h"
@@ -24,7 +25,7 @@ extern keyboard_state_t kbd_state;
  * @param gpio Column GPIO pin number to test
  * @return Row number (0-4) if found, or 0xFF if no active row detected
  */
-uint8_t scan_rows(uint gpio) {
+uint8_t __not_in_flash_func(scan_rows)(uint gpio) {
     // test each row sequentially
     for (uint8_t r = 0; r < 5; r++) {
         // set current row HIGH, all others LOW
@@ -35,7 +36,7 @@ uint8_t scan_rows(uint gpio) {
         gpio_put(ROW_4, (r == 4) ? HIGH : LOW);
         
         // allow signal to settle
-        busy_wait_us(10);
+        settle_wait_us(ROW_SETTLE_TIME_US);
         
         // if column reads HIGH when this row is HIGH, the key is pressed here
         if (gpio_get(gpio) == HIGH) {
@@ -45,47 +46,37 @@ uint8_t scan_rows(uint gpio) {
     return 0xFF; // no row found
 }
 
-// Helper function to check if a key is a consumer control key
-bool is_consumer_key(uint16_t key) {
-    // Media control keys
-    if (key == HID_USAGE_CONSUMER_PLAY_PAUSE ||
-        key == HID_USAGE_CONSUMER_SCAN_NEXT ||
-        key == HID_USAGE_CONSUMER_SCAN_PREVIOUS)
-        return true;
-    
-    // Brightness control keys
-    if (key == HID_USAGE_CONSUMER_BRIGHTNESS_DECREMENT ||
-        key == HID_USAGE_CONSUMER_BRIGHTNESS_INCREMENT)
-        return true;
-    
-    // Volume keys (if you want them too)
-    if (key == HID_USAGE_CONSUMER_MUTE ||
-        key == HID_USAGE_CONSUMER_VOLUME_INCREMENT ||
-        key == HID_USAGE_CONSUMER_VOLUME_DECREMENT)
-        return true;
-    
-    return false;
+/**
+ * @brief Check whether a keycode is a consumer control key
+ *
+ * @param key Keycode from the keymap
+ * @return True for KC_CONSUMER codes
+ */
+bool __not_in_flash_func(is_consumer_key)(uint16_t key) {
+    return key >= KC_CONSUMER_0 && key <= KC_CONSUMER_LAST;
 }
 
 /**
  * @brief Build HID keycode array from pressed keys
  * 
- * Constructs the HID report by iterating through currently pressed keys,
- * translating them to HID keycodes based on the active layer, and separating
- * modifier keys from regular keys. Skips the Fn key itself.
+ * Constructs the HID report from scratch by iterating through the pressed
+ * keys of a matrix snapshot, translating them to HID keycodes based on the
+ * snapshot's layer, and separating modifier keys from regular keys. Skips
+ * the Fn key itself. Used when the whole report is needed at once; matrix
+ * changes are applied with `update_keycode_array` instead.
  * 
+ * @param snapshot Consistent matrix state (see `matrix_snapshot_read`)
  * @param modifier Pointer to modifier byte (bitfield of active modifiers)
  * @param keycode Pointer to 6-byte array for regular keycodes
+ * @param consumer_code Pointer to store the active consumer control code (0 if none)
  */
-void build_keycode_array(uint8_t* modifier, uint8_t* keycode) {
-    static uint16_t last_consumer_code = 0;
-    
+void __not_in_flash_func(build_keycode_array)(const matrix_snapshot_t* snapshot, uint8_t* modifier, uint8_t* keycode, uint16_t* consumer_code) {
     uint8_t key_idx = 0;
     uint16_t active_consumer_code = 0;
     
-    for (uint8_t i = 0; i < kbd_state.pressed_keys_count && key_idx < 6; i++) {
-        uint8_t row = kbd_state.pressed_keys[i][0];
-        uint8_t col = kbd_state.pressed_keys[i][1];
+    for (uint8_t i = 0; i < snapshot->pressed_keys_count && key_idx < 6; i++) {
+        uint8_t row = snapshot->pressed_keys[i][0];
+        uint8_t col = snapshot->pressed_keys[i][1];
         
         // skip the Fn key itself
         if (row == FN_KEY_ROW && col == FN_KEY_COL) {
@@ -93,7 +84,7 @@ void build_keycode_array(uint8_t* modifier, uint8_t* keycode) {
         }
         
         // get HID keycode based on current layer
-        uint16_t hid_key = map_key_to_hid(row, col, kbd_state.current_layer);
+        uint16_t hid_key = map_key_to_hid(row, col, snapshot->current_layer);
 
         if (hid_key != 0) {
             // check if it's a modifier key
@@ -103,8 +94,12 @@ void build_keycode_array(uint8_t* modifier, uint8_t* keycode) {
             }
             // check if it's a consumer control key
             else if (is_consumer_key(hid_key)) {
-                active_consumer_code = hid_key;
-            } 
+                active_consumer_code = KC_CONSUMER_USAGE(hid_key);
+            }
+            // mouse keys, gamepad, profile, leader, tap dance and reset actions are not part of the keyboard report
+            else if (is_mouse_key(hid_key) || is_gamepad_key(hid_key) || is_profile_key(hid_key) || is_leader_key(hid_key) || is_tap_dance_key(hid_key) || is_reboot_key(hid_key)) {
+                continue;
+            }
             else {
                 // regular key
                 keycode[key_idx++] = (uint8_t)hid_key;
@@ -112,29 +107,159 @@ void build_keycode_array(uint8_t* modifier, uint8_t* keycode) {
         }
     }
     
-    // Send consumer control report only when code changes
-    if (active_consumer_code != last_consumer_code) {
-        send_hid_report(REPORT_ID_CONSUMER_CONTROL, active_consumer_code);
-        last_consumer_code = active_consumer_code;
+    *consumer_code = active_consumer_code;
+}
+
+/**
+ * @brief Add a keycode to a keyboard report
+ *
+ * Modifiers set their bit, consumer codes become the active consumer code,
+ * mouse keys go to the mouse keys engine, gamepad, profile, leader and
+ * reset actions run on press, tap dances see the press,
+ * regular keys take the first free slot (dropped if all 6 are in use).
+ */
+static void __not_in_flash_func(report_add_code)(hid_keyboard_report_t* report, uint16_t* consumer_code, uint16_t hid_key) {
+    if (hid_key >= HID_KEY_CONTROL_LEFT && hid_key <= HID_KEY_GUI_RIGHT) {
+        report->modifier |= (1 << ((uint8_t)hid_key - HID_KEY_CONTROL_LEFT));
+    } else if (is_consumer_key(hid_key)) {
+        *consumer_code = KC_CONSUMER_USAGE(hid_key);
+    } else if (is_mouse_key(hid_key)) {
+        mousekey_press(hid_key);
+    } else if (is_gamepad_key(hid_key)) {
+        gamepad_action(hid_key);
+    } else if (is_profile_key(hid_key)) {
+        profile_action(hid_key);
+    } else if (is_leader_key(hid_key)) {
+        leader_start();
+    } else if (is_tap_dance_key(hid_key)) {
+        tap_dance_press(hid_key);
+    } else if (is_reboot_key(hid_key)) {
+        reboot_action(hid_key);
+    } else {
+        for (uint8_t i = 0; i < 6; i++) {
+            if (report->keycode[i] == 0) {
+                report->keycode[i] = (uint8_t)hid_key;
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Remove a keycode from a keyboard report
+ *
+ * Regular keys are removed and the following slots shifted down, keeping
+ * the remaining keys in press order.
+ */
+static void __not_in_flash_func(report_remove_code)(hid_keyboard_report_t* report, uint16_t* consumer_code, uint16_t hid_key) {
+    if (hid_key >= HID_KEY_CONTROL_LEFT && hid_key <= HID_KEY_GUI_RIGHT) {
+        report->modifier &= ~(1 << ((uint8_t)hid_key - HID_KEY_CONTROL_LEFT));
+    } else if (is_consumer_key(hid_key)) {
+        if (*consumer_code == KC_CONSUMER_USAGE(hid_key)) {
+            *consumer_code = 0;
+        }
+    } else if (is_mouse_key(hid_key)) {
+        mousekey_release(hid_key);
+    } else if (is_tap_dance_key(hid_key)) {
+        tap_dance_release(hid_key);
+    } else if (is_gamepad_key(hid_key) || is_profile_key(hid_key) || is_leader_key(hid_key) || is_reboot_key(hid_key)) {
+        // actions run on press only
+    } else {
+        for (uint8_t i = 0; i < 6; i++) {
+            if (report->keycode[i] == (uint8_t)hid_key) {
+                for (uint8_t j = i; j < 5; j++) {
+                    report->keycode[j] = report->keycode[j + 1];
+                }
+                report->keycode[5] = 0;
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Apply the difference between two snapshots to a keyboard report
+ *
+ * Compares the matrix bitmaps and only touches the keys that changed:
+ * releases first, so their slots are free for new presses, then presses.
+ * The keycode of each key is resolved once, when it is pressed, and
+ * remembered, so a release always clears exactly what the press set even
+ * if the layer changed in between. While a leader sequence is being
+ * typed, its keys go to the leader engine and never reach the report. A
+ * press of any other key resolves a pending tap dance first.
+ *
+ * @param prev Snapshot the report currently reflects
+ * @param next New snapshot
+ * @param report Keyboard report to update
+ * @param consumer_code Active consumer control code to update
+ */
+void __not_in_flash_func(update_keycode_array)(const matrix_snapshot_t* prev, const matrix_snapshot_t* next, hid_keyboard_report_t* report, uint16_t* consumer_code) {
+    // keycode each held key was pressed with
+    static uint16_t held_codes[MATRIX_ROWS][MATRIX_COLS] = {0};
+
+    // releases
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        uint16_t released = prev->matrix[row] & ~next->matrix[row];
+
+        for (uint8_t col = 0; released; col++, released >>= 1) {
+            if (!(released & 1)) continue;
+
+            uint16_t hid_key = held_codes[row][col];
+            held_codes[row][col] = 0;
+            if (hid_key != 0) {
+                report_remove_code(report, consumer_code, hid_key);
+            }
+        }
+    }
+
+    // presses
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        uint16_t pressed = next->matrix[row] & ~prev->matrix[row];
+
+        for (uint8_t col = 0; pressed; col++, pressed >>= 1) {
+            if (!(pressed & 1)) continue;
+
+            // skip the Fn key itself
+            if (row == FN_KEY_ROW && col == FN_KEY_COL) continue;
+
+            uint16_t hid_key = map_key_to_hid(row, col, next->current_layer);
+            if (hid_key != 0 && !is_tap_dance_key(hid_key)) {
+                tap_dance_interrupt();
+            }
+            if (hid_key != 0 && leader_key(hid_key)) {
+                held_codes[row][col] = 0;
+                continue;
+            }
+
+            held_codes[row][col] = hid_key;
+            if (hid_key != 0) {
+                report_add_code(report, consumer_code, hid_key);
+            }
+        }
     }
 }
 
 /**
  * @brief Add a key press to the tracked state
  * 
- * Registers a new key press by adding it to the pressed keys list.
- * Checks for duplicates to avoid registering the same key twice.
- * Called from interrupt context.
+ * Registers a new key press in the matrix bitmap and adds it to the pressed
+ * keys list. Checks for duplicates to avoid registering the same key twice.
+ * Called from interrupt context; the caller publishes the new state with
+ * `matrix_snapshot_publish` once all changes for a scan are done.
  * 
  * @param row Row number of the pressed key
  * @param col Column number of the pressed key
+ * @return True if the tracked state changed
  */
-void keyboard_add_key(uint8_t row, uint8_t col) {
+bool __not_in_flash_func(keyboard_add_key)(uint8_t row, uint8_t col) {
+    bool changed = !(kbd_state.matrix[row] & (1u << col));
+    kbd_state.matrix[row] |= (1u << col);
+
     // check if key already in list
     for (uint8_t i = 0; i < kbd_state.pressed_keys_count; i++) {
         if (kbd_state.pressed_keys[i][0] == row && 
             kbd_state.pressed_keys[i][1] == col) {
-            return; // already registered
+            return changed; // already registered
         }
     }
     
@@ -143,21 +268,31 @@ void keyboard_add_key(uint8_t row, uint8_t col) {
         kbd_state.pressed_keys[kbd_state.pressed_keys_count][0] = row;
         kbd_state.pressed_keys[kbd_state.pressed_keys_count][1] = col;
         kbd_state.pressed_keys_count++;
-        kbd_state.has_new_key = true;
+        changed = true;
+    }
+
+    if (changed) {
+        TRACE(TRACE_KEY_ADD, row, col);
     }
+    return changed;
 }
 
 /**
  * @brief Remove a key release from the tracked state
  * 
- * Unregisters a key release by removing it from the pressed keys list
- * and shifting remaining keys down to fill the gap.
- * Called from interrupt context.
+ * Unregisters a key release by clearing it in the matrix bitmap, removing
+ * it from the pressed keys list and shifting remaining keys down to fill
+ * the gap. Called from interrupt context; the caller publishes the new
+ * state with `matrix_snapshot_publish`.
  * 
  * @param row Row number of the released key
  * @param col Column number of the released key
+ * @return True if the tracked state changed
  */
-void keyboard_remove_key(uint8_t row, uint8_t col) {
+bool __not_in_flash_func(keyboard_remove_key)(uint8_t row, uint8_t col) {
+    bool changed = (kbd_state.matrix[row] & (1u << col)) != 0;
+    kbd_state.matrix[row] &= ~(1u << col);
+
     for (uint8_t i = 0; i < kbd_state.pressed_keys_count; i++) {
         // find the key in the pressed list
         if (kbd_state.pressed_keys[i][0] == row && 
@@ -168,8 +303,13 @@ void keyboard_remove_key(uint8_t row, uint8_t col) {
                 kbd_state.pressed_keys[j][1] = kbd_state.pressed_keys[j + 1][1];
             }
             kbd_state.pressed_keys_count--;
-            kbd_state.has_new_key = true;
+            changed = true;
             break;
         }
     }
+
+    if (changed) {
+        TRACE(TRACE_KEY_REMOVE, row, col);
+    }
+    return changed;
 }
\ No newline at end of file
@@ -18,11 +18,33 @@
     #include "../matrix.h"
     #include "../../global.h"
     #include "../keymap/keymap.h"
+    #include "../../scheduler/scheduler.h"
+    #include "../snapshot/snapshot.h"
+    #include "../../mousekey/mousekey.h"
+    #include "../../gamepad/gamepad.h"
+    #include "../../profile/profile.h"
+    #include "../../leader/leader.h"
+    #include "../../tap_dance/tap_dance.h"
+    #include "../../reboot/reboot.h"
+    #include "../../trace/trace.h"
+
+    #define ROW_SETTLE_TIME_US 10 // row to column propagation time
+
+    // Busy wait inlined into the caller, so RAM-resident code never jumps
+    // to flash (busy_wait_us lives in flash)
+    static inline void settle_wait_us(uint32_t us) {
+        uint32_t start = time_us_32();
+        while (time_us_32() - start < us) {
+            tight_loop_contents();
+        }
+    }
 
     uint8_t scan_rows(uint gpio);
-    void keyboard_add_key(uint8_t row, uint8_t col);
-    void keyboard_remove_key(uint8_t row, uint8_t col);
+    bool keyboard_add_key(uint8_t row, uint8_t col);
+    bool keyboard_remove_key(uint8_t row, uint8_t col);
 
-    void build_keycode_array(uint8_t* modifier, uint8_t* keycode);
+    bool is_consumer_key(uint16_t key);
+    void build_keycode_array(const matrix_snapshot_t* snapshot, uint8_t* modifier, uint8_t* keycode, uint16_t* consumer_code);
+    void update_keycode_array(const matrix_snapshot_t* prev, const matrix_snapshot_t* next, hid_keyboard_report_t* report, uint16_t* consumer_code);
 
 #endif /* SCAN_ROWS_H */
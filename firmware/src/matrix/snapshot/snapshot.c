@@ -0,0 +1,122 @@
+/**
+ * @file snapshot.c
+ * @brief Versioned matrix snapshot implementation
+ *
+ * The debounce alarms own `kbd_state` and modify it freely. Once an alarm
+ * has finished updating it, `matrix_snapshot_publish` copies it into a
+ * shared snapshot protected by a seqlock: the sequence number is odd while
+ * the copy is being written and even once it is complete.
+ *
+ * Readers (the report builder in the main loop) copy the snapshot and
+ * retry if the sequence number was odd or changed during the copy, so they
+ * always consume one consistent state without disabling interrupts. The
+ * writer never waits for readers, which keeps the alarm path bounded, and
+ * the memory barriers keep the scheme valid if scanning moves to the other
+ * core or to DMA.
+ */
+
+#include "snapshot.h"
+
+//--------------------------------------------------------------------+
+
+extern keyboard_state_t kbd_state;
+
+static volatile matrix_snapshot_t shared_snapshot = {0};
+
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Publish the current matrix state
+ *
+ * Called by the scan side once per debounce decision, after all key
+ * additions/removals for that decision are done, then wakes the HID task.
+ * Single writer: all callers run in the same (alarm) interrupt context.
+ */
+void __not_in_flash_func(matrix_snapshot_publish)(void) {
+    // odd: write in progress
+    shared_snapshot.seq++;
+    __dmb();
+
+    shared_snapshot.current_layer = kbd_state.current_layer;
+    shared_snapshot.pressed_keys_count = kbd_state.pressed_keys_count;
+    for (uint8_t i = 0; i < MAX_KEYS; i++) {
+        shared_snapshot.pressed_keys[i][0] = kbd_state.pressed_keys[i][0];
+        shared_snapshot.pressed_keys[i][1] = kbd_state.pressed_keys[i][1];
+    }
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        shared_snapshot.matrix[r] = kbd_state.matrix[r];
+    }
+
+    // even: complete
+    __dmb();
+    shared_snapshot.seq++;
+
+    scheduler_notify(TASK_HID);
+}
+
+/**
+ * @brief Copy the latest complete snapshot
+ *
+ * Retries until the copy was not overlapped by a publish.
+ *
+ * @param snapshot Pointer to store the snapshot
+ */
+void __not_in_flash_func(matrix_snapshot_read)(matrix_snapshot_t* snapshot) {
+    uint32_t seq;
+
+    do {
+        seq = shared_snapshot.seq;
+        __dmb();
+
+        snapshot->current_layer = shared_snapshot.current_layer;
+        snapshot->pressed_keys_count = shared_snapshot.pressed_keys_count;
+        for (uint8_t i = 0; i < MAX_KEYS; i++) {
+            snapshot->pressed_keys[i][0] = shared_snapshot.pressed_keys[i][0];
+            snapshot->pressed_keys[i][1] = shared_snapshot.pressed_keys[i][1];
+        }
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+            snapshot->matrix[r] = shared_snapshot.matrix[r];
+        }
+
+        __dmb();
+    } while ((seq & 1) || seq != shared_snapshot.seq);
+
+    snapshot->seq = seq;
+}
+
+/**
+ * @brief Get the version of the latest published snapshot
+ *
+ * @return Sequence number; changes every time a new snapshot is published
+ */
+uint32_t matrix_snapshot_seq(void) {
+    return shared_snapshot.seq;
+}
+
+/**
+ * @brief Check that no key is held in the latest snapshot
+ *
+ * Reads the matrix bitmap, which also holds the keys pressed past the
+ * MAX_KEYS report list. Used to put off the flash writes, which mask
+ * interrupts long enough to lose key edges, until the keyboard is idle.
+ *
+ * @return True if no key is pressed
+ */
+bool matrix_snapshot_idle(void) {
+    uint32_t seq;
+    uint16_t pressed;
+
+    do {
+        seq = shared_snapshot.seq;
+        __dmb();
+
+        pressed = 0;
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+            pressed |= shared_snapshot.matrix[r];
+        }
+
+        __dmb();
+    } while ((seq & 1) || seq != shared_snapshot.seq);
+
+    return pressed == 0;
+}
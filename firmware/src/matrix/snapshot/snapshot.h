@@ -0,0 +1,35 @@
+/**
+ * @file snapshot.h
+ * @brief Versioned matrix snapshot declarations
+ *
+ * Snapshot structure and seqlock API used to hand the matrix state from
+ * the scan side (debounce alarms) to the report builder without tearing.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "hardware/sync.h"
+
+    #include "../matrix.h"
+    #include "../../scheduler/scheduler.h"
+
+    // One complete, consistent view of the matrix
+    typedef struct {
+        uint32_t seq;                       // version, even when complete
+        uint8_t current_layer;
+        uint8_t pressed_keys_count;
+        uint8_t pressed_keys[MAX_KEYS][2];  // [row, column] pairs, press order
+        uint16_t matrix[MATRIX_ROWS];       // bit c of row r set = key (r, c) pressed
+    } matrix_snapshot_t;
+
+    void matrix_snapshot_publish(void);
+    void matrix_snapshot_read(matrix_snapshot_t* snapshot);
+    uint32_t matrix_snapshot_seq(void);
+    bool matrix_snapshot_idle(void);
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,286 @@
+/**
+ * @file mousekey.c
+ * @brief Mouse keys implementation
+ *
+ * Motion is a time integrator rather than a repeat counter: every update
+ * (TASK_MOUSE, once per USB frame while a movement or wheel key is held)
+ * advances each axis by speed * elapsed time into a 16.16 fixed-point
+ * accumulator and reports only the whole counts, keeping the fraction for
+ * the next frame. Motion stays smooth at 1 kHz whatever the speed, and a
+ * late update moves the cursor further instead of slowing it down.
+ *
+ * The speed follows an ease-in curve of the time the movement has been
+ * held (start + (max - start) * s^2, s = held / accel time, in 16.16).
+ * Diagonal movement is scaled by 1/sqrt(2) so the cursor speed does not
+ * depend on the direction. The first update of a new direction moves by
+ * one count, so a tap always moves the cursor.
+ *
+ * Presses and releases come from the keyboard report update in TASK_HID
+ * (see report_add_code in scan_rows.c); everything runs in the main loop.
+ * Reports go out only for motion or button changes: once nothing is
+ * moving the task stays idle and no zero-motion reports are sent.
+ */
+
+#include "mousekey.h"
+#include "../usb/hid_report/hid_report.h"
+
+//--------------------------------------------------------------------+
+
+#define Q16_ONE (1 << 16)
+
+#define MOUSEKEY_BIT(key) (1u << ((key) - KC_MS_UP))
+
+#define MOVE_KEYS (MOUSEKEY_BIT(KC_MS_UP) | MOUSEKEY_BIT(KC_MS_DOWN) | \
+                   MOUSEKEY_BIT(KC_MS_LEFT) | MOUSEKEY_BIT(KC_MS_RIGHT))
+#define WHEEL_KEYS (MOUSEKEY_BIT(KC_MS_WH_UP) | MOUSEKEY_BIT(KC_MS_WH_DOWN) | \
+                    MOUSEKEY_BIT(KC_MS_WH_LEFT) | MOUSEKEY_BIT(KC_MS_WH_RIGHT))
+
+// 1/sqrt(2) in 0.8 fixed point
+#define DIAGONAL_SCALE 181
+
+typedef enum {
+    AXIS_X = 0,
+    AXIS_Y,
+    AXIS_WHEEL,
+    AXIS_PAN,
+    AXIS_COUNT
+} mousekey_axis_t;
+
+typedef struct {
+    uint16_t keys;                  // held mouse keys, MOUSEKEY_BIT
+    uint8_t buttons;                // MOUSE_BUTTON_* bits
+    uint8_t reported_buttons;       // buttons in the last report update
+    uint64_t move_start_us;         // first movement key pressed
+    uint64_t wheel_start_us;        // first wheel key pressed
+    uint64_t last_update_us;
+    int32_t acc[AXIS_COUNT];        // 16.16 counts not reported yet
+} mousekey_state_t;
+
+static mousekey_state_t mousekey_state = {0};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Speed after a key has been held for a while
+ *
+ * @param held_us Time since the first key of the group was pressed
+ * @param start Speed at press time, per second
+ * @param max Speed reached after `accel_ms`, per second
+ * @param accel_ms Acceleration time
+ * @return Speed per second
+ */
+static uint32_t curve_speed(uint64_t held_us, uint32_t start, uint32_t max, uint32_t accel_ms) {
+    uint64_t accel_us = (uint64_t)accel_ms * 1000;
+    if (held_us >= accel_us || max <= start) return max;
+
+    uint64_t s = (held_us << 16) / accel_us;      // 0..1 in 16.16
+    uint64_t s2 = (s * s) >> 16;
+
+    return start + (uint32_t)(((max - start) * s2) >> 16);
+}
+
+/**
+ * @brief Distance covered in a time step, in 16.16 counts
+ */
+static int32_t step_distance(uint32_t speed, uint32_t dt_us) {
+    return (int32_t)(((uint64_t)speed * dt_us << 16) / 1000000);
+}
+
+/**
+ * @brief Direction of an axis from its two keys
+ *
+ * @return 1, -1, or 0 when neither or both are held
+ */
+static int32_t axis_direction(uint16_t keys, uint16_t positive, uint16_t negative) {
+    return ((keys & MOUSEKEY_BIT(positive)) ? 1 : 0) - ((keys & MOUSEKEY_BIT(negative)) ? 1 : 0);
+}
+
+/**
+ * @brief Take the whole counts out of an accumulator
+ *
+ * @return Counts to report, clamped to the report range; the rest stays
+ */
+static int8_t take_counts(int32_t* acc) {
+    int32_t counts = *acc / Q16_ONE;     // towards zero, the fraction keeps its sign
+
+    if (counts > 127) counts = 127;
+    if (counts < -127) counts = -127;
+
+    *acc -= counts * Q16_ONE;
+    return (int8_t)counts;
+}
+
+/**
+ * @brief Button bit of a button key
+ */
+static uint8_t button_bit(uint16_t key) {
+    switch (key) {
+        case KC_MS_BTN1: return MOUSE_BUTTON_LEFT;
+        case KC_MS_BTN2: return MOUSE_BUTTON_RIGHT;
+        case KC_MS_BTN3: return MOUSE_BUTTON_MIDDLE;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Accumulator and one count offset of a movement or wheel key
+ *
+ * @param key Mouse key
+ * @param axis Pointer to store the axis
+ * @return Offset of one count in the key's direction, 0 for other keys
+ */
+static int32_t key_first_count(uint16_t key, mousekey_axis_t* axis) {
+    switch (key) {
+        case KC_MS_UP: *axis = AXIS_Y; return -Q16_ONE;
+        case KC_MS_DOWN: *axis = AXIS_Y; return Q16_ONE;
+        case KC_MS_LEFT: *axis = AXIS_X; return -Q16_ONE;
+        case KC_MS_RIGHT: *axis = AXIS_X; return Q16_ONE;
+        case KC_MS_WH_UP: *axis = AXIS_WHEEL; return Q16_ONE;
+        case KC_MS_WH_DOWN: *axis = AXIS_WHEEL; return -Q16_ONE;
+        case KC_MS_WH_LEFT: *axis = AXIS_PAN; return -Q16_ONE;
+        case KC_MS_WH_RIGHT: *axis = AXIS_PAN; return Q16_ONE;
+        default: return 0;
+    }
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Check whether a keycode is a mouse key
+ *
+ * @param key Keycode from the keymap
+ * @return True for KC_MS_* codes
+ */
+bool __not_in_flash_func(is_mouse_key)(uint16_t key) {
+    return key >= KC_MS_UP && key <= KC_MS_LAST;
+}
+
+/**
+ * @brief Apply a mouse key press
+ *
+ * A movement or wheel key starts its group's acceleration if no other key
+ * of the group was held, and moves one count right away.
+ *
+ * @param key Mouse key (KC_MS_*)
+ */
+void mousekey_press(uint16_t key) {
+    if (!is_mouse_key(key)) return;
+
+    mousekey_state_t* ms = &mousekey_state;
+    uint64_t now = time_us_64();
+    uint16_t bit = MOUSEKEY_BIT(key);
+
+    if ((bit & MOVE_KEYS) && !(ms->keys & MOVE_KEYS)) {
+        ms->move_start_us = now;
+        ms->acc[AXIS_X] = 0;
+        ms->acc[AXIS_Y] = 0;
+    }
+    if ((bit & WHEEL_KEYS) && !(ms->keys & WHEEL_KEYS)) {
+        ms->wheel_start_us = now;
+        ms->acc[AXIS_WHEEL] = 0;
+        ms->acc[AXIS_PAN] = 0;
+    }
+    if (!(ms->keys & (MOVE_KEYS | WHEEL_KEYS))) {
+        ms->last_update_us = now;
+    }
+
+    mousekey_axis_t axis;
+    int32_t first = key_first_count(key, &axis);
+    if (first) {
+        ms->acc[axis] = first;
+    }
+
+    ms->keys |= bit;
+    ms->buttons |= button_bit(key);
+    scheduler_notify(TASK_MOUSE);
+}
+
+/**
+ * @brief Apply a mouse key release
+ *
+ * @param key Mouse key (KC_MS_*)
+ */
+void mousekey_release(uint16_t key) {
+    if (!is_mouse_key(key)) return;
+
+    mousekey_state.keys &= ~MOUSEKEY_BIT(key);
+    mousekey_state.buttons &= ~button_bit(key);
+    scheduler_notify(TASK_MOUSE);
+}
+
+/**
+ * @brief Scroll the wheel by a number of detents
+ *
+ * For the rotary encoder in scroll mode (see profile.h): the detents are
+ * reported with the held buttons, outside the key acceleration.
+ *
+ * @param detents Positive scrolls up
+ */
+void mousekey_wheel(int8_t detents) {
+    hid_report_mouse_update(mousekey_state.buttons, 0, 0, detents, 0);
+    mousekey_state.reported_buttons = mousekey_state.buttons;
+}
+
+/**
+ * @brief Integrate the motion since the last update and report it
+ *
+ * Runs as TASK_MOUSE: notified by presses and releases, and re-armed
+ * every MOUSEKEY_INTERVAL_MS while a movement or wheel key is held.
+ */
+void mousekey_task(void) {
+    mousekey_state_t* ms = &mousekey_state;
+    uint64_t now = time_us_64();
+
+    uint64_t dt = now - ms->last_update_us;
+    if (dt > MOUSEKEY_MAX_STEP_US) dt = MOUSEKEY_MAX_STEP_US;
+    ms->last_update_us = now;
+
+    bool precision = ms->keys & MOUSEKEY_BIT(KC_MS_PRECISION);
+
+    // cursor
+    int32_t dx = axis_direction(ms->keys, KC_MS_RIGHT, KC_MS_LEFT);
+    int32_t dy = axis_direction(ms->keys, KC_MS_DOWN, KC_MS_UP);
+    if (dx || dy) {
+        uint32_t speed = precision ? MOUSEKEY_PRECISION_SPEED
+                                   : curve_speed(now - ms->move_start_us, MOUSEKEY_SPEED_START,
+                                                 MOUSEKEY_SPEED_MAX, MOUSEKEY_ACCEL_MS);
+        int32_t d = step_distance(speed, (uint32_t)dt);
+        if (dx && dy) {
+            d = (d * DIAGONAL_SCALE) >> 8;
+        }
+        ms->acc[AXIS_X] += dx * d;
+        ms->acc[AXIS_Y] += dy * d;
+    }
+
+    // wheel
+    int32_t dw = axis_direction(ms->keys, KC_MS_WH_UP, KC_MS_WH_DOWN);
+    int32_t dp = axis_direction(ms->keys, KC_MS_WH_RIGHT, KC_MS_WH_LEFT);
+    if (dw || dp) {
+        uint32_t speed = precision ? MOUSEKEY_PRECISION_WHEEL_SPEED
+                                   : curve_speed(now - ms->wheel_start_us, MOUSEKEY_WHEEL_SPEED_START,
+                                                 MOUSEKEY_WHEEL_SPEED_MAX, MOUSEKEY_WHEEL_ACCEL_MS);
+        int32_t d = step_distance(speed, (uint32_t)dt);
+        ms->acc[AXIS_WHEEL] += dw * d;
+        ms->acc[AXIS_PAN] += dp * d;
+    }
+
+    int8_t x = take_counts(&ms->acc[AXIS_X]);
+    int8_t y = take_counts(&ms->acc[AXIS_Y]);
+    int8_t wheel = take_counts(&ms->acc[AXIS_WHEEL]);
+    int8_t pan = take_counts(&ms->acc[AXIS_PAN]);
+
+    if (x || y || wheel || pan || ms->buttons != ms->reported_buttons) {
+        hid_report_mouse_update(ms->buttons, x, y, wheel, pan);
+        ms->reported_buttons = ms->buttons;
+        scheduler_notify(TASK_HID);
+    }
+
+    // keep integrating while anything moves, idle otherwise
+    if (ms->keys & (MOVE_KEYS | WHEEL_KEYS)) {
+        scheduler_wake_in_ms(TASK_MOUSE, MOUSEKEY_INTERVAL_MS);
+    }
+}
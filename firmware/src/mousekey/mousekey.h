@@ -0,0 +1,67 @@
+/**
+ * @file mousekey.h
+ * @brief Mouse keys declarations
+ *
+ * Cursor movement, buttons and wheel from keymap actions (`KC_MS_*`, see
+ * keymap.h), sent as the REPORT_ID_MOUSE report of the keyboard
+ * interface. Speeds are in counts (or wheel detents) per second; the
+ * speed ramps from the start to the maximum value over the acceleration
+ * time along an ease-in curve.
+ */
+
+#ifndef MOUSEKEY_H
+#define MOUSEKEY_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../matrix/keymap/keymap.h"
+    #include "../scheduler/scheduler.h"
+
+    // Update period, one USB frame (the endpoint is polled every frame)
+    #ifndef MOUSEKEY_INTERVAL_MS
+    #define MOUSEKEY_INTERVAL_MS 1
+    #endif
+
+    // Cursor speed in counts per second
+    #ifndef MOUSEKEY_SPEED_START
+    #define MOUSEKEY_SPEED_START 240
+    #endif
+    #ifndef MOUSEKEY_SPEED_MAX
+    #define MOUSEKEY_SPEED_MAX 1800
+    #endif
+    #ifndef MOUSEKEY_ACCEL_MS
+    #define MOUSEKEY_ACCEL_MS 1200
+    #endif
+
+    // Wheel speed in detents per second
+    #ifndef MOUSEKEY_WHEEL_SPEED_START
+    #define MOUSEKEY_WHEEL_SPEED_START 8
+    #endif
+    #ifndef MOUSEKEY_WHEEL_SPEED_MAX
+    #define MOUSEKEY_WHEEL_SPEED_MAX 32
+    #endif
+    #ifndef MOUSEKEY_WHEEL_ACCEL_MS
+    #define MOUSEKEY_WHEEL_ACCEL_MS 1500
+    #endif
+
+    // Constant speeds while KC_MS_PRECISION is held
+    #ifndef MOUSEKEY_PRECISION_SPEED
+    #define MOUSEKEY_PRECISION_SPEED 80
+    #endif
+    #ifndef MOUSEKEY_PRECISION_WHEEL_SPEED
+    #define MOUSEKEY_PRECISION_WHEEL_SPEED 4
+    #endif
+
+    // Longest time step integrated at once, bounds the jump after a late update
+    #define MOUSEKEY_MAX_STEP_US 16000
+
+    bool is_mouse_key(uint16_t key);
+    void mousekey_press(uint16_t key);
+    void mousekey_release(uint16_t key);
+    void mousekey_wheel(int8_t detents);
+    void mousekey_task(void);
+
+#endif /* MOUSEKEY_H */
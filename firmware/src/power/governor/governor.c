@@ -0,0 +1,118 @@
+/**
+ * @file governor.c
+ * @brief Activity-driven system clock governor implementation
+ *
+ * Every matrix/encoder edge timestamps the last activity from the GPIO
+ * IRQ. The governor task re-arms itself for the end of the idle period;
+ * once `GOVERNOR_IDLE_MS` pass without edges and with no key held, clk_sys
+ * is moved to the USB PLL (see `power_clocks_low`). The next edge notifies
+ * the task, which re-locks pll_sys and switches back. With the deferred
+ * debounce profiles this lands before the debounce alarm
+ * (`MATRIX_DEBOUNCE_TIME`) scans the matrix. The first scan still runs at
+ * the low clock where it does not wait for the task: the EAGER_PRESS
+ * profiles scan inside the edge IRQ, and the hybrid scan polls from the
+ * edge on. Those scans take about POWER_FULL_SYS_KHZ / POWER_LOW_SYS_KHZ
+ * times longer; the key is not reported any later. The edge-to-full-clock
+ * latency of each transition is measured and logged.
+ *
+ * While the USB bus is suspended the power manager owns the clocks and the
+ * governor stays idle until it is notified on resume.
+ */
+
+#include "governor.h"
+
+//--------------------------------------------------------------------+
+
+typedef struct {
+    volatile bool low;               // clk_sys lowered by the governor
+    volatile uint32_t last_edge_us;  // time of the last matrix/encoder edge
+    governor_stats_t stats;
+} governor_state_t;
+
+static governor_state_t governor_state = {0};
+
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Record a matrix or encoder edge
+ *
+ * Called from the GPIO interrupt dispatcher. Wakes the governor task only
+ * when the clock has to be restored.
+ */
+void __not_in_flash_func(governor_input_edge)(void) {
+    governor_state.last_edge_us = time_us_32();
+
+    if (governor_state.low) {
+        scheduler_notify(TASK_GOVERNOR);
+    }
+}
+
+/**
+ * @brief Clock governor task
+ *
+ * Runs as TASK_GOVERNOR: lowers clk_sys at the end of an idle period,
+ * restores it when notified of an edge, and otherwise re-arms itself for
+ * the time the current idle period would expire.
+ */
+void governor_task(void) {
+    if (GOVERNOR_IDLE_MS == 0) return;
+
+    // clocks are owned by the suspend mode, resume notifies us again
+    if (power_is_suspended()) {
+        governor_state.low = false;
+        return;
+    }
+
+    uint32_t idle_us = time_us_32() - governor_state.last_edge_us;
+    const uint32_t idle_limit_us = GOVERNOR_IDLE_MS * 1000u;
+
+    if (governor_state.low) {
+        // nothing happened since we slowed down
+        if (idle_us >= idle_limit_us) return;
+
+        power_clocks_full();
+        governor_state.low = false;
+
+        uint32_t restore_us = time_us_32() - governor_state.last_edge_us;
+        governor_state.stats.restore_count++;
+        governor_state.stats.restore_last_us = restore_us;
+        if (restore_us > governor_state.stats.restore_max_us) {
+            governor_state.stats.restore_max_us = restore_us;
+        }
+
+        LOG("governor: clk_sys %u -> %u kHz, %lu us after edge (max %lu us)\n",
+            POWER_LOW_SYS_KHZ, POWER_FULL_SYS_KHZ,
+            (unsigned long)restore_us, (unsigned long)governor_state.stats.restore_max_us);
+
+        idle_us = 0;
+    } else if (idle_us >= idle_limit_us && matrix_snapshot_idle()) {
+        // flag first so an edge during the switch notifies us
+        governor_state.low = true;
+        power_clocks_low();
+        governor_state.stats.low_count++;
+
+        LOG("governor: clk_sys %u -> %u kHz after %lu ms idle\n",
+            POWER_FULL_SYS_KHZ, POWER_LOW_SYS_KHZ, (unsigned long)(idle_us / 1000));
+
+        // an edge raced with the idle check: restore straight away
+        if (time_us_32() - governor_state.last_edge_us < idle_limit_us) {
+            scheduler_notify(TASK_GOVERNOR);
+        }
+
+        // otherwise woken by the next edge
+        return;
+    }
+
+    // a key held without edges restarts the idle period
+    uint32_t remaining_us = (idle_us < idle_limit_us) ? (idle_limit_us - idle_us) : idle_limit_us;
+    scheduler_wake_at(TASK_GOVERNOR, make_timeout_time_us(remaining_us));
+}
+
+/**
+ * @brief Get a copy of the governor transition statistics
+ *
+ * @param stats Pointer to store the statistics
+ */
+void governor_get_stats(governor_stats_t* stats) {
+    *stats = governor_state.stats;
+}
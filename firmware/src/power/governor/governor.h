@@ -0,0 +1,41 @@
+/**
+ * @file governor.h
+ * @brief Activity-driven system clock governor declarations
+ *
+ * Drops clk_sys to the low-power clock after a period without matrix or
+ * encoder activity and restores full speed on the first edge.
+ */
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "hardware/clocks.h"
+
+    #include "../power.h"
+    #include "../../log/log.h"
+    #include "../../matrix/matrix.h"
+    #include "../../matrix/snapshot/snapshot.h"
+    #include "../../scheduler/scheduler.h"
+
+    // Idle time before clk_sys is lowered, 0 disables the governor
+    #ifndef GOVERNOR_IDLE_MS
+    #define GOVERNOR_IDLE_MS 60000
+    #endif
+
+    // Transition statistics
+    typedef struct {
+        uint32_t low_count;         // number of full -> low transitions
+        uint32_t restore_count;     // number of low -> full transitions
+        uint32_t restore_last_us;   // edge to full clock, last transition
+        uint32_t restore_max_us;    // edge to full clock, worst case
+    } governor_stats_t;
+
+    void governor_input_edge(void);
+    void governor_task(void);
+    void governor_get_stats(governor_stats_t* stats);
+
+#endif /* GOVERNOR_H */
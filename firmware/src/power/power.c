@@ -0,0 +1,232 @@
+/**
+ * @file power.c
+ * @brief Power management implementation
+ *
+ * Implements the USB suspend low-power mode. The USB spec allows a
+ * suspended device an average of 2.5 mA, which the LEDs and a 125 MHz
+ * core spinning in the main loop cannot meet. On suspend:
+ * - the onboard and Caps Lock LEDs are turned off (`indicator_suspend`)
+ * - all rows are driven HIGH, so any keypress raises a column edge
+ * - clk_sys is moved to the USB PLL (48 MHz) and pll_sys is stopped
+ * - the core enters deep sleep with only USB, timer, GPIO and SRAM clocks
+ *   running (see `power_sleep`)
+ *
+ * Dormant mode is not used: it stops the crystal and the USB PLL, so the
+ * USB controller could no longer detect resume signalling from the host.
+ *
+ * A column or encoder edge while suspended issues `tud_remote_wakeup()`
+ * directly from the wake path, without waiting for the HID task.
+ */
+
+#include "power.h"
+
+//--------------------------------------------------------------------+
+
+typedef struct {
+    volatile bool suspended;         // suspend requested by the USB stack
+    volatile bool input_edge;        // matrix/encoder edge seen while suspended
+    bool remote_wakeup_en;           // host allows remote wakeup
+    bool low_power;                  // clocks and LEDs are in suspend configuration
+} power_state_t;
+
+static power_state_t power_state = {0};
+
+//--------------------------------------------------------------------+
+// CLOCKS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Run clk_sys from the USB PLL and stop the system PLL
+ *
+ * The USB PLL keeps running at 48 MHz for clk_usb, so clk_sys can be
+ * switched to it glitchlessly without touching any USB clock dependency.
+ * clk_peri follows clk_sys. Must not be called from interrupt context.
+ */
+void power_clocks_low(void) {
+    if (clock_get_hz(clk_sys) == POWER_LOW_SYS_KHZ * KHZ) return;
+
+    set_sys_clock_48mhz();
+    pll_deinit(pll_sys);
+
+    // LED patterns keep their timing
+    indicator_clock_changed();
+}
+
+/**
+ * @brief Restart the system PLL and run clk_sys at full speed
+ *
+ * Re-locks pll_sys before switching clk_sys back to it. clk_usb stays on
+ * the USB PLL throughout. Must not be called from interrupt context.
+ */
+void power_clocks_full(void) {
+    if (clock_get_hz(clk_sys) == POWER_FULL_SYS_KHZ * KHZ) return;
+
+    set_sys_clock_khz(POWER_FULL_SYS_KHZ, true);
+    indicator_clock_changed();
+}
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Put the core in deep sleep until the next interrupt
+ *
+ * Gates every clock not needed to detect a wake event while the core
+ * sleeps: the USB controller (resume/reset), the timer (alarms), IO bank 0
+ * (column and encoder edges) and SRAM. Clocks are restored by hardware on
+ * wakeup, before the interrupt handler runs.
+ *
+ * Interrupts are masked around the check so an edge arriving just before
+ * WFI still wakes the core (WFI wakes on pending interrupts with PRIMASK set).
+ */
+static void power_sleep(void) {
+    uint32_t status = save_and_disable_interrupts();
+
+    if (!power_state.input_edge && tud_suspended() && !tud_task_event_ready()) {
+        clocks_hw->sleep_en0 = CLOCKS_SLEEP_EN0_CLK_SYS_CLOCKS_BITS |
+                               CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS |
+                               CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS |
+                               CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS |
+                               CLOCKS_SLEEP_EN0_CLK_SYS_PLL_USB_BITS |
+                               CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS |
+                               CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS |
+                               CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS |
+                               CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS;
+        clocks_hw->sleep_en1 = CLOCKS_SLEEP_EN1_CLK_SYS_SRAM4_BITS |
+                               CLOCKS_SLEEP_EN1_CLK_SYS_SRAM5_BITS |
+                               CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS |
+                               CLOCKS_SLEEP_EN1_CLK_SYS_WATCHDOG_BITS |
+                               CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS |
+                               CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS |
+                               CLOCKS_SLEEP_EN1_CLK_SYS_XOSC_BITS;
+
+        scb_hw->scr |= M0PLUS_SCR_SLEEPDEEP_BITS;
+        __wfi();
+        scb_hw->scr &= ~M0PLUS_SCR_SLEEPDEEP_BITS;
+
+        // back to the reset default: every clock enabled in sleep
+        clocks_hw->sleep_en0 = 0xFFFFFFFF;
+        clocks_hw->sleep_en1 = 0xFFFFFFFF;
+    }
+
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Switch LEDs, matrix and clocks to the suspend configuration
+ */
+static void power_enter_low_power(void) {
+    // LEDs off, their state is kept for resume
+    indicator_suspend(true);
+
+    // idle matrix: every row HIGH so any keypress raises a column edge
+    gpio_put(ROW_0, HIGH);
+    gpio_put(ROW_1, HIGH);
+    gpio_put(ROW_2, HIGH);
+    gpio_put(ROW_3, HIGH);
+    gpio_put(ROW_4, HIGH);
+
+    power_clocks_low();
+    power_state.low_power = true;
+}
+
+/**
+ * @brief Restore clocks and LEDs after suspend
+ */
+static void power_exit_low_power(void) {
+    power_clocks_full();
+
+    // patterns restarted by TASK_LED
+    indicator_suspend(false);
+
+    // the clock governor was idle during suspend
+    scheduler_notify(TASK_GOVERNOR);
+
+    power_state.low_power = false;
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Request the suspend low-power mode
+ *
+ * Called from `tud_suspend_cb` (TinyUSB task context). The actual switch
+ * happens in `power_task`, after the USB stack has returned.
+ *
+ * @param remote_wakeup_en True if the host allows remote wakeup
+ */
+void power_suspend(bool remote_wakeup_en) {
+    power_state.remote_wakeup_en = remote_wakeup_en;
+    power_state.input_edge = false;
+    power_state.suspended = true;
+    scheduler_notify(TASK_POWER);
+}
+
+/**
+ * @brief Leave the suspend low-power mode
+ *
+ * Called from `tud_resume_cb` and `tud_mount_cb`/`tud_umount_cb` (bus
+ * reset or unplug while suspended).
+ */
+void power_resume(void) {
+    power_state.suspended = false;
+    scheduler_notify(TASK_POWER);
+}
+
+/**
+ * @brief Record a matrix or encoder edge
+ *
+ * Called from the GPIO interrupt dispatcher. Only flags the edge while
+ * suspended; the power task turns it into a remote wakeup.
+ */
+void __not_in_flash_func(power_input_edge)(void) {
+    if (power_state.suspended) {
+        power_state.input_edge = true;
+    }
+}
+
+/**
+ * @brief Check whether the suspend low-power mode is active
+ *
+ * @return True while the USB bus is suspended
+ */
+bool power_is_suspended(void) {
+    return power_state.suspended;
+}
+
+/**
+ * @brief Power management task
+ *
+ * Runs as TASK_POWER. While suspended it sleeps once per run and notifies
+ * itself again, so the USB task can process any event that woke the core
+ * before the next sleep. A matrix/encoder edge triggers the remote wakeup
+ * straight away. On resume it restores clocks and LEDs.
+ */
+void power_task(void) {
+    if (!power_state.suspended) {
+        if (power_state.low_power) {
+            power_exit_low_power();
+        }
+        return;
+    }
+
+    if (!power_state.low_power) {
+        power_enter_low_power();
+    }
+
+    power_sleep();
+
+    if (power_state.input_edge) {
+        power_state.input_edge = false;
+
+        if (power_state.remote_wakeup_en) {
+            tud_remote_wakeup();
+        }
+    }
+
+    // keep sleeping after the other tasks had a chance to run
+    scheduler_notify(TASK_POWER);
+}
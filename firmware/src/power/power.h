@@ -0,0 +1,42 @@
+/**
+ * @file power.h
+ * @brief Power management declarations
+ *
+ * USB suspend low-power mode and system clock switching helpers. While the
+ * bus is suspended the LEDs are turned off, clk_sys is moved to the USB PLL
+ * and the core sleeps with clocks gated until a matrix/encoder edge or USB
+ * activity wakes it.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "hardware/clocks.h"
+    #include "hardware/pll.h"
+    #include "hardware/sync.h"
+    #include "hardware/structs/scb.h"
+    #include "bsp/board_api.h"
+    #include "tusb.h"
+
+    #include "../global.h"
+    #include "../indicator/indicator.h"
+    #include "../matrix/matrix.h"
+    #include "../scheduler/scheduler.h"
+
+    #define POWER_FULL_SYS_KHZ 125000   // default clk_sys from pll_sys
+    #define POWER_LOW_SYS_KHZ 48000     // clk_sys from pll_usb, pll_sys stopped
+
+    void power_suspend(bool remote_wakeup_en);
+    void power_resume(void);
+    void power_input_edge(void);
+    bool power_is_suspended(void);
+    void power_task(void);
+
+    void power_clocks_low(void);
+    void power_clocks_full(void);
+
+#endif /* POWER_H */
@@ -0,0 +1,181 @@
+/**
+ * @file profile.c
+ * @brief Keyboard profile implementation
+ *
+ * Everything a profile selects is prepared at boot: `keymap_init` copies
+ * the layers of every profile to RAM, `gamepad_init` builds the gamepad
+ * control table, and `profile_init` copies the settings below. Selecting
+ * a profile then swaps the keymap (layers and encoder bindings) and
+ * settings pointers and sets the gamepad mode, with no table rebuilt and
+ * no flash read.
+ *
+ * The interrupt handlers read the debounce settings through the active
+ * pointer, a single word, so they see either profile and never a mix.
+ * Keys held across a switch release what they pressed: the keyboard report
+ * remembers the code each key resolved to at press time (see
+ * update_keycode_array in scan_rows.c), so only new presses use the new layers.
+ */
+
+#include <string.h>
+
+#include "profile.h"
+#include "../interrupts/interrupts.h"
+#include "../gamepad/gamepad.h"
+
+//--------------------------------------------------------------------+
+
+// Profile definitions in flash, indexed like the keymap tables (config/orione.keymap)
+static const profile_t profile_defs[KEYMAP_PROFILES] = {
+    [KEYMAP_PROFILE_DEFAULT] = {
+        .name = "default",
+        .report_mode = PROFILE_REPORT_KEYBOARD,
+        .debounce = {.algorithm = MATRIX_DEBOUNCE_ALGORITHM, .time_us = MATRIX_DEBOUNCE_TIME},
+        .debounce_adaptive = MATRIX_DEBOUNCE_ADAPTIVE,
+    },
+    [KEYMAP_PROFILE_GAME] = {
+        .name = "game",
+        .report_mode = PROFILE_REPORT_KEYBOARD,
+        .debounce = {.algorithm = DEBOUNCE_EAGER_PRESS, .time_us = MATRIX_DEBOUNCE_TIME},
+        .debounce_adaptive = true,
+    },
+    [KEYMAP_PROFILE_GAMEPAD] = {
+        .name = "gamepad",
+        .report_mode = PROFILE_REPORT_GAMEPAD,
+        .debounce = {.algorithm = DEBOUNCE_EAGER_PRESS, .time_us = MATRIX_DEBOUNCE_TIME},
+        .debounce_adaptive = true,
+    },
+};
+
+// RAM copy of the definitions
+static profile_t profile_ram[KEYMAP_PROFILES];
+
+// Settings of the selected profile, the flash definition until profile_init
+static const profile_t* volatile profile_active = &profile_defs[0];
+static uint8_t profile_active_index = 0;
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Copy the profiles to RAM and select the first one
+ *
+ * Call after `keymap_init` and `gamepad_init`.
+ */
+void profile_init(void) {
+    memcpy(profile_ram, profile_defs, sizeof(profile_ram));
+
+    profile_active_index = 0;
+    keymap_select(0);
+    profile_active = &profile_ram[0];
+    gamepad_set_active(profile_ram[0].report_mode == PROFILE_REPORT_GAMEPAD);
+}
+
+/**
+ * @brief Check whether a keycode is a profile action
+ *
+ * @param key Keycode from the keymap
+ * @return True for KC_PROFILE_* codes
+ */
+bool __not_in_flash_func(is_profile_key)(uint16_t key) {
+    return key >= KC_PROFILE_NEXT && key <= KC_PROFILE_LAST;
+}
+
+/**
+ * @brief Run a profile action
+ *
+ * Called on the press of a KC_PROFILE_* key.
+ *
+ * @param key Action (KC_PROFILE_*)
+ */
+void profile_action(uint16_t key) {
+    if (key == KC_PROFILE_NEXT) {
+        profile_select((profile_active_index + 1) % KEYMAP_PROFILES);
+    } else if (is_profile_key(key)) {
+        profile_select(key - KC_PROFILE_0);
+    }
+}
+
+/**
+ * @brief Switch to a profile
+ *
+ * Runs in the main loop (key actions and vendor commands). TASK_HID is
+ * notified to apply the report mode to the keys already held.
+ *
+ * @param index Profile index
+ * @return False if there is no such profile
+ */
+bool profile_select(uint8_t index) {
+    if (index >= KEYMAP_PROFILES) return false;
+
+    profile_active_index = index;
+    keymap_select(index);
+    profile_active = &profile_ram[index];
+    gamepad_set_active(profile_ram[index].report_mode == PROFILE_REPORT_GAMEPAD);
+
+    scheduler_notify(TASK_HID);
+    return true;
+}
+
+/**
+ * @brief Index of the selected profile
+ */
+uint8_t profile_index(void) {
+    return profile_active_index;
+}
+
+/**
+ * @brief Settings of the selected profile
+ *
+ * Safe to call from the interrupt handlers.
+ */
+const profile_t* __not_in_flash_func(profile_get_active)(void) {
+    return profile_active;
+}
+
+/**
+ * @brief Settings of a profile
+ *
+ * @param index Profile index
+ * @return RAM settings, NULL if there is no such profile
+ */
+const profile_t* profile_get(uint8_t index) {
+    if (index >= KEYMAP_PROFILES) return NULL;
+
+    return &profile_ram[index];
+}
+
+/**
+ * @brief Replace the settings of a profile
+ *
+ * Copied with interrupts masked, so the debounce handlers never see half
+ * of the new settings; the selected profile is applied again for its
+ * report mode. The caller validates the settings.
+ *
+ * @param index Profile index
+ * @param settings New settings
+ */
+void profile_update(uint8_t index, const profile_t* settings) {
+    if (index >= KEYMAP_PROFILES) return;
+
+    uint32_t status = save_and_disable_interrupts();
+    profile_ram[index] = *settings;
+    restore_interrupts(status);
+
+    if (index == profile_active_index) {
+        profile_select(index);
+    }
+}
+
+/**
+ * @brief Restore the settings of every profile from flash
+ *
+ * Keeps the selected profile.
+ */
+void profile_defaults(void) {
+    uint32_t status = save_and_disable_interrupts();
+    memcpy(profile_ram, profile_defs, sizeof(profile_ram));
+    restore_interrupts(status);
+
+    profile_select(profile_active_index);
+}
@@ -0,0 +1,49 @@
+/**
+ * @file profile.h
+ * @brief Keyboard profile declarations
+ *
+ * A profile bundles the keymap layers and encoder bindings (defined in
+ * config/orione.keymap), the matrix debounce settings and the report mode. The
+ * profiles are defined in flash and copied to RAM at boot with everything
+ * they select, so switching is a pointer swap. Profiles are selected with
+ * the KC_PROFILE_* keys or the VENDOR_CMD_PROFILE_SELECT command.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../matrix/keymap/keymap.h"
+    #include "../debounce/debounce.h"
+    #include "../scheduler/scheduler.h"
+
+    #define PROFILE_NAME_LEN 16
+
+    // Which report the bound keys go to
+    typedef enum {
+        PROFILE_REPORT_KEYBOARD = 0,
+        PROFILE_REPORT_GAMEPAD,         // gamepad mode on (see gamepad.c)
+    } profile_report_mode_t;
+
+    typedef struct {
+        char name[PROFILE_NAME_LEN];
+        profile_report_mode_t report_mode;
+        debounce_config_t debounce;     // matrix columns
+        bool debounce_adaptive;         // per-key learned times instead of debounce.time_us (see tuner.h)
+    } profile_t;
+
+    void profile_init(void);
+    bool is_profile_key(uint16_t key);
+    void profile_action(uint16_t key);
+    bool profile_select(uint8_t index);
+    uint8_t profile_index(void);
+    const profile_t* profile_get_active(void);
+    const profile_t* profile_get(uint8_t index);
+    void profile_update(uint8_t index, const profile_t* settings);
+    void profile_defaults(void);
+
+#endif /* PROFILE_H */
@@ -0,0 +1,219 @@
+/**
+ * @file profiler.c
+ * @brief Execution time profiler implementation
+ *
+ * On the Pico the tick source is SysTick, free running from the core clock
+ * over 24 bits: reading it is a single load, and any run shorter than
+ * 2^24 cycles (134 ms at 125 MHz) is measured exactly. The time of a task
+ * includes the interrupts that preempted it.
+ *
+ * Every entry has a single writer (one IRQ handler, or the main loop for
+ * the tasks) and the interrupt handlers share one priority, so updates
+ * need no locking; readers copy with interrupts masked so no entry is
+ * torn.
+ *
+ * The USB IRQ is owned by TinyUSB, so `profiler_init` redirects its RAM
+ * vector table slot to a wrapper that times the original handler.
+ */
+
+#include "profiler.h"
+
+#if PROFILER_ENABLED && !PROFILER_HOST
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/scb.h"
+#endif
+
+//--------------------------------------------------------------------+
+
+#if PROFILER_ENABLED
+
+static prof_entry_t entries[PROF_COUNT] = {0};
+
+#if !PROFILER_HOST
+static irq_handler_t usb_irq_handler = NULL;   // TinyUSB handler, called by the wrapper
+#endif
+
+static const char* const entry_names[PROF_COUNT] = {
+    [PROF_GPIO_IRQ] = "gpio_irq",
+    [PROF_ROTARY_CLK] = "enc_clk",
+    [PROF_COLUMN_ALARM] = "col_alrm",
+    [PROF_BUTTON_ALARM] = "btn_alrm",
+    [PROF_MATRIX_SCAN] = "scan",
+    [PROF_USB_IRQ] = "usb_irq",
+    [PROF_TASK_FIRST + TASK_USB] = "usb",
+    [PROF_TASK_FIRST + TASK_HID] = "hid",
+    [PROF_TASK_FIRST + TASK_MOUSE] = "mouse",
+    [PROF_TASK_FIRST + TASK_VENDOR] = "vendor",
+    [PROF_TASK_FIRST + TASK_LED] = "led",
+    [PROF_TASK_FIRST + TASK_POWER] = "power",
+    [PROF_TASK_FIRST + TASK_GOVERNOR] = "gov",
+    [PROF_TASK_FIRST + TASK_KEYSTATS] = "keystats",
+    [PROF_TASK_FIRST + TASK_LEADER] = "leader",
+    [PROF_TASK_FIRST + TASK_TAP_DANCE] = "tapdance",
+    [PROF_TASK_FIRST + TASK_DRIVE] = "drive",
+    [PROF_TASK_FIRST + TASK_REBOOT] = "reboot",
+#if SCHED_STATS
+    [PROF_TASK_FIRST + TASK_STATS] = "stats",
+#endif
+};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Histogram bin of an execution time
+ *
+ * @param ticks Execution time
+ * @return Bit length of `ticks`, capped to the last bin
+ */
+static inline uint32_t __not_in_flash_func(hist_bin)(uint32_t ticks) {
+    uint32_t bin = 0;
+    while (ticks && bin < PROFILER_HIST_BINS - 1) {
+        ticks >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+#if !PROFILER_HOST
+/**
+ * @brief USB IRQ wrapper installed in the vector table
+ */
+static void __not_in_flash_func(profiler_usb_irq)(void) {
+    PROF_BEGIN();
+    usb_irq_handler();
+    PROF_END(PROF_USB_IRQ);
+}
+#endif
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Start the tick source and hook the USB IRQ
+ *
+ * Call after `tud_init`, once TinyUSB has installed its IRQ handler.
+ */
+void profiler_init(void) {
+#if !PROFILER_HOST
+    // SysTick from the core clock, free running over 24 bits
+    systick_hw->csr = 0;
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
+    // a single word store, the IRQ sees either handler
+    usb_irq_handler = irq_get_vtable_handler(USBCTRL_IRQ);
+    if (usb_irq_handler) {
+        ((irq_handler_t*)(uintptr_t)scb_hw->vtor)[VTABLE_FIRST_IRQ + USBCTRL_IRQ] = profiler_usb_irq;
+    }
+#endif
+}
+
+/**
+ * @brief Account one run of a profiled entry
+ *
+ * Use through `PROF_BEGIN()`/`PROF_END()`, which compile out when the
+ * profiler is disabled.
+ *
+ * @param id Profiled entry
+ * @param start Tick count at the start of the run (`profiler_ticks()`)
+ */
+void __not_in_flash_func(profiler_record)(prof_id_t id, uint32_t start) {
+#if PROFILER_HOST
+    uint32_t ticks = profiler_ticks() - start;
+#else
+    uint32_t ticks = (start - profiler_ticks()) & 0x00FFFFFF;
+#endif
+
+    prof_entry_t* entry = &entries[id];
+    entry->count++;
+    entry->total += ticks;
+    if (ticks > entry->max) entry->max = ticks;
+
+    uint16_t* bin = &entry->hist[hist_bin(ticks)];
+    if (*bin != UINT16_MAX) (*bin)++;
+}
+
+/**
+ * @brief Get a copy of a profiled entry
+ *
+ * @param id Profiled entry
+ * @param entry Pointer to store the entry
+ */
+void profiler_get(prof_id_t id, prof_entry_t* entry) {
+    if (id >= PROF_COUNT) return;
+
+    uint32_t status = save_and_disable_interrupts();
+    *entry = entries[id];
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Clear every entry
+ */
+void profiler_reset(void) {
+    uint32_t status = save_and_disable_interrupts();
+    memset(entries, 0, sizeof(entries));
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Profiler ticks per microsecond
+ *
+ * Read at the time of the call: the clock governor changes clk_sys, so
+ * cycle counts taken at another clock are only approximately converted.
+ *
+ * @return Core clock in MHz on the Pico, 1 on the host
+ */
+uint32_t profiler_ticks_per_us(void) {
+#if PROFILER_HOST
+    return 1;
+#else
+    return clock_get_hz(clk_sys) / MHZ;
+#endif
+}
+
+/**
+ * @brief Short name of a profiled entry
+ *
+ * @param id Profiled entry
+ * @return Name, at most PROFILER_NAME_LEN characters
+ */
+const char* profiler_name(prof_id_t id) {
+    if (id >= PROF_COUNT || !entry_names[id]) return "?";
+
+    return entry_names[id];
+}
+
+#else
+
+// Profiler compiled out: every entry reads as never run
+
+void profiler_init(void) {}
+
+void profiler_record(prof_id_t id, uint32_t start) {
+    (void) id;
+    (void) start;
+}
+
+void profiler_get(prof_id_t id, prof_entry_t* entry) {
+    (void) id;
+    memset(entry, 0, sizeof(*entry));
+}
+
+void profiler_reset(void) {}
+
+uint32_t profiler_ticks_per_us(void) {
+    return 1;
+}
+
+const char* profiler_name(prof_id_t id) {
+    (void) id;
+    return "?";
+}
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file profiler.h
+ * @brief Execution time profiler declarations
+ *
+ * Worst-case execution time accounting of the interrupt entry points
+ * (GPIO IRQ, debounce alarms, USB IRQ) and of every scheduler task. Each
+ * entry keeps a run count, the total and maximum execution time and a
+ * log2 histogram of the execution times. Results are read by the host
+ * over the vendor HID interface (`trace_decoder profile`) and by the
+ * replay simulator.
+ *
+ * Times are in profiler ticks: core clock cycles on the Pico (SysTick,
+ * the Cortex-M0+ has no DWT cycle counter), simulated microseconds on the
+ * host (PROFILER_HOST). `PROF_BEGIN()`/`PROF_END()` compile to nothing
+ * when the firmware is built without ORIONE_PROFILER (PROFILER_ENABLED=0).
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "hardware/sync.h"
+
+    #include "../scheduler/scheduler.h"
+
+    // Build with -DPROFILER_ENABLED=1 (ORIONE_PROFILER in CMake) to profile
+    #ifndef PROFILER_ENABLED
+    #define PROFILER_ENABLED 0
+    #endif
+
+    // Host builds count simulated microseconds instead of SysTick cycles
+    #ifndef PROFILER_HOST
+    #define PROFILER_HOST 0
+    #endif
+
+    #if !PROFILER_HOST
+    #include "hardware/structs/systick.h"
+    #endif
+
+    // Histogram bins: bin 0 counts 0 ticks, bin n counts [2^(n-1), 2^n) ticks,
+    // the last bin everything above
+    #define PROFILER_HIST_BINS 16
+
+    // Longest entry name, without the terminator
+    #define PROFILER_NAME_LEN 8
+
+    // Profiled code, interrupt entry points first then one entry per task
+    typedef enum {
+        PROF_GPIO_IRQ = 0,      // gpio_callback, including the callbacks below it
+        PROF_ROTARY_CLK,        // rotary_clk_callback (nested in PROF_GPIO_IRQ)
+        PROF_COLUMN_ALARM,      // column_debounce_alarm
+        PROF_BUTTON_ALARM,      // rotary_button_debounce_alarm
+        PROF_MATRIX_SCAN,       // hybrid_scan_alarm
+        PROF_USB_IRQ,           // USBCTRL_IRQ handler (TinyUSB dcd)
+        PROF_TASK_FIRST,        // scheduler tasks, PROF_TASK_FIRST + task_id_t
+        PROF_COUNT = PROF_TASK_FIRST + TASK_COUNT
+    } prof_id_t;
+
+    typedef struct {
+        uint32_t count;                         // number of runs
+        uint64_t total;                         // ticks spent in all runs
+        uint32_t max;                           // longest run in ticks
+        uint16_t hist[PROFILER_HIST_BINS];      // runs per bin, saturated
+    } prof_entry_t;
+
+    #if PROFILER_ENABLED
+    #define PROF_BEGIN() uint32_t prof_start_ = profiler_ticks()
+    #define PROF_END(id) profiler_record((id), prof_start_)
+    #else
+    #define PROF_BEGIN() do {} while (0)
+    #define PROF_END(id) do {} while (0)
+    #endif
+
+    /**
+     * @brief Current profiler tick count
+     *
+     * SysTick counts down over 24 bits; `profiler_record` takes care of
+     * the direction and the wrap.
+     */
+    static inline uint32_t profiler_ticks(void) {
+    #if PROFILER_HOST
+        return time_us_32();
+    #else
+        return systick_hw->cvr;
+    #endif
+    }
+
+    void profiler_init(void);
+    void profiler_record(prof_id_t id, uint32_t start);
+    void profiler_get(prof_id_t id, prof_entry_t* entry);
+    void profiler_reset(void);
+    uint32_t profiler_ticks_per_us(void);
+    const char* profiler_name(prof_id_t id);
+
+#endif /* PROFILER_H */
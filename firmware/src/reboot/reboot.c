@@ -0,0 +1,127 @@
+/**
+ * @file reboot.c
+ * @brief Software reset implementation
+ *
+ * A request only records the target and wakes TASK_REBOOT, so it can come
+ * from a USB callback or from the report builder. The task waits until no
+ * key is held: the keys of the combination that asked for the reset are
+ * released first, and the key statistics can then be written to flash
+ * (the write masks interrupts, see keystats.c). The reset itself follows
+ * REBOOT_DELAY_MS later, once the control transfer of a vendor or reset
+ * interface request has completed.
+ */
+
+#include "reboot.h"
+
+//--------------------------------------------------------------------+
+
+typedef enum {
+    PHASE_IDLE = 0,
+    PHASE_WAIT,                     // requested, waiting for the keys to be released
+    PHASE_RESET,                    // statistics saved, reset on the next run
+} reboot_phase_t;
+
+typedef struct {
+    reboot_phase_t phase;
+    reboot_target_t target;
+    uint32_t activity_gpio_mask;    // LED the bootloader blinks on activity
+    uint32_t disable_interface_mask;    // bootloader interfaces left out (bit 0 drive, bit 1 PICOBOOT)
+} reboot_state_t;
+
+static reboot_state_t reboot_state = {0};
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Check whether a keycode is a reset action
+ *
+ * @param key Keycode from the keymap
+ * @return True for KC_BOOTLOADER and KC_REBOOT
+ */
+bool is_reboot_key(uint16_t key) {
+    return key >= KC_BOOTLOADER && key <= KC_REBOOT_LAST;
+}
+
+/**
+ * @brief Run a reset action
+ *
+ * Called on the press of a KC_BOOTLOADER or KC_REBOOT key; the reset
+ * happens once every key is released.
+ *
+ * @param key Action (KC_BOOTLOADER or KC_REBOOT)
+ */
+void reboot_action(uint16_t key) {
+    reboot_request(key == KC_BOOTLOADER ? REBOOT_BOOTLOADER : REBOOT_FIRMWARE);
+}
+
+/**
+ * @brief Ask for a reset
+ *
+ * The last request before the reset wins.
+ *
+ * @param target Firmware or bootloader
+ */
+void reboot_request(reboot_target_t target) {
+    reboot_state.target = target;
+    reboot_state.activity_gpio_mask = 0;
+    reboot_state.disable_interface_mask = 0;
+    if (reboot_state.phase == PHASE_IDLE) {
+        reboot_state.phase = PHASE_WAIT;
+    }
+    scheduler_notify(TASK_REBOOT);
+}
+
+/**
+ * @brief Ask for a reset into the bootloader with its options
+ *
+ * The options of `reset_usb_boot`, as sent by picotool.
+ *
+ * @param activity_gpio_mask GPIO the bootloader drives as an activity LED, 0 for none
+ * @param disable_interface_mask Bit 0 disables the drive, bit 1 the PICOBOOT interface
+ */
+void reboot_request_bootloader(uint32_t activity_gpio_mask, uint32_t disable_interface_mask) {
+    reboot_request(REBOOT_BOOTLOADER);
+    reboot_state.activity_gpio_mask = activity_gpio_mask;
+    reboot_state.disable_interface_mask = disable_interface_mask;
+}
+
+/**
+ * @brief Carry out a requested reset
+ *
+ * Runs as TASK_REBOOT, woken by the requests and by itself.
+ */
+void reboot_task(void) {
+    reboot_state_t* rs = &reboot_state;
+
+    switch (rs->phase) {
+        case PHASE_WAIT: {
+            if (!matrix_snapshot_idle()) {
+                scheduler_wake_in_ms(TASK_REBOOT, REBOOT_RETRY_MS);
+                break;
+            }
+
+            // counted since the last checkpoint, lost otherwise
+            keystats_flush();
+
+            rs->phase = PHASE_RESET;
+            scheduler_wake_in_ms(TASK_REBOOT, REBOOT_DELAY_MS);
+        }
+        break;
+
+        case PHASE_RESET: {
+            if (rs->target == REBOOT_BOOTLOADER) {
+                reset_usb_boot(rs->activity_gpio_mask, rs->disable_interface_mask);
+            } else {
+                watchdog_reboot(0, 0, 1);
+            }
+            // not reached on the board
+            rs->phase = PHASE_IDLE;
+        }
+        break;
+
+        default:
+        break;
+    }
+}
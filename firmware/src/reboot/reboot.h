@@ -0,0 +1,45 @@
+/**
+ * @file reboot.h
+ * @brief Software reset declarations
+ *
+ * Restarts the keyboard, either into the firmware again or into the
+ * RP2040 ROM bootloader (BOOTSEL mode: the RPI-RP2 drive and picotool),
+ * without touching the board. Requested by the KC_BOOTLOADER and
+ * KC_REBOOT keys, the VENDOR_CMD_REBOOT command and the picotool reset
+ * interface (usb/reset_interface); carried out by TASK_REBOOT once no key
+ * is held, after the key statistics not yet checkpointed are saved.
+ */
+
+#ifndef REBOOT_H
+#define REBOOT_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "pico/bootrom.h"
+    #include "hardware/watchdog.h"
+
+    #include "../matrix/keymap/keymap.h"
+    #include "../matrix/snapshot/snapshot.h"
+    #include "../keystats/keystats.h"
+    #include "../scheduler/scheduler.h"
+
+    // Poll period while keys are held
+    #define REBOOT_RETRY_MS 10
+
+    // Time left to the USB stack to finish the request that asked for the reset
+    #define REBOOT_DELAY_MS 20
+
+    typedef enum {
+        REBOOT_FIRMWARE = 0,            // run the firmware again
+        REBOOT_BOOTLOADER,              // ROM bootloader, BOOTSEL mode
+    } reboot_target_t;
+
+    bool is_reboot_key(uint16_t key);
+    void reboot_action(uint16_t key);
+    void reboot_request(reboot_target_t target);
+    void reboot_request_bootloader(uint32_t activity_gpio_mask, uint32_t disable_interface_mask);
+    void reboot_task(void);
+
+#endif /* REBOOT_H */
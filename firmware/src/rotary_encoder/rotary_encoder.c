@@ -4,7 +4,8 @@
  * 
  * Manages rotary encoder state including rotation direction and button
  * press status. Provides interrupt-safe atomic access for reading and
- * clearing encoder events from the main loop.
+ * clearing encoder events from the main loop, and the CLK/DT decoding
+ * used by the CLK interrupt.
  */
 
 #include "rotary_encoder.h"
@@ -23,18 +24,22 @@ rotary_encoder_state_t rotary_state = {0};  // Current encoder state
  * @brief Get and clear current rotary encoder state
  * 
  * Atomically reads the current encoder state (rotation direction and button
- * press) and clears the rotation direction and event flag for the next event.
- * The button_pressed state is preserved to allow distinguishing between
- * press and release events in the main loop. Uses interrupt disabling to
- * ensure thread-safe access between main loop and interrupt handlers.
+ * press) and clears the rotation direction, button edge count and event flag
+ * for the next event. The button_pressed state is preserved to allow
+ * distinguishing between press and release events in the main loop; with
+ * the edge count, a press and release that both happened since the last
+ * read are both seen. Uses interrupt disabling to ensure thread-safe access
+ * between main loop and interrupt handlers.
  * 
  * @param direction Pointer to store rotation direction (-1=CCW, 0=none, 1=CW)
  * @param button_pressed Pointer to store button state (true if pressed, false if released)
+ * @param button_edges Pointer to store the number of button changes, the last one to button_pressed
  */
-void rotary_encoder_get_state(int8_t* direction, bool* button_pressed) {
+void rotary_encoder_get_state(int8_t* direction, bool* button_pressed, uint8_t* button_edges) {
     if (!rotary_state.has_event) {
         *direction = 0;
         *button_pressed = false;
+        *button_edges = 0;
         return;
     }
     
@@ -42,10 +47,32 @@ void rotary_encoder_get_state(int8_t* direction, bool* button_pressed) {
     
     *direction = rotary_state.direction;
     *button_pressed = rotary_state.button_pressed;
+    *button_edges = rotary_state.button_edges;
     
     // Clear solo direction, button_pressed rimane per indicare press vs release
     rotary_state.direction = 0;
+    rotary_state.button_edges = 0;
     rotary_state.has_event = false;
     
     restore_interrupts(status);
+}
+
+/**
+ * @brief Decode the rotation direction from a CLK/DT sample
+ *
+ * A step is detected on the falling edge of CLK: DT HIGH at that point
+ * means clockwise rotation, DT LOW counter-clockwise.
+ *
+ * @param last_clk_state CLK level at the previous sample
+ * @param clk_state Current CLK level
+ * @param dt_state Current DT level
+ * @return 1 for CW, -1 for CCW, 0 if no step
+ */
+int8_t __not_in_flash_func(rotary_encoder_decode)(uint8_t last_clk_state, uint8_t clk_state, uint8_t dt_state) {
+    // no falling edge of CLK -> no step
+    if (!(last_clk_state == 1 && clk_state == 0)) {
+        return 0;
+    }
+
+    return (dt_state == 1) ? 1 : -1;
 }
\ No newline at end of file
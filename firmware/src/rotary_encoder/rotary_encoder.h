@@ -23,6 +23,7 @@
     typedef struct {
         volatile int8_t direction;     // -1 for CCW, 1 for CW, 0 for no change
         volatile bool button_pressed;   // true when button is pressed
+        volatile uint8_t button_edges;  // debounced button changes since the last read
         volatile bool has_event;        // true when there's a new event to process
     } rotary_encoder_state_t;
 
@@ -32,6 +33,9 @@
     extern rotary_encoder_state_t rotary_state;
 
     // Get current state (call from main loop)
-    void rotary_encoder_get_state(int8_t* direction, bool* button_pressed);
+    void rotary_encoder_get_state(int8_t* direction, bool* button_pressed, uint8_t* button_edges);
+
+    // Direction from a CLK/DT sample (-1, 0 or 1)
+    int8_t rotary_encoder_decode(uint8_t last_clk_state, uint8_t clk_state, uint8_t dt_state);
 
 #endif /* ROTARY_ENCODER_H */
\ No newline at end of file
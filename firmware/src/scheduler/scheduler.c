@@ -0,0 +1,239 @@
+/**
+ * @file scheduler.c
+ * @brief Deadline scheduler implementation
+ *
+ * Small cooperative scheduler for the main loop. Every task is one-shot:
+ * after it runs it stays idle until it is re-armed with a deadline
+ * (`scheduler_wake_at`/`scheduler_wake_in_ms`) or notified of an event
+ * (`scheduler_notify`, callable from IRQs). The USB task is notified from
+ * TinyUSB's event hook, so it only runs when the stack queued an event.
+ *
+ * When nothing is due the core sleeps with WFE until the earliest deadline.
+ * Interrupts (USB, GPIO, alarms) wake the core; `scheduler_notify` also
+ * issues SEV so a notification raised between the due check and the WFE
+ * is never lost.
+ */
+
+#include <string.h>
+
+#include "scheduler.h"
+#include "../profiler/profiler.h"
+
+//--------------------------------------------------------------------+
+
+typedef struct {
+    task_fn_t fn;
+    volatile bool pending;      // set by scheduler_notify (IRQ safe)
+    bool armed;                 // deadline is valid
+    absolute_time_t deadline;
+} task_t;
+
+static task_t tasks[TASK_COUNT] = {0};
+
+#if SCHED_STATS
+static task_stats_t task_stats[TASK_COUNT] = {0};
+static uint64_t sleep_total_us = 0;  // total time spent in WFE
+static uint32_t wakeup_count = 0;    // number of WFE wakeups
+#endif
+
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Register a task with the scheduler
+ *
+ * The task starts idle; arm it with a deadline or notify it to run it
+ * for the first time.
+ *
+ * @param id Task identifier
+ * @param fn Task function
+ */
+void scheduler_register(task_id_t id, task_fn_t fn) {
+    if (id >= TASK_COUNT) return;
+
+    tasks[id].fn = fn;
+    tasks[id].pending = false;
+    tasks[id].armed = false;
+}
+
+/**
+ * @brief Arm a task to run at an absolute deadline
+ *
+ * Replaces any previously armed deadline. Must be called from the main
+ * loop (task or TinyUSB callback context), not from interrupts.
+ *
+ * @param id Task identifier
+ * @param deadline Absolute time at which the task becomes due
+ */
+void scheduler_wake_at(task_id_t id, absolute_time_t deadline) {
+    if (id >= TASK_COUNT) return;
+
+    tasks[id].deadline = deadline;
+    tasks[id].armed = true;
+}
+
+/**
+ * @brief Arm a task to run after a delay
+ *
+ * @param id Task identifier
+ * @param delay_ms Delay from now in milliseconds
+ */
+void scheduler_wake_in_ms(task_id_t id, uint32_t delay_ms) {
+    scheduler_wake_at(id, make_timeout_time_ms(delay_ms));
+}
+
+/**
+ * @brief Mark a task as having a pending event
+ *
+ * Safe to call from interrupt context. The task runs on the next pass of
+ * the scheduler loop; SEV guarantees the core does not go back to sleep
+ * before serving it.
+ *
+ * @param id Task identifier
+ */
+void __not_in_flash_func(scheduler_notify)(task_id_t id) {
+    if (id >= TASK_COUNT) return;
+
+    tasks[id].pending = true;
+    __sev();
+}
+
+/**
+ * @brief Run a single task and account for its execution time
+ *
+ * @param id Task identifier
+ */
+static void scheduler_run_task(task_id_t id) {
+    PROF_BEGIN();
+#if SCHED_STATS
+    uint64_t start = time_us_64();
+    tasks[id].fn();
+    task_stats[id].busy_us += time_us_64() - start;
+    task_stats[id].run_count++;
+#else
+    tasks[id].fn();
+#endif
+    PROF_END(PROF_TASK_FIRST + id);
+}
+
+/**
+ * @brief Serve every due task once, in identifier order
+ *
+ * The body of `scheduler_run`, also driven by the host replay on its
+ * simulated clock.
+ *
+ * @param next_deadline Earliest armed deadline, at_the_end_of_time if none
+ * @return True if a task was notified while running and is due again
+ */
+bool scheduler_run_pass(absolute_time_t* next_deadline) {
+    absolute_time_t now = get_absolute_time();
+    bool work_pending = false;
+
+    *next_deadline = at_the_end_of_time;
+
+    for (uint8_t id = 0; id < TASK_COUNT; id++) {
+        task_t* task = &tasks[id];
+        if (!task->fn) continue;
+
+        bool due = task->pending ||
+                   (task->armed && absolute_time_diff_us(task->deadline, now) >= 0);
+
+        if (due) {
+            // clear before running so the task can re-arm itself
+            task->pending = false;
+            task->armed = false;
+            scheduler_run_task(id);
+        }
+
+        if (task->pending) {
+            work_pending = true;
+        } else if (task->armed) {
+            *next_deadline = absolute_time_min(*next_deadline, task->deadline);
+        }
+    }
+    return work_pending;
+}
+
+/**
+ * @brief Scheduler main loop
+ *
+ * Serves every due task in identifier order, then sleeps until the
+ * earliest armed deadline or the next interrupt/event.
+ *
+ * @return Never returns
+ */
+void scheduler_run(void) {
+    while (1) {
+        absolute_time_t next_deadline;
+
+        // another pass straight away if a task was notified while running
+        if (scheduler_run_pass(&next_deadline)) continue;
+
+#if SCHED_STATS
+        uint64_t sleep_start = time_us_64();
+        best_effort_wfe_or_timeout(next_deadline);
+        sleep_total_us += time_us_64() - sleep_start;
+        wakeup_count++;
+#else
+        best_effort_wfe_or_timeout(next_deadline);
+#endif
+    }
+}
+
+//--------------------------------------------------------------------+
+
+#if SCHED_STATS
+/**
+ * @brief Get a copy of the statistics of a task
+ *
+ * @param id Task identifier
+ * @param stats Pointer to store the statistics
+ */
+void scheduler_get_stats(task_id_t id, task_stats_t* stats) {
+    if (id >= TASK_COUNT) return;
+
+    *stats = task_stats[id];
+}
+
+/**
+ * @brief Print per-task statistics and re-arm the report
+ *
+ * Registered as TASK_STATS; runs every `SCHED_STATS_REPORT_MS` and prints
+ * run counts, busy time and the fraction of time spent sleeping.
+ */
+void scheduler_report_stats(void) {
+    static const char* const task_names[TASK_COUNT] = {
+        [TASK_USB] = "usb",
+        [TASK_HID] = "hid",
+        [TASK_MOUSE] = "mouse",
+        [TASK_VENDOR] = "vendor",
+        [TASK_LED] = "led",
+        [TASK_POWER] = "power",
+        [TASK_GOVERNOR] = "gov",
+        [TASK_KEYSTATS] = "keystats",
+        [TASK_LEADER] = "leader",
+        [TASK_TAP_DANCE] = "tapdance",
+        [TASK_DRIVE] = "drive",
+        [TASK_REBOOT] = "reboot",
+        [TASK_STATS] = "stats",
+    };
+
+    // name column as wide as the longest name
+    int name_width = 0;
+    for (uint8_t id = 0; id < TASK_COUNT; id++) {
+        int len = (int)strlen(task_names[id]);
+        if (len > name_width) name_width = len;
+    }
+
+    uint64_t uptime_us = time_us_64();
+
+    printf("sched: up %lu ms, slept %lu ms (%lu wakeups)\n",
+           (unsigned long)(uptime_us / 1000), (unsigned long)(sleep_total_us / 1000), (unsigned long)wakeup_count);
+
+    for (uint8_t id = 0; id < TASK_COUNT; id++) {
+        printf("  %-*s runs %8lu  busy %10lu us\n",
+               name_width, task_names[id], (unsigned long)task_stats[id].run_count, (unsigned long)task_stats[id].busy_us);
+    }
+
+    scheduler_wake_in_ms(TASK_STATS, SCHED_STATS_REPORT_MS);
+}
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file scheduler.h
+ * @brief Deadline scheduler declarations
+ *
+ * Task identifiers, task function type and the scheduler API used to
+ * replace the busy polling main loop. Tasks are woken either by a deadline
+ * or by an event notification (safe to call from interrupt context), and
+ * the core sleeps with WFE while nothing is due.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "hardware/sync.h"
+
+    // Build with -DSCHED_STATS=1 (ORIONE_SCHED_STATS in CMake) to collect per-task statistics
+    #ifndef SCHED_STATS
+    #define SCHED_STATS 0
+    #endif
+
+    #define SCHED_STATS_REPORT_MS 5000
+
+    // Task identifiers, in the order they are served on each wakeup
+    typedef enum {
+        TASK_USB = 0,
+        TASK_HID,
+        TASK_MOUSE,
+        TASK_VENDOR,
+        TASK_LED,
+        TASK_POWER,
+        TASK_GOVERNOR,
+        TASK_KEYSTATS,
+        TASK_LEADER,
+        TASK_TAP_DANCE,
+        TASK_DRIVE,
+        TASK_REBOOT,
+    #if SCHED_STATS
+        TASK_STATS,
+    #endif
+        TASK_COUNT
+    } task_id_t;
+
+    typedef void (*task_fn_t)(void);
+
+    // Per-task statistics (only collected when SCHED_STATS is enabled)
+    typedef struct {
+        uint32_t run_count;     // number of times the task ran
+        uint64_t busy_us;       // total time spent inside the task
+    } task_stats_t;
+
+    void scheduler_register(task_id_t id, task_fn_t fn);
+    void scheduler_wake_at(task_id_t id, absolute_time_t deadline);
+    void scheduler_wake_in_ms(task_id_t id, uint32_t delay_ms);
+    void scheduler_notify(task_id_t id);
+    bool scheduler_run_pass(absolute_time_t* next_deadline);
+    void scheduler_run(void);
+
+    #if SCHED_STATS
+    void scheduler_get_stats(task_id_t id, task_stats_t* stats);
+    void scheduler_report_stats(void);
+    #endif
+
+#endif /* SCHEDULER_H */
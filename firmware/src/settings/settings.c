@@ -0,0 +1,356 @@
+/**
+ * @file settings.c
+ * @brief Live settings implementation
+ *
+ * The settings live in the modules that use them (keymap.c, profile.c);
+ * this module converts them to and from the wire record, validates what
+ * the host sends and persists them. Everything runs in the main loop
+ * (vendor commands come through TASK_USB), like the keymap lookups, so
+ * only the profile debounce settings, read by the interrupt handlers,
+ * need masking (see `profile_update`).
+ *
+ * A batch of writes is staged over a copy of the live settings, so a
+ * partial upload never shows: the first write after a commit takes the
+ * copy, and the commit validates the whole record before applying any of
+ * it. A rejected write is remembered and reported by the commit.
+ */
+
+#include <string.h>
+
+#include "settings.h"
+#include "../matrix/scan_rows/scan_rows.h"
+
+//--------------------------------------------------------------------+
+
+// Record saved in flash
+typedef struct {
+    uint32_t keymap_hash;           // KEYMAP_SOURCE_HASH the settings apply to
+    uint16_t version;               // SETTINGS_VERSION
+    uint16_t reserved;
+    settings_record_t record;
+} settings_saved_t;
+
+_Static_assert(sizeof(settings_saved_t) <= STORAGE_SLOT_MAX - 16, "settings larger than a storage slot");
+
+// Place of a region in the record
+typedef struct {
+    uint16_t offset;
+    uint16_t size;
+    uint16_t entry_size;            // reported offsets are entry aligned
+} settings_region_def_t;
+
+#define REGION(field, count, type) {offsetof(settings_record_t, field), (count) * sizeof(type), sizeof(type)}
+
+static const settings_region_def_t region_defs[SETTINGS_REGION_COUNT] = {
+    [SETTINGS_REGION_KEYMAP] = REGION(keymap, KEYMAP_PROFILES * KEYMAP_LAYERS * MATRIX_ROWS * MATRIX_COLS, uint16_t),
+    [SETTINGS_REGION_ENCODERS] = REGION(encoders, KEYMAP_PROFILES, keymap_encoder_t),
+    [SETTINGS_REGION_PROFILES] = REGION(profiles, KEYMAP_PROFILES, settings_profile_t),
+    [SETTINGS_REGION_TAP_DANCES] = REGION(tap_dances, KEYMAP_TAP_DANCES, tap_dance_t),
+};
+
+typedef struct {
+    settings_record_t staged;       // pending writes over a copy of the live settings
+    bool staging;                   // `staged` holds a copy
+    settings_result_t write_error;  // first rejected write since the last commit
+    settings_record_t live;         // conversion buffer of reads
+    settings_saved_t saved;         // flash record buffer
+    storage_log_t log;
+    bool loaded;                    // restored from flash at boot
+} settings_state_t;
+
+static settings_state_t settings_state = {0};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Copy the live settings into a record
+ */
+static void capture(settings_record_t* record) {
+    memcpy(record->keymap, keymap_layers_ram(), sizeof(record->keymap));
+    memcpy(record->encoders, keymap_encoders_ram(), sizeof(record->encoders));
+    memcpy(record->tap_dances, keymap_tap_dances_ram(), sizeof(record->tap_dances));
+
+    for (uint8_t i = 0; i < KEYMAP_PROFILES; i++) {
+        const profile_t* profile = profile_get(i);
+
+        record->profiles[i] = (settings_profile_t){
+            .report_mode = (uint8_t)profile->report_mode,
+            .algorithm = (uint8_t)profile->debounce.algorithm,
+            .adaptive = profile->debounce_adaptive,
+            .time_us = profile->debounce.time_us,
+        };
+    }
+}
+
+/**
+ * @brief Make a validated record the live settings
+ */
+static void apply(const settings_record_t* record) {
+    memcpy(keymap_layers_ram(), record->keymap, sizeof(record->keymap));
+    memcpy(keymap_encoders_ram(), record->encoders, sizeof(record->encoders));
+    memcpy(keymap_tap_dances_ram(), record->tap_dances, sizeof(record->tap_dances));
+
+    for (uint8_t i = 0; i < KEYMAP_PROFILES; i++) {
+        const settings_profile_t* wire = &record->profiles[i];
+        profile_t profile = *profile_get(i);
+
+        profile.report_mode = (profile_report_mode_t)wire->report_mode;
+        profile.debounce.algorithm = (debounce_algorithm_t)wire->algorithm;
+        profile.debounce.time_us = wire->time_us;
+        profile.debounce_adaptive = wire->adaptive;
+        profile_update(i, &profile);
+    }
+}
+
+/**
+ * @brief Check a keycode of a keyboard layer
+ */
+static bool valid_key(uint16_t key) {
+    return key <= HID_KEY_GUI_RIGHT || is_consumer_key(key) || is_mouse_key(key) || is_gamepad_key(key)
+        || is_profile_key(key) || is_leader_key(key) || is_tap_dance_key(key) || is_reboot_key(key);
+}
+
+/**
+ * @brief Check an encoder binding
+ *
+ * @param press Button binding, which may also be a tap dance
+ */
+static bool valid_encoder_key(uint16_t key, bool press) {
+    return key == 0 || is_consumer_key(key) || key == KC_MS_WH_UP || key == KC_MS_WH_DOWN
+        || (press && is_tap_dance_key(key));
+}
+
+/**
+ * @brief Check a tap dance gesture action
+ */
+static bool valid_action_key(uint16_t key) {
+    if (is_mouse_key(key)) return key == KC_MS_WH_UP || key == KC_MS_WH_DOWN;
+
+    return valid_key(key) && !is_tap_dance_key(key);
+}
+
+/**
+ * @brief Set the error of an invalid entry
+ *
+ * @return False, for the caller to return
+ */
+static bool invalid(settings_result_t* result, uint8_t region, size_t entry) {
+    result->status = SETTINGS_ERR_VALUE;
+    result->region = region;
+    result->offset = (uint16_t)(entry * region_defs[region].entry_size);
+    return false;
+}
+
+/**
+ * @brief Check every entry of a record
+ *
+ * @param result First invalid entry, if any
+ * @return True if the record can be applied
+ */
+static bool validate(const settings_record_t* record, settings_result_t* result) {
+    const uint16_t* keys = &record->keymap[0][0][0][0];
+
+    for (size_t i = 0; i < region_defs[SETTINGS_REGION_KEYMAP].size / sizeof(uint16_t); i++) {
+        uint8_t row = (i / MATRIX_COLS) % MATRIX_ROWS;
+        uint8_t col = i % MATRIX_COLS;
+
+        // the Fn key never reaches the report
+        bool fn = row == FN_KEY_ROW && col == FN_KEY_COL;
+        if (!valid_key(keys[i]) || (fn && keys[i] != 0)) {
+            return invalid(result, SETTINGS_REGION_KEYMAP, i);
+        }
+    }
+
+    for (uint8_t i = 0; i < KEYMAP_PROFILES; i++) {
+        const keymap_encoder_t* encoder = &record->encoders[i];
+        if (!valid_encoder_key(encoder->cw, false) || !valid_encoder_key(encoder->ccw, false)
+                || !valid_encoder_key(encoder->press, true)) {
+            return invalid(result, SETTINGS_REGION_ENCODERS, i);
+        }
+
+        const settings_profile_t* profile = &record->profiles[i];
+        if (profile->report_mode > PROFILE_REPORT_GAMEPAD || profile->algorithm >= DEBOUNCE_ALGORITHM_COUNT
+                || profile->adaptive > 1 || profile->time_us < SETTINGS_DEBOUNCE_MIN_US
+                || profile->time_us > SETTINGS_DEBOUNCE_MAX_US) {
+            return invalid(result, SETTINGS_REGION_PROFILES, i);
+        }
+    }
+
+    for (uint8_t i = 0; i < KEYMAP_TAP_DANCES; i++) {
+        for (uint8_t gesture = 0; gesture < TAP_DANCE_GESTURES; gesture++) {
+            uint16_t key = record->tap_dances[i].actions[gesture].key;
+            if (key && !valid_action_key(key)) {
+                return invalid(result, SETTINGS_REGION_TAP_DANCES, i);
+            }
+        }
+    }
+
+    result->status = SETTINGS_OK;
+    return true;
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Restore the saved settings
+ *
+ * Call once at boot, after `keymap_init` and `profile_init`. Saved
+ * settings of another keymap source or layout are ignored.
+ */
+void settings_init(void) {
+    settings_state_t* st = &settings_state;
+    settings_result_t result;
+
+    storage_log_init(&st->log, STORAGE_LOG_SETTINGS, sizeof(st->saved));
+    st->loaded = storage_load(&st->log, &st->saved, sizeof(st->saved))
+        && st->saved.keymap_hash == KEYMAP_SOURCE_HASH
+        && st->saved.version == SETTINGS_VERSION
+        && validate(&st->saved.record, &result);
+
+    if (st->loaded) {
+        apply(&st->saved.record);
+    }
+}
+
+/**
+ * @brief Size of a region
+ *
+ * @param region settings_region_t
+ * @return Size in bytes, 0 for an unknown region
+ */
+uint16_t settings_region_size(uint8_t region) {
+    if (region >= SETTINGS_REGION_COUNT) return 0;
+
+    return region_defs[region].size;
+}
+
+/**
+ * @brief Read part of a region of the live settings
+ *
+ * @param region settings_region_t
+ * @param offset Byte offset in the region
+ * @param data Buffer to fill
+ * @param len Bytes wanted
+ * @return Bytes read, fewer at the end of the region
+ */
+uint16_t settings_read(uint8_t region, uint16_t offset, uint8_t* data, uint16_t len) {
+    settings_state_t* st = &settings_state;
+
+    if (region >= SETTINGS_REGION_COUNT || offset >= region_defs[region].size) return 0;
+
+    if (len > region_defs[region].size - offset) {
+        len = region_defs[region].size - offset;
+    }
+
+    capture(&st->live);
+    memcpy(data, (const uint8_t*)&st->live + region_defs[region].offset + offset, len);
+    return len;
+}
+
+/**
+ * @brief Stage part of a region
+ *
+ * Nothing changes until `settings_commit`. A write outside the region is
+ * dropped and fails the commit.
+ *
+ * @param region settings_region_t
+ * @param offset Byte offset in the region
+ * @param data New bytes
+ * @param len Byte count
+ */
+void settings_write(uint8_t region, uint16_t offset, const uint8_t* data, uint16_t len) {
+    settings_state_t* st = &settings_state;
+
+    if (!st->staging) {
+        capture(&st->staged);
+        st->staging = true;
+        st->write_error.status = SETTINGS_OK;
+    }
+
+    if (region >= SETTINGS_REGION_COUNT || (uint32_t)offset + len > region_defs[region].size) {
+        if (st->write_error.status == SETTINGS_OK) {
+            st->write_error = (settings_result_t){.status = SETTINGS_ERR_REGION, .region = region, .offset = offset};
+        }
+        return;
+    }
+
+    memcpy((uint8_t*)&st->staged + region_defs[region].offset + offset, data, len);
+}
+
+/**
+ * @brief Apply the staged writes
+ *
+ * All or nothing: a rejected write or an invalid entry anywhere leaves
+ * the live settings unchanged. The staged writes are dropped either way.
+ *
+ * @return Status, with the region and offset of the first error
+ */
+settings_result_t settings_commit(void) {
+    settings_state_t* st = &settings_state;
+    settings_result_t result = {.status = SETTINGS_OK};
+
+    if (!st->staging) return result;
+    st->staging = false;
+
+    if (st->write_error.status != SETTINGS_OK) return st->write_error;
+    if (validate(&st->staged, &result)) {
+        apply(&st->staged);
+    }
+    return result;
+}
+
+/**
+ * @brief Check whether a batch of writes waits for its commit
+ *
+ * The staging copy is shared: a writer that does not own the batch must
+ * wait rather than stage into it or commit it.
+ */
+bool settings_staging(void) {
+    return settings_state.staging;
+}
+
+/**
+ * @brief Save the live settings to flash
+ *
+ * The flash write masks interrupts for up to about 50 ms (see storage.c).
+ *
+ * @return SETTINGS_OK, or SETTINGS_ERR_FLASH
+ */
+settings_result_t settings_save(void) {
+    settings_state_t* st = &settings_state;
+    settings_result_t result = {.status = SETTINGS_OK};
+
+    st->saved.keymap_hash = KEYMAP_SOURCE_HASH;
+    st->saved.version = SETTINGS_VERSION;
+    st->saved.reserved = 0;
+    capture(&st->saved.record);
+
+    if (!storage_save(&st->log, &st->saved, sizeof(st->saved))) {
+        result.status = SETTINGS_ERR_FLASH;
+    }
+    return result;
+}
+
+/**
+ * @brief Restore the compiled keymap and profile settings
+ *
+ * Live settings only: the saved ones come back at the next boot unless
+ * the defaults are saved over them. Pending writes are dropped.
+ */
+void settings_defaults(void) {
+    settings_state.staging = false;
+
+    keymap_init();
+    profile_defaults();
+}
+
+/**
+ * @brief Check whether saved settings were restored at boot
+ */
+bool settings_loaded(void) {
+    return settings_state.loaded;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file settings.h
+ * @brief Live settings declarations
+ *
+ * The settings the host can change over the vendor interface without a
+ * rebuild: the layers and encoder bindings of every profile, the profile
+ * debounce and report settings, and the tap dances. They are exchanged
+ * as regions of one record (settings_record_t), little endian, laid out
+ * the same on the device and the host tools. Writes go to a staging copy
+ * and take effect together on commit; a save stores them in flash, where
+ * they are restored at boot while the firmware keeps the same keymap
+ * source (KEYMAP_SOURCE_HASH).
+ *
+ * The gamepad layer and the leader sequences stay as compiled.
+ */
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../matrix/keymap/keymap.h"
+    #include "../profile/profile.h"
+    #include "../storage/storage.h"
+
+    // Wire layout version, bumped when settings_record_t changes
+    #define SETTINGS_VERSION 1
+
+    // Accepted debounce times
+    #define SETTINGS_DEBOUNCE_MIN_US 500
+    #define SETTINGS_DEBOUNCE_MAX_US 20000
+
+    typedef enum {
+        SETTINGS_REGION_KEYMAP = 0,     // uint16_t [profile][layer][row][col]
+        SETTINGS_REGION_ENCODERS,       // keymap_encoder_t [profile]
+        SETTINGS_REGION_PROFILES,       // settings_profile_t [profile]
+        SETTINGS_REGION_TAP_DANCES,     // tap_dance_t [tap dance]
+        SETTINGS_REGION_COUNT
+    } settings_region_t;
+
+    typedef enum {
+        SETTINGS_OK = 0,
+        SETTINGS_ERR_REGION,            // unknown region, or a write past its end
+        SETTINGS_ERR_VALUE,             // invalid entry, see the offset
+        SETTINGS_ERR_FLASH,             // the flash write failed
+    } settings_status_t;
+
+    // Profile settings on the wire
+    typedef struct __attribute__((packed)) {
+        uint8_t report_mode;            // profile_report_mode_t
+        uint8_t algorithm;              // debounce_algorithm_t
+        uint8_t adaptive;               // learned per-key debounce times
+        uint8_t reserved;
+        uint32_t time_us;               // debounce time
+    } settings_profile_t;
+
+    typedef struct {
+        uint16_t keymap[KEYMAP_PROFILES][KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS];
+        keymap_encoder_t encoders[KEYMAP_PROFILES];
+        settings_profile_t profiles[KEYMAP_PROFILES];
+        tap_dance_t tap_dances[KEYMAP_TAP_DANCE_SLOTS];
+    } settings_record_t;
+
+    // Result of a commit, save or restore
+    typedef struct {
+        settings_status_t status;
+        uint8_t region;                 // region of the error
+        uint16_t offset;                // byte offset of the invalid entry in the region
+    } settings_result_t;
+
+    void settings_init(void);
+    uint16_t settings_region_size(uint8_t region);
+    uint16_t settings_read(uint8_t region, uint16_t offset, uint8_t* data, uint16_t len);
+    void settings_write(uint8_t region, uint16_t offset, const uint8_t* data, uint16_t len);
+    settings_result_t settings_commit(void);
+    bool settings_staging(void);
+    settings_result_t settings_save(void);
+    void settings_defaults(void);
+    bool settings_loaded(void);
+
+#endif /* SETTINGS_H */
@@ -0,0 +1,690 @@
+/**
+ * @file settings_text.c
+ * @brief Text form of the live settings implementation
+ *
+ * Keys are written with the names of keymap_key_names, generated from the
+ * same table as the keymap compiler (tools/keymap_gen.py), so the file
+ * reads like config/orione.keymap; a code without a name is written in
+ * hex and read back as such. Names are found by binary search when
+ * parsing (the table is sorted), and by a linear search when rendering,
+ * which runs once per volume refresh.
+ *
+ * The parser fills a copy of the live settings and stops at the first
+ * error. Values it cannot judge, such as a key bound where it is not
+ * allowed, are left to `settings_commit`, whose error is turned back into
+ * profile, layer and key positions.
+ */
+
+#include <string.h>
+
+#include "settings_text.h"
+
+//--------------------------------------------------------------------+
+
+typedef enum {
+    SECTION_NONE = 0,
+    SECTION_PROFILE,
+    SECTION_LAYER,
+    SECTION_TAP_DANCE,
+} section_t;
+
+// Text built in a fixed buffer, always terminated
+typedef struct {
+    char* buf;
+    size_t size;
+    size_t len;
+    bool full;                      // something did not fit
+} text_t;
+
+typedef struct {
+    settings_record_t record;       // live settings with the parsed changes
+    section_t section;
+    uint8_t profile;                // section being parsed
+    uint8_t layer;
+    uint8_t row;
+    uint8_t tap_dance;
+    uint16_t line;                  // lines seen so far
+    bool failed;
+    settings_text_error_t error;    // first error
+    char buf[SETTINGS_TEXT_LINE_MAX];
+} settings_text_state_t;
+
+static settings_text_state_t text_state = {0};
+
+// Tokens of a line: a layer row, plus one to catch extra keys
+#define MAX_TOKENS (MATRIX_COLS + 1)
+
+static const char* const report_names[] = {
+    [PROFILE_REPORT_KEYBOARD] = "keyboard",
+    [PROFILE_REPORT_GAMEPAD] = "gamepad",
+};
+
+static const char* const algorithm_names[DEBOUNCE_ALGORITHM_COUNT] = {
+    [DEBOUNCE_DEFER] = "defer",
+    [DEBOUNCE_EAGER] = "eager",
+    [DEBOUNCE_EAGER_PRESS] = "eager_press",
+};
+
+static const char* const gesture_names[TAP_DANCE_GESTURES] = {
+    [TAP_DANCE_SINGLE] = "single",
+    [TAP_DANCE_DOUBLE] = "double",
+    [TAP_DANCE_TRIPLE] = "triple",
+    [TAP_DANCE_HOLD] = "hold",
+};
+
+static const char header[] =
+    "# Orione settings\n"
+    "#\n"
+    "# Keys as in config/orione.keymap: HID usages without HID_KEY_ (A, 1,\n"
+    "# SHIFT_LEFT, ...), C:<consumer usage>, MS_*, GP_TOGGLE, GP_SOCD,\n"
+    "# PROFILE_NEXT, PROFILE(<name>), LEADER, TD(<name>), BOOTLOADER, REBOOT\n"
+    "# or 0x<code>; \".\" is no key. Tap dance actions take modifiers:\n"
+    "# CONTROL_LEFT+C.\n"
+    "# Debounce: defer, eager or eager_press, 500..20000 us, \"adaptive\"\n"
+    "# for learned per-key times. Sections left out keep their settings.\n"
+    "\n";
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+static void put_char(text_t* t, char c) {
+    if (t->len + 1 >= t->size) {
+        t->full = true;
+        return;
+    }
+    t->buf[t->len++] = c;
+    t->buf[t->len] = '\0';
+}
+
+static void put(text_t* t, const char* s) {
+    while (*s) {
+        put_char(t, *s++);
+    }
+}
+
+static void put_spaces(text_t* t, size_t count) {
+    while (count--) {
+        put_char(t, ' ');
+    }
+}
+
+static void put_uint(text_t* t, uint32_t value) {
+    char digits[10];
+    uint8_t n = 0;
+
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (n) {
+        put_char(t, digits[--n]);
+    }
+}
+
+/**
+ * @brief Name of a keycode
+ *
+ * @param hex Buffer for the hex form of a code without a name
+ */
+static const char* key_text(uint16_t code, char hex[7]) {
+    static const char digits[] = "0123456789ABCDEF";
+
+    if (code == 0) return ".";
+
+    for (uint16_t i = 0; i < KEYMAP_KEY_NAMES; i++) {
+        if (keymap_key_names[i].code == code) return keymap_key_names[i].name;
+    }
+
+    hex[0] = '0';
+    hex[1] = 'x';
+    for (uint8_t i = 0; i < 4; i++) {
+        hex[2 + i] = digits[(code >> (12 - 4 * i)) & 0xF];
+    }
+    hex[6] = '\0';
+    return hex;
+}
+
+static void put_key(text_t* t, uint16_t code) {
+    char hex[7];
+    put(t, key_text(code, hex));
+}
+
+/**
+ * @brief Write a tap dance action, modifiers first
+ */
+static void put_action(text_t* t, const tap_dance_action_t* action) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        if (action->modifier & (1u << bit)) {
+            put_key(t, HID_KEY_CONTROL_LEFT + bit);
+            put_char(t, '+');
+        }
+    }
+    put_key(t, action->key);
+}
+
+/**
+ * @brief Write a layer, columns aligned
+ */
+static void put_layer(text_t* t, const uint16_t keys[MATRIX_ROWS][MATRIX_COLS]) {
+    size_t width[MATRIX_COLS] = {0};
+    char hex[7];
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            size_t len = strlen(key_text(keys[row][col], hex));
+            if (len > width[col]) width[col] = len;
+        }
+    }
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        put(t, "        ");
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            const char* name = key_text(keys[row][col], hex);
+            put(t, name);
+            if (col + 1 < MATRIX_COLS) put_spaces(t, width[col] - strlen(name) + 2);
+        }
+        put_char(t, '\n');
+    }
+}
+
+static void read_live(settings_record_t* record) {
+    settings_read(SETTINGS_REGION_KEYMAP, 0, (uint8_t*)record->keymap, sizeof(record->keymap));
+    settings_read(SETTINGS_REGION_ENCODERS, 0, (uint8_t*)record->encoders, sizeof(record->encoders));
+    settings_read(SETTINGS_REGION_PROFILES, 0, (uint8_t*)record->profiles, sizeof(record->profiles));
+    settings_read(SETTINGS_REGION_TAP_DANCES, 0, (uint8_t*)record->tap_dances, sizeof(record->tap_dances));
+}
+
+/**
+ * @brief Stop parsing with an error on the current line
+ *
+ * @param token Offending word, or NULL
+ */
+static void fail(settings_text_state_t* st, const char* what, const char* token) {
+    text_t t = {st->error.message, sizeof(st->error.message), 0, false};
+
+    st->failed = true;
+    st->error.line = st->line;
+    put(&t, what);
+    if (token) {
+        put(&t, " '");
+        put(&t, token);
+        put_char(&t, '\'');
+    }
+}
+
+static bool parse_uint(const char* s, uint32_t max, uint32_t* value) {
+    uint32_t v = 0;
+    uint32_t base = 10;
+
+    if (s[0] == '0' && s[1] == 'x') {
+        base = 16;
+        s += 2;
+    }
+    if (!*s) return false;
+
+    for (; *s; s++) {
+        uint32_t digit;
+        if (*s >= '0' && *s <= '9') digit = (uint32_t)(*s - '0');
+        else if (base == 16 && *s >= 'A' && *s <= 'F') digit = (uint32_t)(*s - 'A' + 10);
+        else if (base == 16 && *s >= 'a' && *s <= 'f') digit = (uint32_t)(*s - 'a' + 10);
+        else return false;
+
+        v = v * base + digit;
+        if (v > max) return false;
+    }
+
+    *value = v;
+    return true;
+}
+
+/**
+ * @brief Keycode of a name, "." or a hex code
+ */
+static bool parse_key(const char* name, uint16_t* code) {
+    uint32_t value;
+
+    if (strcmp(name, ".") == 0) {
+        *code = 0;
+        return true;
+    }
+    if (name[0] == '0' && name[1] == 'x') {
+        if (!parse_uint(name, 0xFFFF, &value)) return false;
+        *code = (uint16_t)value;
+        return true;
+    }
+
+    uint16_t low = 0;
+    uint16_t high = KEYMAP_KEY_NAMES;
+    while (low < high) {
+        uint16_t mid = (uint16_t)((low + high) / 2);
+        int cmp = strcmp(name, keymap_key_names[mid].name);
+
+        if (cmp == 0) {
+            *code = keymap_key_names[mid].code;
+            return true;
+        }
+        if (cmp < 0) high = mid;
+        else low = (uint16_t)(mid + 1);
+    }
+    return false;
+}
+
+static bool parse_keys(settings_text_state_t* st, char** tokens, uint8_t count, uint16_t* codes) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (!parse_key(tokens[i], &codes[i])) {
+            fail(st, "unknown key", tokens[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Tap dance action, "MOD+...+KEY"
+ */
+static bool parse_action(settings_text_state_t* st, char* token, tap_dance_action_t* action) {
+    char* part = token;
+    uint8_t modifier = 0;
+    uint16_t code;
+
+    for (char* plus = strchr(part, '+'); plus; plus = strchr(part, '+')) {
+        *plus = '\0';
+        if (!parse_key(part, &code) || code < HID_KEY_CONTROL_LEFT || code > HID_KEY_GUI_RIGHT) {
+            fail(st, "not a modifier", part);
+            return false;
+        }
+        modifier |= (uint8_t)(1u << (code - HID_KEY_CONTROL_LEFT));
+        part = plus + 1;
+    }
+
+    if (!parse_key(part, &code)) {
+        fail(st, "unknown key", part);
+        return false;
+    }
+
+    action->key = code;
+    action->modifier = modifier;
+    return true;
+}
+
+/**
+ * @brief Index of a name in a table
+ *
+ * @return Index, or count if the name is not there
+ */
+static uint8_t find_name(const char* const* names, uint8_t count, const char* name) {
+    uint8_t i = 0;
+    while (i < count && strcmp(names[i], name) != 0) {
+        i++;
+    }
+    return i;
+}
+
+static void parse_top(settings_text_state_t* st, char** tokens, uint8_t count) {
+    if (strcmp(tokens[0], "profile") == 0 && count == 2) {
+        uint8_t i = 0;
+        while (i < KEYMAP_PROFILES && strcmp(profile_get(i)->name, tokens[1]) != 0) {
+            i++;
+        }
+        if (i == KEYMAP_PROFILES) {
+            fail(st, "unknown profile", tokens[1]);
+            return;
+        }
+
+        st->profile = i;
+        st->section = SECTION_PROFILE;
+    } else if (strcmp(tokens[0], "tap_dance") == 0 && count == 4) {
+        uint8_t i = find_name(keymap_tap_dance_names, KEYMAP_TAP_DANCES, tokens[1]);
+        uint32_t tap_ms;
+        uint32_t hold_ms;
+
+        if (i == KEYMAP_TAP_DANCES) {
+            fail(st, "unknown tap dance", tokens[1]);
+            return;
+        }
+        if (!parse_uint(tokens[2], UINT16_MAX, &tap_ms) || !parse_uint(tokens[3], UINT16_MAX, &hold_ms)) {
+            fail(st, "bad tap dance times, expected <tap ms> <hold ms>", NULL);
+            return;
+        }
+
+        // the section lists every bound gesture
+        tap_dance_t* dance = &st->record.tap_dances[i];
+        memset(dance->actions, 0, sizeof(dance->actions));
+        dance->tap_ms = (uint16_t)tap_ms;
+        dance->hold_ms = (uint16_t)hold_ms;
+        st->tap_dance = i;
+        st->section = SECTION_TAP_DANCE;
+    } else {
+        fail(st, "expected 'profile <name>' or 'tap_dance <name> <tap ms> <hold ms>', not", tokens[0]);
+    }
+}
+
+static void parse_profile(settings_text_state_t* st, char** tokens, uint8_t count) {
+    settings_profile_t* profile = &st->record.profiles[st->profile];
+    uint32_t value;
+
+    if (strcmp(tokens[0], "end") == 0 && count == 1) {
+        st->section = SECTION_NONE;
+    } else if (strcmp(tokens[0], "report") == 0 && count == 2) {
+        uint8_t mode = find_name(report_names, 2, tokens[1]);
+        if (mode == 2) {
+            fail(st, "unknown report mode", tokens[1]);
+            return;
+        }
+        profile->report_mode = mode;
+    } else if (strcmp(tokens[0], "debounce") == 0 && (count == 3 || count == 4)) {
+        uint8_t algorithm = find_name(algorithm_names, DEBOUNCE_ALGORITHM_COUNT, tokens[1]);
+        if (algorithm == DEBOUNCE_ALGORITHM_COUNT) {
+            fail(st, "unknown debounce algorithm", tokens[1]);
+            return;
+        }
+        if (!parse_uint(tokens[2], UINT32_MAX, &value)) {
+            fail(st, "bad debounce time", tokens[2]);
+            return;
+        }
+        if (count == 4 && strcmp(tokens[3], "adaptive") != 0) {
+            fail(st, "expected 'adaptive', not", tokens[3]);
+            return;
+        }
+        profile->algorithm = algorithm;
+        profile->time_us = value;
+        profile->adaptive = (count == 4);
+    } else if (strcmp(tokens[0], "encoder") == 0 && count == 4) {
+        uint16_t keys[3];
+        if (!parse_keys(st, &tokens[1], 3, keys)) return;
+
+        st->record.encoders[st->profile] = (keymap_encoder_t){.cw = keys[0], .ccw = keys[1], .press = keys[2]};
+    } else if (strcmp(tokens[0], "layer") == 0 && count == 2) {
+        if (!parse_uint(tokens[1], KEYMAP_LAYERS - 1, &value)) {
+            fail(st, "unknown layer", tokens[1]);
+            return;
+        }
+        st->layer = (uint8_t)value;
+        st->row = 0;
+        st->section = SECTION_LAYER;
+    } else {
+        fail(st, "expected report, debounce, encoder, layer or end, not", tokens[0]);
+    }
+}
+
+static void parse_row(settings_text_state_t* st, char** tokens, uint8_t count) {
+    if (count != MATRIX_COLS) {
+        text_t t = {st->error.message, sizeof(st->error.message), 0, false};
+
+        fail(st, "", NULL);
+        put(&t, "row ");
+        put_uint(&t, st->row + 1u);
+        put(&t, " of layer ");
+        put_uint(&t, st->layer);
+        put(&t, " needs ");
+        put_uint(&t, MATRIX_COLS);
+        put(&t, " keys");
+        return;
+    }
+
+    if (!parse_keys(st, tokens, count, st->record.keymap[st->profile][st->layer][st->row])) return;
+
+    if (++st->row == MATRIX_ROWS) {
+        st->section = SECTION_PROFILE;
+    }
+}
+
+static void parse_tap_dance(settings_text_state_t* st, char** tokens, uint8_t count) {
+    if (strcmp(tokens[0], "end") == 0 && count == 1) {
+        st->section = SECTION_NONE;
+        return;
+    }
+
+    uint8_t gesture = find_name(gesture_names, TAP_DANCE_GESTURES, tokens[0]);
+    if (gesture == TAP_DANCE_GESTURES || count != 2) {
+        fail(st, "expected single, double, triple or hold <action>, or end, not", tokens[0]);
+        return;
+    }
+
+    parse_action(st, tokens[1], &st->record.tap_dances[st->tap_dance].actions[gesture]);
+}
+
+/**
+ * @brief Explain an entry `settings_commit` rejected
+ */
+static void describe(const settings_result_t* result, settings_text_error_t* error) {
+    text_t t = {error->message, sizeof(error->message), 0, false};
+
+    error->line = 0;
+    error->message[0] = '\0';
+
+    switch (result->region) {
+        case SETTINGS_REGION_KEYMAP: {
+            uint16_t entry = result->offset / sizeof(uint16_t);
+            uint8_t col = entry % MATRIX_COLS;
+            uint8_t row = (entry / MATRIX_COLS) % MATRIX_ROWS;
+            uint8_t layer = (entry / (MATRIX_COLS * MATRIX_ROWS)) % KEYMAP_LAYERS;
+            uint8_t profile = entry / (MATRIX_COLS * MATRIX_ROWS * KEYMAP_LAYERS);
+
+            put(&t, "profile ");
+            put(&t, profile_get(profile)->name);
+            put(&t, " layer ");
+            put_uint(&t, layer);
+            put(&t, " row ");
+            put_uint(&t, row + 1u);
+            put(&t, " key ");
+            put_uint(&t, col + 1u);
+            put(&t, (row == FN_KEY_ROW && col == FN_KEY_COL) ? ": the Fn key must be ." : ": key not allowed here");
+        }
+        break;
+
+        case SETTINGS_REGION_ENCODERS: {
+            put(&t, "profile ");
+            put(&t, profile_get(result->offset / sizeof(keymap_encoder_t))->name);
+            put(&t, ": encoder turns take C:* or MS_WH_UP/DOWN, the press also TD(*)");
+        }
+        break;
+
+        case SETTINGS_REGION_PROFILES: {
+            put(&t, "profile ");
+            put(&t, profile_get(result->offset / sizeof(settings_profile_t))->name);
+            put(&t, ": debounce time must be ");
+            put_uint(&t, SETTINGS_DEBOUNCE_MIN_US);
+            put(&t, "..");
+            put_uint(&t, SETTINGS_DEBOUNCE_MAX_US);
+            put(&t, " us");
+        }
+        break;
+
+        case SETTINGS_REGION_TAP_DANCES: {
+            put(&t, "tap_dance ");
+            put(&t, keymap_tap_dance_names[result->offset / sizeof(tap_dance_t)]);
+            put(&t, ": action not allowed in a tap dance");
+        }
+        break;
+
+        default: {
+            put(&t, "settings rejected");
+        }
+        break;
+    }
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Write the live settings as text
+ *
+ * @param out Buffer, terminated on return
+ * @param size Buffer size
+ * @return Text length, 0 if it does not fit
+ */
+size_t settings_text_render(char* out, size_t size) {
+    settings_record_t* record = &text_state.record;
+    text_t t = {out, size, 0, false};
+
+    read_live(record);
+    put(&t, header);
+
+    for (uint8_t p = 0; p < KEYMAP_PROFILES; p++) {
+        const settings_profile_t* profile = &record->profiles[p];
+        const keymap_encoder_t* encoder = &record->encoders[p];
+
+        put(&t, "profile ");
+        put(&t, profile_get(p)->name);
+        put(&t, "\n    report ");
+        put(&t, report_names[profile->report_mode]);
+        put(&t, "\n    debounce ");
+        put(&t, algorithm_names[profile->algorithm]);
+        put_char(&t, ' ');
+        put_uint(&t, profile->time_us);
+        if (profile->adaptive) put(&t, " adaptive");
+        put(&t, "\n    encoder ");
+        put_key(&t, encoder->cw);
+        put_char(&t, ' ');
+        put_key(&t, encoder->ccw);
+        put_char(&t, ' ');
+        put_key(&t, encoder->press);
+        put_char(&t, '\n');
+
+        for (uint8_t layer = 0; layer < KEYMAP_LAYERS; layer++) {
+            put(&t, "    layer ");
+            put_uint(&t, layer);
+            put_char(&t, '\n');
+            put_layer(&t, (const uint16_t (*)[MATRIX_COLS])record->keymap[p][layer]);
+        }
+        put(&t, "end\n\n");
+    }
+
+    for (uint8_t i = 0; i < KEYMAP_TAP_DANCES; i++) {
+        const tap_dance_t* dance = &record->tap_dances[i];
+
+        put(&t, "tap_dance ");
+        put(&t, keymap_tap_dance_names[i]);
+        put_char(&t, ' ');
+        put_uint(&t, dance->tap_ms);
+        put_char(&t, ' ');
+        put_uint(&t, dance->hold_ms);
+        put_char(&t, '\n');
+
+        for (uint8_t gesture = 0; gesture < TAP_DANCE_GESTURES; gesture++) {
+            if (!dance->actions[gesture].key) continue;
+
+            put(&t, "    ");
+            put(&t, gesture_names[gesture]);
+            put_char(&t, ' ');
+            put_action(&t, &dance->actions[gesture]);
+            put_char(&t, '\n');
+        }
+        put(&t, "end\n\n");
+    }
+
+    return t.full ? 0 : t.len;
+}
+
+/**
+ * @brief Start parsing a file over the live settings
+ */
+void settings_text_begin(void) {
+    settings_text_state_t* st = &text_state;
+
+    read_live(&st->record);
+    st->section = SECTION_NONE;
+    st->line = 0;
+    st->failed = false;
+    st->error.line = 0;
+    st->error.message[0] = '\0';
+}
+
+/**
+ * @brief Parse the next line
+ *
+ * Lines after an error are ignored.
+ *
+ * @param line Line text, without the line break
+ * @param len Its length
+ */
+void settings_text_line(const char* line, size_t len) {
+    settings_text_state_t* st = &text_state;
+    char* tokens[MAX_TOKENS];
+    uint8_t count = 0;
+
+    if (st->failed) return;
+    st->line++;
+
+    if (len >= sizeof(st->buf)) {
+        fail(st, "line too long", NULL);
+        return;
+    }
+    memcpy(st->buf, line, len);
+    st->buf[len] = '\0';
+
+    char* comment = strchr(st->buf, '#');
+    if (comment) *comment = '\0';
+
+    // split on blanks, in place
+    for (char* p = st->buf; *p;) {
+        while (*p == ' ' || *p == '\t' || *p == '\r') {
+            *p++ = '\0';
+        }
+        if (!*p) break;
+
+        if (count == MAX_TOKENS) {
+            fail(st, "too many words", NULL);
+            return;
+        }
+        tokens[count++] = p;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\r') {
+            p++;
+        }
+    }
+    if (count == 0) return;
+
+    switch (st->section) {
+        case SECTION_NONE: parse_top(st, tokens, count); break;
+        case SECTION_PROFILE: parse_profile(st, tokens, count); break;
+        case SECTION_LAYER: parse_row(st, tokens, count); break;
+        case SECTION_TAP_DANCE: parse_tap_dance(st, tokens, count); break;
+    }
+}
+
+/**
+ * @brief Finish parsing and apply the file
+ *
+ * Nothing changes unless the whole file is valid. A file ending while a
+ * vendor batch is staged is rejected, so neither applies half of the other.
+ *
+ * @param error Filled when the file is rejected
+ * @return True if the settings were applied
+ */
+bool settings_text_end(settings_text_error_t* error) {
+    settings_text_state_t* st = &text_state;
+    settings_record_t* record = &st->record;
+
+    if (!st->failed && st->section != SECTION_NONE) {
+        fail(st, "missing end", NULL);
+    }
+    if (st->failed) {
+        *error = st->error;
+        return false;
+    }
+    if (settings_staging()) {
+        text_t t = {error->message, sizeof(error->message), 0, false};
+
+        error->line = 0;
+        error->message[0] = '\0';
+        put(&t, "settings upload over USB in progress, save the file again");
+        return false;
+    }
+
+    settings_write(SETTINGS_REGION_KEYMAP, 0, (const uint8_t*)record->keymap, sizeof(record->keymap));
+    settings_write(SETTINGS_REGION_ENCODERS, 0, (const uint8_t*)record->encoders, sizeof(record->encoders));
+    settings_write(SETTINGS_REGION_PROFILES, 0, (const uint8_t*)record->profiles, sizeof(record->profiles));
+    settings_write(SETTINGS_REGION_TAP_DANCES, 0, (const uint8_t*)record->tap_dances, sizeof(record->tap_dances));
+
+    settings_result_t result = settings_commit();
+    if (result.status != SETTINGS_OK) {
+        describe(&result, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file settings_text.h
+ * @brief Text form of the live settings declarations
+ *
+ * The live settings (settings.h) as a file a person can edit: the layers,
+ * encoder bindings, report mode and debounce settings of every profile and
+ * the tap dances, with the key names of config/orione.keymap. Rendering
+ * writes the whole file; parsing takes it one line at a time, so the
+ * caller can feed it from scattered storage, and applies it through
+ * `settings_write` and `settings_commit`, all or nothing, unless a vendor
+ * batch is staged. Sections the file leaves out keep their live values.
+ *
+ *   profile <name>
+ *       report keyboard|gamepad
+ *       debounce defer|eager|eager_press <us> [adaptive]
+ *       encoder <cw> <ccw> <press>
+ *       layer <n>
+ *           <MATRIX_ROWS lines of MATRIX_COLS keys>
+ *   end
+ *
+ *   tap_dance <name> <tap ms> <hold ms>
+ *       single|double|triple|hold <action>
+ *   end
+ */
+
+#ifndef SETTINGS_TEXT_H
+#define SETTINGS_TEXT_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    #include "../settings.h"
+
+    // Longest line taken, longer ones are an error
+    #define SETTINGS_TEXT_LINE_MAX 256
+
+    #define SETTINGS_TEXT_ERROR_LEN 96
+
+    typedef struct {
+        uint16_t line;                  // line of the error, 0 for an invalid value found on commit
+        char message[SETTINGS_TEXT_ERROR_LEN];
+    } settings_text_error_t;
+
+    size_t settings_text_render(char* out, size_t size);
+    void settings_text_begin(void);
+    void settings_text_line(const char* line, size_t len);
+    bool settings_text_end(settings_text_error_t* error);
+
+#endif /* SETTINGS_TEXT_H */
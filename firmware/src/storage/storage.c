@@ -0,0 +1,223 @@
+/**
+ * @file storage.c
+ * @brief Persistent flash storage implementation
+ *
+ * Slot layout: a 16 byte header (magic, sequence number, record size,
+ * CRC-32 of the record) followed by the record, padded with 0xFF to the
+ * slot size. Slots never straddle a sector. Reads go through XIP; erases
+ * and programs run through `flash_safe_execute`, with interrupts disabled
+ * for their duration (about 45 ms for a sector erase, 1 ms per page), so
+ * the callers only save when no key is held.
+ */
+
+#include <string.h>
+
+#include "storage.h"
+#include "pico/flash.h"
+
+//--------------------------------------------------------------------+
+
+#define STORAGE_MAGIC 0x4F524931u   // "ORI1"
+
+// The firmware build keeps this much flash clear of the image
+#ifdef STORAGE_RESERVED_SIZE
+_Static_assert(STORAGE_SIZE <= STORAGE_RESERVED_SIZE, "storage logs larger than ORIONE_STORAGE_SIZE");
+#endif
+
+// Wait for the other core to park before touching the flash (single core: unused)
+#define STORAGE_FLASH_TIMEOUT_MS 100
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t size;
+    uint16_t reserved;
+    uint32_t crc;
+} storage_header_t;
+
+// Flash operation run with the flash out of XIP
+typedef struct {
+    uint32_t offset;
+    bool erase;
+    const uint8_t* data;
+    size_t size;
+} storage_op_t;
+
+static uint8_t slot_buffer[STORAGE_SLOT_MAX];
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief CRC-32 (IEEE, reflected) of a buffer
+ */
+static uint32_t crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Slots in one sector of a log
+ */
+static inline uint16_t slots_per_sector(const storage_log_t* log) {
+    return FLASH_SECTOR_SIZE / log->slot_size;
+}
+
+/**
+ * @brief Flash offset of a slot
+ */
+static uint32_t slot_offset(const storage_log_t* log, uint16_t slot) {
+    uint32_t base = PICO_FLASH_SIZE_BYTES - (log->id + 1) * STORAGE_LOG_SECTORS * FLASH_SECTOR_SIZE;
+    uint16_t per_sector = slots_per_sector(log);
+
+    return base + (slot / per_sector) * FLASH_SECTOR_SIZE + (slot % per_sector) * log->slot_size;
+}
+
+/**
+ * @brief Memory-mapped contents of a slot
+ */
+static inline const uint8_t* slot_data(const storage_log_t* log, uint16_t slot) {
+    return (const uint8_t*)(XIP_BASE + slot_offset(log, slot));
+}
+
+/**
+ * @brief Check whether a slot is still erased
+ */
+static bool slot_blank(const storage_log_t* log, uint16_t slot) {
+    const uint8_t* data = slot_data(log, slot);
+
+    for (uint16_t i = 0; i < log->slot_size; i++) {
+        if (data[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Erase or program, called by `flash_safe_execute`
+ */
+static void __not_in_flash_func(storage_flash_op)(void* param) {
+    const storage_op_t* op = param;
+
+    if (op->erase) {
+        flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+    } else {
+        flash_range_program(op->offset, op->data, op->size);
+    }
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Set up a log for records of a given size
+ *
+ * @param log Log state
+ * @param id Log
+ * @param record_size Size of the records, at most STORAGE_SLOT_MAX minus the header
+ */
+void storage_log_init(storage_log_t* log, storage_log_id_t id, size_t record_size) {
+    size_t slot_size = sizeof(storage_header_t) + record_size;
+
+    log->id = id;
+    log->slot_size = (slot_size + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE;
+    log->slot = 0;
+    log->seq = 0;
+}
+
+/**
+ * @brief Load the newest valid record of a log
+ *
+ * Also positions the log so the next save follows that record.
+ *
+ * @param log Log state
+ * @param record Buffer for the record
+ * @param size Record size, records of another size are ignored
+ * @return False if the log holds no valid record
+ */
+bool storage_load(storage_log_t* log, void* record, size_t size) {
+    uint16_t slot_count = slots_per_sector(log) * STORAGE_LOG_SECTORS;
+    const uint8_t* newest = NULL;
+
+    for (uint16_t slot = 0; slot < slot_count; slot++) {
+        const uint8_t* data = slot_data(log, slot);
+        storage_header_t header;
+        memcpy(&header, data, sizeof(header));
+
+        if (header.magic != STORAGE_MAGIC || header.size != size) continue;
+        if (newest && header.seq <= log->seq) continue;
+        if (crc32(data + sizeof(header), size) != header.crc) continue;
+
+        newest = data;
+        log->slot = slot;
+        log->seq = header.seq;
+    }
+
+    if (!newest) return false;
+
+    memcpy(record, newest + sizeof(storage_header_t), size);
+    return true;
+}
+
+/**
+ * @brief Append a record to a log
+ *
+ * Writes the slot after the current record, erasing its sector first
+ * when it starts one. A slot left half written by a reset is skipped.
+ * Interrupts are disabled while the flash is busy.
+ *
+ * @param log Log state
+ * @param record Record
+ * @param size Record size, as given to `storage_log_init`
+ * @return False if the flash could not be written
+ */
+bool storage_save(storage_log_t* log, const void* record, size_t size) {
+    if (log->slot_size > STORAGE_SLOT_MAX) return false;
+
+    uint16_t per_sector = slots_per_sector(log);
+    uint16_t slot_count = per_sector * STORAGE_LOG_SECTORS;
+    uint16_t slot = log->slot;
+
+    // next blank slot, a new sector is erased
+    for (uint16_t tries = 0; tries < slot_count; tries++) {
+        slot = (log->seq == 0 && tries == 0) ? 0 : (slot + 1) % slot_count;
+
+        if (slot % per_sector == 0) {
+            storage_op_t erase = {.offset = slot_offset(log, slot), .erase = true};
+            if (flash_safe_execute(storage_flash_op, &erase, STORAGE_FLASH_TIMEOUT_MS) != PICO_OK) return false;
+            break;
+        }
+        if (slot_blank(log, slot)) break;
+    }
+
+    storage_header_t header = {
+        .magic = STORAGE_MAGIC,
+        .seq = log->seq + 1,
+        .size = size,
+        .reserved = 0xFFFF,
+        .crc = crc32(record, size),
+    };
+
+    memset(slot_buffer, 0xFF, log->slot_size);
+    memcpy(slot_buffer, &header, sizeof(header));
+    memcpy(slot_buffer + sizeof(header), record, size);
+
+    storage_op_t program = {
+        .offset = slot_offset(log, slot),
+        .data = slot_buffer,
+        .size = log->slot_size,
+    };
+    if (flash_safe_execute(storage_flash_op, &program, STORAGE_FLASH_TIMEOUT_MS) != PICO_OK) return false;
+
+    log->slot = slot;
+    log->seq = header.seq;
+    return true;
+}
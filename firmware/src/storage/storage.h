@@ -0,0 +1,48 @@
+/**
+ * @file storage.h
+ * @brief Persistent flash storage declarations
+ *
+ * Append-only record logs in the last sectors of the flash, past the
+ * program image. A log spans two sectors of fixed-size slots; every save
+ * writes the next slot, so a sector is erased once per
+ * `FLASH_SECTOR_SIZE / slot size` saves, and the newest valid slot is the
+ * current record. A save interrupted by a reset leaves a slot that fails
+ * its checksum and the previous record is loaded instead.
+ */
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    #include "pico/stdlib.h"
+    #include "hardware/flash.h"
+
+    #define STORAGE_LOG_SECTORS 2
+    #define STORAGE_SLOT_MAX 1024       // largest slot, header included
+
+    // Logs, numbered from the end of the flash
+    typedef enum {
+        STORAGE_LOG_KEYSTATS = 0,
+        STORAGE_LOG_SETTINGS,
+        STORAGE_LOG_COUNT
+    } storage_log_id_t;
+
+    // Flash taken by the logs: the build checks the image ends before it
+    // (ORIONE_STORAGE_SIZE in CMakeLists.txt, tools/ram_report.py)
+    #define STORAGE_SIZE (STORAGE_LOG_COUNT * STORAGE_LOG_SECTORS * FLASH_SECTOR_SIZE)
+
+    typedef struct {
+        storage_log_id_t id;
+        uint16_t slot_size;         // header included, multiple of FLASH_PAGE_SIZE
+        uint16_t slot;              // last slot written or loaded, within both sectors
+        uint32_t seq;               // its sequence number, 0 = none yet
+    } storage_log_t;
+
+    void storage_log_init(storage_log_t* log, storage_log_id_t id, size_t record_size);
+    bool storage_load(storage_log_t* log, void* record, size_t size);
+    bool storage_save(storage_log_t* log, const void* record, size_t size);
+
+#endif /* STORAGE_H */
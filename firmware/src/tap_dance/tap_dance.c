@@ -0,0 +1,276 @@
+/**
+ * @file tap_dance.c
+ * @brief Tap dance implementation
+ *
+ * One state machine, driven by the presses and releases of the tap dance
+ * keys and by TASK_TAP_DANCE on the scheduler for the windows; nothing
+ * waits or blocks. Presses and releases come from the keyboard report
+ * update and the encoder button handling in TASK_HID, so all of it runs in
+ * the main loop.
+ *
+ *   IDLE --press--> PRESSED --release--> RELEASED --press--> PRESSED ...
+ *                      |                    |
+ *                 hold window          tap window
+ *                      v                    v
+ *                 hold action,         action of the press count,
+ *                 HELD until release   IDLE
+ *
+ * A gesture resolves as soon as nothing else can follow: on the press
+ * that reaches the highest bound count, without waiting for the window,
+ * so a tap dance with only a single press action acts on press. Any other
+ * key pressed meanwhile resolves the pending gesture first, so keys are
+ * never held back and the action comes before the key that interrupted
+ * it. The tap dances share one state: a second tap dance key interrupts
+ * the first. An action that cannot go out yet (the previous tap is still
+ * in the report) is queued, and later ones queue behind it, so gestures
+ * resolved in quick succession all run, in order.
+ */
+
+#include "tap_dance.h"
+#include "../usb/hid_report/hid_report.h"
+#include "../matrix/scan_rows/scan_rows.h"
+
+//--------------------------------------------------------------------+
+
+typedef enum {
+    TAP_DANCE_IDLE = 0,
+    TAP_DANCE_PRESSED,          // pressed, waiting for release or the hold window
+    TAP_DANCE_RELEASED,         // released, waiting for the next press or the tap window
+    TAP_DANCE_HELD              // resolved while pressed, waiting for release
+} tap_dance_phase_t;
+
+typedef struct {
+    tap_dance_phase_t phase;
+    uint8_t index;              // tap dance in progress
+    uint8_t taps;               // presses so far
+    bool timed;                 // deadline armed
+    absolute_time_t deadline;   // end of the current window
+    uint8_t queue_head;
+    uint8_t queue_count;        // actions waiting for the previous tap to go out
+    tap_dance_action_t queue[TAP_DANCE_QUEUE_LEN];
+} tap_dance_state_t;
+
+static tap_dance_state_t tap_dance_state = {0};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Highest press count with an action
+ */
+static uint8_t max_taps(const tap_dance_t* dance) {
+    for (uint8_t taps = TAP_DANCE_TRIPLE + 1; taps > 0; taps--) {
+        if (dance->actions[taps - 1].key) return taps;
+    }
+    return 0;
+}
+
+/**
+ * @brief Run an action now, or keep it until the previous tap is out
+ *
+ * @return False if the action must wait
+ */
+static bool run_action(tap_dance_action_t action) {
+    uint16_t key = action.key;
+
+    if (is_consumer_key(key)) {
+        if (!hid_report_tap_idle()) return false;
+        hid_report_consumer_tap(KC_CONSUMER_USAGE(key));
+    } else if (key == KC_MS_WH_UP || key == KC_MS_WH_DOWN) {
+        mousekey_wheel(key == KC_MS_WH_UP ? 1 : -1);
+    } else if (is_profile_key(key)) {
+        profile_action(key);
+    } else if (is_gamepad_key(key)) {
+        gamepad_action(key);
+    } else if (is_leader_key(key)) {
+        leader_start();
+    } else if (is_reboot_key(key)) {
+        reboot_action(key);
+    } else {
+        if (!hid_report_keyboard_tap_idle()) return false;
+        hid_report_keyboard_tap(action.modifier, (uint8_t)key);
+    }
+
+    scheduler_notify(TASK_HID);
+    return true;
+}
+
+/**
+ * @brief Run the queued actions in order, as far as they can go out
+ *
+ * @return True once the queue is empty
+ */
+static bool run_queue(void) {
+    tap_dance_state_t* td = &tap_dance_state;
+
+    while (td->queue_count) {
+        if (!run_action(td->queue[td->queue_head])) return false;
+
+        td->queue_head = (td->queue_head + 1) % TAP_DANCE_QUEUE_LEN;
+        td->queue_count--;
+    }
+    return true;
+}
+
+/**
+ * @brief Run the action of a gesture of the tap dance in progress
+ *
+ * Runs at once unless earlier actions are still queued or the previous tap
+ * is still out; it is queued behind them otherwise. A full queue, which
+ * takes gestures faster than one per report, drops the new action.
+ */
+static void resolve(tap_dance_gesture_t gesture) {
+    tap_dance_state_t* td = &tap_dance_state;
+    tap_dance_action_t action = keymap_tap_dance(td->index)->actions[gesture];
+
+    td->timed = false;
+    if (!action.key) return;
+
+    if (!td->queue_count && run_action(action)) return;
+    if (td->queue_count == TAP_DANCE_QUEUE_LEN) return;
+
+    td->queue[(td->queue_head + td->queue_count) % TAP_DANCE_QUEUE_LEN] = action;
+    td->queue_count++;
+    scheduler_wake_in_ms(TASK_TAP_DANCE, TAP_DANCE_RETRY_MS);
+}
+
+/**
+ * @brief Arm a window of the tap dance in progress
+ */
+static void arm(uint16_t window_ms, uint16_t default_ms) {
+    tap_dance_state_t* td = &tap_dance_state;
+
+    td->timed = true;
+    td->deadline = make_timeout_time_ms(window_ms ? window_ms : default_ms);
+
+    // waiting actions keep their retry, the task re-arms the window after them
+    if (!td->queue_count) {
+        scheduler_wake_at(TASK_TAP_DANCE, td->deadline);
+    }
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Check whether a keycode is a tap dance
+ *
+ * @param key Keycode from the keymap
+ * @return True for KC_TAP_DANCE codes
+ */
+bool __not_in_flash_func(is_tap_dance_key)(uint16_t key) {
+    return key >= KC_TAP_DANCE_0 && key <= KC_TAP_DANCE_LAST;
+}
+
+/**
+ * @brief Press of a tap dance key
+ *
+ * @param key KC_TAP_DANCE code
+ */
+void tap_dance_press(uint16_t key) {
+    tap_dance_state_t* td = &tap_dance_state;
+    uint8_t index = KC_TAP_DANCE_INDEX(key);
+
+    if (td->phase != TAP_DANCE_IDLE && td->index != index) {
+        tap_dance_interrupt();
+    }
+    if (td->phase == TAP_DANCE_IDLE || td->phase == TAP_DANCE_HELD) {
+        td->taps = 0;
+    }
+
+    const tap_dance_t* dance = keymap_tap_dance(index);
+    bool hold = dance->actions[TAP_DANCE_HOLD].key != 0;
+
+    td->index = index;
+    td->taps++;
+    td->phase = TAP_DANCE_PRESSED;
+
+    if (td->taps == 1 && hold) {
+        arm(dance->hold_ms, TAP_DANCE_HOLD_MS);
+    } else if (td->taps >= max_taps(dance)) {
+        // no longer gesture: no need to wait
+        resolve((tap_dance_gesture_t)(td->taps - 1));
+        td->phase = TAP_DANCE_HELD;
+    } else {
+        td->timed = false;
+    }
+}
+
+/**
+ * @brief Release of a tap dance key
+ *
+ * @param key KC_TAP_DANCE code
+ */
+void tap_dance_release(uint16_t key) {
+    tap_dance_state_t* td = &tap_dance_state;
+
+    if (td->index != KC_TAP_DANCE_INDEX(key)) return;
+
+    if (td->phase == TAP_DANCE_HELD) {
+        td->phase = TAP_DANCE_IDLE;
+    } else if (td->phase == TAP_DANCE_PRESSED) {
+        const tap_dance_t* dance = keymap_tap_dance(td->index);
+
+        if (td->taps >= max_taps(dance)) {
+            // released before the hold window, no longer gesture
+            resolve((tap_dance_gesture_t)(td->taps - 1));
+            td->phase = TAP_DANCE_IDLE;
+        } else {
+            td->phase = TAP_DANCE_RELEASED;
+            arm(dance->tap_ms, TAP_DANCE_TAP_MS);
+        }
+    }
+}
+
+/**
+ * @brief Resolve the pending gesture now
+ *
+ * Called before another key is applied to the report. A first press still
+ * held with a hold action becomes a hold, otherwise the presses so far
+ * count as they are.
+ */
+void tap_dance_interrupt(void) {
+    tap_dance_state_t* td = &tap_dance_state;
+
+    if (td->phase == TAP_DANCE_PRESSED) {
+        bool hold = td->taps == 1 && keymap_tap_dance(td->index)->actions[TAP_DANCE_HOLD].key;
+        resolve(hold ? TAP_DANCE_HOLD : (tap_dance_gesture_t)(td->taps - 1));
+        td->phase = TAP_DANCE_HELD;
+    } else if (td->phase == TAP_DANCE_RELEASED) {
+        resolve((tap_dance_gesture_t)(td->taps - 1));
+        td->phase = TAP_DANCE_IDLE;
+    }
+}
+
+/**
+ * @brief Close the windows and run delayed actions
+ *
+ * Runs as TASK_TAP_DANCE: armed with the end of the current window, and
+ * every TAP_DANCE_RETRY_MS while actions wait for the previous tap.
+ */
+void tap_dance_task(void) {
+    tap_dance_state_t* td = &tap_dance_state;
+
+    if (!run_queue()) {
+        scheduler_wake_in_ms(TASK_TAP_DANCE, TAP_DANCE_RETRY_MS);
+        return;
+    }
+
+    if (!td->timed) return;
+
+    // run early by a notification: wait for the rest of the window
+    if (!time_reached(td->deadline)) {
+        scheduler_wake_at(TASK_TAP_DANCE, td->deadline);
+        return;
+    }
+
+    if (td->phase == TAP_DANCE_PRESSED) {
+        resolve(TAP_DANCE_HOLD);
+        td->phase = TAP_DANCE_HELD;
+    } else if (td->phase == TAP_DANCE_RELEASED) {
+        resolve((tap_dance_gesture_t)(td->taps - 1));
+        td->phase = TAP_DANCE_IDLE;
+    }
+}
@@ -0,0 +1,45 @@
+/**
+ * @file tap_dance.h
+ * @brief Tap dance declarations
+ *
+ * A tap dance key (KC_TAP_DANCE, on a keyboard layer or the encoder
+ * button) runs a different action for a single, double or triple press
+ * and for a long press, as bound in the `tap_dance` blocks of
+ * config/orione.keymap.
+ */
+
+#ifndef TAP_DANCE_H
+#define TAP_DANCE_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../matrix/keymap/keymap.h"
+    #include "../scheduler/scheduler.h"
+
+    // Default windows, for tap dances that do not set their own: the
+    // next press must come within TAP_DANCE_TAP_MS of a release, a first
+    // press held for TAP_DANCE_HOLD_MS is a long press
+    #ifndef TAP_DANCE_TAP_MS
+    #define TAP_DANCE_TAP_MS 200
+    #endif
+
+    #ifndef TAP_DANCE_HOLD_MS
+    #define TAP_DANCE_HOLD_MS 300
+    #endif
+
+    // Poll period while an action waits for the previous tap to go out
+    #define TAP_DANCE_RETRY_MS 1
+
+    // Actions waiting for the previous tap, run in order
+    #define TAP_DANCE_QUEUE_LEN 4
+
+    bool is_tap_dance_key(uint16_t key);
+    void tap_dance_press(uint16_t key);
+    void tap_dance_release(uint16_t key);
+    void tap_dance_interrupt(void);
+    void tap_dance_task(void);
+
+#endif /* TAP_DANCE_H */
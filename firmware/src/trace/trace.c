@@ -0,0 +1,165 @@
+/**
+ * @file trace.c
+ * @brief On-device event trace implementation
+ *
+ * Records are written into a fixed ring indexed by a free-running sequence
+ * number (`head`), so the ring never needs to be cleared and a reader can
+ * tell from the distance to `head` how many records it lost. Writers are
+ * IRQ handlers and the main loop; the Cortex-M0+ has no exclusive
+ * load/store, so a push claims its slot and fills it with interrupts
+ * masked for a handful of instructions instead of using an atomic
+ * increment. Nothing waits and nothing allocates.
+ *
+ * Readers own a `trace_cursor_t`: the ring is overwritten when full, and
+ * a reader that fell behind skips to the oldest record still present and
+ * counts the ones it missed.
+ */
+
+#include "trace.h"
+
+//--------------------------------------------------------------------+
+
+#if TRACE_ENABLED
+
+static trace_record_t ring[TRACE_RING_RECORDS];
+static volatile uint32_t head = 0;          // sequence number of the next record written
+static volatile bool listener = false;      // wake the vendor task on every record
+
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Append a record to the trace ring
+ *
+ * Safe from interrupt context. Use through `TRACE()`, which compiles out
+ * when tracing is disabled.
+ *
+ * @param type Event type (trace_type_t)
+ * @param arg8 First argument
+ * @param arg16 Second argument
+ */
+void __not_in_flash_func(trace_record)(uint8_t type, uint8_t arg8, uint16_t arg16) {
+    // timestamp taken inside the critical section keeps the ring in time order
+    uint32_t status = save_and_disable_interrupts();
+    trace_record_t* record = &ring[head & (TRACE_RING_RECORDS - 1)];
+    record->time_us = time_us_32();
+    record->type = type;
+    record->arg8 = arg8;
+    record->arg16 = arg16;
+    head++;
+    restore_interrupts(status);
+
+    if (listener) {
+        scheduler_notify(TASK_VENDOR);
+    }
+}
+
+/**
+ * @brief Position a cursor on the oldest record still in the ring
+ *
+ * @param cursor Reader cursor
+ */
+void trace_cursor_oldest(trace_cursor_t* cursor) {
+    uint32_t now = head;
+
+    cursor->next = (now > TRACE_RING_RECORDS) ? now - TRACE_RING_RECORDS : 0;
+    cursor->dropped = 0;
+}
+
+/**
+ * @brief Position a cursor after the newest record
+ *
+ * @param cursor Reader cursor
+ */
+void trace_cursor_now(trace_cursor_t* cursor) {
+    cursor->next = head;
+    cursor->dropped = 0;
+}
+
+/**
+ * @brief Copy records from the ring
+ *
+ * Records overwritten since the previous read are skipped and added to
+ * `cursor->dropped`. The copy is made with interrupts masked so no record
+ * is torn by a concurrent push; keep `max` small.
+ *
+ * @param cursor Reader cursor
+ * @param records Destination
+ * @param max Maximum number of records to copy
+ * @return Number of records copied
+ */
+uint32_t trace_read(trace_cursor_t* cursor, trace_record_t* records, uint32_t max) {
+    uint32_t status = save_and_disable_interrupts();
+
+    uint32_t now = head;
+    if (now - cursor->next > TRACE_RING_RECORDS) {
+        cursor->dropped += now - cursor->next - TRACE_RING_RECORDS;
+        cursor->next = now - TRACE_RING_RECORDS;
+    }
+
+    uint32_t count = now - cursor->next;
+    if (count > max) count = max;
+
+    for (uint32_t i = 0; i < count; i++) {
+        records[i] = ring[(cursor->next + i) & (TRACE_RING_RECORDS - 1)];
+    }
+    cursor->next += count;
+
+    restore_interrupts(status);
+    return count;
+}
+
+/**
+ * @brief Check whether a cursor has records left to read
+ *
+ * @param cursor Reader cursor
+ * @return True if at least one record is newer than the cursor
+ */
+bool trace_available(const trace_cursor_t* cursor) {
+    return head != cursor->next;
+}
+
+/**
+ * @brief Enable or disable the vendor task wakeup on new records
+ *
+ * @param enabled True while a host is streaming the trace
+ */
+void trace_set_listener(bool enabled) {
+    listener = enabled;
+}
+
+#else
+
+// Tracing compiled out: the stream interface stays, with an empty ring
+
+void trace_record(uint8_t type, uint8_t arg8, uint16_t arg16) {
+    (void) type;
+    (void) arg8;
+    (void) arg16;
+}
+
+void trace_cursor_oldest(trace_cursor_t* cursor) {
+    cursor->next = 0;
+    cursor->dropped = 0;
+}
+
+void trace_cursor_now(trace_cursor_t* cursor) {
+    trace_cursor_oldest(cursor);
+}
+
+uint32_t trace_read(trace_cursor_t* cursor, trace_record_t* records, uint32_t max) {
+    (void) cursor;
+    (void) records;
+    (void) max;
+    return 0;
+}
+
+bool trace_available(const trace_cursor_t* cursor) {
+    (void) cursor;
+    return false;
+}
+
+void trace_set_listener(bool enabled) {
+    (void) enabled;
+}
+
+#endif
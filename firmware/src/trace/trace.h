@@ -0,0 +1,84 @@
+/**
+ * @file trace.h
+ * @brief On-device event trace declarations
+ *
+ * Compact binary trace of input and USB events: every record is 8 bytes
+ * with a 32-bit microsecond timestamp, an event type and two arguments.
+ * Records go into a RAM ring that is streamed to the host over the vendor
+ * HID interface (see usb/vendor/vendor.c) and decoded by
+ * host/trace_decoder.
+ *
+ * `TRACE()` compiles to nothing when the firmware is built without
+ * ORIONE_TRACE (TRACE_ENABLED=0), like `LOG()`.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "hardware/sync.h"
+
+    #include "../scheduler/scheduler.h"
+
+    #ifndef TRACE_ENABLED
+    #define TRACE_ENABLED 1
+    #endif
+
+    // Ring size in records, power of two (8 bytes each)
+    #ifndef TRACE_RING_RECORDS
+    #define TRACE_RING_RECORDS 1024
+    #endif
+
+    // Event types, arguments in brackets (arg8, arg16)
+    typedef enum {
+        TRACE_NONE = 0,
+        TRACE_GPIO_EDGE,        // raw GPIO interrupt (gpio, events)
+        TRACE_DEBOUNCE,         // debounced level change (column or TRACE_INPUT_ENCODER_BTN, pressed)
+        TRACE_KEY_ADD,          // key added to the tracked state (row, col)
+        TRACE_KEY_REMOVE,       // key removed from the tracked state (row, col)
+        TRACE_LAYER,            // active layer changed (layer, -)
+        TRACE_REPORT,           // HID report queued on the endpoint (report ID, length)
+        TRACE_USB_MOUNT,        // device configured (-, -)
+        TRACE_USB_UNMOUNT,      // device unmounted (-, -)
+        TRACE_USB_SUSPEND,      // bus suspended (remote wakeup allowed, -)
+        TRACE_USB_RESUME,       // bus resumed (-, -)
+        TRACE_SCAN,             // matrix scan mode changed (1 = polled, 0 = column interrupts, -)
+        TRACE_TYPE_COUNT
+    } trace_type_t;
+
+    // TRACE_DEBOUNCE input index of the encoder button (columns are 0..13)
+    #define TRACE_INPUT_ENCODER_BTN 0xFF
+
+    typedef struct __attribute__((packed)) {
+        uint32_t time_us;       // time_us_32() when recorded, wraps every ~71 minutes
+        uint8_t type;           // trace_type_t
+        uint8_t arg8;
+        uint16_t arg16;
+    } trace_record_t;
+
+    _Static_assert(sizeof(trace_record_t) == 8, "trace records are 8 bytes");
+    _Static_assert((TRACE_RING_RECORDS & (TRACE_RING_RECORDS - 1)) == 0, "TRACE_RING_RECORDS must be a power of two");
+
+    // Reader position in the ring
+    typedef struct {
+        uint32_t next;          // sequence number of the next record to read
+        uint32_t dropped;       // records overwritten before they were read
+    } trace_cursor_t;
+
+    #if TRACE_ENABLED
+    #define TRACE(type, arg8, arg16) trace_record((type), (arg8), (arg16))
+    #else
+    #define TRACE(type, arg8, arg16) do { } while (0)
+    #endif
+
+    void trace_record(uint8_t type, uint8_t arg8, uint16_t arg16);
+    void trace_cursor_oldest(trace_cursor_t* cursor);
+    void trace_cursor_now(trace_cursor_t* cursor);
+    uint32_t trace_read(trace_cursor_t* cursor, trace_record_t* records, uint32_t max);
+    bool trace_available(const trace_cursor_t* cursor);
+    void trace_set_listener(bool enabled);
+
+#endif /* TRACE_H */
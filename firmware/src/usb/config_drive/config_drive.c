@@ -0,0 +1,557 @@
+/**
+ * @file config_drive.c
+ * @brief USB configuration drive implementation
+ *
+ * The volume is a plain FAT12 layout: boot sector, one FAT sector, one
+ * root directory sector (16 entries) and one sector per cluster after
+ * that. It is built with KEYMAP.TXT in one run of clusters, but after the
+ * host edited it the file is wherever the host put it, so it is read by
+ * following its FAT chain.
+ *
+ * The MSC callbacks (usb_callbacks.c) only copy sectors and arm TASK_DRIVE
+ * on writes; the task does the rest in phases:
+ *
+ *   build    From mount the medium reads as removed until TASK_DRIVE,
+ *            served after TASK_HID, has rendered the settings: that
+ *            takes milliseconds, which neither the boot nor the first
+ *            keyboard report wait for.
+ *   settle   CONFIG_DRIVE_SETTLE_MS after the last write, KEYMAP.TXT is
+ *            compared with the last applied or built version (hash); an
+ *            unchanged file (the host only touched metadata) ends here.
+ *            A changed one is parsed and applied (settings_text.c), all or
+ *            nothing, and the medium reads as removed from now on.
+ *   save     The applied settings go to flash once no key is held: the
+ *            write masks interrupts for tens of ms (see storage.c), which
+ *            must not swallow key edges. Same policy as keystats.c.
+ *   eject    After CONFIG_DRIVE_EJECT_MS the volume is rebuilt: from the
+ *            live settings on success, or left as the host wrote it plus
+ *            ERRORS.TXT. The medium comes back with a unit attention, so
+ *            the host reads it afresh.
+ */
+
+#include <string.h>
+
+#include "config_drive.h"
+
+//--------------------------------------------------------------------+
+
+#define BOOT_LBA 0
+#define FAT_LBA 1
+#define ROOT_LBA 2
+#define DATA_LBA 3
+
+#define ROOT_ENTRIES (CONFIG_DRIVE_SECTOR_SIZE / sizeof(dir_entry_t))
+#define CLUSTERS (CONFIG_DRIVE_SECTORS - DATA_LBA)
+#define FIRST_CLUSTER 2
+#define CLUSTER_END 0xFFF
+
+#define ATTR_VOLUME_ID 0x08
+#define ATTR_DIRECTORY 0x10
+#define ATTR_LONG_NAME 0x0F
+#define ENTRY_FREE 0xE5
+
+// Timestamp of the files: 2024-01-01 00:00
+#define FAT_DATE (((2024 - 1980) << 9) | (1 << 5) | 1)
+
+_Static_assert((CLUSTERS + FIRST_CLUSTER) * 3 / 2 + 1 < CONFIG_DRIVE_SECTOR_SIZE, "FAT larger than a sector");
+_Static_assert(CLUSTERS < 4085, "too many clusters for FAT12");
+
+typedef struct __attribute__((packed)) {
+    uint8_t jump[3];
+    char oem[8];
+    uint16_t bytes_per_sector;
+    uint8_t sectors_per_cluster;
+    uint16_t reserved_sectors;
+    uint8_t fats;
+    uint16_t root_entries;
+    uint16_t sectors;
+    uint8_t media;
+    uint16_t sectors_per_fat;
+    uint16_t sectors_per_track;
+    uint16_t heads;
+    uint32_t hidden_sectors;
+    uint32_t large_sectors;
+    uint8_t drive;
+    uint8_t reserved;
+    uint8_t signature;              // 0x29: serial, label and type follow
+    uint32_t serial;
+    char label[11];
+    char fs_type[8];
+} boot_sector_t;
+
+typedef struct __attribute__((packed)) {
+    char name[11];                  // 8.3, space padded, no dot
+    uint8_t attr;
+    uint8_t reserved[10];           // case flags, creation and access dates, FAT32 cluster high
+    uint16_t time;
+    uint16_t date;
+    uint16_t cluster;               // first cluster, 0 for an empty file
+    uint32_t size;
+} dir_entry_t;
+
+_Static_assert(sizeof(dir_entry_t) == 32, "directory entry layout");
+
+typedef enum {
+    PHASE_IDLE = 0,
+    PHASE_BUILD,                    // mounted, volume not built yet
+    PHASE_SETTLE,                   // written, waiting for the host to finish
+    PHASE_SAVE,                     // applied, flash save pending
+    PHASE_EJECT,                    // removed, rebuilt when the time is up
+} drive_phase_t;
+
+typedef struct {
+    drive_phase_t phase;
+    config_drive_status_t status;
+    uint32_t hash;                  // KEYMAP.TXT as last built or applied
+    bool applied;                   // rebuild from the live settings
+    bool failed;                    // add ERRORS.TXT on rebuild
+    settings_text_error_t error;
+    char line[SETTINGS_TEXT_LINE_MAX];
+    size_t line_len;
+    bool bom;                       // still at the start of the file
+} drive_state_t;
+
+static drive_state_t drive_state = {0};
+
+static uint8_t disk[CONFIG_DRIVE_SECTORS][CONFIG_DRIVE_SECTOR_SIZE] __attribute__((aligned(4)));
+
+static const char keymap_name[11] = {'K', 'E', 'Y', 'M', 'A', 'P', ' ', ' ', 'T', 'X', 'T'};
+static const char errors_name[11] = {'E', 'R', 'R', 'O', 'R', 'S', ' ', ' ', 'T', 'X', 'T'};
+static const char volume_label[11] = {'O', 'R', 'I', 'O', 'N', 'E', ' ', ' ', ' ', ' ', ' '};
+
+typedef void (*chunk_fn_t)(const uint8_t* data, uint32_t len, void* ctx);
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+static uint8_t* cluster_data(uint16_t cluster) {
+    return disk[DATA_LBA + cluster - FIRST_CLUSTER];
+}
+
+static dir_entry_t* root_entry(uint8_t index) {
+    return (dir_entry_t*)disk[ROOT_LBA] + index;
+}
+
+static uint16_t fat_get(uint16_t cluster) {
+    const uint8_t* fat = disk[FAT_LBA];
+    uint16_t i = (uint16_t)(cluster + cluster / 2);
+    uint16_t pair = (uint16_t)(fat[i] | (fat[i + 1] << 8));
+
+    return (cluster & 1) ? (pair >> 4) : (pair & 0xFFF);
+}
+
+static void fat_set(uint16_t cluster, uint16_t value) {
+    uint8_t* fat = disk[FAT_LBA];
+    uint16_t i = (uint16_t)(cluster + cluster / 2);
+
+    if (cluster & 1) {
+        fat[i] = (uint8_t)((fat[i] & 0x0F) | (value << 4));
+        fat[i + 1] = (uint8_t)(value >> 4);
+    } else {
+        fat[i] = (uint8_t)value;
+        fat[i + 1] = (uint8_t)((fat[i + 1] & 0xF0) | (value >> 8));
+    }
+}
+
+static bool valid_cluster(uint16_t cluster) {
+    return cluster >= FIRST_CLUSTER && cluster < FIRST_CLUSTER + CLUSTERS;
+}
+
+/**
+ * @brief Find a file in the root directory
+ *
+ * @return Its entry, or NULL
+ */
+static dir_entry_t* find_file(const char name[11]) {
+    for (uint8_t i = 0; i < ROOT_ENTRIES; i++) {
+        dir_entry_t* entry = root_entry(i);
+
+        if (entry->name[0] == 0) break;
+        if ((uint8_t)entry->name[0] == ENTRY_FREE || entry->attr == ATTR_LONG_NAME) continue;
+        if (entry->attr & (ATTR_VOLUME_ID | ATTR_DIRECTORY)) continue;
+        if (memcmp(entry->name, name, sizeof(entry->name)) == 0) return entry;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Pass the contents of a file along its cluster chain
+ *
+ * @return False if the chain ends before the file size
+ */
+static bool read_file(const dir_entry_t* entry, chunk_fn_t fn, void* ctx) {
+    uint32_t left = entry->size;
+    uint16_t cluster = entry->cluster;
+
+    for (uint16_t hops = 0; left; hops++) {
+        if (!valid_cluster(cluster) || hops == CLUSTERS) return false;
+
+        uint32_t len = (left < CONFIG_DRIVE_SECTOR_SIZE) ? left : CONFIG_DRIVE_SECTOR_SIZE;
+        fn(cluster_data(cluster), len, ctx);
+        left -= len;
+        cluster = fat_get(cluster);
+    }
+    return true;
+}
+
+static void hash_chunk(const uint8_t* data, uint32_t len, void* ctx) {
+    uint32_t* hash = ctx;
+
+    // FNV-1a
+    for (uint32_t i = 0; i < len; i++) {
+        *hash = (*hash ^ data[i]) * 16777619u;
+    }
+}
+
+/**
+ * @brief Hash of KEYMAP.TXT, 0 when it is missing or broken
+ */
+static uint32_t keymap_hash(void) {
+    const dir_entry_t* entry = find_file(keymap_name);
+    uint32_t hash = 2166136261u;
+
+    if (!entry || !read_file(entry, hash_chunk, &hash)) return 0;
+    return hash;
+}
+
+static void parse_chunk(const uint8_t* data, uint32_t len, void* ctx) {
+    drive_state_t* ds = ctx;
+    static const uint8_t bom[] = {0xEF, 0xBB, 0xBF};
+
+    // UTF-8 byte order mark some editors put first
+    if (ds->bom) {
+        ds->bom = false;
+        if (len >= sizeof(bom) && memcmp(data, bom, sizeof(bom)) == 0) {
+            data += sizeof(bom);
+            len -= sizeof(bom);
+        }
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (data[i] == '\n') {
+            settings_text_line(ds->line, ds->line_len);
+            ds->line_len = 0;
+        } else if (ds->line_len < sizeof(ds->line)) {
+            ds->line[ds->line_len++] = (char)data[i];
+        }
+    }
+}
+
+/**
+ * @brief Parse and apply KEYMAP.TXT
+ */
+static bool apply_file(drive_state_t* ds) {
+    const dir_entry_t* entry = find_file(keymap_name);
+
+    ds->line_len = 0;
+    ds->bom = true;
+    settings_text_begin();
+    read_file(entry, parse_chunk, ds);
+    if (ds->line_len) {
+        settings_text_line(ds->line, ds->line_len);
+    }
+    return settings_text_end(&ds->error);
+}
+
+/**
+ * @brief Add a root directory entry for clusters already linked
+ *
+ * @return False if the directory is full
+ */
+static bool add_entry(const char name[11], uint16_t cluster, uint32_t size) {
+    for (uint8_t i = 0; i < ROOT_ENTRIES; i++) {
+        dir_entry_t* entry = root_entry(i);
+
+        if (entry->name[0] != 0 && (uint8_t)entry->name[0] != ENTRY_FREE) continue;
+
+        memset(entry, 0, sizeof(*entry));
+        memcpy(entry->name, name, sizeof(entry->name));
+        entry->date = FAT_DATE;
+        entry->cluster = size ? cluster : 0;
+        entry->size = size;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Link a run of clusters into a chain
+ */
+static void link_run(uint16_t first, uint32_t size) {
+    uint16_t count = (uint16_t)((size + CONFIG_DRIVE_SECTOR_SIZE - 1) / CONFIG_DRIVE_SECTOR_SIZE);
+
+    for (uint16_t i = 0; i < count; i++) {
+        fat_set((uint16_t)(first + i), (i + 1 == count) ? CLUSTER_END : (uint16_t)(first + i + 1));
+    }
+}
+
+/**
+ * @brief Empty volume, label only
+ */
+static void format(void) {
+    boot_sector_t* boot = (boot_sector_t*)disk[BOOT_LBA];
+
+    memset(disk, 0, sizeof(disk));
+
+    *boot = (boot_sector_t){
+        .jump = {0xEB, 0x3C, 0x90},
+        .oem = {'M', 'S', 'D', 'O', 'S', '5', '.', '0'},
+        .bytes_per_sector = CONFIG_DRIVE_SECTOR_SIZE,
+        .sectors_per_cluster = 1,
+        .reserved_sectors = 1,
+        .fats = 1,
+        .root_entries = ROOT_ENTRIES,
+        .sectors = CONFIG_DRIVE_SECTORS,
+        .media = 0xF8,
+        .sectors_per_fat = 1,
+        .sectors_per_track = 1,
+        .heads = 1,
+        .drive = 0x80,
+        .signature = 0x29,
+        .serial = 0x4F52494Fu,
+        .fs_type = {'F', 'A', 'T', '1', '2', ' ', ' ', ' '},
+    };
+    memcpy(boot->label, volume_label, sizeof(boot->label));
+    disk[BOOT_LBA][510] = 0x55;
+    disk[BOOT_LBA][511] = 0xAA;
+
+    fat_set(0, 0xF00 | boot->media);
+    fat_set(1, CLUSTER_END);
+
+    dir_entry_t* label = root_entry(0);
+    memcpy(label->name, volume_label, sizeof(label->name));
+    label->attr = ATTR_VOLUME_ID;
+    label->date = FAT_DATE;
+}
+
+/**
+ * @brief Volume holding the live settings
+ *
+ * The text is written straight into the data clusters of the fresh
+ * volume.
+ */
+static void build(void) {
+    format();
+
+    size_t len = settings_text_render((char*)cluster_data(FIRST_CLUSTER), CLUSTERS * CONFIG_DRIVE_SECTOR_SIZE);
+    link_run(FIRST_CLUSTER, len);
+    add_entry(keymap_name, FIRST_CLUSTER, len);
+}
+
+static void put(char* out, size_t size, size_t* len, const char* s) {
+    while (*s && *len + 1 < size) {
+        out[(*len)++] = *s++;
+    }
+}
+
+/**
+ * @brief Replace ERRORS.TXT with the last error
+ *
+ * Skipped when the host left no free cluster or directory entry.
+ */
+static void add_errors(const drive_state_t* ds) {
+    dir_entry_t* old = find_file(errors_name);
+
+    if (old) {
+        for (uint16_t cluster = old->cluster, hops = 0; valid_cluster(cluster) && hops < CLUSTERS; hops++) {
+            uint16_t next = fat_get(cluster);
+            fat_set(cluster, 0);
+            cluster = next;
+        }
+        old->name[0] = (char)ENTRY_FREE;
+    }
+
+    uint16_t cluster = FIRST_CLUSTER;
+    while (cluster < FIRST_CLUSTER + CLUSTERS && fat_get(cluster) != 0) {
+        cluster++;
+    }
+    if (cluster == FIRST_CLUSTER + CLUSTERS) return;
+
+    char* text = (char*)cluster_data(cluster);
+    char number[6] = {0};
+    size_t len = 0;
+
+    memset(text, 0, CONFIG_DRIVE_SECTOR_SIZE);
+    if (ds->error.line) {
+        uint16_t line = ds->error.line;
+        uint8_t n = sizeof(number) - 1;
+        do {
+            number[--n] = (char)('0' + line % 10);
+            line /= 10;
+        } while (line);
+
+        put(text, CONFIG_DRIVE_SECTOR_SIZE, &len, "KEYMAP.TXT line ");
+        put(text, CONFIG_DRIVE_SECTOR_SIZE, &len, &number[n]);
+        put(text, CONFIG_DRIVE_SECTOR_SIZE, &len, ": ");
+    } else {
+        put(text, CONFIG_DRIVE_SECTOR_SIZE, &len, "KEYMAP.TXT: ");
+    }
+    put(text, CONFIG_DRIVE_SECTOR_SIZE, &len, ds->error.message);
+    put(text, CONFIG_DRIVE_SECTOR_SIZE, &len, "\r\n");
+
+    if (add_entry(errors_name, cluster, len)) {
+        link_run(cluster, len);
+    }
+}
+
+static void set_error(drive_state_t* ds, const char* message) {
+    size_t len = 0;
+
+    ds->failed = true;
+    ds->error.line = 0;
+    put(ds->error.message, sizeof(ds->error.message), &len, message);
+    ds->error.message[len] = '\0';
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Start with no medium
+ *
+ * Call once at boot; the volume is built on mount.
+ */
+void config_drive_init(void) {
+    drive_state.phase = PHASE_BUILD;
+    drive_state.status = CONFIG_DRIVE_ABSENT;
+}
+
+/**
+ * @brief Rebuild the volume for a new host session
+ *
+ * Called on USB mount. The medium is out until TASK_DRIVE has built it.
+ * A file being applied is left alone.
+ */
+void config_drive_mount(void) {
+    if (drive_state.phase != PHASE_IDLE && drive_state.phase != PHASE_BUILD) return;
+
+    config_drive_init();
+    scheduler_notify(TASK_DRIVE);
+}
+
+/**
+ * @brief Medium state for TEST UNIT READY
+ *
+ * CONFIG_DRIVE_CHANGED is reported once, then the medium is ready.
+ */
+config_drive_status_t config_drive_status(void) {
+    config_drive_status_t status = drive_state.status;
+
+    if (status == CONFIG_DRIVE_CHANGED) {
+        drive_state.status = CONFIG_DRIVE_READY;
+    }
+    return status;
+}
+
+/**
+ * @brief Read sectors (READ10)
+ *
+ * @return Bytes read, -1 past the end of the volume
+ */
+int32_t config_drive_read(uint32_t lba, uint32_t offset, void* buffer, uint32_t size) {
+    uint32_t start = lba * CONFIG_DRIVE_SECTOR_SIZE + offset;
+
+    if (lba >= CONFIG_DRIVE_SECTORS || start + size > sizeof(disk)) return -1;
+
+    memcpy(buffer, &disk[0][0] + start, size);
+    return (int32_t)size;
+}
+
+/**
+ * @brief Write sectors (WRITE10)
+ *
+ * Arms the settle timer of TASK_DRIVE. Refused while the medium is out.
+ *
+ * @return Bytes written, -1 past the end of the volume or while removed
+ */
+int32_t config_drive_write(uint32_t lba, uint32_t offset, const void* buffer, uint32_t size) {
+    drive_state_t* ds = &drive_state;
+    uint32_t start = lba * CONFIG_DRIVE_SECTOR_SIZE + offset;
+
+    if (lba >= CONFIG_DRIVE_SECTORS || start + size > sizeof(disk)) return -1;
+    if (ds->phase != PHASE_IDLE && ds->phase != PHASE_SETTLE) return -1;
+
+    memcpy(&disk[0][0] + start, buffer, size);
+    ds->phase = PHASE_SETTLE;
+    scheduler_wake_in_ms(TASK_DRIVE, CONFIG_DRIVE_SETTLE_MS);
+    return (int32_t)size;
+}
+
+/**
+ * @brief The host ejected the medium: read the file now
+ */
+void config_drive_eject(void) {
+    if (drive_state.phase == PHASE_SETTLE) {
+        scheduler_notify(TASK_DRIVE);
+    }
+}
+
+/**
+ * @brief Apply, save and rebuild
+ *
+ * Runs as TASK_DRIVE, armed by writes and by itself.
+ */
+void config_drive_task(void) {
+    drive_state_t* ds = &drive_state;
+
+    switch (ds->phase) {
+        case PHASE_BUILD: {
+            build();
+            ds->hash = keymap_hash();
+            ds->phase = PHASE_IDLE;
+            ds->status = CONFIG_DRIVE_CHANGED;
+        }
+        break;
+
+        case PHASE_SETTLE: {
+            uint32_t hash = keymap_hash();
+            if (hash == 0 || hash == ds->hash) {
+                ds->phase = PHASE_IDLE;
+                break;
+            }
+
+            ds->hash = hash;
+            ds->status = CONFIG_DRIVE_ABSENT;
+            ds->applied = apply_file(ds);
+            ds->failed = !ds->applied;
+            ds->phase = ds->applied ? PHASE_SAVE : PHASE_EJECT;
+            if (ds->failed) {
+                scheduler_wake_in_ms(TASK_DRIVE, CONFIG_DRIVE_EJECT_MS);
+            } else {
+                scheduler_notify(TASK_DRIVE);
+            }
+        }
+        break;
+
+        case PHASE_SAVE: {
+            if (!matrix_snapshot_idle()) {
+                scheduler_wake_in_ms(TASK_DRIVE, CONFIG_DRIVE_SAVE_RETRY_MS);
+                break;
+            }
+
+            if (settings_save().status != SETTINGS_OK) {
+                set_error(ds, "applied, but not saved to flash: lost at power off");
+            }
+            ds->phase = PHASE_EJECT;
+            scheduler_wake_in_ms(TASK_DRIVE, CONFIG_DRIVE_EJECT_MS);
+        }
+        break;
+
+        case PHASE_EJECT: {
+            // the host's text is replaced by the canonical one once applied,
+            // and stays for the user to fix otherwise
+            if (ds->applied) build();
+            if (ds->failed) add_errors(ds);
+
+            ds->hash = keymap_hash();
+            ds->phase = PHASE_IDLE;
+            ds->status = CONFIG_DRIVE_CHANGED;
+        }
+        break;
+
+        default:
+        break;
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * @file config_drive.h
+ * @brief USB configuration drive declarations
+ *
+ * A small FAT12 volume in RAM, exposed as a USB mass storage device, with
+ * one file, KEYMAP.TXT: the live settings in the text form of
+ * settings_text.h. When the host writes the volume and then leaves it
+ * alone for CONFIG_DRIVE_SETTLE_MS, the file is parsed and applied once,
+ * and saved to flash as soon as no key is held. The drive then drops off
+ * the host for CONFIG_DRIVE_EJECT_MS and comes back rebuilt: with the
+ * settings as applied, or with the file as written and ERRORS.TXT telling
+ * what is wrong with it. The keyboard keeps running throughout; the file
+ * is only read by TASK_DRIVE in the main loop.
+ *
+ * The volume is rebuilt from the live settings at every mount, so changes
+ * made over the vendor interface show up the next time the keyboard is
+ * plugged in. Only KEYMAP.TXT is looked at; other files the host creates
+ * are dropped on the next rebuild.
+ */
+
+#ifndef CONFIG_DRIVE_H
+#define CONFIG_DRIVE_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+
+    #include "../../matrix/snapshot/snapshot.h"
+    #include "../../scheduler/scheduler.h"
+    #include "../../settings/settings_text/settings_text.h"
+
+    #define CONFIG_DRIVE_SECTOR_SIZE 512
+
+    // Volume size, held in RAM
+    #ifndef CONFIG_DRIVE_SECTORS
+    #define CONFIG_DRIVE_SECTORS 64
+    #endif
+
+    // Quiet time after the last write before the file is read
+    #define CONFIG_DRIVE_SETTLE_MS 1000
+
+    // Time the medium reads as removed, so the host drops its cached view
+    #define CONFIG_DRIVE_EJECT_MS 2000
+
+    // Retry period of the flash save while keys are held
+    #define CONFIG_DRIVE_SAVE_RETRY_MS 100
+
+    // Medium state seen by the host (TEST UNIT READY)
+    typedef enum {
+        CONFIG_DRIVE_READY = 0,
+        CONFIG_DRIVE_ABSENT,            // not ready, medium not present
+        CONFIG_DRIVE_CHANGED,           // unit attention, medium may have changed (reported once)
+    } config_drive_status_t;
+
+    void config_drive_init(void);
+    void config_drive_mount(void);
+    config_drive_status_t config_drive_status(void);
+    int32_t config_drive_read(uint32_t lba, uint32_t offset, void* buffer, uint32_t size);
+    int32_t config_drive_write(uint32_t lba, uint32_t offset, const void* buffer, uint32_t size);
+    void config_drive_eject(void);
+    void config_drive_task(void);
+
+#endif /* CONFIG_DRIVE_H */
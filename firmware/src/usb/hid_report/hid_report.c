@@ -0,0 +1,403 @@
+/**
+ * @file hid_report.c
+ * @brief HID report state and transmission implementation
+ *
+ * Every report ID has a desired report (what the host should see) and the
+ * last report actually sent. Producers update the desired report with
+ * `hid_report_set`; a report is marked dirty only if its bytes differ from
+ * the last sent one, otherwise the update is counted as suppressed and no
+ * IN transaction is spent on it. `hid_report_flush` sends one dirty report
+ * per call, keyboard first, since only one report can be in flight.
+ *
+ * The keyboard report is maintained incrementally: each new matrix snapshot
+ * is diffed against the previous one and only the pressed/released keys are
+ * applied (see `update_keycode_array`), instead of rebuilding the report
+ * from the whole pressed list on every change.
+ *
+ * Encoder actions are taps (press then release) of a consumer code; they
+ * temporarily override the consumer code held through the keymap.
+ * Keyboard taps (leader and tap dance actions) work the same way on the
+ * keyboard report: the tapped key and modifiers are added to the keys held
+ * when the tap was queued. Keys pressed or released meanwhile only reach
+ * the report once the release of the tap has been sent, so they never
+ * share a report with the tap's modifiers.
+ *
+ * The mouse report is relative, so the byte comparison does not apply:
+ * it is sent whenever it carries motion or its buttons changed, and
+ * motion added before the previous update went out is merged into it.
+ */
+
+#include "hid_report.h"
+
+//--------------------------------------------------------------------+
+
+typedef struct {
+    uint8_t len;
+    uint8_t data[HID_REPORT_MAX_LEN];
+} report_buffer_t;
+
+// Progress of a consumer control or keyboard tap
+typedef enum {
+    TAP_IDLE = 0,
+    TAP_PRESS,      // press report pending
+    TAP_RELEASE     // press sent, release pending
+} tap_phase_t;
+
+typedef struct {
+    report_buffer_t desired[REPORT_ID_COUNT];
+    report_buffer_t last_sent[REPORT_ID_COUNT];
+    bool dirty[REPORT_ID_COUNT];
+
+    matrix_snapshot_t last_snapshot;    // snapshot the keyboard report reflects
+    hid_keyboard_report_t keyboard;     // incrementally maintained keyboard report
+    hid_mouse_report_t mouse;           // motion not sent yet and current buttons
+    uint16_t held_consumer_code;        // consumer code held through the keymap
+
+    tap_phase_t tap_phase;
+    uint16_t tap_code;
+
+    tap_phase_t key_tap_phase;
+    uint8_t key_tap_modifier;
+    uint8_t key_tap_code;               // 0 for a modifier-only tap
+    hid_keyboard_report_t key_tap_base; // held keys the tap is sent over
+
+    hid_report_stats_t stats;
+} hid_report_state_t;
+
+static hid_report_state_t report_state = {0};
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Check whether two report buffers hold the same bytes
+ */
+static bool __not_in_flash_func(report_equal)(const report_buffer_t* a, const report_buffer_t* b) {
+    if (a->len != b->len) return false;
+
+    for (uint8_t i = 0; i < a->len; i++) {
+        if (a->data[i] != b->data[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Add two relative motions, saturated to the report range
+ */
+static int8_t motion_add(int8_t a, int8_t b) {
+    int16_t sum = (int16_t)a + b;
+
+    if (sum > 127) return 127;
+    if (sum < -127) return -127;
+    return (int8_t)sum;
+}
+
+/**
+ * @brief Update the desired consumer control report
+ *
+ * A tap in progress takes precedence over the code held through the keymap.
+ */
+static void __not_in_flash_func(update_consumer_report)(void) {
+    uint16_t code = (report_state.tap_phase == TAP_PRESS) ? report_state.tap_code
+                                                          : report_state.held_consumer_code;
+    hid_report_set(REPORT_ID_CONSUMER_CONTROL, &code, sizeof(code));
+}
+
+/**
+ * @brief Update the desired keyboard report
+ *
+ * A keyboard tap in progress adds its key and modifiers to the keys held
+ * when it was queued, and holds back later changes until it is done.
+ */
+static void __not_in_flash_func(update_keyboard_report)(void) {
+    hid_keyboard_report_t report = (report_state.key_tap_phase == TAP_IDLE) ? report_state.keyboard
+                                                                            : report_state.key_tap_base;
+
+    if (report_state.key_tap_phase == TAP_PRESS) {
+        report.modifier |= report_state.key_tap_modifier;
+
+        for (uint8_t i = 0; i < 6 && report_state.key_tap_code; i++) {
+            if (report.keycode[i] == report_state.key_tap_code) break;
+            if (report.keycode[i] == 0) {
+                report.keycode[i] = report_state.key_tap_code;
+                break;
+            }
+        }
+    }
+    hid_report_set(REPORT_ID_KEYBOARD, &report, sizeof(report));
+}
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Set the desired content of a report
+ *
+ * Marks the report for transmission if it differs from the last report
+ * sent with the same ID, otherwise counts the update as suppressed.
+ *
+ * @param report_id Report ID (without the ID byte in data)
+ * @param data Report payload
+ * @param len Payload length in bytes (at most `HID_REPORT_MAX_LEN`)
+ */
+void __not_in_flash_func(hid_report_set)(uint8_t report_id, const void* data, uint8_t len) {
+    if (report_id >= REPORT_ID_COUNT || len > HID_REPORT_MAX_LEN) return;
+
+    report_buffer_t* desired = &report_state.desired[report_id];
+    const uint8_t* bytes = data;
+
+    desired->len = len;
+    for (uint8_t i = 0; i < len; i++) {
+        desired->data[i] = bytes[i];
+    }
+
+    report_state.dirty[report_id] = !report_equal(desired, &report_state.last_sent[report_id]);
+    if (!report_state.dirty[report_id]) {
+        report_state.stats.suppressed[report_id]++;
+    }
+}
+
+/**
+ * @brief Apply a new matrix snapshot to the keyboard report
+ *
+ * Applies only the keys that changed since the previous snapshot, then
+ * updates the keyboard and (if it changed) consumer control reports.
+ *
+ * @param snapshot Consistent matrix state (see `matrix_snapshot_read`)
+ */
+void __not_in_flash_func(hid_report_keyboard_update)(const matrix_snapshot_t* snapshot) {
+    uint16_t consumer_code = report_state.held_consumer_code;
+
+    update_keycode_array(&report_state.last_snapshot, snapshot, &report_state.keyboard, &consumer_code);
+    report_state.last_snapshot = *snapshot;
+
+    update_keyboard_report();
+
+    if (consumer_code != report_state.held_consumer_code) {
+        report_state.held_consumer_code = consumer_code;
+        update_consumer_report();
+    }
+}
+
+/**
+ * @brief Queue a consumer control tap (press followed by release)
+ *
+ * @param consumer_code Consumer usage to tap
+ * @return False if a previous tap is still in progress
+ */
+bool hid_report_consumer_tap(uint16_t consumer_code) {
+    if (report_state.tap_phase != TAP_IDLE) return false;
+
+    report_state.tap_code = consumer_code;
+    report_state.tap_phase = TAP_PRESS;
+    update_consumer_report();
+
+    // already what the host has: nothing to release
+    if (!report_state.dirty[REPORT_ID_CONSUMER_CONTROL]) {
+        report_state.tap_phase = TAP_IDLE;
+    }
+    return true;
+}
+
+/**
+ * @brief Queue a keyboard tap (press followed by release)
+ *
+ * @param modifier Modifiers held with the key (KEYBOARD_MODIFIER_*)
+ * @param keycode Keyboard usage; a modifier usage adds its bit instead
+ * @return False if a previous keyboard tap is still in progress
+ */
+bool hid_report_keyboard_tap(uint8_t modifier, uint8_t keycode) {
+    if (report_state.key_tap_phase != TAP_IDLE) return false;
+
+    if (keycode >= HID_KEY_CONTROL_LEFT && keycode <= HID_KEY_GUI_RIGHT) {
+        modifier |= 1 << (keycode - HID_KEY_CONTROL_LEFT);
+        keycode = 0;
+    }
+
+    report_state.key_tap_modifier = modifier;
+    report_state.key_tap_code = keycode;
+    report_state.key_tap_base = report_state.keyboard;
+    report_state.key_tap_phase = TAP_PRESS;
+    update_keyboard_report();
+
+    // already what the host has: nothing to release
+    if (!report_state.dirty[REPORT_ID_KEYBOARD]) {
+        report_state.key_tap_phase = TAP_IDLE;
+    }
+    return true;
+}
+
+/**
+ * @brief Update the mouse report
+ *
+ * Motion is added to the motion not sent yet. Marks the report for
+ * transmission if it carries motion or the buttons differ from the last
+ * report sent, so no zero-motion reports go out while nothing moves.
+ *
+ * @param buttons Held buttons (MOUSE_BUTTON_*)
+ * @param x Horizontal motion in counts
+ * @param y Vertical motion in counts (positive down)
+ * @param wheel Vertical wheel detents (positive up)
+ * @param pan Horizontal wheel detents (positive right)
+ */
+void hid_report_mouse_update(uint8_t buttons, int8_t x, int8_t y, int8_t wheel, int8_t pan) {
+    hid_mouse_report_t* mouse = &report_state.mouse;
+
+    // the previous motion went out: start over
+    if (!report_state.dirty[REPORT_ID_MOUSE]) {
+        mouse->x = 0;
+        mouse->y = 0;
+        mouse->wheel = 0;
+        mouse->pan = 0;
+    }
+
+    mouse->buttons = buttons;
+    mouse->x = motion_add(mouse->x, x);
+    mouse->y = motion_add(mouse->y, y);
+    mouse->wheel = motion_add(mouse->wheel, wheel);
+    mouse->pan = motion_add(mouse->pan, pan);
+
+    report_buffer_t* desired = &report_state.desired[REPORT_ID_MOUSE];
+    const report_buffer_t* last = &report_state.last_sent[REPORT_ID_MOUSE];
+
+    const uint8_t* bytes = (const uint8_t*)mouse;
+
+    desired->len = sizeof(*mouse);
+    for (uint8_t i = 0; i < sizeof(*mouse); i++) {
+        desired->data[i] = bytes[i];
+    }
+
+    bool motion = mouse->x || mouse->y || mouse->wheel || mouse->pan;
+    bool buttons_changed = last->len == 0 || last->data[0] != buttons;
+
+    report_state.dirty[REPORT_ID_MOUSE] = motion || buttons_changed;
+    if (!report_state.dirty[REPORT_ID_MOUSE]) {
+        report_state.stats.suppressed[REPORT_ID_MOUSE]++;
+    }
+}
+
+/**
+ * @brief Check whether a new consumer control tap can be queued
+ *
+ * @return True if no tap is waiting to be pressed or released
+ */
+bool hid_report_tap_idle(void) {
+    return report_state.tap_phase == TAP_IDLE;
+}
+
+/**
+ * @brief Check whether a new keyboard tap can be queued
+ *
+ * @return True if no keyboard tap is waiting to be pressed or released
+ */
+bool hid_report_keyboard_tap_idle(void) {
+    return report_state.key_tap_phase == TAP_IDLE;
+}
+
+/**
+ * @brief Check whether any report is waiting to be sent
+ *
+ * @return True if at least one report differs from what the host has
+ */
+bool hid_report_pending(void) {
+    for (uint8_t id = 1; id < REPORT_ID_COUNT; id++) {
+        if (report_state.dirty[id]) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Send the next pending report
+ *
+ * Sends at most one report, in report ID order. Call again from the
+ * report complete callback to drain the remaining ones.
+ */
+void hid_report_flush(void) {
+    if (!tud_hid_ready()) return;
+
+    for (uint8_t id = 1; id < REPORT_ID_COUNT; id++) {
+        if (!report_state.dirty[id]) continue;
+
+        report_buffer_t* desired = &report_state.desired[id];
+        if (!tud_hid_report(id, desired->data, desired->len)) return;
+        TRACE(TRACE_REPORT, id, desired->len);
+
+        report_state.last_sent[id] = *desired;
+        report_state.dirty[id] = false;
+        report_state.stats.sent[id]++;
+
+        // tap pressed: release it next
+        if (id == REPORT_ID_CONSUMER_CONTROL && report_state.tap_phase == TAP_PRESS) {
+            report_state.tap_phase = TAP_RELEASE;
+            update_consumer_report();
+        }
+
+        // release sent (or identical to the press): tap done
+        if (report_state.tap_phase == TAP_RELEASE && !report_state.dirty[REPORT_ID_CONSUMER_CONTROL]) {
+            report_state.tap_phase = TAP_IDLE;
+        }
+
+        // same for keyboard taps
+        if (id == REPORT_ID_KEYBOARD && report_state.key_tap_phase == TAP_PRESS) {
+            report_state.key_tap_phase = TAP_RELEASE;
+            update_keyboard_report();
+        }
+        if (report_state.key_tap_phase == TAP_RELEASE && !report_state.dirty[REPORT_ID_KEYBOARD]) {
+            report_state.key_tap_phase = TAP_IDLE;
+            // keys changed during the tap
+            update_keyboard_report();
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Start over with a new host
+ *
+ * Called on USB mount: the host starts with every report at zero, so
+ * what was sent to a previous one no longer counts. Reports that differ
+ * from an all-zero report become pending, such as the keys held at
+ * power-on, which then go out on the first IN poll. The mouse report
+ * carries relative motion and keeps its own pending state.
+ */
+void hid_report_resync(void) {
+    for (uint8_t id = 1; id < REPORT_ID_COUNT; id++) {
+        if (id == REPORT_ID_MOUSE) continue;
+
+        report_state.last_sent[id] = (report_buffer_t){.len = report_state.desired[id].len};
+        report_state.dirty[id] = !report_equal(&report_state.desired[id], &report_state.last_sent[id]);
+    }
+}
+
+/**
+ * @brief Copy the last report sent for a report ID
+ *
+ * Used to answer GET_REPORT requests with what the host last received.
+ *
+ * @param report_id Report ID
+ * @param buffer Destination buffer
+ * @param reqlen Size of the destination buffer
+ * @return Number of bytes copied
+ */
+uint16_t hid_report_get(uint8_t report_id, uint8_t* buffer, uint16_t reqlen) {
+    if (report_id >= REPORT_ID_COUNT) return 0;
+
+    const report_buffer_t* last = &report_state.last_sent[report_id];
+    uint16_t len = (last->len < reqlen) ? last->len : reqlen;
+
+    for (uint16_t i = 0; i < len; i++) {
+        buffer[i] = last->data[i];
+    }
+    return len;
+}
+
+/**
+ * @brief Get a copy of the transmission counters
+ *
+ * @param stats Pointer to store the counters
+ */
+void hid_report_get_stats(hid_report_stats_t* stats) {
+    *stats = report_state.stats;
+}
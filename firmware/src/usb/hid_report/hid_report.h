@@ -0,0 +1,47 @@
+/**
+ * @file hid_report.h
+ * @brief HID report state and transmission declarations
+ *
+ * Keeps the desired and last-sent report for every report ID, applies
+ * matrix changes to the keyboard report incrementally and only transmits
+ * reports whose bytes differ from what the host already has (for the
+ * relative mouse report: that carry motion or new buttons).
+ */
+
+#ifndef HID_REPORT_H
+#define HID_REPORT_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "pico/stdlib.h"
+    #include "tusb.h"
+    #include <class/hid/hid.h>
+
+    #include "../usb_descriptors/usb_descriptors.h"
+    #include "../../matrix/snapshot/snapshot.h"
+    #include "../../matrix/scan_rows/scan_rows.h"
+    #include "../../trace/trace.h"
+
+    #define HID_REPORT_MAX_LEN 15 // HID_KEYBOARD_EP_SIZE minus the report ID
+
+    // Per report ID transmission counters
+    typedef struct {
+        uint32_t sent[REPORT_ID_COUNT];         // reports transmitted
+        uint32_t suppressed[REPORT_ID_COUNT];   // updates identical to the last sent report
+    } hid_report_stats_t;
+
+    void hid_report_set(uint8_t report_id, const void* data, uint8_t len);
+    void hid_report_keyboard_update(const matrix_snapshot_t* snapshot);
+    bool hid_report_consumer_tap(uint16_t consumer_code);
+    bool hid_report_keyboard_tap(uint8_t modifier, uint8_t keycode);
+    void hid_report_mouse_update(uint8_t buttons, int8_t x, int8_t y, int8_t wheel, int8_t pan);
+    bool hid_report_tap_idle(void);
+    bool hid_report_keyboard_tap_idle(void);
+    bool hid_report_pending(void);
+    void hid_report_flush(void);
+    void hid_report_resync(void);
+    uint16_t hid_report_get(uint8_t report_id, uint8_t* buffer, uint16_t reqlen);
+    void hid_report_get_stats(hid_report_stats_t* stats);
+
+#endif /* HID_REPORT_H */
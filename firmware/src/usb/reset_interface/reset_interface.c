@@ -0,0 +1,113 @@
+/**
+ * @file reset_interface.c
+ * @brief picotool reset interface implementation
+ *
+ * A TinyUSB application class driver: it claims the reset interface when
+ * the configuration is opened and answers its two control requests.
+ * The request is acknowledged before anything happens; TASK_REBOOT
+ * resets the chip REBOOT_DELAY_MS after the keys are released, so the
+ * status stage reaches picotool.
+ */
+
+#include "reset_interface.h"
+
+#if RESET_INTERFACE_ENABLED
+
+//--------------------------------------------------------------------+
+
+static uint8_t reset_itf_num = 0xFF;
+
+//--------------------------------------------------------------------+
+// SUPPORT FUNCTIONS
+//--------------------------------------------------------------------+
+
+static void resetd_init(void) {
+    reset_itf_num = 0xFF;
+}
+
+static void resetd_reset(uint8_t rhport) {
+    (void) rhport;
+    reset_itf_num = 0xFF;
+}
+
+/**
+ * @brief Claim the reset interface of the configuration
+ *
+ * @return Descriptor bytes taken, 0 if the interface is not ours
+ */
+static uint16_t resetd_open(uint8_t rhport, tusb_desc_interface_t const* itf_desc, uint16_t max_len) {
+    (void) rhport;
+
+    TU_VERIFY(itf_desc->bInterfaceClass == TUSB_CLASS_VENDOR_SPECIFIC
+              && itf_desc->bInterfaceSubClass == RESET_INTERFACE_SUBCLASS
+              && itf_desc->bInterfaceProtocol == RESET_INTERFACE_PROTOCOL, 0);
+    TU_VERIFY(max_len >= sizeof(tusb_desc_interface_t), 0);
+
+    reset_itf_num = itf_desc->bInterfaceNumber;
+    return sizeof(tusb_desc_interface_t);
+}
+
+/**
+ * @brief Handle a control request to the reset interface
+ *
+ * @return False to stall an unknown request
+ */
+static bool resetd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const* request) {
+    if (stage != CONTROL_STAGE_SETUP) return true;
+    if (request->wIndex != reset_itf_num) return false;
+
+    switch (request->bRequest) {
+        case RESET_REQUEST_BOOTSEL: {
+            uint32_t activity_mask = 0;
+            if (request->wValue & 0x100) {
+                activity_mask = 1u << (request->wValue >> 9);
+            }
+            reboot_request_bootloader(activity_mask, request->wValue & 0x7F);
+        }
+        break;
+
+        case RESET_REQUEST_FLASH: {
+            reboot_request(REBOOT_FIRMWARE);
+        }
+        break;
+
+        default:
+        return false;
+    }
+
+    return tud_control_status(rhport, request);
+}
+
+static bool resetd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+    (void) rhport;
+    (void) ep_addr;
+    (void) result;
+    (void) xferred_bytes;
+    return true;
+}
+
+static const usbd_class_driver_t resetd_driver = {
+#if CFG_TUSB_DEBUG >= 2
+    .name = "RESET",
+#endif
+    .init = resetd_init,
+    .reset = resetd_reset,
+    .open = resetd_open,
+    .control_xfer_cb = resetd_control_xfer_cb,
+    .xfer_cb = resetd_xfer_cb,
+    .sof = NULL,
+};
+
+//--------------------------------------------------------------------+
+// FUNCTIONS
+//--------------------------------------------------------------------+
+
+/**
+ * @brief Application class drivers, asked for by TinyUSB at init
+ */
+usbd_class_driver_t const* usbd_app_driver_get_cb(uint8_t* driver_count) {
+    *driver_count = 1;
+    return &resetd_driver;
+}
+
+#endif /* RESET_INTERFACE_ENABLED */
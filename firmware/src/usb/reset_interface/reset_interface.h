@@ -0,0 +1,38 @@
+/**
+ * @file reset_interface.h
+ * @brief picotool reset interface declarations
+ *
+ * The vendor interface without endpoints that picotool looks for on a
+ * running device (as in the SDK's stdio_usb): `picotool reboot -f -u`,
+ * `picotool load -f` and friends send it a control request to reset into
+ * BOOTSEL mode or to restart the firmware, so a new image can be loaded
+ * without touching the board. The resets go through reboot.c like the
+ * other requests. Off with ORIONE_RESET_INTERFACE=OFF.
+ */
+
+#ifndef RESET_INTERFACE_H
+#define RESET_INTERFACE_H
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    #include "tusb.h"
+    #include "device/usbd_pvt.h"
+
+    #include "../../reboot/reboot.h"
+
+    // Interface and requests, as in the SDK's pico/usb_reset_interface.h
+    #define RESET_INTERFACE_SUBCLASS 0x00
+    #define RESET_INTERFACE_PROTOCOL 0x01
+
+    #define RESET_REQUEST_BOOTSEL 0x01  // wValue: [6:0] disabled bootloader interfaces, [8] activity LED on GPIO [15:9]
+    #define RESET_REQUEST_FLASH 0x02    // restart the firmware
+
+    #define TUD_RESET_DESC_LEN 9
+
+    // Interface number, string index
+    #define TUD_RESET_DESCRIPTOR(_itfnum, _stridx) \
+        9, TUSB_DESC_INTERFACE, _itfnum, 0, 0, TUSB_CLASS_VENDOR_SPECIFIC, RESET_INTERFACE_SUBCLASS, \
+        RESET_INTERFACE_PROTOCOL, _stridx
+
+#endif /* RESET_INTERFACE_H */
@@ -2,95 +2,115 @@
  * @file usb_callbacks.c
  * @brief USB HID callback implementation
  * 
- * Implements TinyUSB callbacks for USB device lifecycle management and
- * HID report handling. Manages LED status indicators (Caps Lock) and
- * adjusts LED blink patterns based on USB connection state.
+ * Implements TinyUSB callbacks for USB device lifecycle management,
+ * HID report handling and the configuration drive (MSC). Connection and
+ * Caps Lock changes are recorded for the LED indicators, which TASK_LED
+ * applies after the callback has returned (see indicator.c).
  */
 
-#include "usb_callbacks.h"
-
-//--------------------------------------------------------------------+
+#include <string.h>
 
-extern uint32_t blink_interval_ms;
+#include "usb_callbacks.h"
 
 //--------------------------------------------------------------------+
 
 // Invoked when device is mounted
 void tud_mount_cb(void) {
-    blink_interval_ms = BLINK_MOUNTED;
+    TRACE(TRACE_USB_MOUNT, 0, 0);
+    boot_mark(BOOT_MOUNTED);
+    // a new host has every report at zero: the held keys go out on the first poll
+    hid_report_resync();
+    scheduler_notify(TASK_HID);
+    indicator_set(INDICATOR_MOUNTED, true);
+    power_resume();
+#if CFG_TUD_MSC
+    // the host may have changed the settings over the vendor interface
+    config_drive_mount();
+#endif
 }
 
 // Invoked when device is unmounted
 void tud_umount_cb(void) {
-    blink_interval_ms = BLINK_NOT_MOUNTED;
+    TRACE(TRACE_USB_UNMOUNT, 0, 0);
+    vendor_reset();
+    indicator_set(INDICATOR_MOUNTED, false);
+    power_resume();
 }
 
 // Invoked when usb bus is suspended
 // remote_wakeup_en : if host allow us  to perform remote wakeup
 // Within 7ms, device must draw an average of current less than 2.5 mA from bus
+// -> LEDs off, clocks down and deep sleep until an edge or resume (see power.c)
 void tud_suspend_cb(bool remote_wakeup_en) {
-    (void) remote_wakeup_en;
-    blink_interval_ms = BLINK_SUSPENDED;
+    TRACE(TRACE_USB_SUSPEND, remote_wakeup_en, 0);
+    power_suspend(remote_wakeup_en);
 }
 
 // Invoked when usb bus is resumed
 void tud_resume_cb(void) {
-    blink_interval_ms = tud_mounted() ? BLINK_MOUNTED : BLINK_NOT_MOUNTED;
+    TRACE(TRACE_USB_RESUME, 0, 0);
+    // clocks and LEDs are restored by the power task
+    power_resume();
+    // flush input gathered while suspended
+    scheduler_notify(TASK_HID);
+    scheduler_notify(TASK_VENDOR);
 }
 
-//--------------------------------------------------------------------+
-
-void send_hid_report(uint8_t report_id, uint16_t consumer_code) {
-    // skip if hid is not ready yet
-    if (!tud_hid_ready()) return;
-
-    switch(report_id) {
-        case REPORT_ID_KEYBOARD: {
-            uint8_t keycode[6] = {0};
-            uint8_t modifier = 0;
-            
-            build_keycode_array(&modifier, keycode);
-
-            tud_hid_keyboard_report(REPORT_ID_KEYBOARD, modifier, keycode);
-        }
-        break;
-
-        case REPORT_ID_CONSUMER_CONTROL: {
-            tud_hid_report(REPORT_ID_CONSUMER_CONTROL, &consumer_code, 2);
-        }
-        break;
-
-        default: break;
-    }
+// Invoked from the USB IRQ when an event is queued for tud_task()
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
+    (void) rhport;
+    (void) eventid;
+    (void) in_isr;
+    scheduler_notify(TASK_USB);
 }
 
+//--------------------------------------------------------------------+
+
 // Invoked when sent REPORT successfully to host
 // Application can use this to send the next report
 // Note: For composite reports, report[0] is report ID
 void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
-    (void) instance;
     (void) len;
     (void) report;
+
+    // endpoint free again: send the next pending report
+    if (instance == HID_INSTANCE_VENDOR) {
+        scheduler_notify(TASK_VENDOR);
+    } else {
+        boot_mark(BOOT_REPORT);
+        scheduler_notify(TASK_HID);
+    }
 }
 
 // Invoked when received GET_REPORT control request
 // Application must fill buffer report's content and return its length.
 // Return zero will cause the stack to STALL request
 uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen) {
-    // TODO not Implemented
-    (void) instance;
-    (void) report_id;
-    (void) report_type;
-    (void) buffer;
-    (void) reqlen;
+    // vendor interface: key statistics pages
+    if (instance == HID_INSTANCE_VENDOR) {
+        if (report_type != HID_REPORT_TYPE_FEATURE) return 0;
+        return vendor_get_feature(buffer, reqlen);
+    }
+
+    // input reports: what the host last received (keyboard interface only)
+    if (instance != HID_INSTANCE_KEYBOARD) return 0;
+    if (report_type != HID_REPORT_TYPE_INPUT) return 0;
 
-    return 0;
+    return hid_report_get(report_id, buffer, reqlen);
 }
 
 // Invoked when received SET_REPORT control request or
 // received data on OUT endpoint ( Report ID = 0, Type = 0 )
 void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize) {
-    (void) instance;
+    // vendor interface: host commands (trace streaming), feature page selection
+    if (instance == HID_INSTANCE_VENDOR) {
+        if (report_type == HID_REPORT_TYPE_FEATURE) {
+            vendor_set_feature(buffer, bufsize);
+        } else {
+            vendor_receive(buffer, bufsize);
+        }
+        return;
+    }
 
     if (report_type == HID_REPORT_TYPE_OUTPUT) {
         // Set keyboard LED e.g Capslock, Numlock etc...
@@ -100,17 +120,90 @@ void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_
 
             uint8_t const kbd_leds = buffer[0];
 
-            if (kbd_leds & KEYBOARD_LED_CAPSLOCK) {
-                // Capslock On: disable blink, turn led on
-                blink_interval_ms = 100;
-                gpio_put(CAPS_LOCK_LED, HIGH);
-                board_led_write(true);
-            } else {
-                // Caplocks Off: back to normal blink
-                board_led_write(false);
-                gpio_put(CAPS_LOCK_LED, LOW);
-                blink_interval_ms = BLINK_MOUNTED;
-            }
+            // Caps Lock LED on, rapid status blink (applied by TASK_LED)
+            indicator_set(INDICATOR_CAPS_LOCK, kbd_leds & KEYBOARD_LED_CAPSLOCK);
         }
     }
-}
\ No newline at end of file
+}
+
+//--------------------------------------------------------------------+
+
+#if CFG_TUD_MSC
+
+// Invoked when received SCSI_CMD_INQUIRY
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]) {
+    (void) lun;
+
+    memcpy(vendor_id, "Orione  ", 8);
+    memcpy(product_id, "Config drive    ", 16);
+    memcpy(product_rev, "1.0 ", 4);
+}
+
+// Invoked when received Test Unit Ready command
+// -> not ready while a written file is applied, then a media change once
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+    (void) lun;
+
+    switch (config_drive_status()) {
+        case CONFIG_DRIVE_ABSENT:
+            tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+            return false;
+
+        case CONFIG_DRIVE_CHANGED:
+            tud_msc_set_sense(lun, SCSI_SENSE_UNIT_ATTENTION, 0x28, 0x00);
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+// Invoked when received SCSI_CMD_READ_CAPACITY_10 and SCSI_CMD_READ_FORMAT_CAPACITY
+void tud_msc_capacity_cb(uint8_t lun, uint32_t* block_count, uint16_t* block_size) {
+    (void) lun;
+
+    *block_count = CONFIG_DRIVE_SECTORS;
+    *block_size = CONFIG_DRIVE_SECTOR_SIZE;
+}
+
+// Invoked when received Start Stop Unit command
+// -> an eject applies a written file without waiting for it to settle
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject) {
+    (void) lun;
+    (void) power_condition;
+
+    if (load_eject && !start) {
+        config_drive_eject();
+    }
+    return true;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun) {
+    (void) lun;
+    return true;
+}
+
+// Invoked when received SCSI READ10 command
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
+    (void) lun;
+    return config_drive_read(lba, offset, buffer, bufsize);
+}
+
+// Invoked when received SCSI WRITE10 command
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize) {
+    (void) lun;
+    return config_drive_write(lba, offset, buffer, bufsize);
+}
+
+// Invoked when received a SCSI command not handled by TinyUSB
+// -> none are supported
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void* buffer, uint16_t bufsize) {
+    (void) scsi_cmd;
+    (void) buffer;
+    (void) bufsize;
+
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+    return -1;
+}
+
+#endif
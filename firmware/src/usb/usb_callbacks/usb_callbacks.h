@@ -3,7 +3,8 @@
  * @brief USB HID callback function declarations
  * 
  * TinyUSB callback prototypes for device lifecycle events (mount, unmount,
- * suspend, resume) and HID report transmission/reception.
+ * suspend, resume), HID report transmission/reception and the sectors of
+ * the configuration drive.
  */
 
 #ifndef USB_CALLBACKS_H
@@ -15,16 +16,36 @@
     
     #include "../usb_descriptors/usb_descriptors.h"
     #include "src/global.h"
+    #include "src/matrix/snapshot/snapshot.h"
+    #include "src/usb/hid_report/hid_report.h"
+    #include "src/usb/vendor/vendor.h"
+    #include "src/usb/config_drive/config_drive.h"
+    #include "src/trace/trace.h"
     #include "src/matrix/scan_rows/scan_rows.h"
+    #include "src/scheduler/scheduler.h"
+    #include "src/power/power.h"
+    #include "src/boot/boot.h"
+    #include "src/indicator/indicator.h"
     
     void tud_mount_cb(void);
     void tud_umount_cb(void);
     void tud_suspend_cb(bool remote_wakeup_en);
     void tud_resume_cb(void);
+    void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr);
 
-    void send_hid_report(uint8_t report_id, uint16_t consumer_code);
     void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len);
     uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen);
     void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize);
 
+    #if CFG_TUD_MSC
+    void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]);
+    bool tud_msc_test_unit_ready_cb(uint8_t lun);
+    void tud_msc_capacity_cb(uint8_t lun, uint32_t* block_count, uint16_t* block_size);
+    bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject);
+    bool tud_msc_is_writable_cb(uint8_t lun);
+    int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
+    int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
+    int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void* buffer, uint16_t bufsize);
+    #endif
+
 #endif /* USB_CALLBACKS_H */
\ No newline at end of file
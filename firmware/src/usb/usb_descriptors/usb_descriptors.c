@@ -26,16 +26,17 @@
 #include "bsp/board_api.h"
 #include "tusb.h"
 #include "usb_descriptors.h"
+#include "../reset_interface/reset_interface.h"
 
 /* A combination of interfaces must have a unique product id, since PC will save device driver after the first plug.
  * Same VID/PID with different interface e.g MSC (first), then CDC (later) will possibly cause system error on PC.
  *
  * Auto ProductID layout's Bitmap:
- *   [MSB]         HID | MSC | CDC          [LSB]
+ *   [MSB]         RESET | VENDOR | MIDI | HID | MSC | CDC          [LSB]
  */
 #define _PID_MAP(itf, n)  ( (CFG_TUD_##itf) << (n) )
 #define USB_PID           (0x4000 | _PID_MAP(CDC, 0) | _PID_MAP(MSC, 1) | _PID_MAP(HID, 2) | \
-                           _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4) )
+                           _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4) | (RESET_INTERFACE_ENABLED << 5) )
 
 #define USB_VID   0xCafe
 #define USB_BCD   0x0200
@@ -83,12 +84,44 @@ uint8_t const desc_hid_report[] =
   TUD_HID_REPORT_DESC_GAMEPAD ( HID_REPORT_ID(REPORT_ID_GAMEPAD          ))
 };
 
+// Vendor interface: 64 byte IN/OUT reports on a vendor usage page, used to
+// stream the event trace, and a 64 byte feature report for the key
+// statistics (see src/usb/vendor/vendor.c)
+uint8_t const desc_hid_vendor_report[] =
+{
+  HID_USAGE_PAGE_N ( HID_USAGE_PAGE_VENDOR, 2   ),
+  HID_USAGE        ( 0x01                       ),
+  HID_COLLECTION   ( HID_COLLECTION_APPLICATION ),
+    // device -> host packets
+    HID_USAGE         ( 0x02                                   ),
+    HID_LOGICAL_MIN   ( 0x00                                   ),
+    HID_LOGICAL_MAX_N ( 0xff, 2                                ),
+    HID_REPORT_SIZE   ( 8                                      ),
+    HID_REPORT_COUNT  ( VENDOR_REPORT_SIZE                     ),
+    HID_INPUT         ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ),
+    // host -> device commands
+    HID_USAGE         ( 0x03                                   ),
+    HID_LOGICAL_MIN   ( 0x00                                   ),
+    HID_LOGICAL_MAX_N ( 0xff, 2                                ),
+    HID_REPORT_SIZE   ( 8                                      ),
+    HID_REPORT_COUNT  ( VENDOR_REPORT_SIZE                     ),
+    HID_OUTPUT        ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ),
+    // key statistics pages
+    HID_USAGE         ( 0x04                                   ),
+    HID_LOGICAL_MIN   ( 0x00                                   ),
+    HID_LOGICAL_MAX_N ( 0xff, 2                                ),
+    HID_REPORT_SIZE   ( 8                                      ),
+    HID_REPORT_COUNT  ( VENDOR_REPORT_SIZE                     ),
+    HID_FEATURE       ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ),
+  HID_COLLECTION_END
+};
+
 // Invoked when received GET HID REPORT DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance)
 {
-  (void) instance;
+  if (instance == HID_INSTANCE_VENDOR) return desc_hid_vendor_report;
   return desc_hid_report;
 }
 
@@ -99,12 +132,24 @@ uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance)
 enum
 {
   ITF_NUM_HID,
+  ITF_NUM_VENDOR,
+#if CFG_TUD_MSC
+  ITF_NUM_MSC,
+#endif
+#if RESET_INTERFACE_ENABLED
+  ITF_NUM_RESET,
+#endif
   ITF_NUM_TOTAL
 };
 
-#define  CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
+#define  CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + TUD_HID_INOUT_DESC_LEN + CFG_TUD_MSC * TUD_MSC_DESC_LEN + \
+                           RESET_INTERFACE_ENABLED * TUD_RESET_DESC_LEN)
 
-#define EPNUM_HID   0x81
+#define EPNUM_HID          0x81
+#define EPNUM_VENDOR_OUT   0x02
+#define EPNUM_VENDOR_IN    0x82
+#define EPNUM_MSC_OUT      0x03
+#define EPNUM_MSC_IN       0x83
 
 uint8_t const desc_configuration[] =
 {
@@ -112,7 +157,23 @@ uint8_t const desc_configuration[] =
   TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
 
   // Interface number, string index, protocol, report descriptor len, EP In address, size & polling interval
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, 5)
+  // (polled every frame, mouse keys update once per frame)
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID, HID_KEYBOARD_EP_SIZE, 1),
+
+  // Interface number, string index, protocol, report descriptor len, EP Out & In address, size & polling interval
+  TUD_HID_INOUT_DESCRIPTOR(ITF_NUM_VENDOR, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_vendor_report), EPNUM_VENDOR_OUT, EPNUM_VENDOR_IN, VENDOR_REPORT_SIZE, 1),
+
+#if CFG_TUD_MSC
+  // Configuration drive (src/usb/config_drive)
+  // Interface number, string index, EP Out & EP In address, EP size
+  TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 0, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+#endif
+
+#if RESET_INTERFACE_ENABLED
+  // picotool reset interface (src/usb/reset_interface), no endpoints
+  // Interface number, string index
+  TUD_RESET_DESCRIPTOR(ITF_NUM_RESET, 0),
+#endif
 };
 
 #if TUD_OPT_HIGH_SPEED
@@ -34,4 +34,18 @@ enum
   REPORT_ID_COUNT
 };
 
+// HID interface instances, in configuration descriptor order
+enum
+{
+  HID_INSTANCE_KEYBOARD = 0,
+  HID_INSTANCE_VENDOR,
+  HID_INSTANCE_COUNT
+};
+
+// Keyboard interface IN endpoint size: largest report plus the report ID
+#define HID_KEYBOARD_EP_SIZE  16
+
+// Vendor interface report size, IN and OUT (no report ID)
+#define VENDOR_REPORT_SIZE    64
+
 #endif /* USB_DESCRIPTORS_H_ */
\ No newline at end of file
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Compare two runs of the Orione micro-benchmarks.
+
+Reads the JSON lines printed by the bench program (host or Pico build),
+matches results by benchmark and case, and prints the per-operation cost
+of both runs with the relative change. Uses cycles_per_op when both runs
+have it (Pico), ns_per_op otherwise.
+
+With --check, compares one run against the limits of a thresholds file
+({"bench": {"case": {"metric": limit}}}, e.g. bench/thresholds.json for
+the `replay run --profile` execution times) and exits with status 1 when
+any limit is exceeded or has no result in the run: a handler the run did
+not reach is not checked, so it fails too.
+
+usage: bench_compare.py base.jsonl new.jsonl
+       bench_compare.py --check thresholds.json run.jsonl
+"""
+
+import json
+import sys
+
+
+def load(path):
+    results = {}
+
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue
+            try:
+                entry = json.loads(line)
+            except ValueError:
+                continue
+            if "bench" not in entry:
+                continue
+            results[(entry["bench"], entry["case"])] = entry
+
+    return results
+
+
+def metric(base, new):
+    if "cycles_per_op" in base and "cycles_per_op" in new:
+        return "cycles_per_op"
+    return "ns_per_op"
+
+
+def check(thresholds_path, run_path):
+    with open(thresholds_path) as f:
+        thresholds = json.load(f)
+    run = load(run_path)
+
+    failed = 0
+    print(f"{'bench':<28} {'case':<18} {'metric':<10} {'value':>10} {'limit':>10}")
+    for bench, cases in sorted(thresholds.items()):
+        for case, limits in sorted(cases.items()):
+            for m, limit in sorted(limits.items()):
+                entry = run.get((bench, case))
+                if entry is None or m not in entry:
+                    print(f"{bench:<28} {case:<18} {m:<10} {'-':>10} {limit:10.2f}  FAIL, not measured")
+                    failed += 1
+                    continue
+
+                value = entry[m]
+                status = ""
+                if value > limit:
+                    status = "  FAIL"
+                    failed += 1
+                print(f"{bench:<28} {case:<18} {m:<10} {value:10.2f} {limit:10.2f}{status}")
+
+    return 1 if failed else 0
+
+
+def main(argv):
+    if len(argv) == 3 and argv[0] == "--check":
+        return check(argv[1], argv[2])
+
+    if len(argv) != 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    base = load(argv[0])
+    new = load(argv[1])
+
+    print(f"{'bench':<28} {'case':<18} {'base':>10} {'new':>10} {'change':>8}")
+    for key in sorted(base.keys() | new.keys()):
+        bench, case = key
+        if key not in base or key not in new:
+            side = "new" if key not in base else "base"
+            print(f"{bench:<28} {case:<18} {'only in ' + side:>30}")
+            continue
+
+        m = metric(base[key], new[key])
+        b, n = base[key][m], new[key][m]
+        change = (n - b) / b * 100 if b else 0.0
+        print(f"{bench:<28} {case:<18} {b:10.2f} {n:10.2f} {change:+7.1f}%")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
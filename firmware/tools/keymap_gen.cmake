@@ -0,0 +1,31 @@
+# Keymap tables generated from config/orione.keymap by tools/keymap_gen.py
+#
+#   include(path/to/tools/keymap_gen.cmake)
+#   orione_keymap_tables(<target>)
+#
+# The generator runs when the keymap or the generator change, and fails the
+# build on an invalid keymap. The tables are written to the build tree and
+# the target gets keymap_tables.c as a source and their include directory.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+get_filename_component(ORIONE_KEYMAP_DEFAULT ${CMAKE_CURRENT_LIST_DIR}/../config/orione.keymap ABSOLUTE)
+set(ORIONE_KEYMAP ${ORIONE_KEYMAP_DEFAULT} CACHE FILEPATH "Keymap source")
+set(ORIONE_KEYMAP_GEN ${CMAKE_CURRENT_LIST_DIR}/keymap_gen.py)
+set(ORIONE_KEYMAP_DIR ${CMAKE_CURRENT_BINARY_DIR}/keymap)
+
+add_custom_command(
+        OUTPUT ${ORIONE_KEYMAP_DIR}/keymap_tables.h ${ORIONE_KEYMAP_DIR}/keymap_tables.c
+        COMMAND ${Python3_EXECUTABLE} ${ORIONE_KEYMAP_GEN} ${ORIONE_KEYMAP} ${ORIONE_KEYMAP_DIR}
+        DEPENDS ${ORIONE_KEYMAP} ${ORIONE_KEYMAP_GEN}
+        COMMENT "Generating keymap tables from ${ORIONE_KEYMAP}"
+        VERBATIM)
+
+add_custom_target(orione_keymap_tables
+        DEPENDS ${ORIONE_KEYMAP_DIR}/keymap_tables.h ${ORIONE_KEYMAP_DIR}/keymap_tables.c)
+
+function(orione_keymap_tables target)
+    target_sources(${target} PRIVATE ${ORIONE_KEYMAP_DIR}/keymap_tables.c)
+    target_include_directories(${target} PUBLIC ${ORIONE_KEYMAP_DIR})
+    add_dependencies(${target} orione_keymap_tables)
+endfunction()
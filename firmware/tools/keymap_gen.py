@@ -0,0 +1,647 @@
+#!/usr/bin/env python3
+"""
+Keymap compiler for the Orione firmware.
+
+Reads a keymap source (config/orione.keymap, format described at its top),
+checks it against the firmware (matrix size, Fn key, known keycodes, a
+gamepad layer that leaves the mode and profile keys usable) and writes
+keymap_tables.h and keymap_tables.c to the output directory:
+
+  keymap_tables[profile][layer][row][col]   every profile's layers, in the
+                                            order keymap.c copies to RAM
+  gamepad_keymap[row][col]                  gamepad mode controls
+  keymap_encoders[profile]                  encoder bindings
+  leader_symbols, leader_nodes, leader_steps
+                                            leader key sequences, as a
+                                            double-array trie
+  keymap_tap_dances[dance]                  tap dance gesture actions
+  keymap_key_names, keymap_tap_dance_names  key names of the keyboard layers,
+                                            sorted, for the config drive
+
+KEYMAP_SOURCE_HASH is the CRC-32 of the keymap source, so settings saved
+by the firmware are only restored over the tables they were made from.
+
+Errors are printed as <file>:<line>: <message> and exit with status 1.
+Files are only rewritten when their content changes.
+
+usage: keymap_gen.py <keymap> <output dir>
+"""
+
+import os
+import re
+import sys
+import zlib
+
+KEYBOARD_KEYS = set(
+    [chr(c) for c in range(ord("A"), ord("Z") + 1)]
+    + [str(d) for d in range(10)]
+    + [f"F{n}" for n in range(1, 25)]
+    + [f"KEYPAD_{d}" for d in range(10)]
+    + """
+    ENTER ESCAPE BACKSPACE TAB SPACE MINUS EQUAL BRACKET_LEFT BRACKET_RIGHT
+    BACKSLASH EUROPE_1 SEMICOLON APOSTROPHE GRAVE COMMA PERIOD SLASH
+    CAPS_LOCK PRINT_SCREEN SCROLL_LOCK PAUSE INSERT HOME PAGE_UP DELETE END
+    PAGE_DOWN ARROW_RIGHT ARROW_LEFT ARROW_DOWN ARROW_UP NUM_LOCK
+    KEYPAD_DIVIDE KEYPAD_MULTIPLY KEYPAD_SUBTRACT KEYPAD_ADD KEYPAD_ENTER
+    KEYPAD_DECIMAL EUROPE_2 APPLICATION POWER KEYPAD_EQUAL
+    CONTROL_LEFT SHIFT_LEFT ALT_LEFT GUI_LEFT
+    CONTROL_RIGHT SHIFT_RIGHT ALT_RIGHT GUI_RIGHT
+    """.split()
+)
+
+CONSUMER_USAGES = set(
+    """
+    POWER SLEEP BRIGHTNESS_INCREMENT BRIGHTNESS_DECREMENT PLAY_PAUSE
+    SCAN_NEXT SCAN_PREVIOUS STOP MUTE VOLUME_INCREMENT VOLUME_DECREMENT
+    AL_EMAIL_READER AL_CALCULATOR AL_LOCAL_BROWSER
+    AC_SEARCH AC_HOME AC_BACK AC_FORWARD AC_STOP AC_REFRESH
+    """.split()
+)
+
+MOUSE_KEYS = set(
+    """
+    MS_UP MS_DOWN MS_LEFT MS_RIGHT MS_BTN1 MS_BTN2 MS_BTN3
+    MS_WH_UP MS_WH_DOWN MS_WH_LEFT MS_WH_RIGHT MS_PRECISION
+    """.split()
+)
+
+ACTION_KEYS = {"GP_TOGGLE", "GP_SOCD", "PROFILE_NEXT", "LEADER", "BOOTLOADER", "REBOOT"}
+
+MODIFIERS = {
+    "CONTROL_LEFT": "KEYBOARD_MODIFIER_LEFTCTRL",
+    "SHIFT_LEFT": "KEYBOARD_MODIFIER_LEFTSHIFT",
+    "ALT_LEFT": "KEYBOARD_MODIFIER_LEFTALT",
+    "GUI_LEFT": "KEYBOARD_MODIFIER_LEFTGUI",
+    "CONTROL_RIGHT": "KEYBOARD_MODIFIER_RIGHTCTRL",
+    "SHIFT_RIGHT": "KEYBOARD_MODIFIER_RIGHTSHIFT",
+    "ALT_RIGHT": "KEYBOARD_MODIFIER_RIGHTALT",
+    "GUI_RIGHT": "KEYBOARD_MODIFIER_RIGHTGUI",
+}
+
+# Text of a leader action, typed on a US layout: character -> (shift, key)
+TEXT_KEYS = {" ": (False, "SPACE")}
+TEXT_KEYS.update({c: (False, c.upper()) for c in "abcdefghijklmnopqrstuvwxyz0123456789"})
+TEXT_KEYS.update({c: (True, c) for c in "ABCDEFGHIJKLMNOPQRSTUVWXYZ"})
+TEXT_KEYS.update({c: (True, k) for c, k in zip("!@#$%^&*()", "1234567890")})
+for plain, shifted, key in [("-", "_", "MINUS"), ("=", "+", "EQUAL"), ("[", "{", "BRACKET_LEFT"),
+                            ("]", "}", "BRACKET_RIGHT"), ("\\", "|", "BACKSLASH"), (";", ":", "SEMICOLON"),
+                            ("'", None, "APOSTROPHE"), ("`", "~", "GRAVE"), (",", "<", "COMMA"),
+                            (".", ">", "PERIOD"), ("/", "?", "SLASH")]:
+    TEXT_KEYS[plain] = (False, key)
+    if shifted:
+        TEXT_KEYS[shifted] = (True, key)
+
+# Symbols of the leader trie are keyboard usages below this value
+LEADER_SYMBOL_RANGE = 256
+
+GAMEPAD_CONTROLS = set(
+    f"{stick}_{direction}"
+    for stick in ("DPAD", "LS", "RS")
+    for direction in ("UP", "DOWN", "LEFT", "RIGHT")
+)
+GAMEPAD_BUTTONS = 16
+
+ENCODER_MOUSE_KEYS = {"MS_WH_UP", "MS_WH_DOWN"}
+
+# Gestures of a tap dance, in the order of tap_dance_gesture_t
+TAP_DANCE_GESTURES = ["single", "double", "triple", "hold"]
+
+NO_KEY = "0"
+
+NAME_RE = re.compile(r"^[a-z_][a-z0-9_]*$")
+CALL_RE = re.compile(r"^([A-Z]+)\((\w+)\)$")
+TOKEN_RE = re.compile(r'"[^"]*"|\S+')
+OVERRIDE_RE = re.compile(r"^(\d+),(\d+)$")
+
+
+class KeymapError(Exception):
+    def __init__(self, line, message):
+        super().__init__(message)
+        self.line = line
+
+
+class Keymap:
+    def __init__(self):
+        self.rows = None
+        self.cols = None
+        self.fn = None
+        self.layers = {}        # name -> grid of C expressions
+        self.gamepad = None
+        self.profiles = []      # (name, [layer names], (cw, ccw, press), line)
+        self.leader = []        # ([sequence keys], [(key, [modifiers])], line)
+        self.tap_dances = []    # (name, {gesture: (key, [modifiers])}, (tap ms, hold ms), line)
+        self.line_of = {}       # (layer, row, col) -> source line, for messages
+        self.raw_keys = []      # (layer, row, col, token) of every key, for cross checks
+
+
+def c_profile(name):
+    return f"KEYMAP_PROFILE_{name.upper()}"
+
+
+def c_tap_dance(name):
+    return f"KEYMAP_TAP_DANCE_{name.upper()}"
+
+
+def keycode(token, line, gamepad, profiles, tap_dances=()):
+    """C expression of a key token, or raise KeymapError."""
+    if token == ".":
+        return NO_KEY
+
+    call = CALL_RE.match(token)
+
+    if gamepad:
+        if token in GAMEPAD_CONTROLS:
+            return f"GP_{token}"
+        if call and call.group(1) == "BTN":
+            n = call.group(2)
+            if not n.isdigit() or int(n) >= GAMEPAD_BUTTONS:
+                raise KeymapError(line, f"gamepad button {n} out of range 0..{GAMEPAD_BUTTONS - 1}")
+            return f"GP_BTN({int(n)})"
+        raise KeymapError(line, f"'{token}' is not a gamepad control")
+
+    if token.startswith("C:"):
+        usage = token[2:]
+        if usage not in CONSUMER_USAGES:
+            raise KeymapError(line, f"unknown consumer usage '{usage}'")
+        return f"KC_CONSUMER(HID_USAGE_CONSUMER_{usage})"
+    if token in MOUSE_KEYS or token in ACTION_KEYS:
+        return f"KC_{token}"
+    if call and call.group(1) == "PROFILE":
+        name = call.group(2)
+        if name not in profiles:
+            raise KeymapError(line, f"unknown profile '{name}'")
+        return f"KC_PROFILE({c_profile(name)})"
+    if call and call.group(1) == "TD":
+        name = call.group(2)
+        if name not in tap_dances:
+            raise KeymapError(line, f"unknown tap dance '{name}'")
+        return f"KC_TAP_DANCE({c_tap_dance(name)})"
+    if token in KEYBOARD_KEYS:
+        return f"HID_KEY_{token}"
+    if token in GAMEPAD_CONTROLS or (call and call.group(1) == "BTN"):
+        raise KeymapError(line, f"gamepad control '{token}' outside the gamepad layer")
+
+    raise KeymapError(line, f"unknown key '{token}'")
+
+
+def tokenize(path):
+    """Yield (line number, tokens) of the non-empty lines; quoted text is one token."""
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            tokens = []
+            for token in TOKEN_RE.findall(line):
+                if token.startswith("#"):
+                    break
+                tokens.append(token)
+            if tokens:
+                yield number, tokens
+
+
+def action_step(token, line, profiles):
+    """One tap of an action: (C expression of the key, [modifier names])."""
+    *mods, key = token.split("+")
+    for mod in mods:
+        if mod not in MODIFIERS:
+            raise KeymapError(line, f"'{mod}' is not a modifier")
+    code = keycode(key, line, False, profiles)
+    if mods and not code.startswith("HID_KEY_"):
+        raise KeymapError(line, f"modifiers only apply to keyboard keys, not '{key}'")
+    if code == NO_KEY:
+        raise KeymapError(line, "empty action")
+    return code, mods
+
+
+def leader_steps(tokens, line, profiles):
+    """Steps of a leader action: [(C expression of the key, [modifier names])]."""
+    steps = []
+    for token in tokens:
+        if token.startswith('"'):
+            for char in token[1:-1]:
+                if char not in TEXT_KEYS:
+                    raise KeymapError(line, f"character {char!r} cannot be typed")
+                shift, key = TEXT_KEYS[char]
+                steps.append((f"HID_KEY_{key}", ["SHIFT_LEFT"] if shift else []))
+            continue
+
+        key = token.split("+")[-1]
+        if key in MOUSE_KEYS or key == "LEADER":
+            raise KeymapError(line, f"'{key}' cannot be a leader action")
+        steps.append(action_step(token, line, profiles))
+
+    if not steps:
+        raise KeymapError(line, "leader sequence without an action")
+    return steps
+
+
+def parse(path):
+    km = Keymap()
+    lines = list(tokenize(path))
+    profile_names = [tokens[1] for _, tokens in lines if tokens[0] == "profile" and len(tokens) == 2]
+    tap_dance_names = [tokens[1] for _, tokens in lines if tokens[0] == "tap_dance" and len(tokens) in (2, 4)]
+
+    def grid_size(line):
+        if km.rows is None:
+            raise KeymapError(line, "'matrix' must come before the layers")
+        return km.rows, km.cols
+
+    def block(start):
+        """Lines up to the matching 'end'."""
+        body = []
+        i = start + 1
+        while i < len(lines):
+            number, tokens = lines[i]
+            if tokens == ["end"]:
+                return body, i + 1
+            body.append(lines[i])
+            i += 1
+        raise KeymapError(lines[start][0], "block without 'end'")
+
+    def full_grid(name, body, line, gamepad):
+        rows, cols = grid_size(line)
+        if len(body) != rows:
+            raise KeymapError(line, f"{name}: {len(body)} rows, the matrix has {rows}")
+        grid = []
+        for r, (number, tokens) in enumerate(body):
+            if len(tokens) != cols:
+                raise KeymapError(number, f"{name}: {len(tokens)} keys in row {r}, the matrix has {cols} columns")
+            grid.append([keycode(t, number, gamepad, profile_names, tap_dance_names) for t in tokens])
+            for c, t in enumerate(tokens):
+                km.line_of[(name, r, c)] = number
+                km.raw_keys.append((name, r, c, t))
+        return grid
+
+    i = 0
+    while i < len(lines):
+        number, tokens = lines[i]
+        keyword = tokens[0]
+
+        if keyword == "matrix" and len(tokens) == 3:
+            km.rows, km.cols = int(tokens[1]), int(tokens[2])
+            i += 1
+
+        elif keyword == "fn" and len(tokens) == 3:
+            km.fn = (int(tokens[1]), int(tokens[2]))
+            i += 1
+
+        elif keyword == "layer" and len(tokens) in (2, 4):
+            name = tokens[1]
+            if not NAME_RE.match(name):
+                raise KeymapError(number, f"invalid layer name '{name}'")
+            if name in km.layers:
+                raise KeymapError(number, f"layer '{name}' defined twice")
+            body, i = block(i)
+
+            if len(tokens) == 2:
+                km.layers[name] = full_grid(name, body, number, False)
+                continue
+
+            if tokens[2] != "=" or tokens[3] not in km.layers:
+                raise KeymapError(number, f"layer '{name}': parent must be a layer defined above")
+            parent = tokens[3]
+            rows, cols = grid_size(number)
+            grid = [list(row) for row in km.layers[parent]]
+            for (r, c) in [(r, c) for r in range(rows) for c in range(cols)]:
+                km.line_of[(name, r, c)] = km.line_of[(parent, r, c)]
+            km.raw_keys += [(name, r, c, t) for (layer, r, c, t) in km.raw_keys if layer == parent]
+            for override_line, override in body:
+                m = OVERRIDE_RE.match(override[0]) if len(override) == 2 else None
+                if not m:
+                    raise KeymapError(override_line, "expected '<row>,<col> <key>'")
+                r, c = int(m.group(1)), int(m.group(2))
+                if r >= rows or c >= cols:
+                    raise KeymapError(override_line, f"key {r},{c} outside the {rows}x{cols} matrix")
+                grid[r][c] = keycode(override[1], override_line, False, profile_names, tap_dance_names)
+                km.line_of[(name, r, c)] = override_line
+                km.raw_keys = [k for k in km.raw_keys if k[:3] != (name, r, c)] + [(name, r, c, override[1])]
+            km.layers[name] = grid
+
+        elif keyword == "gamepad" and len(tokens) == 1:
+            if km.gamepad is not None:
+                raise KeymapError(number, "gamepad layer defined twice")
+            body, i = block(i)
+            km.gamepad = full_grid("gamepad", body, number, True)
+
+        elif keyword == "profile" and len(tokens) == 2:
+            name = tokens[1]
+            if not NAME_RE.match(name):
+                raise KeymapError(number, f"invalid profile name '{name}'")
+            if any(p[0] == name for p in km.profiles):
+                raise KeymapError(number, f"profile '{name}' defined twice")
+            body, i = block(i)
+
+            layers = None
+            encoder = None
+            for setting_line, setting in body:
+                if setting[0] == "layers" and len(setting) == 3:
+                    for layer in setting[1:]:
+                        if layer not in km.layers:
+                            raise KeymapError(setting_line, f"unknown layer '{layer}'")
+                    layers = setting[1:]
+                elif setting[0] == "encoder" and len(setting) == 4:
+                    encoder = []
+                    for n, token in enumerate(setting[1:]):
+                        press = n == 2 and token.startswith("TD(")
+                        if not (token.startswith("C:") or token in ENCODER_MOUSE_KEYS or press):
+                            raise KeymapError(setting_line, f"'{token}': encoder actions are consumer usages, MS_WH_UP, MS_WH_DOWN, or TD(<name>) on the button")
+                        encoder.append(keycode(token, setting_line, False, profile_names, tap_dance_names))
+                else:
+                    raise KeymapError(setting_line, f"unknown profile setting '{' '.join(setting)}'")
+            if layers is None or encoder is None:
+                raise KeymapError(number, f"profile '{name}' needs 'layers' and 'encoder'")
+            km.profiles.append((name, layers, tuple(encoder), number))
+
+        elif keyword == "leader" and len(tokens) == 1:
+            body, i = block(i)
+            seen = {}
+            for seq_line, seq in body:
+                if "=" not in seq:
+                    raise KeymapError(seq_line, "expected '<keys> = <action>'")
+                split = seq.index("=")
+                keys, action = seq[:split], seq[split + 1:]
+                if not keys:
+                    raise KeymapError(seq_line, "empty leader sequence")
+                for key in keys:
+                    if key not in KEYBOARD_KEYS or key in MODIFIERS:
+                        raise KeymapError(seq_line, f"'{key}': leader sequences are keyboard keys other than modifiers")
+                if tuple(keys) in seen:
+                    raise KeymapError(seq_line, f"sequence '{' '.join(keys)}' already defined on line {seen[tuple(keys)]}")
+                seen[tuple(keys)] = seq_line
+                km.leader.append((keys, leader_steps(action, seq_line, profile_names), seq_line))
+
+        elif keyword == "tap_dance" and len(tokens) in (2, 4):
+            name = tokens[1]
+            if not NAME_RE.match(name):
+                raise KeymapError(number, f"invalid tap dance name '{name}'")
+            if any(d[0] == name for d in km.tap_dances):
+                raise KeymapError(number, f"tap dance '{name}' defined twice")
+            windows = (0, 0)
+            if len(tokens) == 4:
+                if not (tokens[2].isdigit() and tokens[3].isdigit()) or not 0 < int(tokens[2]) <= 0xFFFF or not 0 < int(tokens[3]) <= 0xFFFF:
+                    raise KeymapError(number, "tap dance windows are '<tap ms> <hold ms>', 1..65535")
+                windows = (int(tokens[2]), int(tokens[3]))
+            body, i = block(i)
+
+            gestures = {}
+            for gesture_line, gesture in body:
+                if gesture[0] not in TAP_DANCE_GESTURES or len(gesture) != 2:
+                    raise KeymapError(gesture_line, f"expected '<{'|'.join(TAP_DANCE_GESTURES)}> <action>'")
+                if gesture[0] in gestures:
+                    raise KeymapError(gesture_line, f"'{gesture[0]}' defined twice")
+                if gesture[1].split("+")[-1].startswith("TD("):
+                    raise KeymapError(gesture_line, "a tap dance cannot start another")
+                if gesture[1] in MOUSE_KEYS - ENCODER_MOUSE_KEYS:
+                    raise KeymapError(gesture_line, f"'{gesture[1]}': the only mouse actions are MS_WH_UP and MS_WH_DOWN")
+                gestures[gesture[0]] = action_step(gesture[1], gesture_line, profile_names)
+            if not gestures:
+                raise KeymapError(number, f"tap dance '{name}' without gestures")
+            km.tap_dances.append((name, gestures, windows, number))
+
+        elif keyword in ("combo", "macro"):
+            raise KeymapError(number, f"'{keyword}' is not supported by the firmware")
+
+        else:
+            raise KeymapError(number, f"unexpected '{' '.join(tokens)}'")
+
+    return km
+
+
+def check(km):
+    """Cross checks that need the whole file."""
+    if km.rows is None or km.fn is None:
+        raise KeymapError(1, "'matrix' and 'fn' are required")
+    if not km.profiles:
+        raise KeymapError(1, "at least one profile is required")
+    if km.gamepad is None:
+        raise KeymapError(1, "the gamepad layer is required")
+
+    fn_row, fn_col = km.fn
+    if fn_row >= km.rows or fn_col >= km.cols:
+        raise KeymapError(1, f"Fn key {fn_row},{fn_col} outside the {km.rows}x{km.cols} matrix")
+
+    # the Fn key never reaches the report, a code there is a mistake
+    used = {layer for _, layers, _, _ in km.profiles for layer in layers}
+    for layer in sorted(used):
+        if km.layers[layer][fn_row][fn_col] != NO_KEY:
+            raise KeymapError(km.line_of[(layer, fn_row, fn_col)], f"layer '{layer}': the Fn key {fn_row},{fn_col} must be '.'")
+
+    # gamepad mode must not take the Fn key or the keys that leave it
+    reserved = {(fn_row, fn_col): "the Fn key"}
+    for layer, r, c, token in km.raw_keys:
+        if layer in used and (token == "GP_TOGGLE" or token == "PROFILE_NEXT" or token.startswith("PROFILE(")):
+            reserved[(r, c)] = f"{token} on layer '{layer}'"
+    for (r, c), what in sorted(reserved.items()):
+        if km.gamepad[r][c] != NO_KEY:
+            raise KeymapError(km.line_of[("gamepad", r, c)], f"gamepad key {r},{c} must be '.', it is {what}")
+
+
+def build_trie(km):
+    """
+    Double-array trie of the leader sequences.
+
+    Returns (symbols, nodes, steps): symbols maps a key name to its symbol
+    (1..), nodes is a list of [base, check, action] where the children of
+    position s are at base + symbol with check == s + 1, and action is the
+    first step + 1 of the sequence ending there (0 = none). Leaves have
+    base 0; position 0 is the root.
+    """
+    names = sorted({key for keys, _, _ in km.leader for key in keys})
+    symbols = {name: i + 1 for i, name in enumerate(names)}
+
+    # plain trie: node -> {symbol: child}, node -> action
+    children = [{}]
+    actions = [None]
+    for keys, action, _ in km.leader:
+        node = 0
+        for key in keys:
+            sym = symbols[key]
+            if sym not in children[node]:
+                children[node][sym] = len(children)
+                children.append({})
+                actions.append(None)
+            node = children[node][sym]
+        actions[node] = action
+
+    steps = []
+    nodes = [[0, 0, 0]]
+    position = {0: 0}
+    queue = [0]
+    while queue:
+        node = queue.pop(0)
+        pos = position[node]
+        if actions[node] is not None:
+            nodes[pos][2] = len(steps) + 1
+            steps += [(key, mods, i == len(actions[node]) - 1) for i, (key, mods) in enumerate(actions[node])]
+        if not children[node]:
+            continue
+
+        # lowest base where every child lands on a free position
+        syms = sorted(children[node])
+        base = 1
+        while any(base + sym < len(nodes) and nodes[base + sym][1] != 0 or base + sym == 0 for sym in syms):
+            base += 1
+        nodes[pos][0] = base
+        for sym in syms:
+            while len(nodes) <= base + sym:
+                nodes.append([0, 0, 0])
+            nodes[base + sym][1] = pos + 1
+            position[children[node][sym]] = base + sym
+            queue.append(children[node][sym])
+
+    if len(nodes) > 0xFFFF or len(steps) >= 0xFFFF:
+        raise KeymapError(1, "too many leader sequences")
+    return symbols, nodes, steps
+
+
+def render(km, source, source_hash):
+    rows, cols = km.rows, km.cols
+    fn_row, fn_col = km.fn
+    header = f"// Generated by tools/keymap_gen.py from {source}, do not edit\n"
+
+    def grid(table, indent):
+        pad = " " * indent
+        out = []
+        for r, row in enumerate(table):
+            out.append(f"{pad}// Row {r}\n{pad}{{{', '.join(row)}}},\n")
+        return "".join(out)
+
+    h = [header, "\n#ifndef KEYMAP_TABLES_H\n#define KEYMAP_TABLES_H\n\n"]
+    h.append(f"    #define KEYMAP_PROFILES {len(km.profiles)}\n")
+    h.append(f"    #define KEYMAP_LAYERS 2\n")
+    h.append(f"    #define KEYMAP_SOURCE_HASH 0x{source_hash:08X}u\n\n")
+    for index, (name, _, _, _) in enumerate(km.profiles):
+        h.append(f"    #define {c_profile(name)} {index}\n")
+    h.append(f"\n    _Static_assert(MATRIX_ROWS == {rows} && MATRIX_COLS == {cols}, \"keymap and matrix sizes differ\");\n")
+    h.append(f"    _Static_assert(FN_KEY_ROW == {fn_row} && FN_KEY_COL == {fn_col}, \"keymap and matrix Fn keys differ\");\n\n")
+    h.append("    extern const uint16_t keymap_tables[KEYMAP_PROFILES][KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS];\n")
+    h.append("    extern const uint16_t gamepad_keymap[MATRIX_ROWS][MATRIX_COLS];\n")
+    h.append("    extern const keymap_encoder_t keymap_encoders[KEYMAP_PROFILES];\n")
+
+    symbols, nodes, steps = build_trie(km)
+    h.append(f"\n    #define LEADER_SEQUENCES {len(km.leader)}\n")
+    h.append(f"    #define LEADER_NODES {len(nodes)}\n")
+    h.append(f"    #define LEADER_SYMBOL_RANGE {LEADER_SYMBOL_RANGE}\n\n")
+    h.append("    extern const uint8_t leader_symbols[LEADER_SYMBOL_RANGE];\n")
+    h.append("    extern const leader_node_t leader_nodes[LEADER_NODES];\n")
+    h.append("    extern const leader_step_t leader_steps[];\n")
+
+    h.append(f"\n    #define KEYMAP_TAP_DANCES {len(km.tap_dances)}\n")
+    for index, (name, _, _, _) in enumerate(km.tap_dances):
+        h.append(f"    #define {c_tap_dance(name)} {index}\n")
+    h.append("\n    extern const tap_dance_t keymap_tap_dances[];\n")
+    h.append("    extern const char* const keymap_tap_dance_names[];\n")
+
+    names = key_names(km)
+    h.append(f"\n    #define KEYMAP_KEY_NAMES {len(names)}\n\n")
+    h.append("    extern const keymap_name_t keymap_key_names[KEYMAP_KEY_NAMES];\n")
+    h.append("\n#endif /* KEYMAP_TABLES_H */\n")
+
+    c = [header, "\n#include \"src/matrix/keymap/keymap.h\"\n\n"]
+    c.append("const uint16_t keymap_tables[KEYMAP_PROFILES][KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS] = {\n")
+    for name, layers, _, _ in km.profiles:
+        c.append(f"    [{c_profile(name)}] = {{\n")
+        for layer in layers:
+            c.append(f"        {{   // {layer}\n{grid(km.layers[layer], 12)}        }},\n")
+        c.append("    },\n")
+    c.append("};\n\n")
+    c.append(f"const uint16_t gamepad_keymap[MATRIX_ROWS][MATRIX_COLS] = {{\n{grid(km.gamepad, 4)}}};\n\n")
+    c.append("const keymap_encoder_t keymap_encoders[KEYMAP_PROFILES] = {\n")
+    for name, _, (cw, ccw, press), _ in km.profiles:
+        c.append(f"    [{c_profile(name)}] = {{.cw = {cw}, .ccw = {ccw}, .press = {press}}},\n")
+    c.append("};\n\n")
+
+    c.append(f"// Leader sequences: {len(km.leader)}, {len(symbols)} symbols, {len(nodes)} trie positions\n")
+    c.append("const uint8_t leader_symbols[LEADER_SYMBOL_RANGE] = {\n")
+    for name, sym in sorted(symbols.items(), key=lambda item: item[1]):
+        c.append(f"    [HID_KEY_{name}] = {sym},\n")
+    c.append("};\n\n")
+    c.append("const leader_node_t leader_nodes[LEADER_NODES] = {\n")
+    for pos, (base, check, action) in enumerate(nodes):
+        if base or check or action or pos == 0:
+            c.append(f"    [{pos}] = {{.base = {base}, .check = {check}, .action = {action}}},\n")
+    c.append("};\n\n")
+    c.append("const leader_step_t leader_steps[] = {\n")
+    for key, mods, last in steps:
+        modifier = " | ".join(MODIFIERS[m] for m in mods) or "0"
+        c.append(f"    {{.key = {key}, .modifier = {modifier}, .last = {int(last)}}},\n")
+    if not steps:
+        c.append("    {0},\n")
+    c.append("};\n\n")
+
+    c.append("const tap_dance_t keymap_tap_dances[] = {\n")
+    for name, gestures, (tap_ms, hold_ms), _ in km.tap_dances:
+        c.append(f"    [{c_tap_dance(name)}] = {{\n")
+        for gesture in TAP_DANCE_GESTURES:
+            if gesture in gestures:
+                key, mods = gestures[gesture]
+                modifier = " | ".join(MODIFIERS[m] for m in mods) or "0"
+                c.append(f"        .actions[TAP_DANCE_{gesture.upper()}] = {{.key = {key}, .modifier = {modifier}}},\n")
+        c.append(f"        .tap_ms = {tap_ms}, .hold_ms = {hold_ms},\n    }},\n")
+    if not km.tap_dances:
+        c.append("    {0},\n")
+    c.append("};\n\n")
+
+    c.append("const char* const keymap_tap_dance_names[] = {\n")
+    for name, _, _, _ in km.tap_dances:
+        c.append(f"    [{c_tap_dance(name)}] = \"{name}\",\n")
+    if not km.tap_dances:
+        c.append("    \"\",\n")
+    c.append("};\n\n")
+
+    c.append("// Sorted by name (byte order)\n")
+    c.append("const keymap_name_t keymap_key_names[KEYMAP_KEY_NAMES] = {\n")
+    for name, code in names:
+        c.append(f"    {{\"{name}\", {code}}},\n")
+    c.append("};\n")
+
+    return "".join(h), "".join(c)
+
+
+def key_names(km):
+    """(name, C expression) of every key a keyboard layer can hold, sorted by name."""
+    names = [(key, f"HID_KEY_{key}") for key in KEYBOARD_KEYS]
+    names += [(f"C:{usage}", f"KC_CONSUMER(HID_USAGE_CONSUMER_{usage})") for usage in CONSUMER_USAGES]
+    names += [(key, f"KC_{key}") for key in MOUSE_KEYS | ACTION_KEYS]
+    names += [(f"PROFILE({name})", f"KC_PROFILE({c_profile(name)})") for name, _, _, _ in km.profiles]
+    names += [(f"TD({name})", f"KC_TAP_DANCE({c_tap_dance(name)})") for name, _, _, _ in km.tap_dances]
+    return sorted(names, key=lambda item: item[0].encode())
+
+
+def write_if_changed(path, content):
+    try:
+        with open(path) as f:
+            if f.read() == content:
+                return
+    except OSError:
+        pass
+    with open(path, "w") as f:
+        f.write(content)
+
+
+def main(argv):
+    if len(argv) != 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    source, out_dir = argv
+    try:
+        km = parse(source)
+        check(km)
+    except KeymapError as e:
+        print(f"{source}:{e.line}: {e}", file=sys.stderr)
+        return 1
+    except ValueError as e:
+        print(f"{source}: {e}", file=sys.stderr)
+        return 1
+
+    with open(source, "rb") as f:
+        source_hash = zlib.crc32(f.read())
+
+    header, tables = render(km, os.path.basename(source), source_hash)
+    os.makedirs(out_dir, exist_ok=True)
+    write_if_changed(os.path.join(out_dir, "keymap_tables.h"), header)
+    write_if_changed(os.path.join(out_dir, "keymap_tables.c"), tables)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""
+RAM residency report for the Orione firmware.
+
+Parses the GNU ld map file produced next to the ELF (orione.elf.map) and
+lists every input section placed in SRAM, split into code (functions
+marked __not_in_flash_func, i.e. .time_critical.*) and data (.data/.bss).
+By default only the firmware's own objects are listed; pass --all to
+include the Pico SDK and TinyUSB.
+
+With --flash-reserve=BYTES it also checks that the image ends before the
+last BYTES of the flash (the storage logs, STORAGE_SIZE in storage.h) and
+exits with an error when it does not: a save would erase the program.
+
+usage: ram_report.py [--all] [--flash-reserve=BYTES] orione.elf.map
+"""
+
+import re
+import sys
+
+SRAM_START = 0x20000000
+SRAM_END = 0x20042000
+
+# " .section  0xADDR  0xSIZE object" (possibly split over two lines)
+SECTION_RE = re.compile(r"^ (\.[^\s]+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+))?$")
+CONTINUATION_RE = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+)$")
+
+# "FLASH  0xORIGIN  0xLENGTH  xr" (Memory Configuration)
+FLASH_REGION_RE = re.compile(r"^FLASH\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)")
+# "  0xADDR  __flash_binary_end = ."
+FLASH_END_RE = re.compile(r"^\s+0x([0-9a-f]+)\s+__flash_binary_end = ")
+
+
+def parse_map(path):
+    sections = []
+    pending = None
+
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip("\n")
+
+            if pending is not None:
+                m = CONTINUATION_RE.match(line)
+                if m:
+                    sections.append((pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3)))
+                pending = None
+                continue
+
+            m = SECTION_RE.match(line)
+            if not m:
+                continue
+            if m.group(2) is None:
+                pending = m.group(1)
+            else:
+                sections.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+
+    return sections
+
+
+def parse_flash(path):
+    """Return (origin, length, image end) of the flash, None where not found"""
+    origin = length = end = None
+
+    with open(path) as f:
+        for line in f:
+            m = FLASH_REGION_RE.match(line)
+            if m and origin is None:
+                origin, length = int(m.group(1), 16), int(m.group(2), 16)
+                continue
+            m = FLASH_END_RE.match(line)
+            if m:
+                end = int(m.group(1), 16)
+
+    return origin, length, end
+
+
+def check_flash(path, reserve):
+    origin, length, end = parse_flash(path)
+    if origin is None or end is None:
+        print(f"ram_report: no flash region or __flash_binary_end in {path}", file=sys.stderr)
+        return False
+
+    limit = origin + length - reserve
+    if end > limit:
+        print(f"ram_report: the image ends at 0x{end:08x}, {end - limit} bytes into the "
+              f"{reserve} bytes of storage at the end of the flash", file=sys.stderr)
+        return False
+
+    print(f"Flash image end 0x{end:08x}, storage from 0x{limit:08x} ({limit - end} bytes free)\n")
+    return True
+
+
+def classify(name):
+    if name.startswith(".time_critical") or name.startswith(".text"):
+        return "code"
+    if name.startswith(".data") or name.startswith(".bss") or name.startswith(".scratch"):
+        return "data"
+    return None
+
+
+def main(argv):
+    show_all = "--all" in argv
+    reserve = None
+    for a in argv:
+        if a.startswith("--flash-reserve="):
+            reserve = int(a.split("=", 1)[1], 0)
+    args = [a for a in argv if not a.startswith("--")]
+    if len(args) != 1:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    if reserve is not None and not check_flash(args[0], reserve):
+        return 1
+
+    groups = {"code": [], "data": []}
+
+    for name, addr, size, obj in parse_map(args[0]):
+        if size == 0 or not (SRAM_START <= addr < SRAM_END):
+            continue
+        kind = classify(name)
+        if kind is None:
+            continue
+        if not show_all and "orione.dir" not in obj:
+            continue
+        groups[kind].append((name, addr, size, obj.split("/")[-1]))
+
+    for kind, title in (("code", "Code resident in SRAM"), ("data", "Data resident in SRAM")):
+        entries = sorted(groups[kind], key=lambda e: e[2], reverse=True)
+        print(f"{title}:")
+        for name, addr, size, obj in entries:
+            print(f"  0x{addr:08x} {size:6d}  {name:<48} {obj}")
+        print(f"  total {sum(e[2] for e in entries)} bytes\n")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
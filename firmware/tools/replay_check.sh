@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Check the interrupt handler budgets and the clock governor restore on the
+# simulated clock, with the column interrupts and with the hybrid scan:
+# synthesizes a chatter session with encoder detents and button presses
+# that ends with an idle pause past GOVERNOR_IDLE_MS (60 s) and one more
+# keystroke, replays it in both modes with --profile and checks the
+# results against bench/thresholds.json. Every limit there must be
+# measured by one of the two runs.
+#
+# usage: replay_check.sh [path/to/replay] [work dir]
+#
+# Run by ctest in the host build. bench/replay_baseline.jsonl is the
+# output of this script the limits were set from.
+
+set -e
+
+replay=${1:-./build-host/replay}
+work=${2:-.}
+tools=$(dirname "$0")
+
+"$replay" synth -p chatter -s 1 -k 200 -e 20 -i 61000 "$work/check_session.txt"
+"$replay" run --profile "$work/check_irq.jsonl" "$work/check_session.txt" > /dev/null
+"$replay" run --hybrid --profile "$work/check_hybrid.jsonl" "$work/check_session.txt" > /dev/null
+cat "$work/check_irq.jsonl" "$work/check_hybrid.jsonl" > "$work/check.jsonl"
+
+python3 "$tools/bench_compare.py" --check "$tools/../bench/thresholds.json" "$work/check.jsonl"